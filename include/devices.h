@@ -1,39 +1,73 @@
 #ifndef DEVICES_H
 #define DEVICES_H
 
-#include <Arduino.h>
+#include <stdint.h>
 
-// 電球デバイス構造体
-struct BulbDevice
+// デバイス設定（起動時にデバイス登録簿 device_registry へ読み込む）
+struct DeviceConfig
 {
-    String deviceId; // SwitchBot デバイスID
-    String name;     // 表示名
-    bool powerState; // 電源状態
-    int brightness;  // 明るさ（1-100）
+    const char *deviceId; // SwitchBot デバイスID
+    const char *name;     // 表示名
 };
 
-// 電球の数
-#define NUM_BULBS 4
+// 温湿度計
+inline const DeviceConfig meterConfig = {"CA323435166C", "温湿度計 6C"};
+
+// 電球（台数に制限なし、4台ずつページに並ぶ）
+// deviceId は GET /v1.1/devices で取得できます
+inline const DeviceConfig bulbConfigs[] = {
+    {"94A99076A08A", "寝室ライト"},
+    {"94A990794BC2", "和室ライト"},
+    {"84FCE6B54B5E", "風呂ライト"},
+    {"84FCE6F438D6", "キッチンライト"}};
 
-// 温湿度計デバイス構造体
-struct MeterDevice
+// シーン・グループ（scene.cpp で使用）
+// brightness・color は -1 なら変えない、color は 0xRRGGBB
+struct SceneTarget
 {
-    String deviceId;    // SwitchBot デバイスID
-    String name;        // 表示名
-    float temperature;  // 温度（℃）
-    int humidity;       // 湿度（%）
-    bool valid;         // データ有効フラグ
+    const char *deviceId;
+    bool power;
+    int brightness;
+    int32_t color;
 };
 
-// 温湿度計
-inline MeterDevice meter = {"CA323435166C", "温湿度計 6C", 0.0f, 0, false};
+struct SceneConfig
+{
+    const char *name;
+    const SceneTarget *targets;
+    int count;
+};
 
-// 電球デバイス配列（初期設定）
-// deviceId は GET /v1.1/devices で取得できます
-inline BulbDevice bulbs[NUM_BULBS] = {
-    {"94A99076A08A", "寝室ライト", false, 100},
-    {"94A990794BC2", "和室ライト", false, 100},
-    {"84FCE6B54B5E", "風呂ライト", false, 100},
-    {"84FCE6F438D6", "キッチンライト", false, 100}};
+struct GroupConfig
+{
+    const char *name;
+    const char *const *deviceIds;
+    int count;
+};
+
+#define CONFIG_COUNT(array) ((int)(sizeof(array) / sizeof((array)[0])))
+
+inline const SceneTarget eveningTargets[] = {
+    {"94A99076A08A", true, 40, 0xFFB46E},
+    {"94A990794BC2", true, 40, 0xFFB46E},
+    {"84FCE6B54B5E", true, 60, -1},
+    {"84FCE6F438D6", true, 80, -1}};
+
+inline const SceneTarget nightTargets[] = {
+    {"94A99076A08A", true, 5, 0xFF8C3C},
+    {"94A990794BC2", false, -1, -1},
+    {"84FCE6B54B5E", false, -1, -1},
+    {"84FCE6F438D6", false, -1, -1}};
+
+inline const SceneConfig sceneConfigs[] = {
+    {"夕方", eveningTargets, CONFIG_COUNT(eveningTargets)},
+    {"おやすみ", nightTargets, CONFIG_COUNT(nightTargets)}};
+
+inline const char *const allBulbIds[] = {"94A99076A08A", "94A990794BC2", "84FCE6B54B5E", "84FCE6F438D6"};
+inline const char *const wetAreaIds[] = {"84FCE6B54B5E", "84FCE6F438D6"};
+
+inline const GroupConfig groupConfigs[] = {
+    {"全部", allBulbIds, CONFIG_COUNT(allBulbIds)},
+    {"水回り", wetAreaIds, CONFIG_COUNT(wetAreaIds)}};
 
 #endif // DEVICES_H
@@ -9,4 +9,7 @@
 #define SWITCHBOT_TOKEN "YOUR_SWITCHBOT_TOKEN"
 #define SWITCHBOT_SECRET "YOUR_SWITCHBOT_SECRET"
 
+// Webhook の中継と共有する合言葉（中継は X-Webhook-Token ヘッダーで送る、空ならWebhookを待ち受けない）
+#define WEBHOOK_TOKEN "YOUR_WEBHOOK_TOKEN"
+
 #endif // SECRETS_H
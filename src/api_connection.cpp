@@ -0,0 +1,337 @@
+#include "api_connection.h"
+
+#include <WiFi.h>
+#include <strings.h>
+#include <freertos/FreeRTOS.h>
+
+// TLSハンドシェイクのタイムアウト（秒）
+#define API_CONN_HANDSHAKE_TIMEOUT_S 5
+
+static ApiConnection pool[API_CONN_POOL_SIZE];
+static ApiConnStats stats = {};
+
+// プールと統計は複数のワーカータスクから触られる
+static portMUX_TYPE poolMux = portMUX_INITIALIZER_UNLOCKED;
+
+void apiConnInit() {
+    for (int i = 0; i < API_CONN_POOL_SIZE; i++) {
+        pool[i].client.setInsecure();
+        pool[i].client.setHandshakeTimeout(API_CONN_HANDSHAKE_TIMEOUT_S);
+        pool[i].inUse = false;
+        pool[i].reused = false;
+        pool[i].keepAlive = false;
+        pool[i].chunked = false;
+        pool[i].contentLength = -1;
+        pool[i].timeoutMs = 0;
+        pool[i].lastUsed = 0;
+        pool[i].dnsUs = 0;
+        pool[i].connectUs = 0;
+        pool[i].rxLen = 0;
+        pool[i].rxPos = 0;
+    }
+}
+
+ApiConnection* apiConnAcquire() {
+    ApiConnection* conn = nullptr;
+
+    // keep-alive中のセッションを持つスロットを優先して選ぶ
+    portENTER_CRITICAL(&poolMux);
+    for (int i = 0; i < API_CONN_POOL_SIZE; i++) {
+        if (pool[i].inUse) continue;
+        if (conn == nullptr || pool[i].lastUsed > conn->lastUsed) {
+            conn = &pool[i];
+        }
+    }
+    if (conn != nullptr) {
+        conn->inUse = true;
+    }
+    portEXIT_CRITICAL(&poolMux);
+
+    if (conn == nullptr) return nullptr;
+
+    // 長時間アイドルのセッションはサーバー側で閉じられている可能性が高いので先に閉じる
+    if (conn->client.connected() && millis() - conn->lastUsed >= API_CONN_IDLE_TIMEOUT_MS) {
+        conn->client.stop();
+        portENTER_CRITICAL(&poolMux);
+        stats.idleCloses++;
+        portEXIT_CRITICAL(&poolMux);
+    }
+    return conn;
+}
+
+void apiConnRelease(ApiConnection* conn) {
+    if (conn == nullptr) return;
+
+    portENTER_CRITICAL(&poolMux);
+    conn->lastUsed = millis();
+    conn->inUse = false;
+    portEXIT_CRITICAL(&poolMux);
+}
+
+// URLをホスト名とパスに分ける（"https://host/path..."）
+static bool parseUrl(const char* url, char* host, size_t size, const char** path) {
+    const char* p = strstr(url, "://");
+    p = (p != nullptr) ? p + 3 : url;
+    size_t len = strcspn(p, ":/");
+    if (len == 0 || len >= size) return false;
+    memcpy(host, p, len);
+    host[len] = '\0';
+    *path = strchr(p + len, '/');
+    if (*path == nullptr) *path = "/";
+    return true;
+}
+
+// 名前解決とTCP+TLS接続を別々に計測しながら接続する
+static bool connectTimed(ApiConnection* conn, const char* host) {
+    unsigned long t0 = micros();
+    IPAddress ip;
+    if (!WiFi.hostByName(host, ip)) return false;
+    unsigned long t1 = micros();
+
+    // SNIのためホスト名で接続する（名前解決はlwIPのキャッシュに当たる）
+    bool ok = conn->client.connect(host, 443);
+    unsigned long t2 = micros();
+
+    conn->dnsUs = t1 - t0;
+    conn->connectUs = t2 - t1;
+    return ok;
+}
+
+bool apiConnBegin(ApiConnection* conn, const char* url, uint16_t timeoutMs) {
+    // 接続済みならハンドシェイクせずにそのセッションで送る
+    conn->reused = conn->client.connected();
+
+    portENTER_CRITICAL(&poolMux);
+    stats.requests++;
+    if (conn->reused) {
+        stats.reused++;
+    } else {
+        stats.handshakes++;
+    }
+    portEXIT_CRITICAL(&poolMux);
+
+    conn->timeoutMs = timeoutMs;
+    conn->dnsUs = 0;
+    conn->connectUs = 0;
+    conn->rxLen = 0;
+    conn->rxPos = 0;
+    if (conn->reused) return true;
+
+    char host[64];
+    const char* path;
+    if (!parseUrl(url, host, sizeof(host), &path) || !connectTimed(conn, host)) return false;
+
+    uint32_t ms = conn->connectUs / 1000;
+    portENTER_CRITICAL(&poolMux);
+    stats.handshakeMsTotal += ms;
+    if (ms > stats.handshakeMsMax) stats.handshakeMsMax = ms;
+    portEXIT_CRITICAL(&poolMux);
+    return true;
+}
+
+// 受信バッファが空なら読み足す
+// 戻り値: 読めるバイトがある=true、切断・タイムアウト=false
+static bool fill(ApiConnection* conn) {
+    if (conn->rxPos < conn->rxLen) return true;
+
+    unsigned long start = millis();
+    while (true) {
+        int avail = conn->client.available();
+        if (avail > 0) {
+            int got = conn->client.read((uint8_t*)conn->rx, min(avail, (int)sizeof(conn->rx)));
+            if (got > 0) {
+                conn->rxLen = (uint16_t)got;
+                conn->rxPos = 0;
+                return true;
+            }
+            continue;
+        }
+        if (!conn->client.connected() || millis() - start >= conn->timeoutMs) return false;
+        delay(1);
+    }
+}
+
+// 読めなかった理由を通信エラーのコードにする
+static int readError(ApiConnection* conn) {
+    return conn->client.connected() ? API_CONN_ERROR_READ_TIMEOUT : API_CONN_ERROR_CONNECTION_LOST;
+}
+
+// 1行読む（CRLF は除く、size を超える分は読み捨てる）
+static bool readLine(ApiConnection* conn, char* line, size_t size) {
+    size_t len = 0;
+    while (fill(conn)) {
+        char c = conn->rx[conn->rxPos++];
+        if (c == '\n') {
+            if (len > 0 && line[len - 1] == '\r') len--;
+            line[len] = '\0';
+            return true;
+        }
+        if (len + 1 < size) line[len++] = c;
+    }
+    return false;
+}
+
+// ヘッダー行の名前が name なら値の先頭を返す
+static const char* headerValue(const char* line, const char* name) {
+    size_t len = strlen(name);
+    if (strncasecmp(line, name, len) != 0 || line[len] != ':') return nullptr;
+    const char* v = line + len + 1;
+    while (*v == ' ' || *v == '\t') v++;
+    return v;
+}
+
+int apiConnSend(ApiConnection* conn, const char* url, const HalHttpHeader* headers, int headerCount,
+                const char* body) {
+    char host[64];
+    const char* path;
+    if (!parseUrl(url, host, sizeof(host), &path)) return API_CONN_ERROR_SEND_FAILED;
+
+    // リクエストライン・ヘッダーをまとめて1回で送る
+    char head[API_CONN_HEADER_MAX];
+    size_t bodyLen = (body != nullptr) ? strlen(body) : 0;
+    int len = snprintf(head, sizeof(head), "%s %s HTTP/1.1\r\nHost: %s\r\nConnection: keep-alive\r\n",
+                       body != nullptr ? "POST" : "GET", path, host);
+    for (int i = 0; i < headerCount && len > 0 && len < (int)sizeof(head); i++) {
+        len += snprintf(head + len, sizeof(head) - len, "%s: %s\r\n", headers[i].name, headers[i].value);
+    }
+    if (body != nullptr && len > 0 && len < (int)sizeof(head)) {
+        len += snprintf(head + len, sizeof(head) - len, "Content-Length: %u\r\n", (unsigned)bodyLen);
+    }
+    if (len > 0 && len < (int)sizeof(head)) {
+        len += snprintf(head + len, sizeof(head) - len, "\r\n");
+    }
+    if (len <= 0 || len >= (int)sizeof(head)) return API_CONN_ERROR_SEND_FAILED;
+
+    if (conn->client.write((const uint8_t*)head, len) != (size_t)len) return API_CONN_ERROR_SEND_FAILED;
+    if (bodyLen > 0 && conn->client.write((const uint8_t*)body, bodyLen) != bodyLen) {
+        return API_CONN_ERROR_SEND_FAILED;
+    }
+
+    // ステータス行（"HTTP/1.1 200 OK"）
+    char line[API_CONN_LINE_MAX];
+    if (!readLine(conn, line, sizeof(line))) return readError(conn);
+    if (strncmp(line, "HTTP/1.", 7) != 0 || line[8] != ' ') return API_CONN_ERROR_NO_HTTP_SERVER;
+    int code = atoi(line + 9);
+    if (code <= 0) return API_CONN_ERROR_NO_HTTP_SERVER;
+
+    // ボディの長さと keep-alive を決めるヘッダーだけを見る
+    conn->keepAlive = line[7] == '1';
+    conn->chunked = false;
+    conn->contentLength = -1;
+    while (true) {
+        if (!readLine(conn, line, sizeof(line))) return readError(conn);
+        if (line[0] == '\0') break;
+
+        const char* v;
+        if ((v = headerValue(line, "Content-Length")) != nullptr) {
+            conn->contentLength = atol(v);
+        } else if ((v = headerValue(line, "Transfer-Encoding")) != nullptr) {
+            conn->chunked = strncasecmp(v, "chunked", 7) == 0;
+        } else if ((v = headerValue(line, "Connection")) != nullptr) {
+            conn->keepAlive = strncasecmp(v, "close", 5) != 0;
+        }
+    }
+    if (code == 204 || code == 304) {
+        conn->chunked = false;
+        conn->contentLength = 0;
+    }
+    return code;
+}
+
+// 受信済みのボディを最大 n バイト sink に渡す（戻り値: 渡したバイト数、0 は切断・タイムアウト）
+static size_t drain(ApiConnection* conn, size_t n, ApiBodySink sink, void* ctx, bool& wantMore) {
+    if (!fill(conn)) return 0;
+    size_t take = min(n, (size_t)(conn->rxLen - conn->rxPos));
+
+    // 必要なフィールドが揃ったら以降は解析せず読み捨てる
+    if (wantMore) {
+        wantMore = sink(ctx, conn->rx + conn->rxPos, take);
+    }
+    conn->rxPos += take;
+    return take;
+}
+
+// ボディを n バイト読む
+static bool readExactly(ApiConnection* conn, size_t n, ApiBodySink sink, void* ctx, bool& wantMore) {
+    while (n > 0) {
+        size_t got = drain(conn, n, sink, ctx, wantMore);
+        if (got == 0) return false;
+        n -= got;
+    }
+    return true;
+}
+
+bool apiConnReadBody(ApiConnection* conn, ApiBodySink sink, void* ctx) {
+    bool wantMore = (sink != nullptr);
+    bool ok = true;
+
+    if (conn->chunked) {
+        // チャンクごとに "長さ(16進)" 行・データ・CRLF、長さ0のチャンクと空行で終わる
+        char line[API_CONN_LINE_MAX];
+        while (ok) {
+            ok = readLine(conn, line, sizeof(line));
+            if (!ok) break;
+            size_t size = strtoul(line, nullptr, 16);
+            if (size == 0) {
+                while ((ok = readLine(conn, line, sizeof(line))) && line[0] != '\0') {
+                }
+                break;
+            }
+            ok = readExactly(conn, size, sink, ctx, wantMore) && readLine(conn, line, sizeof(line));
+        }
+    } else if (conn->contentLength >= 0) {
+        ok = readExactly(conn, conn->contentLength, sink, ctx, wantMore);
+    } else {
+        // 長さの指定がなければサーバーが閉じるまでがボディ
+        while (drain(conn, sizeof(conn->rx), sink, ctx, wantMore) > 0) {
+        }
+        conn->keepAlive = false;
+        ok = !conn->client.connected();
+    }
+
+    if (!ok) conn->client.stop();
+    return ok;
+}
+
+bool apiConnEnd(ApiConnection* conn, int httpCode) {
+    // 送信失敗・切断（負のコード）はセッションを破棄
+    if (httpCode < 0) {
+        conn->client.stop();
+
+        // 再利用したセッションがサーバー側で閉じられていた場合のみ再試行
+        if (conn->reused) {
+            portENTER_CRITICAL(&poolMux);
+            stats.reconnects++;
+            portEXIT_CRITICAL(&poolMux);
+            return true;
+        }
+        return false;
+    }
+
+    // サーバーが Connection: close で応答したらこちらも閉じる
+    if (!conn->keepAlive) {
+        conn->client.stop();
+        portENTER_CRITICAL(&poolMux);
+        stats.serverCloses++;
+        portEXIT_CRITICAL(&poolMux);
+    }
+    return false;
+}
+
+ApiConnStats apiConnGetStats() {
+    portENTER_CRITICAL(&poolMux);
+    ApiConnStats copy = stats;
+    portEXIT_CRITICAL(&poolMux);
+    return copy;
+}
+
+void apiConnPrintStats() {
+    ApiConnStats s = apiConnGetStats();
+    Serial.printf("API conn: requests=%lu reused=%lu handshakes=%lu reconnects=%lu\n",
+                  (unsigned long)s.requests, (unsigned long)s.reused,
+                  (unsigned long)s.handshakes, (unsigned long)s.reconnects);
+    Serial.printf("API conn: idle_closes=%lu server_closes=%lu handshake avg/max=%lu/%lums\n",
+                  (unsigned long)s.idleCloses, (unsigned long)s.serverCloses,
+                  (unsigned long)(s.handshakes > 0 ? s.handshakeMsTotal / s.handshakes : 0),
+                  (unsigned long)s.handshakeMsMax);
+}
@@ -0,0 +1,106 @@
+#ifndef API_CONNECTION_H
+#define API_CONNECTION_H
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include "hal/hal_http.h"
+
+// 同時に保持するTLSセッション数（＝同時リクエスト数の上限）
+#define API_CONN_POOL_SIZE HAL_HTTP_MAX_CONCURRENT
+
+// レスポンスを読み出す単位（接続ごとの受信バッファ）
+#define API_CONN_READ_CHUNK 128
+
+// リクエストライン・ヘッダーを組み立てるバッファ（スタック上）
+#define API_CONN_HEADER_MAX 768
+
+// レスポンスヘッダー1行の最大長（これより長い行は切り詰めて読む）
+#define API_CONN_LINE_MAX 96
+
+// この時間使われなかったセッションはサーバー側で切られる前に閉じる
+#ifndef API_CONN_IDLE_TIMEOUT_MS
+#define API_CONN_IDLE_TIMEOUT_MS 30000
+#endif
+
+// 通信エラー（HTTPClient の HTTPC_ERROR_* と同じ値）
+#define API_CONN_ERROR_CONNECTION_REFUSED (-1)
+#define API_CONN_ERROR_SEND_FAILED (-2)
+#define API_CONN_ERROR_CONNECTION_LOST (-5)
+#define API_CONN_ERROR_NO_HTTP_SERVER (-7)
+#define API_CONN_ERROR_READ_TIMEOUT (-11)
+
+// keep-aliveで保持するHTTPS接続1本分
+// HTTP/1.1 の読み書きは固定長のバッファで行い、リクエストごとのヒープ確保をしない
+struct ApiConnection
+{
+    WiFiClientSecure client;
+    bool inUse;             // 使用中フラグ
+    bool reused;            // 直近のリクエストで既存セッションを再利用したか
+    bool keepAlive;         // 直近のレスポンスの後もセッションを続けられるか
+    bool chunked;           // 直近のレスポンスが chunked 転送か
+    int32_t contentLength;  // 直近のレスポンスの Content-Length（なければ -1）
+    uint16_t timeoutMs;     // 直近のリクエストのタイムアウト
+    unsigned long lastUsed; // 最終使用時刻（millis）
+    uint32_t dnsUs;         // 直近の apiConnBegin での名前解決時間（再利用時は0）
+    uint32_t connectUs;     // 直近の apiConnBegin でのTCP+TLS接続時間（再利用時は0）
+    uint16_t rxLen;         // 受信バッファの有効バイト数
+    uint16_t rxPos;         // 受信バッファの読み出し位置
+    char rx[API_CONN_READ_CHUNK];
+};
+
+// 接続統計
+struct ApiConnStats
+{
+    uint32_t requests;   // 総リクエスト数
+    uint32_t reused;     // 既存セッションを再利用した回数
+    uint32_t handshakes; // 新規TCP+TLSハンドシェイク回数
+    uint32_t reconnects; // サーバー切断を検出して再接続した回数
+    // ハンドシェイクの原因（TLSセッションの再開はしないため、閉じたセッションは毎回フルハンドシェイクになる）
+    uint32_t idleCloses;   // アイドルが続いたセッションを送る前に閉じた回数
+    uint32_t serverCloses; // サーバーが Connection: close で応答した回数
+    // ハンドシェイク（TCP+TLS接続）にかかった時間
+    uint32_t handshakeMsTotal;
+    uint32_t handshakeMsMax;
+};
+
+// コネクションプール初期化
+void apiConnInit();
+
+// 空いている接続を取得（なければnullptr、複数タスクから呼び出し可）
+ApiConnection* apiConnAcquire();
+
+// 接続を返却
+void apiConnRelease(ApiConnection* conn);
+
+// リクエスト開始（keep-alive中のセッションがあれば再利用）
+// 新規接続は段階ごとの時間を測るためここで確立する（dnsUs / connectUs に記録）
+// timeoutMs: 接続・応答待ちのタイムアウト
+// 戻り値: 成功=true, 失敗=false
+bool apiConnBegin(ApiConnection* conn, const char* url, uint16_t timeoutMs);
+
+// リクエストを送り、レスポンスのステータス行とヘッダーを読む
+// body が nullptr なら GET、それ以外は POST
+// 戻り値: HTTPステータスコード（負値は API_CONN_ERROR_*）
+int apiConnSend(ApiConnection* conn, const char* url, const HalHttpHeader* headers, int headerCount,
+                const char* body);
+
+// レスポンスボディの受け取り先
+// 戻り値: 続きが必要=true, もう不要=false（残りは解析せずに読み捨てる）
+typedef bool (*ApiBodySink)(void* ctx, const char* data, size_t len);
+
+// レスポンスボディをチャンク単位で sink に渡す（sink が nullptr なら読み捨て）
+// keep-aliveを維持するため、sink が不要と返した後もボディの終わりまで読み切る
+// 戻り値: 成功=true, 読み込み失敗=false（セッションは破棄される）
+bool apiConnReadBody(ApiConnection* conn, ApiBodySink sink, void* ctx);
+
+// リクエスト終了。再利用したセッションが切断されていた場合は破棄する
+// 戻り値: 新しいセッションで再試行すべき場合 true
+bool apiConnEnd(ApiConnection* conn, int httpCode);
+
+// 統計取得
+ApiConnStats apiConnGetStats();
+
+// 統計をシリアルに出力
+void apiConnPrintStats();
+
+#endif // API_CONNECTION_H
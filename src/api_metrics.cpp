@@ -0,0 +1,229 @@
+#include "api_metrics.h"
+#include "hal/hal_memory.h"
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+// エンドポイントごとの集計
+struct EndpointMetrics
+{
+    ApiHistogram hist[API_METRIC_COUNT];
+    uint32_t requests;
+    uint32_t failures;
+    uint32_t reused;
+    ApiHeapStats heap;
+};
+
+static EndpointMetrics metrics[API_ENDPOINT_COUNT];
+
+// 記録は複数のワーカータスクから行われる
+static portMUX_TYPE metricsMux = portMUX_INITIALIZER_UNLOCKED;
+
+static const char *const endpointNames[API_ENDPOINT_COUNT] = {"command", "status", "devices"};
+static const char *const metricNames[API_METRIC_COUNT] = {"dns", "connect", "ttfb", "body", "total"};
+
+// 値からバケット番号を求める
+// 0-3 はそのまま、それ以上は最上位ビットの位置と続く2ビットで決める
+static int bucketIndex(uint32_t us)
+{
+    if (us < API_HIST_SUB_BUCKETS)
+        return (int)us;
+
+    int msb = 31 - __builtin_clz(us);
+    int sub = (int)((us >> (msb - 2)) & (API_HIST_SUB_BUCKETS - 1));
+    int index = (msb - 1) * API_HIST_SUB_BUCKETS + sub;
+    return index < API_HIST_BUCKETS ? index : API_HIST_BUCKETS - 1;
+}
+
+// バケットに入る最大値
+static uint32_t bucketUpperBound(int index)
+{
+    if (index < API_HIST_SUB_BUCKETS)
+        return (uint32_t)index;
+
+    int msb = index / API_HIST_SUB_BUCKETS + 1;
+    int sub = index % API_HIST_SUB_BUCKETS;
+    uint64_t lower = ((uint64_t)(API_HIST_SUB_BUCKETS + sub)) << (msb - 2);
+    uint64_t upper = lower + (1ULL << (msb - 2)) - 1;
+    return upper > 0xFFFFFFFFULL ? 0xFFFFFFFF : (uint32_t)upper;
+}
+
+static void addSample(ApiHistogram &hist, uint32_t us)
+{
+    hist.counts[bucketIndex(us)]++;
+    hist.samples++;
+    if (us > hist.maxUs)
+        hist.maxUs = us;
+}
+
+static uint32_t percentileOf(const ApiHistogram &hist, int percent)
+{
+    if (hist.samples == 0)
+        return 0;
+
+    // 小さい方から数えて percent% 番目のサンプルを含むバケット
+    uint64_t rank = ((uint64_t)hist.samples * percent + 99) / 100;
+    if (rank == 0)
+        rank = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < API_HIST_BUCKETS; i++)
+    {
+        seen += hist.counts[i];
+        if (seen >= rank)
+        {
+            // 最後のバケットは上限なし
+            if (i == API_HIST_BUCKETS - 1)
+                return hist.maxUs;
+            return min(bucketUpperBound(i), hist.maxUs);
+        }
+    }
+    return hist.maxUs;
+}
+
+void apiMetricsRecord(ApiEndpoint endpoint, const HalHttpTiming &timing, uint32_t totalUs, bool success)
+{
+    if (endpoint < 0 || endpoint >= API_ENDPOINT_COUNT)
+        return;
+
+    portENTER_CRITICAL(&metricsMux);
+    EndpointMetrics &m = metrics[endpoint];
+    m.requests++;
+    if (!success)
+        m.failures++;
+    if (timing.reused)
+    {
+        m.reused++;
+    }
+    else
+    {
+        // 名前解決・接続は新規接続のときだけ記録する（再利用時の0で分布を薄めない）
+        addSample(m.hist[HAL_HTTP_PHASE_DNS], timing.phaseUs[HAL_HTTP_PHASE_DNS]);
+        addSample(m.hist[HAL_HTTP_PHASE_CONNECT], timing.phaseUs[HAL_HTTP_PHASE_CONNECT]);
+    }
+    addSample(m.hist[HAL_HTTP_PHASE_TTFB], timing.phaseUs[HAL_HTTP_PHASE_TTFB]);
+    addSample(m.hist[HAL_HTTP_PHASE_BODY], timing.phaseUs[HAL_HTTP_PHASE_BODY]);
+    addSample(m.hist[API_METRIC_TOTAL], totalUs);
+    portEXIT_CRITICAL(&metricsMux);
+}
+
+void apiMetricsHeapBegin(ApiHeapProbe &probe)
+{
+    probe.perTask = halHeapTaskCounts(probe.allocs, probe.frees);
+    probe.blocks = halHeapInfo().allocatedBlocks;
+}
+
+void apiMetricsHeapEnd(ApiEndpoint endpoint, const ApiHeapProbe &probe)
+{
+    if (endpoint < 0 || endpoint >= API_ENDPOINT_COUNT)
+        return;
+
+    uint32_t allocs = 0;
+    int32_t net;
+    ApiHeapProbe end;
+    apiMetricsHeapBegin(end);
+    if (probe.perTask)
+    {
+        allocs = end.allocs - probe.allocs;
+        net = (int32_t)allocs - (int32_t)(end.frees - probe.frees);
+    }
+    else
+    {
+        net = (int32_t)(end.blocks - probe.blocks);
+    }
+
+    portENTER_CRITICAL(&metricsMux);
+    ApiHeapStats &h = metrics[endpoint].heap;
+    h.requests++;
+    h.allocs += allocs;
+    if (allocs > h.maxAllocs)
+        h.maxAllocs = allocs;
+    h.net += net;
+    portEXIT_CRITICAL(&metricsMux);
+}
+
+ApiHeapStats apiMetricsHeapStats(ApiEndpoint endpoint)
+{
+    ApiHeapStats copy = {};
+    if (endpoint < 0 || endpoint >= API_ENDPOINT_COUNT)
+        return copy;
+
+    portENTER_CRITICAL(&metricsMux);
+    copy = metrics[endpoint].heap;
+    portEXIT_CRITICAL(&metricsMux);
+    return copy;
+}
+
+ApiHistogram apiMetricsHistogram(ApiEndpoint endpoint, int metric)
+{
+    ApiHistogram copy = {};
+    if (endpoint < 0 || endpoint >= API_ENDPOINT_COUNT || metric < 0 || metric >= API_METRIC_COUNT)
+        return copy;
+
+    portENTER_CRITICAL(&metricsMux);
+    copy = metrics[endpoint].hist[metric];
+    portEXIT_CRITICAL(&metricsMux);
+    return copy;
+}
+
+uint32_t apiMetricsPercentile(ApiEndpoint endpoint, int metric, int percent)
+{
+    ApiHistogram hist = apiMetricsHistogram(endpoint, metric);
+    return percentileOf(hist, percent);
+}
+
+void apiMetricsReset()
+{
+    portENTER_CRITICAL(&metricsMux);
+    memset(metrics, 0, sizeof(metrics));
+    portEXIT_CRITICAL(&metricsMux);
+}
+
+void apiMetricsPrint()
+{
+    // 1行1段階: "lat <endpoint> <phase> n=<件数> p50/p95/p99/max=<ミリ秒>"
+    for (int e = 0; e < API_ENDPOINT_COUNT; e++)
+    {
+        portENTER_CRITICAL(&metricsMux);
+        uint32_t requests = metrics[e].requests;
+        uint32_t failures = metrics[e].failures;
+        uint32_t reused = metrics[e].reused;
+        portEXIT_CRITICAL(&metricsMux);
+
+        Serial.printf("lat %s requests=%lu failed=%lu reused=%lu\n", endpointNames[e], (unsigned long)requests,
+                      (unsigned long)failures, (unsigned long)reused);
+
+        for (int m = 0; m < API_METRIC_COUNT; m++)
+        {
+            ApiHistogram hist = apiMetricsHistogram((ApiEndpoint)e, m);
+            if (hist.samples == 0)
+                continue;
+
+            Serial.printf("lat %s %s n=%lu p50/p95/p99/max=%.1f/%.1f/%.1f/%.1fms\n", endpointNames[e],
+                          metricNames[m], (unsigned long)hist.samples, percentileOf(hist, 50) / 1000.0f,
+                          percentileOf(hist, 95) / 1000.0f, percentileOf(hist, 99) / 1000.0f,
+                          hist.maxUs / 1000.0f);
+        }
+    }
+}
+
+void apiMetricsPrintHeap()
+{
+    // 断片化: 空きのうち一度に確保できない割合
+    HalHeapInfo info = halHeapInfo();
+    float fragmentation = info.freeBytes > 0 ? 100.0f * (1.0f - (float)info.largestFreeBlock / info.freeBytes) : 0.0f;
+    Serial.printf("Heap: free=%lu largest=%lu min=%lu blocks=%lu frag=%.1f%%\n", (unsigned long)info.freeBytes,
+                  (unsigned long)info.largestFreeBlock, (unsigned long)info.minFreeBytes,
+                  (unsigned long)info.allocatedBlocks, fragmentation);
+
+    // 1行1エンドポイント: "heap <endpoint> requests=<件数> allocs/req=<平均> max=<最大> net=<残ったブロック数>"
+    for (int e = 0; e < API_ENDPOINT_COUNT; e++)
+    {
+        ApiHeapStats h = apiMetricsHeapStats((ApiEndpoint)e);
+        if (h.requests == 0)
+            continue;
+        Serial.printf("heap %s requests=%lu allocs/req=%.2f max=%lu net=%ld\n", endpointNames[e],
+                      (unsigned long)h.requests, (double)h.allocs / h.requests, (unsigned long)h.maxAllocs,
+                      (long)h.net);
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef API_METRICS_H
+#define API_METRICS_H
+
+#include <stdint.h>
+#include "hal/hal_http.h"
+
+// 計測対象のエンドポイント
+enum ApiEndpoint
+{
+    API_ENDPOINT_COMMAND, // POST /devices/{id}/commands
+    API_ENDPOINT_STATUS,  // GET /devices/{id}/status
+    API_ENDPOINT_DEVICES, // GET /devices
+    API_ENDPOINT_COUNT
+};
+
+// ヒストグラムを持つ段階（HalHttpPhase に全体を加えたもの）
+#define API_METRIC_TOTAL HAL_HTTP_PHASE_COUNT // 署名からレスポンス解析までの全体
+#define API_METRIC_COUNT (HAL_HTTP_PHASE_COUNT + 1)
+
+// 対数バケット: 2倍ごとに4分割（相対誤差25%以内）、1us〜約134秒
+#define API_HIST_SUB_BUCKETS 4
+#define API_HIST_BUCKETS 104
+
+// 1段階分のヒストグラム
+struct ApiHistogram
+{
+    uint32_t counts[API_HIST_BUCKETS];
+    uint32_t samples;
+    uint32_t maxUs;
+};
+
+// 1リクエストの間のヒープの確保の計測（apiMetricsHeapBegin で始め、apiMetricsHeapEnd で記録する）
+// タスクごとに数えられる環境（ホスト）はそのタスクの確保・解放の回数、
+// 実機は確保中のブロック数の増減（他のタスクの分も含む目安）
+struct ApiHeapProbe
+{
+    uint32_t allocs;
+    uint32_t frees;
+    uint32_t blocks;
+    bool perTask;
+};
+
+// エンドポイントごとのヒープの確保
+struct ApiHeapStats
+{
+    uint32_t requests;  // 計測したリクエスト数
+    uint32_t allocs;    // 確保の回数の合計（実機は 0）
+    uint32_t maxAllocs; // 1リクエストの確保の回数の最大
+    int32_t net;        // 確保したまま残ったブロック数の合計（0 であること）
+};
+
+// 1リクエスト分の計測値を記録（複数タスクから呼び出し可、ヒープは使わない）
+// totalUs: リクエスト全体の所要時間
+void apiMetricsRecord(ApiEndpoint endpoint, const HalHttpTiming &timing, uint32_t totalUs, bool success);
+
+// 1リクエストの間のヒープの確保を計測（呼び出したタスクで Begin と End を呼ぶ）
+void apiMetricsHeapBegin(ApiHeapProbe &probe);
+void apiMetricsHeapEnd(ApiEndpoint endpoint, const ApiHeapProbe &probe);
+
+// エンドポイントごとのヒープの確保
+ApiHeapStats apiMetricsHeapStats(ApiEndpoint endpoint);
+
+// パーセンタイル値（マイクロ秒、バケットの上端。サンプルがなければ0）
+uint32_t apiMetricsPercentile(ApiEndpoint endpoint, int metric, int percent);
+
+// ヒストグラムのコピーを取得
+ApiHistogram apiMetricsHistogram(ApiEndpoint endpoint, int metric);
+
+// 集計をリセット
+void apiMetricsReset();
+
+// エンドポイント・段階ごとの p50/p95/p99/max をシリアルに出力
+void apiMetricsPrint();
+
+// ヒープの空き・最大ブロック・断片化と、エンドポイントごとの1リクエストあたりの確保をシリアルに出力
+void apiMetricsPrintHeap();
+
+#endif // API_METRICS_H
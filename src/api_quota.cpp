@@ -0,0 +1,153 @@
+#include "api_quota.h"
+#include "hal/hal_clock.h"
+
+#include <Arduino.h>
+#include <time.h>
+
+#define SECONDS_PER_DAY 86400
+
+// 呼び出しは UI スレッドからのみ行う（apiWorkerSubmit と同じ）
+static uint32_t budget = 0;
+static uint32_t reserve = 0;
+static uint32_t currentDay = 0;
+static ApiQuotaStats stats = {};
+
+// 登録済みポーリングの通常時のペース（呼び出し/日）
+static uint32_t pollDemand[API_POLL_SOURCE_COUNT];
+
+static const char *const priorityNames[API_PRIORITY_COUNT] = {"command", "refresh", "background"};
+
+void apiQuotaInit(uint32_t dailyLimit, int panels)
+{
+    budget = dailyLimit / (uint32_t)max(panels, 1);
+    reserve = budget * API_QUOTA_COMMAND_RESERVE_PERCENT / 100;
+    currentDay = 0;
+    memset(&stats, 0, sizeof(stats));
+    memset(pollDemand, 0, sizeof(pollDemand));
+    stats.budget = budget;
+    stats.stretchPercent = 100;
+    stats.peakStretchPercent = 100;
+}
+
+uint32_t apiQuotaNowSec()
+{
+    time_t now = time(nullptr);
+    if (now >= EPOCH_VALID)
+        return (uint32_t)now;
+    return millis() / 1000;
+}
+
+// 日付が変わったら使用回数をリセット
+static void rollDay(uint32_t nowSec)
+{
+    uint32_t day = nowSec / SECONDS_PER_DAY;
+    if (day == currentDay)
+        return;
+
+    currentDay = day;
+    stats.used = 0;
+    memset(stats.usedBy, 0, sizeof(stats.usedBy));
+    stats.peakStretchPercent = stats.stretchPercent;
+}
+
+// コマンド用の予約を除いた、ポーリング・状態取得に使える残り回数
+static uint32_t remainingForPolls()
+{
+    uint32_t commandsUsed = stats.usedBy[API_PRIORITY_COMMAND];
+    uint32_t reserveLeft = commandsUsed < reserve ? reserve - commandsUsed : 0;
+    uint32_t committed = stats.used + reserveLeft;
+    return committed < budget ? budget - committed : 0;
+}
+
+// 消費ペースを見積もる最短の経過時間（日の始めの少ない件数で見積もりが振れないように）
+#define RATE_WINDOW_MIN_SEC 3600
+
+// 現在のポーリング間隔の倍率（%）
+// 今日の残り時間に、コマンド・状態取得をこれまでのペースで使い、ポーリングを通常の間隔で続けた場合の
+// 見込み回数が残りに収まるよう、ポーリングだけを引き延ばす
+static uint32_t stretchPercent(uint32_t nowSec)
+{
+    uint32_t demand = 0;
+    for (int i = 0; i < API_POLL_SOURCE_COUNT; i++)
+        demand += pollDemand[i];
+    if (demand == 0)
+        return 100;
+
+    uint32_t secOfDay = nowSec % SECONDS_PER_DAY;
+    uint32_t secLeft = SECONDS_PER_DAY - secOfDay;
+
+    // ポーリング以外の見込み回数（コマンドは予約分を超えた分だけ）
+    uint32_t nonPoll = stats.usedBy[API_PRIORITY_COMMAND] + stats.usedBy[API_PRIORITY_REFRESH];
+    uint64_t nonPollProjected = (uint64_t)nonPoll * secLeft / max(secOfDay, (uint32_t)RATE_WINDOW_MIN_SEC);
+    uint32_t available = remainingForPolls();
+    uint32_t commandsUsed = stats.usedBy[API_PRIORITY_COMMAND];
+    uint64_t reserveLeft = commandsUsed < reserve ? reserve - commandsUsed : 0;
+    uint64_t nonPollOverReserve = nonPollProjected > reserveLeft ? nonPollProjected - reserveLeft : 0;
+    if (available <= nonPollOverReserve)
+        return API_QUOTA_MAX_STRETCH * 100;
+
+    uint64_t pollProjected = (uint64_t)demand * secLeft / SECONDS_PER_DAY;
+    uint64_t percent = pollProjected * 100 / (available - nonPollOverReserve);
+    if (percent < 100)
+        return 100;
+    if (percent > API_QUOTA_MAX_STRETCH * 100)
+        return API_QUOTA_MAX_STRETCH * 100;
+    return (uint32_t)percent;
+}
+
+bool apiQuotaAcquire(ApiPriority priority, uint32_t nowSec)
+{
+    if (priority < 0 || priority >= API_PRIORITY_COUNT)
+        return false;
+
+    rollDay(nowSec);
+
+    // コマンドは予約分も使えるが、割り当てそのものは超えない
+    bool allowed = (priority == API_PRIORITY_COMMAND) ? stats.used < budget : remainingForPolls() > 0;
+    if (!allowed)
+    {
+        stats.deniedBy[priority]++;
+        return false;
+    }
+
+    stats.used++;
+    stats.usedBy[priority]++;
+    return true;
+}
+
+uint32_t apiQuotaPollInterval(ApiPollSource source, uint32_t baseMs, int callsPerPoll, uint32_t nowSec)
+{
+    if (source < 0 || source >= API_POLL_SOURCE_COUNT || baseMs == 0)
+        return baseMs;
+
+    rollDay(nowSec);
+    pollDemand[source] = (uint32_t)((uint64_t)SECONDS_PER_DAY * 1000 * max(callsPerPoll, 0) / baseMs);
+    return apiQuotaStretch(baseMs, nowSec);
+}
+
+uint32_t apiQuotaStretch(uint32_t baseMs, uint32_t nowSec)
+{
+    rollDay(nowSec);
+    stats.stretchPercent = stretchPercent(nowSec);
+    stats.peakStretchPercent = max(stats.peakStretchPercent, stats.stretchPercent);
+    return (uint32_t)((uint64_t)baseMs * stats.stretchPercent / 100);
+}
+
+ApiQuotaStats apiQuotaGetStats()
+{
+    return stats;
+}
+
+void apiQuotaPrint()
+{
+    Serial.printf("Quota: used=%lu/%lu stretch=%lu%% (peak %lu%%)", (unsigned long)stats.used,
+                  (unsigned long)stats.budget, (unsigned long)stats.stretchPercent,
+                  (unsigned long)stats.peakStretchPercent);
+    for (int i = 0; i < API_PRIORITY_COUNT; i++)
+    {
+        Serial.printf(" %s=%lu", priorityNames[i], (unsigned long)stats.usedBy[i]);
+        if (stats.deniedBy[i] > 0)
+            Serial.printf("(denied %lu)", (unsigned long)stats.deniedBy[i]);
+    }
+    Serial.println();
+}
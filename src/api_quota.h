@@ -0,0 +1,71 @@
+#ifndef API_QUOTA_H
+#define API_QUOTA_H
+
+#include <stdint.h>
+
+// SwitchBot API のトークンあたりの1日の呼び出し上限
+#ifndef API_QUOTA_DAILY_LIMIT
+#define API_QUOTA_DAILY_LIMIT 10000
+#endif
+
+// 同じトークンを使うパネルの台数（上限を均等に分け合う）
+#ifndef API_QUOTA_PANELS
+#define API_QUOTA_PANELS 1
+#endif
+
+// ユーザー操作のコマンド用に確保しておく割合（%）
+#define API_QUOTA_COMMAND_RESERVE_PERCENT 10
+
+// ポーリング間隔を引き延ばす倍率の上限
+#define API_QUOTA_MAX_STRETCH 64
+
+// 呼び出しの優先度
+enum ApiPriority
+{
+    API_PRIORITY_COMMAND,    // ユーザー操作のコマンド（予約分も使える）
+    API_PRIORITY_REFRESH,    // 画面に反映するための状態取得（復帰時・操作後）
+    API_PRIORITY_BACKGROUND, // 定期ポーリング
+    API_PRIORITY_COUNT
+};
+
+// 定期ポーリングの発生源（間隔の引き延ばしの計算に使う）
+enum ApiPollSource
+{
+    API_POLL_METER, // 温湿度計
+    API_POLL_SOURCE_COUNT
+};
+
+// 集計
+struct ApiQuotaStats
+{
+    uint32_t budget;                        // このパネルの1日の割り当て
+    uint32_t used;                          // 今日使った回数
+    uint32_t usedBy[API_PRIORITY_COUNT];    // 優先度ごとの使用回数
+    uint32_t deniedBy[API_PRIORITY_COUNT];  // 優先度ごとの拒否回数
+    uint32_t stretchPercent;                // 現在のポーリング間隔の倍率（%）
+    uint32_t peakStretchPercent;            // 今日の倍率の最大値（%）
+};
+
+// 初期化（dailyLimit をパネル台数で割ったものがこのパネルの割り当て）
+void apiQuotaInit(uint32_t dailyLimit, int panels);
+
+// 現在時刻（UNIX秒、時刻同期前は起動からの秒数）
+uint32_t apiQuotaNowSec();
+
+// 呼び出しを1回使ってよいか判定し、よければ消費する
+// 日付（UTC）が変わると使用回数はリセットされる
+bool apiQuotaAcquire(ApiPriority priority, uint32_t nowSec);
+
+// 定期ポーリングの間隔を求める
+// 登録済みの全ポーリングの呼び出しペースが残りの割り当てに収まるよう、全体を同じ倍率で引き延ばす
+// baseMs: 通常時の間隔, callsPerPoll: 1回のポーリングで使う呼び出し数
+uint32_t apiQuotaPollInterval(ApiPollSource source, uint32_t baseMs, int callsPerPoll, uint32_t nowSec);
+
+// 定期ではない待ち時間（操作後の状態確認など）を同じ倍率で引き延ばす
+uint32_t apiQuotaStretch(uint32_t baseMs, uint32_t nowSec);
+
+// 集計取得・シリアル出力
+ApiQuotaStats apiQuotaGetStats();
+void apiQuotaPrint();
+
+#endif // API_QUOTA_H
@@ -0,0 +1,249 @@
+#include "api_worker.h"
+#include "switchbot_api.h"
+#include "api_quota.h"
+#include "device_discovery.h"
+#include "hal/hal_event.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+#include <atomic>
+
+// ワーカータスク設定（TLSハンドシェイクのためスタックは大きめ）
+#define API_WORKER_STACK_SIZE 12288
+#define API_WORKER_PRIORITY 1
+
+// オフライン中に取り出したジョブを持ったまま接続を待つ間隔
+#define API_WORKER_OFFLINE_POLL_MS 50
+
+// 完了キューに積む要素
+struct ApiCompletion {
+    ApiResult result;
+    ApiCallback callback;
+};
+
+// 待ち行列の1件（seq は投入順、同じ優先度の中では小さい順に取り出す）
+struct PendingJob {
+    ApiJob job;
+    ApiPriority priority;
+    uint32_t seq;
+    bool used;
+};
+
+// 待ち行列と実行中のデバイスID（どちらも jobMux で保護する）
+// コマンドは状態取得より先に取り出すが、同じ優先度の中では投入順を守る
+// 同じデバイスのジョブは1件ずつ実行し、実行中のデバイスのジョブは待ち行列に残す
+static PendingJob pending[API_JOB_QUEUE_LEN];
+static char inFlight[API_WORKER_COUNT][API_DEVICE_ID_LEN];
+static uint32_t nextSeq = 0;
+static portMUX_TYPE jobMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ワーカーを起こす合図（1件の投入・1件の完了ごとに1つ積む、中身は使わない）
+static QueueHandle_t wakeQueue = nullptr;
+static QueueHandle_t completionQueue = nullptr;
+
+// false の間はジョブを実行しない（起動直後の WiFi 接続・時刻同期待ち）
+static std::atomic<bool> online(true);
+
+// 投入数と完了通知数（どちらもUIスレッドからのみ更新）
+static uint32_t submittedCount = 0;
+static uint32_t dispatchedCount = 0;
+
+// ジョブ種別ごとの優先度
+static ApiPriority priorityOf(ApiJobType type) {
+    switch (type) {
+    case API_JOB_BULB_POWER:
+    case API_JOB_BULB_BRIGHTNESS:
+    case API_JOB_BULB_COLOR:
+        return API_PRIORITY_COMMAND;
+    case API_JOB_BULB_STATUS:
+        return API_PRIORITY_REFRESH;
+    default:
+        return API_PRIORITY_BACKGROUND;
+    }
+}
+
+// ジョブを実行して結果を作る
+static void runJob(const ApiJob& job, ApiResult& result) {
+    const char* deviceId = job.deviceId;
+
+    result.type = job.type;
+    result.index = job.index;
+    result.value = job.value;
+    result.success = false;
+    result.powerState = false;
+    result.brightness = 0;
+    result.temperature = 0.0f;
+    result.humidity = 0;
+
+    switch (job.type) {
+    case API_JOB_BULB_POWER:
+        result.success = switchbotBulbPower(deviceId, job.value != 0);
+        break;
+    case API_JOB_BULB_BRIGHTNESS:
+        result.success = switchbotBulbBrightness(deviceId, job.value);
+        break;
+    case API_JOB_BULB_COLOR:
+        result.success = switchbotBulbColor(deviceId, (uint32_t)job.value);
+        break;
+    case API_JOB_BULB_STATUS:
+        result.success = switchbotBulbStatus(deviceId, result.powerState, result.brightness);
+        break;
+    case API_JOB_METER_STATUS:
+        result.success = switchbotMeterStatus(deviceId, result.temperature, result.humidity);
+        break;
+    case API_JOB_DEVICE_LIST: {
+        // 一覧はワーカータスク上でスナップショットに直接書き込む（UIスレッドには変化の有無だけを返す）
+        bool changed = false;
+        result.success = discoveryFetch(changed);
+        result.value = changed ? 1 : 0;
+        break;
+    }
+    }
+}
+
+// ワーカーを1つ起こす（合図が溢れるのは全ワーカーに十分な数が積まれているときなので捨ててよい）
+static void wakeWorker() {
+    uint8_t token = 0;
+    xQueueSend(wakeQueue, &token, 0);
+}
+
+// 実行できるジョブのうち優先度が最も高く最も古いものを取り出し、そのデバイスを実行中にする（jobMux を取ってから呼ぶ）
+// 戻り値: 取り出せた=true（待ち行列が空か、残りが全て実行中のデバイスのジョブなら false）
+static bool takeNextJob(int worker, ApiJob& job) {
+    int best = -1;
+    for (int i = 0; i < API_JOB_QUEUE_LEN; i++) {
+        if (!pending[i].used) continue;
+        bool busy = false;
+        for (int w = 0; w < API_WORKER_COUNT && !busy; w++) {
+            busy = strcmp(inFlight[w], pending[i].job.deviceId) == 0;
+        }
+        if (busy) continue;
+        if (best < 0 || pending[i].priority < pending[best].priority ||
+            (pending[i].priority == pending[best].priority && (int32_t)(pending[i].seq - pending[best].seq) < 0)) {
+            best = i;
+        }
+    }
+    if (best < 0) return false;
+
+    job = pending[best].job;
+    pending[best].used = false;
+    memcpy(inFlight[worker], job.deviceId, API_DEVICE_ID_LEN);
+    return true;
+}
+
+// ネットワークワーカータスク本体
+static void workerTask(void* arg) {
+    int worker = (int)(intptr_t)arg;
+    uint8_t token;
+    ApiJob job;
+    ApiCompletion completion;
+
+    for (;;) {
+        if (xQueueReceive(wakeQueue, &token, portMAX_DELAY) != pdTRUE) continue;
+
+        // 接続を待つ間、ジョブは待ち行列に残る（接続後もコマンドから投入順に送られる）
+        while (!online.load()) {
+            vTaskDelay(pdMS_TO_TICKS(API_WORKER_OFFLINE_POLL_MS));
+        }
+
+        portENTER_CRITICAL(&jobMux);
+        bool taken = takeNextJob(worker, job);
+        portEXIT_CRITICAL(&jobMux);
+        // 残りが実行中のデバイスのジョブだけなら、そのジョブの完了の合図で起こされる
+        if (!taken) continue;
+
+        runJob(job, completion.result);
+        completion.callback = job.callback;
+
+        portENTER_CRITICAL(&jobMux);
+        inFlight[worker][0] = '\0';
+        portEXIT_CRITICAL(&jobMux);
+        // 同じデバイスの次のジョブが実行できるようになったので、別のワーカーも起こす
+        wakeWorker();
+
+        xQueueSend(completionQueue, &completion, portMAX_DELAY);
+        halEventSignal(HAL_EVENT_NETWORK);
+    }
+}
+
+void apiWorkerInit() {
+    if (wakeQueue != nullptr) return;
+
+    wakeQueue = xQueueCreate(API_JOB_QUEUE_LEN + API_WORKER_COUNT, sizeof(uint8_t));
+    completionQueue = xQueueCreate(API_JOB_QUEUE_LEN + API_WORKER_COUNT, sizeof(ApiCompletion));
+
+    // 全ワーカーが同じ待ち行列から取り出すので、別のデバイスのジョブは最大 API_WORKER_COUNT 件並列に実行される
+    for (int i = 0; i < API_WORKER_COUNT; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "api_worker%d", i);
+        xTaskCreate(workerTask, name, API_WORKER_STACK_SIZE, (void*)(intptr_t)i, API_WORKER_PRIORITY, nullptr);
+    }
+}
+
+bool apiWorkerSubmit(ApiJobType type, const char* deviceId, int index, int value, ApiCallback callback) {
+    if (wakeQueue == nullptr || deviceId == nullptr || deviceId[0] == '\0') return false;
+
+    // UIスレッドは待たない（投入できないジョブで割り当てを消費しないよう先に空きを確認）
+    // 待ち行列から取り除くのはワーカーだけなので、ここで見つけた空きは投入まで空いたまま
+    int slot = -1;
+    portENTER_CRITICAL(&jobMux);
+    for (int i = 0; i < API_JOB_QUEUE_LEN && slot < 0; i++) {
+        if (!pending[i].used) slot = i;
+    }
+    portEXIT_CRITICAL(&jobMux);
+    if (slot < 0) {
+        Serial.printf("API queue full, dropped job type=%d index=%d\n", (int)type, index);
+        return false;
+    }
+
+    // 割り当て超過の拒否は api_quota の統計に残る（呼び出し元が毎ループ再試行するのでログは出さない）
+    ApiPriority priority = priorityOf(type);
+    if (!apiQuotaAcquire(priority, apiQuotaNowSec())) {
+        return false;
+    }
+
+    PendingJob& entry = pending[slot];
+    portENTER_CRITICAL(&jobMux);
+    entry.job.type = type;
+    entry.job.index = index;
+    entry.job.value = value;
+    strncpy(entry.job.deviceId, deviceId, sizeof(entry.job.deviceId) - 1);
+    entry.job.deviceId[sizeof(entry.job.deviceId) - 1] = '\0';
+    entry.job.callback = callback;
+    entry.priority = priority;
+    entry.seq = nextSeq++;
+    entry.used = true;
+    portEXIT_CRITICAL(&jobMux);
+
+    wakeWorker();
+    submittedCount++;
+    return true;
+}
+
+int apiWorkerDispatch(int maxResults) {
+    if (completionQueue == nullptr) return 0;
+
+    ApiCompletion completion;
+    int count = 0;
+    while (count < maxResults && xQueueReceive(completionQueue, &completion, 0) == pdTRUE) {
+        dispatchedCount++;
+        count++;
+        if (completion.callback != nullptr) {
+            completion.callback(completion.result);
+        }
+    }
+    return count;
+}
+
+int apiWorkerPending() {
+    return (int)(submittedCount - dispatchedCount);
+}
+
+void apiWorkerSetOnline(bool isOnline) {
+    online.store(isOnline);
+}
+
+bool apiWorkerOnline() {
+    return online.load();
+}
@@ -0,0 +1,81 @@
+#ifndef API_WORKER_H
+#define API_WORKER_H
+
+#include <Arduino.h>
+#include "hal/hal_http.h"
+
+// 並列に動かすワーカータスク数（同時リクエスト数が上限）
+#ifndef API_WORKER_COUNT
+#define API_WORKER_COUNT HAL_HTTP_MAX_CONCURRENT
+#endif
+
+#if API_WORKER_COUNT > HAL_HTTP_MAX_CONCURRENT
+#error "API_WORKER_COUNT must not exceed HAL_HTTP_MAX_CONCURRENT"
+#endif
+
+// ジョブの待ち行列の長さ（実行中のジョブは含まない）
+#define API_JOB_QUEUE_LEN 16
+
+// デバイスIDの最大長（終端含む）
+#define API_DEVICE_ID_LEN 24
+
+// ジョブ種別
+enum ApiJobType
+{
+    API_JOB_BULB_POWER,      // 電球ON/OFF（value: 1=ON, 0=OFF）
+    API_JOB_BULB_BRIGHTNESS, // 電球の明るさ（value: 1-100）
+    API_JOB_BULB_COLOR,      // 電球の色（value: 0xRRGGBB）
+    API_JOB_BULB_STATUS,     // 電球のステータス取得
+    API_JOB_METER_STATUS,    // 温湿度計のステータス取得
+    API_JOB_DEVICE_LIST      // デバイス一覧の取得（device_discovery、結果の value: 1=一覧が変わった）
+};
+
+// ジョブ完了結果
+struct ApiResult
+{
+    ApiJobType type;
+    int index;         // 投入時に指定したデバイスインデックス
+    int value;         // 投入時に指定した値
+    bool success;      // 成功=true, 失敗=false
+    bool powerState;   // API_JOB_BULB_STATUS の結果
+    int brightness;    // API_JOB_BULB_STATUS の結果
+    float temperature; // API_JOB_METER_STATUS の結果
+    int humidity;      // API_JOB_METER_STATUS の結果
+};
+
+// 完了コールバック（apiWorkerDispatch を呼んだスレッド＝UIスレッドで実行される）
+typedef void (*ApiCallback)(const ApiResult& result);
+
+// ワーカーに投入するジョブ
+struct ApiJob
+{
+    ApiJobType type;
+    int index;
+    int value;
+    char deviceId[API_DEVICE_ID_LEN];
+    ApiCallback callback;
+};
+
+// ネットワークワーカータスク起動（switchbotApiInit の後に呼ぶ）
+void apiWorkerInit();
+
+// ジョブ投入（ブロックしない、UIスレッドから呼ぶ）
+// コマンド・状態取得・定期ポーリングの順に実行し、同じ優先度の中では投入順に実行する
+// 同じデバイスID のジョブは並列に実行せず、前のジョブが終わってから次を実行する
+// 呼び出し回数の割り当て（api_quota）を超える場合は投入しない
+// 戻り値: 投入できた=true, IDが空・キューが満杯・割り当て超過=false
+bool apiWorkerSubmit(ApiJobType type, const char* deviceId, int index, int value, ApiCallback callback);
+
+// 完了したジョブのコールバックを最大 maxResults 件実行
+// 戻り値: 実行した件数
+int apiWorkerDispatch(int maxResults);
+
+// 未完了ジョブ数（キュー待ち＋実行中）
+int apiWorkerPending();
+
+// ネットワークが使えるか（false の間に投入したジョブは実行せずに溜め、true になってから送る）
+// 既定は true。起動直後は WiFi 接続と時刻同期が済むまで false にしておく
+void apiWorkerSetOnline(bool online);
+bool apiWorkerOnline();
+
+#endif // API_WORKER_H
@@ -0,0 +1,150 @@
+#include "boot.h"
+#include "api_worker.h"
+#include "hal/hal_network.h"
+
+static BootPhase phase = BOOT_ONLINE;
+static BootStats stats = {};
+static BootOnlineCallback onlineCallback = nullptr;
+static bool begun = false;
+static unsigned long connectStartTime = 0;
+static bool connectFailed = false;
+static bool reported = false;
+
+// 計測点を記録（0 は未記録を表すので、起動直後でも 1 以上にする）
+static void notePoint(uint32_t &point)
+{
+    if (point == 0)
+    {
+        uint32_t now = millis();
+        point = (now > 0) ? now : 1;
+    }
+}
+
+void bootBegin(BootOnlineCallback onOnline)
+{
+    onlineCallback = onOnline;
+    begun = true;
+    phase = BOOT_CONNECTING;
+    connectStartTime = millis();
+    connectFailed = false;
+
+    // ジョブは投入できるが、実行はオンラインになってから
+    apiWorkerSetOnline(false);
+    halNetworkBegin();
+}
+
+void bootNoteRestored(int count)
+{
+    stats.restored = count;
+}
+
+void bootNoteFirstFrame()
+{
+    notePoint(stats.firstFrameMs);
+}
+
+void bootNoteInteractive()
+{
+    notePoint(stats.interactiveMs);
+}
+
+void bootNoteStatusDone()
+{
+    if (phase != BOOT_ONLINE || stats.onlineMs == 0 || stats.statusMs != 0)
+        return;
+    notePoint(stats.statusMs);
+    if (!reported)
+    {
+        reported = true;
+        bootPrint();
+    }
+}
+
+void bootService(unsigned long now)
+{
+    switch (phase)
+    {
+    case BOOT_CONNECTING:
+        if (halNetworkConnected())
+        {
+            notePoint(stats.connectedMs);
+            Serial.printf("WiFi connected (%lu ms)\n", (unsigned long)(now - connectStartTime));
+            connectFailed = false;
+            phase = BOOT_TIME_SYNC;
+        }
+        else if (now - connectStartTime >= BOOT_WIFI_RETRY_MS)
+        {
+            // 画面はそのまま使えるので止めずに接続をやり直す
+            Serial.println("WiFi connection failed, retrying");
+            connectFailed = true;
+            connectStartTime = now;
+            stats.retries++;
+            halNetworkReconnect();
+        }
+        break;
+
+    case BOOT_TIME_SYNC:
+        if (!halNetworkConnected())
+        {
+            phase = BOOT_CONNECTING;
+            connectStartTime = now;
+        }
+        else if (halNetworkTimeSynced())
+        {
+            notePoint(stats.timeSyncedMs);
+            if (stats.onlineMs == 0)
+                stats.queuedAtOnline = apiWorkerPending();
+            notePoint(stats.onlineMs);
+            phase = BOOT_ONLINE;
+            apiWorkerSetOnline(true);
+            Serial.printf("Online: %d queued jobs\n", apiWorkerPending());
+            if (onlineCallback != nullptr)
+                onlineCallback();
+        }
+        break;
+
+    case BOOT_ONLINE:
+        // 切断されたら再接続まで新しいジョブを溜める
+        if (begun && !halNetworkConnected())
+        {
+            Serial.println("WiFi disconnected");
+            apiWorkerSetOnline(false);
+            phase = BOOT_CONNECTING;
+            connectStartTime = now;
+        }
+        break;
+    }
+}
+
+BootPhase bootPhase()
+{
+    return phase;
+}
+
+const char *bootStatusText()
+{
+    switch (phase)
+    {
+    case BOOT_CONNECTING:
+        return connectFailed ? "WiFi failed, retrying" : "Connecting WiFi...";
+    case BOOT_TIME_SYNC:
+        return "Syncing time...";
+    default:
+        return "SwitchBot Controller";
+    }
+}
+
+BootStats bootGetStats()
+{
+    return stats;
+}
+
+void bootPrint()
+{
+    // 1行: "boot ttff=<最初の表示> tti=<タッチ受付> wifi=... ntp=... online=... status=...（起動からのミリ秒）"
+    Serial.printf("boot ttff=%lums tti=%lums wifi=%lums ntp=%lums online=%lums status=%lums restored=%d "
+                  "queued=%d retries=%lu\n",
+                  (unsigned long)stats.firstFrameMs, (unsigned long)stats.interactiveMs,
+                  (unsigned long)stats.connectedMs, (unsigned long)stats.timeSyncedMs, (unsigned long)stats.onlineMs,
+                  (unsigned long)stats.statusMs, stats.restored, stats.queuedAtOnline, (unsigned long)stats.retries);
+}
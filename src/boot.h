@@ -0,0 +1,60 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <Arduino.h>
+
+// WiFi に接続できないまま再接続を試みるまでの時間
+#define BOOT_WIFI_RETRY_MS 30000
+
+// 接続・時刻同期を待つ間に状態を確かめる間隔
+#define BOOT_POLL_MS 100
+
+// 起動の段階
+enum BootPhase
+{
+    BOOT_CONNECTING, // WiFi接続待ち（コマンドは溜めておく）
+    BOOT_TIME_SYNC,  // NTP 時刻同期待ち（署名のタイムスタンプに必要）
+    BOOT_ONLINE      // API を呼べる
+};
+
+// 起動の計測結果（起動＝リセットからのミリ秒、まだなら 0）
+struct BootStats
+{
+    uint32_t firstFrameMs;  // 最初の画面表示（前回の状態でパネル全体を描画）
+    uint32_t interactiveMs; // タッチを受け付け始めた（setup 完了）
+    uint32_t connectedMs;   // WiFi接続
+    uint32_t timeSyncedMs;  // 時刻同期
+    uint32_t onlineMs;      // 溜めていたコマンドの送信開始
+    uint32_t statusMs;      // 表示中のページの状態を API から取得し終えた
+    int restored;           // フラッシュから状態を戻した電球の数
+    int queuedAtOnline;     // 接続待ちの間に溜まったジョブ数
+    uint32_t retries;       // WiFi の再接続を試みた回数
+};
+
+// オンラインになったとき（再接続を含む）に呼ばれる（UIスレッド）
+typedef void (*BootOnlineCallback)();
+
+// WiFi接続・時刻同期をバックグラウンドで開始し、それまで API ワーカーを止めておく
+void bootBegin(BootOnlineCallback onOnline);
+
+// 計測点の記録（最初の1回だけ記録）
+void bootNoteRestored(int count);
+void bootNoteFirstFrame();
+void bootNoteInteractive();
+void bootNoteStatusDone();
+
+// 接続・時刻同期の進み具合を確認（毎ループ呼ぶ）
+void bootService(unsigned long now);
+
+// 現在の段階（bootBegin の前は BOOT_ONLINE）
+BootPhase bootPhase();
+
+// ヘッダーに出す接続状態（オンラインならアプリ名）
+const char *bootStatusText();
+
+BootStats bootGetStats();
+
+// シリアルに1行で出力
+void bootPrint();
+
+#endif // BOOT_H
@@ -0,0 +1,361 @@
+#include "command_coalescer.h"
+#include "command_log.h"
+
+#include <time.h>
+
+static CoalesceSlot slots[REGISTRY_MAX_BULBS];
+static CoalesceStats stats = {0, 0, 0, 0};
+static ApiCallback resultCallback = nullptr;
+static CoalesceHoldFn holdCallback = nullptr;
+
+static void onCommandDone(const ApiResult &result);
+
+// 記録した指示をあきらめたことを通知する（UI は画面を実際の状態に合わせる）
+static void notifyFailed(int index, const CommandEntry &entry)
+{
+    if (resultCallback == nullptr)
+        return;
+
+    ApiResult result = {};
+    result.type = entry.type;
+    result.index = index;
+    result.value = entry.value;
+    result.success = false;
+    resultCallback(result);
+}
+
+// この電球の記録した指示を古い順に1つ送信
+// 戻り値: 記録した指示がある（送った・送り直しを待っている）=true
+static bool flushLogged(int index, unsigned long now)
+{
+    CoalesceSlot &slot = slots[index];
+    const CommandEntry *entry;
+    while ((entry = commandLogFirst(bulbs.deviceId[index])) != nullptr)
+    {
+        // 古すぎる指示はあきらめる、確認済みの値と同じ指示は送らない
+        if (commandLogExpired(*entry, (uint32_t)time(nullptr)))
+        {
+            CommandEntry expired = *entry;
+            commandLogDrop(expired.seq, true);
+            Serial.printf("Command expired: bulb %d (type=%d, value=%d)\n", index, (int)expired.type, expired.value);
+            notifyFailed(index, expired);
+            continue;
+        }
+        if (coalescerConfirmed(index, entry->type, entry->value))
+        {
+            commandLogDrop(entry->seq, false);
+            stats.skipped++;
+            continue;
+        }
+
+        // 送り直しの時刻まで、この電球の新しい指示も待たせる（記録した順に届ける）
+        if ((long)(now - entry->retryAt) < 0)
+            return true;
+
+        // キューが満杯なら記録したまま次のループで再試行
+        if (!apiWorkerSubmit(entry->type, bulbs.deviceId[index], index, entry->value, onCommandDone))
+            return true;
+
+        slot.inFlight = true;
+        slot.inFlightSeq = entry->seq;
+        slot.lastSent = now;
+        stats.sent++;
+        commandLogNoteSent(entry->seq);
+        return true;
+    }
+    return false;
+}
+
+// 保留中の指示を1つ送信（記録した指示を古い順に、次に保留スロットの電源・明るさ）
+static void flushSlot(int index, unsigned long now)
+{
+    CoalesceSlot &slot = slots[index];
+    if (slot.inFlight)
+        return;
+    // シーンなどが送り終えるまで待たせる（指示は記録・保留スロットに残る）
+    if (holdCallback != nullptr && holdCallback(index))
+        return;
+    if (flushLogged(index, now))
+        return;
+
+    // 送信済みの値と同じ指示は送らない
+    if (slot.pendingPower >= 0 && slot.pendingPower == slot.sentPower)
+    {
+        slot.pendingPower = -1;
+        stats.skipped++;
+    }
+    if (slot.pendingBrightness >= 0 && slot.pendingBrightness == slot.sentBrightness)
+    {
+        slot.pendingBrightness = -1;
+        stats.skipped++;
+    }
+
+    ApiJobType type;
+    int value;
+    if (slot.pendingPower >= 0)
+    {
+        type = API_JOB_BULB_POWER;
+        value = slot.pendingPower;
+    }
+    else if (slot.pendingBrightness >= 0)
+    {
+        // ドラッグ中の中間値は送信間隔を空ける
+        if (!slot.pendingFinal && now - slot.lastSent < COALESCE_STREAM_INTERVAL_MS)
+            return;
+        type = API_JOB_BULB_BRIGHTNESS;
+        value = slot.pendingBrightness;
+    }
+    else
+    {
+        return;
+    }
+
+    // キューが満杯なら保留のまま次のループで再試行
+    if (!apiWorkerSubmit(type, bulbs.deviceId[index], index, value, onCommandDone))
+        return;
+
+    if (type == API_JOB_BULB_POWER)
+        slot.pendingPower = -1;
+    else
+        slot.pendingBrightness = -1;
+    slot.inFlight = true;
+    slot.inFlightSeq = 0;
+    slot.lastSent = now;
+    stats.sent++;
+}
+
+// コマンド完了（UIスレッドで呼ばれる）
+static void onCommandDone(const ApiResult &result)
+{
+    if (result.index < 0 || result.index >= bulbs.count)
+        return;
+
+    CoalesceSlot &slot = slots[result.index];
+    uint32_t seq = slot.inFlightSeq;
+    slot.inFlight = false;
+    slot.inFlightSeq = 0;
+    coalescerNoteSent(result.index, result.type, result.value, result.success);
+
+    // 記録した指示の失敗は間隔を空けて送り直す（あきらめるまで UI には知らせない）
+    bool notify = true;
+    if (seq != 0)
+    {
+        CommandOutcome outcome = commandLogNoteResult(seq, result.success, millis());
+        if (outcome == COMMAND_RETRY)
+        {
+            stats.retries++;
+            notify = false;
+            Serial.printf("Command retry: bulb %d (type=%d, value=%d)\n", result.index, (int)result.type,
+                          result.value);
+        }
+        else if (outcome == COMMAND_SUPERSEDED && !result.success)
+        {
+            // 新しい指示がこの後に送られる
+            notify = false;
+        }
+    }
+
+    if (notify && resultCallback != nullptr)
+        resultCallback(result);
+
+    // 送信中に溜まった最新の指示を続けて送る
+    flushSlot(result.index, millis());
+}
+
+void coalescerInit(ApiCallback onResult)
+{
+    resultCallback = onResult;
+    for (int i = 0; i < REGISTRY_MAX_BULBS; i++)
+    {
+        slots[i].inFlight = false;
+        slots[i].pendingPower = -1;
+        slots[i].pendingBrightness = -1;
+        slots[i].pendingFinal = true;
+        slots[i].sentPower = -1;
+        slots[i].sentBrightness = -1;
+        slots[i].lastSent = 0;
+        slots[i].inFlightSeq = 0;
+    }
+}
+
+int coalescerRestore()
+{
+    int restored = commandLogRestore();
+    for (int i = 0; i < commandLogCount(); i++)
+    {
+        const CommandEntry &entry = commandLogEntry(i);
+        int index = registryFindBulb(entry.deviceId);
+        if (index < 0)
+            continue;
+        if (entry.type == API_JOB_BULB_POWER)
+            bulbs.powerState[index] = entry.value != 0;
+        else
+            bulbs.brightness[index] = constrain(entry.value, 1, 100);
+    }
+    return restored;
+}
+
+void coalescerSetPower(int index, bool on)
+{
+    if (index < 0 || index >= bulbs.count)
+        return;
+
+    stats.intents++;
+    // 記録できなければ（満杯）保留スロットから送る
+    unsigned long now = millis();
+    if (commandLogAppend(bulbs.deviceId[index], API_JOB_BULB_POWER, on ? 1 : 0, now) != 0)
+        slots[index].pendingPower = -1;
+    else
+        slots[index].pendingPower = on ? 1 : 0;
+    flushSlot(index, now);
+}
+
+void coalescerSetBrightness(int index, int brightness, bool final)
+{
+    if (index < 0 || index >= bulbs.count)
+        return;
+
+    stats.intents++;
+    unsigned long now = millis();
+    brightness = constrain(brightness, 1, 100);
+    if (final && commandLogAppend(bulbs.deviceId[index], API_JOB_BULB_BRIGHTNESS, brightness, now) != 0)
+    {
+        slots[index].pendingBrightness = -1;
+        slots[index].pendingFinal = true;
+    }
+    else
+    {
+        slots[index].pendingBrightness = brightness;
+        slots[index].pendingFinal = final;
+    }
+    flushSlot(index, now);
+}
+
+void coalescerSetHold(CoalesceHoldFn held)
+{
+    holdCallback = held;
+}
+
+void coalescerService(unsigned long now)
+{
+    // 記録した指示を古い順に（登録簿にない電球の指示はあきらめる）
+    for (int i = 0; i < commandLogCount();)
+    {
+        const CommandEntry &entry = commandLogEntry(i);
+        int index = registryFindBulb(entry.deviceId);
+        if (index < 0)
+        {
+            commandLogDrop(entry.seq, true);
+            continue;
+        }
+        flushSlot(index, now);
+        i++;
+    }
+
+    for (int i = 0; i < bulbs.count; i++)
+    {
+        flushSlot(i, now);
+    }
+
+    // 記録の追加・削除があればまとめてフラッシュに残す
+    commandLogSave(now);
+}
+
+bool coalescerNextService(unsigned long now, unsigned long &at)
+{
+    // 記録の書き込み
+    bool found = commandLogNextSave(at);
+
+    // 記録した指示は電球ごとに最も古いものの送り直しの時刻
+    for (int i = 0; i < commandLogCount(); i++)
+    {
+        const CommandEntry &entry = commandLogEntry(i);
+        int index = registryFindBulb(entry.deviceId);
+        if (index < 0 || slots[index].inFlight || commandLogFirst(entry.deviceId) != &entry)
+            continue;
+        if (holdCallback != nullptr && holdCallback(index))
+            continue;
+
+        unsigned long entryAt = (long)(entry.retryAt - now) > 0 ? entry.retryAt : now;
+        if (!found || (long)(entryAt - at) < 0)
+            at = entryAt;
+        found = true;
+    }
+
+    for (int i = 0; i < bulbs.count; i++)
+    {
+        // 送信中のスロットは完了時に続けて送る、記録した指示がある電球は上で見た時刻
+        const CoalesceSlot &slot = slots[i];
+        if (slot.inFlight || (slot.pendingPower < 0 && slot.pendingBrightness < 0) ||
+            commandLogFirst(bulbs.deviceId[i]) != nullptr)
+            continue;
+        if (holdCallback != nullptr && holdCallback(i))
+            continue;
+
+        unsigned long slotAt = now;
+        if (slot.pendingPower < 0 && !slot.pendingFinal)
+            slotAt = slot.lastSent + COALESCE_STREAM_INTERVAL_MS;
+        if (!found || (long)(slotAt - at) < 0)
+            at = slotAt;
+        found = true;
+    }
+    return found;
+}
+
+void coalescerNoteStatus(int index, bool powerState, int brightness)
+{
+    if (index < 0 || index >= bulbs.count)
+        return;
+
+    slots[index].sentPower = powerState ? 1 : 0;
+    slots[index].sentBrightness = brightness;
+}
+
+void coalescerNoteSent(int index, ApiJobType type, int value, bool success)
+{
+    if (index < 0 || index >= bulbs.count)
+        return;
+
+    // 失敗時は送信済みの値が不明になる
+    CoalesceSlot &slot = slots[index];
+    if (type == API_JOB_BULB_POWER)
+        slot.sentPower = success ? value : -1;
+    else if (type == API_JOB_BULB_BRIGHTNESS)
+        slot.sentBrightness = success ? value : -1;
+}
+
+bool coalescerConfirmed(int index, ApiJobType type, int value)
+{
+    if (index < 0 || index >= bulbs.count)
+        return false;
+
+    const CoalesceSlot &slot = slots[index];
+    if (type == API_JOB_BULB_POWER)
+        return slot.sentPower >= 0 && slot.sentPower == value;
+    if (type == API_JOB_BULB_BRIGHTNESS)
+        return slot.sentBrightness >= 0 && slot.sentBrightness == value;
+    return false;
+}
+
+bool coalescerSending(int index)
+{
+    if (index < 0 || index >= bulbs.count)
+        return false;
+
+    return slots[index].inFlight;
+}
+
+bool coalescerIdle(int index)
+{
+    if (index < 0 || index >= bulbs.count)
+        return true;
+
+    const CoalesceSlot &slot = slots[index];
+    return !slot.inFlight && slot.pendingPower < 0 && slot.pendingBrightness < 0 &&
+           commandLogFirst(bulbs.deviceId[index]) == nullptr;
+}
+
+CoalesceStats coalescerGetStats()
+{
+    return stats;
+}
@@ -0,0 +1,82 @@
+#ifndef COMMAND_COALESCER_H
+#define COMMAND_COALESCER_H
+
+#include <Arduino.h>
+#include "api_worker.h"
+#include "device_registry.h"
+
+// ドラッグ中に中間値を送る最小間隔
+#define COALESCE_STREAM_INTERVAL_MS 400
+
+// 電球ごとの送信スロット
+// 1台につき同時に送るコマンドは1つだけ。電源と確定した明るさの指示はコマンドの記録（command_log.h）に残し、
+// 古い順に送る（失敗したら間隔を空けて送り直す）。ドラッグ中の中間値は記録せず保留スロットを上書きし、
+// 送信完了時に最後の値だけを送る。
+struct CoalesceSlot
+{
+    bool inFlight;           // コマンド送信中
+    int pendingPower;        // 保留中の電源指示（-1=なし, 0=OFF, 1=ON）
+    int pendingBrightness;   // 保留中の明るさ指示（-1=なし）
+    bool pendingFinal;       // 保留中の明るさが確定値か（ドラッグ中の中間値なら false）
+    int sentPower;           // 最後に送信成功した電源状態（-1=不明）
+    int sentBrightness;      // 最後に送信成功した明るさ（-1=不明）
+    unsigned long lastSent;  // 最後に送信した時刻
+    uint32_t inFlightSeq;    // 送信中の指示の記録番号（0=記録していない中間値）
+};
+
+// 送信統計
+struct CoalesceStats
+{
+    uint32_t intents;   // UIからの指示数
+    uint32_t sent;      // 実際に送信したコマンド数
+    uint32_t skipped;   // 送信済みの値と同じため省略した数
+    uint32_t retries;   // 失敗して送り直した数
+};
+
+// 送信を待たせる電球の判定（true を返した電球には送らない）
+typedef bool (*CoalesceHoldFn)(int index);
+
+// 初期化（コマンドの記録は消さない）
+// onResult: コマンド完了時に呼ばれる（UIスレッド、nullptr可）
+// 失敗して送り直すときは呼ばれず、送れたか・あきらめたときだけ呼ばれる
+void coalescerInit(ApiCallback onResult);
+
+// 前回の起動で送り終えていなかった指示を戻し、電球の表示をその値にする（登録簿を読み込んだ後に呼ぶ）
+// 戻り値: 戻した指示の数
+int coalescerRestore();
+
+// 電源指示
+void coalescerSetPower(int index, bool on);
+
+// 明るさ指示
+// final: true=確定値（指を離した）, false=ドラッグ中の中間値（送信間隔を制限）
+void coalescerSetBrightness(int index, int brightness, bool final);
+
+// 送信を待たせる電球の判定を設定（シーン実行中の電球への指示を、シーンのコマンドの後に送るため）
+void coalescerSetHold(CoalesceHoldFn held);
+
+// 保留中の指示を送信（uiUpdate から毎ループ呼ぶ）
+void coalescerService(unsigned long now);
+
+// 次に coalescerService で送れる指示がある時刻（なければ false）
+bool coalescerNextService(unsigned long now, unsigned long &at);
+
+// ステータス取得で確認した実際の状態を記録（送信済みの値の省略判定に使う）
+void coalescerNoteStatus(int index, bool powerState, int brightness);
+
+// このモジュールを通さずに送ったコマンドの結果を記録（シーンなど）
+void coalescerNoteSent(int index, ApiJobType type, int value, bool success);
+
+// 電球の状態が value であることを確認済みか（送信成功・ステータス取得で確認した値と同じか）
+bool coalescerConfirmed(int index, ApiJobType type, int value);
+
+// この電球へのコマンドを送信中か
+bool coalescerSending(int index);
+
+// 送信中・保留中・記録した指示がないか
+bool coalescerIdle(int index);
+
+// 統計取得
+CoalesceStats coalescerGetStats();
+
+#endif // COMMAND_COALESCER_H
@@ -0,0 +1,311 @@
+#include "command_log.h"
+#include "crc32.h"
+#include "hal/hal_clock.h"
+#include "hal/hal_storage.h"
+
+#include <string.h>
+#include <time.h>
+
+// 保存形式（リトルエンディアン）
+//   ヘッダー: magic "SBCL" / version u16 / 指示の数 u16 / 予備 u32 / 以降の CRC32 u32
+//   指示（古い順）: 番号 u32 / 記録した時刻 u32 / 種類 u8 / 値 u8 / 送った回数 u8 / IDの長さ u8 / ID
+#define LOG_MAGIC "SBCL"
+#define LOG_VERSION 1
+#define LOG_HEADER_SIZE 16
+#define LOG_ENTRY_MAX (12 + DEVICE_ID_LEN)
+#define LOG_MAX (LOG_HEADER_SIZE + COMMAND_LOG_CAPACITY * LOG_ENTRY_MAX)
+
+// 記録した指示（古い順に詰めて並べる）
+static CommandEntry entries[COMMAND_LOG_CAPACITY];
+static int entryCount = 0;
+static uint32_t nextSeq = 1;
+static bool dirty = false;            // 指示の追加・削除があり、まだ書き込んでいない
+static unsigned long dirtySince = 0; // 書き込んでいない変化が最初にあった時刻
+static bool stored = false;          // フラッシュに記録のファイルがある
+static CommandLogStats stats = {};
+
+static uint8_t buffer[LOG_MAX];
+
+static uint32_t epochNow()
+{
+    time_t epoch = time(nullptr);
+    return epoch >= EPOCH_VALID ? (uint32_t)epoch : 0;
+}
+
+static int findSeq(uint32_t seq)
+{
+    for (int i = 0; i < entryCount; i++)
+    {
+        if (entries[i].seq == seq)
+            return i;
+    }
+    return -1;
+}
+
+// 書き込みを予約する（最初の変化から COMMAND_LOG_SAVE_DELAY_MS 後にまとめて書き込む）
+static void markDirty()
+{
+    if (dirty)
+        return;
+    dirty = true;
+    dirtySince = millis();
+}
+
+// i 番目を消して後ろを詰める（古い順を保つ）
+static void removeAt(int i)
+{
+    memmove(&entries[i], &entries[i + 1], (entryCount - i - 1) * sizeof(CommandEntry));
+    entryCount--;
+    markDirty();
+}
+
+// 送り直すまでの時間（倍々に延ばし、その半分〜全部の範囲で揺らす）
+static uint32_t retryDelay(int attempts)
+{
+    uint32_t delayMs = COMMAND_RETRY_BASE_MS;
+    for (int i = 1; i < attempts && delayMs < COMMAND_RETRY_MAX_MS; i++)
+        delayMs *= 2;
+    delayMs = min(delayMs, (uint32_t)COMMAND_RETRY_MAX_MS);
+    return delayMs / 2 + esp_random() % (delayMs / 2 + 1);
+}
+
+void commandLogInit()
+{
+    entryCount = 0;
+    nextSeq = 1;
+    dirty = false;
+    stored = false;
+}
+
+int commandLogRestore()
+{
+    size_t len = 0;
+    if (!halStorageRead(COMMAND_LOG_NAME, buffer, sizeof(buffer), &len))
+        return 0;
+    stored = true;
+    if (len < LOG_HEADER_SIZE || memcmp(buffer, LOG_MAGIC, 4) != 0 ||
+        (buffer[4] | (buffer[5] << 8)) != LOG_VERSION ||
+        crc32(buffer + LOG_HEADER_SIZE, len - LOG_HEADER_SIZE) != getU32(buffer + 12))
+    {
+        Serial.println("Command log: invalid, ignored");
+        return 0;
+    }
+
+    int count = min(buffer[6] | (buffer[7] << 8), COMMAND_LOG_CAPACITY);
+    const uint8_t *p = buffer + LOG_HEADER_SIZE;
+    const uint8_t *end = buffer + len;
+    entryCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (end - p < 12 || p[11] >= DEVICE_ID_LEN || end - p < 12 + p[11])
+            break;
+        CommandEntry &e = entries[entryCount++];
+        e.seq = getU32(p);
+        e.createdAt = getU32(p + 4);
+        e.type = p[8] == API_JOB_BULB_POWER ? API_JOB_BULB_POWER : API_JOB_BULB_BRIGHTNESS;
+        e.value = p[9];
+        e.attempts = p[10];
+        memcpy(e.deviceId, p + 12, p[11]);
+        e.deviceId[p[11]] = '\0';
+        e.inFlight = false;
+        e.retryAt = 0;
+        nextSeq = max(nextSeq, e.seq + 1);
+        p += 12 + p[11];
+    }
+    stats.restored += entryCount;
+    if (entryCount > 0)
+        Serial.printf("Command log: restored %d pending commands\n", entryCount);
+    return entryCount;
+}
+
+uint32_t commandLogAppend(const char *deviceId, ApiJobType type, int value, unsigned long now)
+{
+    if (deviceId == nullptr || deviceId[0] == '\0')
+        return 0;
+
+    // 同じ電球・同じ種類の古い指示は新しい指示で置き換える（送信中なら結果は COMMAND_SUPERSEDED になる）
+    for (int i = 0; i < entryCount; i++)
+    {
+        if (entries[i].type == type && strcmp(entries[i].deviceId, deviceId) == 0)
+        {
+            removeAt(i);
+            stats.superseded++;
+            break;
+        }
+    }
+    if (entryCount >= COMMAND_LOG_CAPACITY)
+    {
+        stats.full++;
+        return 0;
+    }
+
+    CommandEntry &e = entries[entryCount++];
+    e.seq = nextSeq++;
+    strncpy(e.deviceId, deviceId, sizeof(e.deviceId) - 1);
+    e.deviceId[sizeof(e.deviceId) - 1] = '\0';
+    e.type = type;
+    e.value = value;
+    e.attempts = 0;
+    e.inFlight = false;
+    e.retryAt = now;
+    e.createdAt = epochNow();
+    markDirty();
+    stats.appended++;
+    return e.seq;
+}
+
+const CommandEntry *commandLogFirst(const char *deviceId)
+{
+    for (int i = 0; i < entryCount; i++)
+    {
+        if (strcmp(entries[i].deviceId, deviceId) == 0)
+            return &entries[i];
+    }
+    return nullptr;
+}
+
+int commandLogCount()
+{
+    return entryCount;
+}
+
+const CommandEntry &commandLogEntry(int i)
+{
+    return entries[i];
+}
+
+void commandLogNoteSent(uint32_t seq)
+{
+    int i = findSeq(seq);
+    if (i < 0)
+        return;
+
+    // 送るたびには書き込まない（送った回数は次に追加・削除で書き込むときに残る）
+    entries[i].inFlight = true;
+    entries[i].attempts++;
+}
+
+CommandOutcome commandLogNoteResult(uint32_t seq, bool success, unsigned long now)
+{
+    int i = findSeq(seq);
+    if (i < 0)
+        return COMMAND_SUPERSEDED;
+
+    CommandEntry &e = entries[i];
+    e.inFlight = false;
+    if (success)
+    {
+        removeAt(i);
+        stats.delivered++;
+        return COMMAND_DELIVERED;
+    }
+    if (e.attempts >= COMMAND_RETRY_LIMIT)
+    {
+        Serial.printf("Command log: giving up %s (type=%d, value=%d) after %d attempts\n", e.deviceId, (int)e.type,
+                      e.value, e.attempts);
+        removeAt(i);
+        stats.failed++;
+        return COMMAND_FAILED;
+    }
+
+    e.retryAt = now + retryDelay(e.attempts);
+    stats.retries++;
+    return COMMAND_RETRY;
+}
+
+void commandLogDrop(uint32_t seq, bool failed)
+{
+    int i = findSeq(seq);
+    if (i < 0)
+        return;
+
+    removeAt(i);
+    if (failed)
+        stats.failed++;
+}
+
+bool commandLogExpired(const CommandEntry &entry, uint32_t epoch)
+{
+    if (entry.createdAt == 0 || epoch < EPOCH_VALID)
+        return false;
+    return epoch - entry.createdAt >= COMMAND_LOG_EXPIRE_SEC;
+}
+
+bool commandLogSave(unsigned long now)
+{
+    if (!dirty || now - dirtySince < COMMAND_LOG_SAVE_DELAY_MS)
+        return false;
+    return commandLogFlush();
+}
+
+bool commandLogNextSave(unsigned long &at)
+{
+    if (!dirty)
+        return false;
+    at = dirtySince + COMMAND_LOG_SAVE_DELAY_MS;
+    return true;
+}
+
+bool commandLogFlush()
+{
+    if (!dirty)
+        return false;
+    dirty = false;
+
+    // 空になったら消す（次の起動で戻すものがない）、書き込む前に送れた指示ならファイルはない
+    if (entryCount == 0)
+    {
+        if (!stored)
+            return false;
+        halStorageRemove(COMMAND_LOG_NAME);
+        stored = false;
+        stats.saves++;
+        return true;
+    }
+
+    uint8_t *p = buffer + LOG_HEADER_SIZE;
+    for (int i = 0; i < entryCount; i++)
+    {
+        const CommandEntry &e = entries[i];
+        size_t idLen = strlen(e.deviceId);
+        putU32(p, e.seq);
+        putU32(p + 4, e.createdAt);
+        p[8] = (uint8_t)e.type;
+        p[9] = (uint8_t)e.value;
+        p[10] = e.attempts;
+        p[11] = (uint8_t)idLen;
+        memcpy(p + 12, e.deviceId, idLen);
+        p += 12 + idLen;
+    }
+
+    size_t len = p - buffer;
+    memcpy(buffer, LOG_MAGIC, 4);
+    buffer[4] = (uint8_t)LOG_VERSION;
+    buffer[5] = (uint8_t)(LOG_VERSION >> 8);
+    buffer[6] = (uint8_t)entryCount;
+    buffer[7] = (uint8_t)(entryCount >> 8);
+    putU32(buffer + 8, 0);
+    putU32(buffer + 12, crc32(buffer + LOG_HEADER_SIZE, len - LOG_HEADER_SIZE));
+    stats.saves++;
+    if (!halStorageWrite(COMMAND_LOG_NAME, buffer, len))
+    {
+        Serial.println("Command log: save failed");
+        return false;
+    }
+    stored = true;
+    return true;
+}
+
+CommandLogStats commandLogGetStats()
+{
+    return stats;
+}
+
+void commandLogPrint()
+{
+    Serial.printf("Command log: pending=%d appended=%lu superseded=%lu delivered=%lu retries=%lu failed=%lu "
+                  "restored=%lu saves=%lu full=%lu\n",
+                  entryCount, (unsigned long)stats.appended, (unsigned long)stats.superseded,
+                  (unsigned long)stats.delivered, (unsigned long)stats.retries, (unsigned long)stats.failed,
+                  (unsigned long)stats.restored, (unsigned long)stats.saves, (unsigned long)stats.full);
+}
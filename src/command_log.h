@@ -0,0 +1,118 @@
+#ifndef COMMAND_LOG_H
+#define COMMAND_LOG_H
+
+#include <Arduino.h>
+#include "api_worker.h"
+#include "device_registry.h"
+
+// 電球コマンドの記録（送り終えていない電源・明るさの指示をフラッシュに残し、失敗したら間隔を空けて送り直す）
+//
+// 指示はデバイスIDで記録するので、デバイス一覧を取り直しても再起動しても残る
+// 同じ電球・同じ種類の指示は新しいものだけを残し、電球ごとに古い順に送る
+// 送り直しは COMMAND_RETRY_BASE_MS から倍々に延ばし（上限 COMMAND_RETRY_MAX_MS）、その半分〜全部の範囲で揺らす
+// COMMAND_RETRY_LIMIT 回失敗した・COMMAND_LOG_EXPIRE_SEC より古い指示はあきらめ、画面を実際の状態に合わせる
+
+// 保存名
+#define COMMAND_LOG_NAME "commands.bin"
+
+// 記録が変わってからフラッシュに書き込むまでの時間（この間に送れた指示は書き込まずに済む）
+#ifndef COMMAND_LOG_SAVE_DELAY_MS
+#define COMMAND_LOG_SAVE_DELAY_MS 1000
+#endif
+
+// 記録できる指示の数（電球1台につき電源・明るさの2件まで）
+#define COMMAND_LOG_CAPACITY 32
+
+// 送り直しの間隔と回数（最初の送信を含む）
+#ifndef COMMAND_RETRY_BASE_MS
+#define COMMAND_RETRY_BASE_MS 2000
+#endif
+#ifndef COMMAND_RETRY_MAX_MS
+#define COMMAND_RETRY_MAX_MS 60000
+#endif
+#define COMMAND_RETRY_LIMIT 6
+
+// これより古い指示は送らない（再起動をまたいで何時間も前の操作を実行しない）
+#define COMMAND_LOG_EXPIRE_SEC 900
+
+// 記録した指示
+struct CommandEntry
+{
+    uint32_t seq;                 // 記録した順の番号（1から）
+    char deviceId[DEVICE_ID_LEN];
+    ApiJobType type;              // API_JOB_BULB_POWER / API_JOB_BULB_BRIGHTNESS
+    int value;
+    uint8_t attempts;             // 送った回数
+    bool inFlight;                // 送信中
+    unsigned long retryAt;        // この時刻以降に送る
+    uint32_t createdAt;           // 記録した時刻（エポック秒、時刻同期前は 0）
+};
+
+// 送信結果の扱い
+enum CommandOutcome
+{
+    COMMAND_DELIVERED,  // 送れた（記録から消した）
+    COMMAND_RETRY,      // 失敗したので間隔を空けて送り直す
+    COMMAND_FAILED,     // 失敗してあきらめた（記録から消した）
+    COMMAND_SUPERSEDED  // 送信中に新しい指示で置き換わった
+};
+
+// 集計
+struct CommandLogStats
+{
+    uint32_t appended;   // 記録した指示
+    uint32_t superseded; // 新しい指示で置き換えた
+    uint32_t delivered;  // 送れた
+    uint32_t retries;    // 送り直し
+    uint32_t failed;     // あきらめた（送り直しの上限・期限切れ・登録簿にない電球）
+    uint32_t restored;   // 起動時に戻した
+    uint32_t saves;      // フラッシュへの書き込み（ファイルの削除を含む）
+    uint32_t full;       // 満杯で記録できなかった（記録せずに送る）
+};
+
+// 記録を空にする
+void commandLogInit();
+
+// 保存した記録を戻す（戻り値: 戻した指示の数、送信中だったものは未送信に戻す）
+int commandLogRestore();
+
+// 指示を記録する（同じ電球・同じ種類の古い指示は消す）
+// 戻り値: 記録した番号（満杯なら 0）
+uint32_t commandLogAppend(const char *deviceId, ApiJobType type, int value, unsigned long now);
+
+// この電球の最も古い指示（なければ nullptr）
+const CommandEntry *commandLogFirst(const char *deviceId);
+
+// 記録した指示の数と、古い順の i 番目
+int commandLogCount();
+const CommandEntry &commandLogEntry(int i);
+
+// 送った（送信中にし、送った回数を数える）
+// 送った回数はメモリだけで数え、指示の追加・削除で書き込むときに一緒に保存する
+void commandLogNoteSent(uint32_t seq);
+
+// 送信結果を記録する（失敗なら送り直す時刻を決めるか、あきらめて消す）
+CommandOutcome commandLogNoteResult(uint32_t seq, bool success, unsigned long now);
+
+// 送らずに消す（failed: あきらめた=true, 送る必要がなくなった=false）
+void commandLogDrop(uint32_t seq, bool failed);
+
+// 記録した時刻から COMMAND_LOG_EXPIRE_SEC 以上経ったか（epoch は現在のエポック秒、時刻同期前は期限切れにしない）
+bool commandLogExpired(const CommandEntry &entry, uint32_t epoch);
+
+// 指示の追加・削除から COMMAND_LOG_SAVE_DELAY_MS 経っていればフラッシュに書き込む
+// 保存済みの内容と同じ（空のまま）なら書き込まない
+// 戻り値: 書き込んだ=true
+bool commandLogSave(unsigned long now);
+
+// 待たずにすぐ書き込む（再起動の前など）
+bool commandLogFlush();
+
+// 次に commandLogSave で書き込む時刻（書き込むものがなければ false）
+bool commandLogNextSave(unsigned long &at);
+
+// 集計取得・シリアル出力
+CommandLogStats commandLogGetStats();
+void commandLogPrint();
+
+#endif // COMMAND_LOG_H
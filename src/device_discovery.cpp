@@ -0,0 +1,283 @@
+#include "device_discovery.h"
+#include "crc32.h"
+#include "device_registry.h"
+#include "devices.h"
+#include "switchbot_api.h"
+#include "api_worker.h"
+#include "hal/hal_storage.h"
+
+#include <string.h>
+
+// スナップショットの形式（リトルエンディアン）
+//   ヘッダー: magic "SBDS" / version u16 / 件数 u16 / レコード部のバイト数 u32 / レコード部の CRC32 u32
+//   レコード: 種類 u8 / IDの長さ u8 / ID / 名前の長さ u8 / 名前（終端なし）
+// 電球は一覧の順、温湿度計は1台だけ最後に置く
+#define SNAPSHOT_MAGIC "SBDS"
+#define SNAPSHOT_HEADER_SIZE 16
+#define SNAPSHOT_RECORD_MAX (3 + DEVICE_ID_LEN + DEVICE_NAME_LEN)
+
+#if DISCOVERY_SNAPSHOT_MAX < SNAPSHOT_HEADER_SIZE + (REGISTRY_MAX_BULBS + 1) * SNAPSHOT_RECORD_MAX
+#error "DISCOVERY_SNAPSHOT_MAX is too small for REGISTRY_MAX_BULBS"
+#endif
+
+// 読み込み・取得で共用するバッファ
+// 取得中はワーカータスクだけが、それ以外は UI スレッドだけが触る（完了通知のキューで受け渡す）
+static uint8_t snapshot[DISCOVERY_SNAPSHOT_MAX];
+static size_t snapshotLen = 0;
+
+// 登録簿に反映済みの内容（取得した一覧との比較用）
+static uint32_t appliedCrc = 0;
+static uint32_t appliedPayloadLen = 0;
+
+static DiscoverySource source = DISCOVERY_SOURCE_CONFIG;
+static bool fetching = false;
+static bool updateReady = false;
+
+// 取得中の状態（ワーカータスク）
+struct FetchState
+{
+    size_t len;      // レコード部に書いたバイト数
+    int bulbCount;   // 書いた電球の数
+    int skipped;     // 登録簿に入りきらず捨てた電球の数
+    bool hasMeter;   // 温湿度計の候補があるか
+    bool meterFixed; // devices.h で指定した温湿度計が見つかった
+    DiscoveredDevice meter;
+};
+
+// レコードを1件書き込む（ヘッダーの後ろ、state.len の位置）
+static void appendRecord(FetchState &state, const DiscoveredDevice &device)
+{
+    uint8_t *p = snapshot + SNAPSHOT_HEADER_SIZE + state.len;
+    size_t idLen = strlen(device.deviceId);
+    size_t nameLen = strlen(device.name);
+
+    *p++ = device.kind;
+    *p++ = (uint8_t)idLen;
+    memcpy(p, device.deviceId, idLen);
+    p += idLen;
+    *p++ = (uint8_t)nameLen;
+    memcpy(p, device.name, nameLen);
+    state.len += 3 + idLen + nameLen;
+}
+
+// デバイス一覧から1件受け取る（ワーカータスク）
+static void onDiscovered(void *ctx, const DiscoveredDevice &device)
+{
+    FetchState &state = *static_cast<FetchState *>(ctx);
+
+    if (device.kind == DISCOVERED_METER)
+    {
+        // devices.h で指定した温湿度計を優先し、なければ最初に見つかったもの
+        bool preferred = meterConfig.deviceId[0] != '\0' && strcmp(device.deviceId, meterConfig.deviceId) == 0;
+        if (!state.meterFixed && (preferred || !state.hasMeter))
+        {
+            state.meter = device;
+            state.hasMeter = true;
+            state.meterFixed = preferred;
+        }
+        return;
+    }
+
+    if (state.bulbCount >= REGISTRY_MAX_BULBS)
+    {
+        state.skipped++;
+        return;
+    }
+    appendRecord(state, device);
+    state.bulbCount++;
+}
+
+// スナップショットを検証し、apply なら登録簿に読み込む
+// 戻り値: 形式・CRC が正しい=true
+static bool decodeSnapshot(const uint8_t *data, size_t len, bool apply)
+{
+    if (len < SNAPSHOT_HEADER_SIZE || memcmp(data, SNAPSHOT_MAGIC, 4) != 0)
+        return false;
+    if (getU16(data + 4) != DISCOVERY_SNAPSHOT_VERSION)
+        return false;
+
+    int count = getU16(data + 6);
+    uint32_t payloadLen = getU32(data + 8);
+    if (payloadLen != len - SNAPSHOT_HEADER_SIZE || crc32(data + SNAPSHOT_HEADER_SIZE, payloadLen) != getU32(data + 12))
+        return false;
+
+    if (apply)
+        registryClear();
+
+    const uint8_t *p = data + SNAPSHOT_HEADER_SIZE;
+    const uint8_t *end = p + payloadLen;
+    bool meterFound = false;
+    for (int i = 0; i < count; i++)
+    {
+        char id[DEVICE_ID_LEN];
+        char name[DEVICE_NAME_LEN];
+
+        if (end - p < 2)
+            return false;
+        uint8_t kind = *p++;
+        uint8_t idLen = *p++;
+        if (idLen >= DEVICE_ID_LEN || end - p < idLen + 1)
+            return false;
+        memcpy(id, p, idLen);
+        id[idLen] = '\0';
+        p += idLen;
+
+        uint8_t nameLen = *p++;
+        if (nameLen >= DEVICE_NAME_LEN || end - p < nameLen)
+            return false;
+        memcpy(name, p, nameLen);
+        name[nameLen] = '\0';
+        p += nameLen;
+
+        if (!apply)
+            continue;
+        if (kind == DISCOVERED_METER)
+        {
+            // 同じ温湿度計なら表示中の値を残す
+            MeterDevice previous = meter;
+            registrySetMeter(id, name);
+            if (strcmp(previous.deviceId, id) == 0)
+            {
+                meter.temperature = previous.temperature;
+                meter.humidity = previous.humidity;
+                meter.valid = previous.valid;
+            }
+            meterFound = true;
+        }
+        else
+        {
+            registryAddBulb(id, name);
+        }
+    }
+
+    // 一覧に温湿度計がなければ devices.h の設定を使う
+    if (apply && !meterFound && strcmp(meter.deviceId, meterConfig.deviceId) != 0)
+        registrySetMeter(meterConfig.deviceId, meterConfig.name);
+    return p == end;
+}
+
+void discoveryInit()
+{
+    source = DISCOVERY_SOURCE_CONFIG;
+    fetching = false;
+    updateReady = false;
+    registryInit();
+
+#if DEVICE_DISCOVERY
+    uint32_t start = millis();
+    if (halStorageRead(DISCOVERY_SNAPSHOT_NAME, snapshot, sizeof(snapshot), &snapshotLen) &&
+        decodeSnapshot(snapshot, snapshotLen, false))
+    {
+        decodeSnapshot(snapshot, snapshotLen, true);
+        appliedPayloadLen = getU32(snapshot + 8);
+        appliedCrc = getU32(snapshot + 12);
+        source = DISCOVERY_SOURCE_SNAPSHOT;
+        Serial.printf("Devices: %d bulbs from snapshot (%u bytes, %lu ms)\n", bulbs.count, (unsigned)snapshotLen,
+                      (unsigned long)(millis() - start));
+        return;
+    }
+    Serial.println("Devices: no valid snapshot, using devices.h");
+#endif
+}
+
+// 取得の完了（UIスレッド、result.value は内容が変わったか）
+static void onDeviceList(const ApiResult &result)
+{
+    fetching = false;
+    if (!result.success)
+    {
+        Serial.println("Devices: revalidation failed, keeping current list");
+        return;
+    }
+    updateReady = (result.value != 0);
+    if (!updateReady && source == DISCOVERY_SOURCE_SNAPSHOT)
+        source = DISCOVERY_SOURCE_CLOUD;
+}
+
+bool discoveryRevalidate()
+{
+#if DEVICE_DISCOVERY
+    if (fetching || updateReady)
+        return false;
+    // デバイスIDは使わないが、空文字列は投入できないので一覧のパスを入れる
+    if (!apiWorkerSubmit(API_JOB_DEVICE_LIST, "devices", 0, 0, onDeviceList))
+        return false;
+    fetching = true;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool discoveryUpdateReady()
+{
+    return updateReady;
+}
+
+bool discoveryApply()
+{
+    if (!updateReady)
+        return false;
+    updateReady = false;
+
+    if (!decodeSnapshot(snapshot, snapshotLen, true))
+    {
+        // 取得時に検証済みなので通常は起きない
+        registryInit();
+        source = DISCOVERY_SOURCE_CONFIG;
+        return true;
+    }
+    appliedPayloadLen = getU32(snapshot + 8);
+    appliedCrc = getU32(snapshot + 12);
+    source = DISCOVERY_SOURCE_CLOUD;
+    Serial.printf("Devices: applied %d bulbs from device list\n", bulbs.count);
+    return true;
+}
+
+DiscoverySource discoverySource()
+{
+    return source;
+}
+
+bool discoveryFetch(bool &changed)
+{
+    changed = false;
+
+    FetchState state = {};
+    if (!switchbotDeviceList(onDiscovered, &state))
+        return false;
+
+    // 一覧が空なら（電球も温湿度計もない）devices.h の設定を使い続ける
+    if (state.bulbCount == 0 && !state.hasMeter)
+    {
+        Serial.println("Devices: device list has no bulbs or meters");
+        return true;
+    }
+    if (state.skipped > 0)
+        Serial.printf("Devices: %d bulbs over REGISTRY_MAX_BULBS ignored\n", state.skipped);
+
+    int count = state.bulbCount;
+    if (state.hasMeter)
+    {
+        appendRecord(state, state.meter);
+        count++;
+    }
+
+    uint8_t *header = snapshot;
+    memcpy(header, SNAPSHOT_MAGIC, 4);
+    putU16(header + 4, DISCOVERY_SNAPSHOT_VERSION);
+    putU16(header + 6, (uint16_t)count);
+    putU32(header + 8, (uint32_t)state.len);
+    uint32_t crc = crc32(snapshot + SNAPSHOT_HEADER_SIZE, state.len);
+    putU32(header + 12, crc);
+    snapshotLen = SNAPSHOT_HEADER_SIZE + state.len;
+
+    // 登録簿と同じ内容ならフラッシュに書かない
+    if (source != DISCOVERY_SOURCE_CONFIG && crc == appliedCrc && state.len == appliedPayloadLen)
+        return true;
+
+    changed = true;
+    if (!halStorageWrite(DISCOVERY_SNAPSHOT_NAME, snapshot, snapshotLen))
+        Serial.println("Devices: failed to save snapshot");
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef DEVICE_DISCOVERY_H
+#define DEVICE_DISCOVERY_H
+
+#include <Arduino.h>
+
+// デバイス一覧を API から取得して登録簿を作る（0 にすると devices.h の設定だけを使う）
+#ifndef DEVICE_DISCOVERY
+#define DEVICE_DISCOVERY 1
+#endif
+
+// フラッシュに保存するデバイス一覧のスナップショット
+#define DISCOVERY_SNAPSHOT_NAME "devices.bin"
+#define DISCOVERY_SNAPSHOT_VERSION 1
+#define DISCOVERY_SNAPSHOT_MAX 40960 // 電球 REGISTRY_MAX_BULBS 台分の最長のレコードが収まる大きさ
+
+// 登録簿の出どころ
+enum DiscoverySource
+{
+    DISCOVERY_SOURCE_CONFIG,   // devices.h
+    DISCOVERY_SOURCE_SNAPSHOT, // 前回保存したスナップショット
+    DISCOVERY_SOURCE_CLOUD     // 今回の起動で取得したデバイス一覧
+};
+
+// 登録簿を作る（スナップショットがあればそこから、なければ devices.h から）
+// ネットワークを待たないので、起動直後からパネルを描画できる
+void discoveryInit();
+
+// デバイス一覧の再取得をワーカーに投入（UIスレッドから呼ぶ）
+// 取得した一覧がスナップショットと違えば保存し、discoveryUpdateReady() が true になる
+// 戻り値: 投入した=true, 取得中・投入できない=false
+bool discoveryRevalidate();
+
+// 取得した一覧が登録簿と違い、反映を待っているか
+bool discoveryUpdateReady();
+
+// 取得した一覧を登録簿に反映（UIスレッド、送信中のジョブがないときに呼ぶ）
+// 電球の並び・デバイス番号が変わるので、呼び出し側で送信スロットの初期化と再描画を行う
+// 戻り値: 反映した=true
+bool discoveryApply();
+
+// 登録簿の出どころ
+DiscoverySource discoverySource();
+
+// デバイス一覧を取得してスナップショットを作る（ワーカータスクから呼ばれる）
+// changed: 保存済みのスナップショットと内容が違ったか
+// 戻り値: 一覧を最後まで取得できた=true
+bool discoveryFetch(bool &changed);
+
+#endif // DEVICE_DISCOVERY_H
@@ -0,0 +1,118 @@
+#include "device_list.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// 温湿度計として扱う deviceType
+static const char *const meterTypes[] = {"Meter", "MeterPlus", "WoIOSensor", "MeterPro", "MeterPro(CO2)"};
+
+// 電球として扱う deviceType
+static const char *const bulbTypes[] = {"Color Bulb"};
+
+static bool matchesAny(const char *type, const char *const *list, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (strcmp(type, list[i]) == 0)
+            return true;
+    }
+    return false;
+}
+
+// 終端付きでコピー（切り捨てたときは UTF-8 の文字の途中で切らない）
+static void copyName(char *dst, size_t size, const char *src)
+{
+    size_t len = strlen(src);
+    if (len >= size)
+    {
+        len = size - 1;
+        while (len > 0 && ((unsigned char)src[len] & 0xC0) == 0x80)
+            len--;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+DeviceListParser::DeviceListParser(DeviceListHandler handler, void *ctx)
+    : handler(handler), handlerCtx(ctx), scanner(onValue, this), code(-1), listedCount(0), acceptedCount(0),
+      idTooLong(false)
+{
+    scanner.setObjectEndHandler(onObjectEnd);
+    // "deviceList" の要素のオブジェクトより深い入れ子は読まない
+    scanner.setDepthLimit(4);
+    memset(&current, 0, sizeof(current));
+    deviceType[0] = '\0';
+}
+
+bool DeviceListParser::feed(const char *data, size_t len)
+{
+    if (!scanner.feed(data, len))
+        return false;
+    return !scanner.finished();
+}
+
+void DeviceListParser::onValue(void *ctx, const char *parentKey, const char *key,
+                               JsonValueType type, const char *value, bool truncated)
+{
+    DeviceListParser *self = static_cast<DeviceListParser *>(ctx);
+
+    // トップレベル
+    if (parentKey[0] == '\0')
+    {
+        if (type == JSON_NUMBER && strcmp(key, "statusCode") == 0)
+            self->code = atoi(value);
+        return;
+    }
+
+    // "deviceList" の要素のメンバーのみ
+    if (strcmp(parentKey, "deviceList") != 0 || type != JSON_STRING)
+        return;
+
+    if (strcmp(key, "deviceId") == 0)
+    {
+        self->idTooLong = truncated || strlen(value) >= DEVICE_ID_LEN;
+        if (!self->idTooLong)
+            strcpy(self->current.deviceId, value);
+    }
+    else if (strcmp(key, "deviceName") == 0)
+    {
+        // 長い名前は切り詰めて使う
+        copyName(self->current.name, sizeof(self->current.name), value);
+    }
+    else if (strcmp(key, "deviceType") == 0)
+    {
+        strncpy(self->deviceType, value, sizeof(self->deviceType) - 1);
+        self->deviceType[sizeof(self->deviceType) - 1] = '\0';
+    }
+}
+
+void DeviceListParser::onObjectEnd(void *ctx, const char *parentKey)
+{
+    DeviceListParser *self = static_cast<DeviceListParser *>(ctx);
+    if (strcmp(parentKey, "deviceList") != 0)
+        return;
+
+    self->listedCount++;
+    DiscoveredDevice &device = self->current;
+    bool known = true;
+    if (matchesAny(self->deviceType, bulbTypes, sizeof(bulbTypes) / sizeof(bulbTypes[0])))
+        device.kind = DISCOVERED_BULB;
+    else if (matchesAny(self->deviceType, meterTypes, sizeof(meterTypes) / sizeof(meterTypes[0])))
+        device.kind = DISCOVERED_METER;
+    else
+        known = false;
+
+    if (known && !self->idTooLong && device.deviceId[0] != '\0')
+    {
+        if (device.name[0] == '\0')
+            strcpy(device.name, device.deviceId);
+        self->acceptedCount++;
+        if (self->handler != nullptr)
+            self->handler(self->handlerCtx, device);
+    }
+
+    // 次の要素に備えて空にする
+    memset(&device, 0, sizeof(device));
+    self->deviceType[0] = '\0';
+    self->idTooLong = false;
+}
@@ -0,0 +1,70 @@
+#ifndef DEVICE_LIST_H
+#define DEVICE_LIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "json_scanner.h"
+#include "device_registry.h"
+
+// 見つかったデバイスの種類
+enum DiscoveredKind : uint8_t
+{
+    DISCOVERED_BULB = 1,
+    DISCOVERED_METER = 2
+};
+
+// デバイス一覧の1件
+struct DiscoveredDevice
+{
+    DiscoveredKind kind;
+    char deviceId[DEVICE_ID_LEN];
+    char name[DEVICE_NAME_LEN];
+};
+
+// 電球・温湿度計を1件見つけるごとに呼ばれる
+typedef void (*DeviceListHandler)(void *ctx, const DiscoveredDevice &device);
+
+// デバイス一覧レスポンス（GET /v1.1/devices）のストリーミングパーサー
+// "body" の "deviceList" の要素を1件ずつ確定させて handler に渡す。一覧全体は保持しない。
+// 電球（Color Bulb）と温湿度計（Meter 系）以外、赤外線リモコン（infraredRemoteList）は読み飛ばす。
+class DeviceListParser
+{
+public:
+    DeviceListParser(DeviceListHandler handler, void *ctx);
+
+    // チャンクを投入
+    // 戻り値: 続きが必要=true, 読み終えたまたは構文エラー=false
+    bool feed(const char *data, size_t len);
+
+    // 構文エラーが発生したか
+    bool failed() const { return scanner.failed(); }
+
+    // レスポンスを最後まで読んだか
+    bool finished() const { return scanner.finished(); }
+
+    // トップレベルの statusCode（まだ読んでいなければ -1）
+    int statusCode() const { return code; }
+
+    // 一覧の件数（対象外の種類を含む）と、handler に渡した件数
+    int listed() const { return listedCount; }
+    int accepted() const { return acceptedCount; }
+
+private:
+    static void onValue(void *ctx, const char *parentKey, const char *key,
+                        JsonValueType type, const char *value, bool truncated);
+    static void onObjectEnd(void *ctx, const char *parentKey);
+
+    DeviceListHandler handler;
+    void *handlerCtx;
+    JsonScanner scanner;
+    int code;
+    int listedCount;
+    int acceptedCount;
+
+    // 読み途中の要素
+    DiscoveredDevice current;
+    char deviceType[24];
+    bool idTooLong;
+};
+
+#endif // DEVICE_LIST_H
@@ -0,0 +1,76 @@
+#include "device_registry.h"
+#include "devices.h"
+
+#include <string.h>
+
+BulbTable bulbs;
+MeterDevice meter;
+
+// 終端付きでコピー（UTF-8 の文字の途中では切らない）
+static void copyField(char *dst, size_t size, const char *src)
+{
+    if (src == nullptr)
+        src = "";
+
+    size_t len = strlen(src);
+    if (len >= size)
+    {
+        len = size - 1;
+        while (len > 0 && ((unsigned char)src[len] & 0xC0) == 0x80)
+            len--;
+    }
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+void registryInit()
+{
+    registryClear();
+    registrySetMeter(meterConfig.deviceId, meterConfig.name);
+    for (const DeviceConfig &config : bulbConfigs)
+    {
+        registryAddBulb(config.deviceId, config.name);
+    }
+}
+
+void registryClear()
+{
+    bulbs.count = 0;
+}
+
+int registryAddBulb(const char *deviceId, const char *name)
+{
+    if (bulbs.count >= REGISTRY_MAX_BULBS)
+        return -1;
+    if (deviceId != nullptr && strlen(deviceId) >= DEVICE_ID_LEN)
+        return -1;
+
+    int index = bulbs.count++;
+    copyField(bulbs.deviceId[index], DEVICE_ID_LEN, deviceId);
+    copyField(bulbs.name[index], DEVICE_NAME_LEN, name);
+    bulbs.powerState[index] = false;
+    bulbs.brightness[index] = 100;
+    return index;
+}
+
+int registryFindBulb(const char *deviceId)
+{
+    if (deviceId == nullptr || deviceId[0] == '\0')
+        return -1;
+
+    for (int i = 0; i < bulbs.count; i++)
+    {
+        if (strcmp(bulbs.deviceId[i], deviceId) == 0)
+            return i;
+    }
+    return -1;
+}
+
+void registrySetMeter(const char *deviceId, const char *name)
+{
+    copyField(meter.deviceId, DEVICE_ID_LEN, deviceId);
+    copyField(meter.name, DEVICE_NAME_LEN, name);
+    meter.temperature = 0.0f;
+    meter.humidity = 0;
+    meter.valid = false;
+}
@@ -0,0 +1,62 @@
+#ifndef DEVICE_REGISTRY_H
+#define DEVICE_REGISTRY_H
+
+#include <stdint.h>
+
+// 登録できる電球の最大数
+#ifndef REGISTRY_MAX_BULBS
+#define REGISTRY_MAX_BULBS 512
+#endif
+
+// デバイスID・表示名の長さ（終端含む、表示名は UTF-8）
+#define DEVICE_ID_LEN 24
+#define DEVICE_NAME_LEN 48
+
+// 電球の登録簿（struct-of-arrays）
+// 描画・当たり判定・送信でそれぞれ必要な列だけを読むよう、項目ごとに配列を分けている
+// 添字がデバイス番号（コールバックの index、送信スロットなどと共通）
+struct BulbTable
+{
+    int count;                                    // 登録数
+    char deviceId[REGISTRY_MAX_BULBS][DEVICE_ID_LEN]; // 空文字列なら未設定
+    char name[REGISTRY_MAX_BULBS][DEVICE_NAME_LEN];
+    bool powerState[REGISTRY_MAX_BULBS];
+    uint8_t brightness[REGISTRY_MAX_BULBS];      // 1-100
+};
+
+// 温湿度計
+struct MeterDevice
+{
+    char deviceId[DEVICE_ID_LEN];
+    char name[DEVICE_NAME_LEN];
+    float temperature; // 温度（℃）
+    int humidity;      // 湿度（%）
+    bool valid;        // データ有効フラグ
+};
+
+extern BulbTable bulbs;
+extern MeterDevice meter;
+
+// devices.h の設定を読み込む
+void registryInit();
+
+// 電球を全て削除
+void registryClear();
+
+// 電球を追加（長すぎるIDは登録しない、名前は切り詰める）
+// 戻り値: デバイス番号、満杯・IDが長すぎる場合 -1
+int registryAddBulb(const char *deviceId, const char *name);
+
+// デバイスIDから電球を探す（戻り値: デバイス番号、なければ -1）
+int registryFindBulb(const char *deviceId);
+
+// 温湿度計を設定
+void registrySetMeter(const char *deviceId, const char *name);
+
+// デバイスIDが設定されているか
+static inline bool bulbEnabled(int index)
+{
+    return index >= 0 && index < bulbs.count && bulbs.deviceId[index][0] != '\0';
+}
+
+#endif // DEVICE_REGISTRY_H
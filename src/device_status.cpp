@@ -0,0 +1,106 @@
+#include "device_status.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// "255:128:0" 形式の色を解析
+static bool parseColor(const char *value, uint8_t &r, uint8_t &g, uint8_t &b)
+{
+    char *end;
+    long rv = strtol(value, &end, 10);
+    if (*end != ':')
+        return false;
+    long gv = strtol(end + 1, &end, 10);
+    if (*end != ':')
+        return false;
+    long bv = strtol(end + 1, &end, 10);
+    if (*end != '\0')
+        return false;
+    if (rv < 0 || rv > 255 || gv < 0 || gv > 255 || bv < 0 || bv > 255)
+        return false;
+
+    r = (uint8_t)rv;
+    g = (uint8_t)gv;
+    b = (uint8_t)bv;
+    return true;
+}
+
+DeviceStatusParser::DeviceStatusParser(uint16_t fields)
+    : wanted(fields), scanner(onValue, this)
+{
+    // "body" 直下より深い入れ子は読まない
+    scanner.setDepthLimit(2);
+    memset(&status, 0, sizeof(status));
+}
+
+bool DeviceStatusParser::feed(const char *data, size_t len)
+{
+    if (complete())
+        return false;
+    if (!scanner.feed(data, len))
+        return false;
+    return !complete() && !scanner.finished();
+}
+
+void DeviceStatusParser::onValue(void *ctx, const char *parentKey, const char *key,
+                                 JsonValueType type, const char *value, bool truncated)
+{
+    DeviceStatusParser *self = static_cast<DeviceStatusParser *>(ctx);
+    DeviceStatus &s = self->status;
+    if (truncated)
+        return;
+
+    // トップレベル
+    if (parentKey[0] == '\0')
+    {
+        if (type == JSON_NUMBER && strcmp(key, "statusCode") == 0)
+        {
+            s.statusCode = atoi(value);
+            s.found |= STATUS_FIELD_STATUS_CODE;
+            if (self->complete())
+                self->scanner.stop();
+        }
+        return;
+    }
+
+    // "body" 直下のみ
+    if (strcmp(parentKey, "body") != 0)
+        return;
+
+    uint16_t field = 0;
+    if (type == JSON_NUMBER && strcmp(key, "temperature") == 0)
+    {
+        s.temperature = strtof(value, nullptr);
+        field = STATUS_FIELD_TEMPERATURE;
+    }
+    else if (type == JSON_NUMBER && strcmp(key, "humidity") == 0)
+    {
+        s.humidity = atoi(value);
+        field = STATUS_FIELD_HUMIDITY;
+    }
+    else if (type == JSON_STRING && strcmp(key, "power") == 0)
+    {
+        s.power = strcmp(value, "on") == 0;
+        field = STATUS_FIELD_POWER;
+    }
+    else if (type == JSON_NUMBER && strcmp(key, "brightness") == 0)
+    {
+        s.brightness = atoi(value);
+        field = STATUS_FIELD_BRIGHTNESS;
+    }
+    else if (type == JSON_STRING && strcmp(key, "color") == 0)
+    {
+        if (parseColor(value, s.colorR, s.colorG, s.colorB))
+            field = STATUS_FIELD_COLOR;
+    }
+    else if (type == JSON_NUMBER && strcmp(key, "colorTemperature") == 0)
+    {
+        s.colorTemperature = atoi(value);
+        field = STATUS_FIELD_COLOR_TEMPERATURE;
+    }
+    s.found |= field;
+
+    // 揃ったら残りは読まない
+    if (self->complete())
+        self->scanner.stop();
+}
@@ -0,0 +1,68 @@
+#ifndef DEVICE_STATUS_H
+#define DEVICE_STATUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "json_scanner.h"
+
+// 取り出すフィールド（ビットマスク）
+#define STATUS_FIELD_STATUS_CODE (1 << 0)
+#define STATUS_FIELD_TEMPERATURE (1 << 1)
+#define STATUS_FIELD_HUMIDITY (1 << 2)
+#define STATUS_FIELD_POWER (1 << 3)
+#define STATUS_FIELD_BRIGHTNESS (1 << 4)
+#define STATUS_FIELD_COLOR (1 << 5)
+#define STATUS_FIELD_COLOR_TEMPERATURE (1 << 6)
+
+#define STATUS_FIELDS_METER (STATUS_FIELD_STATUS_CODE | STATUS_FIELD_TEMPERATURE | STATUS_FIELD_HUMIDITY)
+#define STATUS_FIELDS_BULB (STATUS_FIELD_STATUS_CODE | STATUS_FIELD_POWER | STATUS_FIELD_BRIGHTNESS)
+
+// SwitchBot API の statusCode（成功）
+#define SWITCHBOT_STATUS_SUCCESS 100
+
+// デバイスステータス（/v1.1/devices/{id}/status のレスポンス）
+struct DeviceStatus
+{
+    uint16_t found;       // 取り出せたフィールド（STATUS_FIELD_*）
+    int statusCode;       // statusCode（100=成功）
+    float temperature;    // 温度（℃）
+    int humidity;         // 湿度（%）
+    bool power;           // 電源状態
+    int brightness;       // 明るさ（1-100）
+    uint8_t colorR;       // 色（R:G:B）
+    uint8_t colorG;
+    uint8_t colorB;
+    int colorTemperature; // 色温度（K）
+};
+
+// ステータスレスポンスのストリーミングパーサー
+// トップレベルの statusCode と "body" 直下のフィールドだけを取り出し、
+// 他のオブジェクトにネストした同名キーは無視する。ヒープは使わない。
+class DeviceStatusParser
+{
+public:
+    // fields: 取り出すフィールド（STATUS_FIELD_* の組み合わせ）
+    explicit DeviceStatusParser(uint16_t fields);
+
+    // チャンクを投入
+    // 戻り値: 続きが必要=true, 全フィールド取得済みまたは構文エラー=false
+    bool feed(const char *data, size_t len);
+
+    // 要求した全フィールドを取得できたか
+    bool complete() const { return (status.found & wanted) == wanted; }
+
+    // 構文エラーが発生したか
+    bool failed() const { return scanner.failed(); }
+
+    const DeviceStatus &result() const { return status; }
+
+private:
+    static void onValue(void *ctx, const char *parentKey, const char *key,
+                        JsonValueType type, const char *value, bool truncated);
+
+    uint16_t wanted;
+    DeviceStatus status;
+    JsonScanner scanner;
+};
+
+#endif // DEVICE_STATUS_H
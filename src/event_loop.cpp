@@ -0,0 +1,226 @@
+#include "event_loop.h"
+#include "hal/hal_event.h"
+
+// ホイールに入れるタイマー（同じスロットのタイマーは双方向リストでつなぐ）
+struct WheelTimer
+{
+    bool armed;
+    unsigned long at; // 起こす時刻（millis）
+    int8_t prev;      // 同じスロットの前後のタイマー（なければ -1）
+    int8_t next;
+    uint8_t slot;
+};
+
+static WheelTimer timers[LOOP_TIMER_COUNT];
+static int8_t slotHead[TIMER_WHEEL_SLOTS];
+static uint32_t lastTick = 0;  // 最後にホイールを進めた目盛り
+static bool polling = (EVENT_LOOP == 0);
+static EventLoopStats stats = {};
+static uint32_t lastMarkUs = 0; // 集計期間の計測点
+
+static const char *const timerNames[LOOP_TIMER_COUNT] = {"active", "serial", "webhook", "boot", "meter",
+                                                         "battery", "screen", "bulb_off", "reconcile", "command",
+                                                         "prefetch", "gesture"};
+
+static uint32_t tickOf(unsigned long t)
+{
+    return (uint32_t)(t / TIMER_WHEEL_TICK_MS);
+}
+
+static void unlinkTimer(int t)
+{
+    WheelTimer &timer = timers[t];
+    if (timer.prev >= 0)
+        timers[timer.prev].next = timer.next;
+    else
+        slotHead[timer.slot] = timer.next;
+    if (timer.next >= 0)
+        timers[timer.next].prev = timer.prev;
+    timer.armed = false;
+}
+
+static void linkTimer(int t)
+{
+    WheelTimer &timer = timers[t];
+    timer.slot = tickOf(timer.at) % TIMER_WHEEL_SLOTS;
+    timer.prev = -1;
+    timer.next = slotHead[timer.slot];
+    if (timer.next >= 0)
+        timers[timer.next].prev = t;
+    slotHead[timer.slot] = t;
+    timer.armed = true;
+}
+
+// 前回から今までに通り過ぎたスロットを見て、時刻が来たタイマーを発火させる
+// 戻り値: 発火したタイマー（LoopTimer のビット）
+static uint32_t advance(unsigned long now)
+{
+    uint32_t nowTick = tickOf(now);
+    // 前回と同じ目盛りのスロットにも、前回より後の時刻のタイマーがあるので含める
+    uint32_t count = nowTick - lastTick + 1;
+    if (count > TIMER_WHEEL_SLOTS)
+        count = TIMER_WHEEL_SLOTS;
+
+    uint32_t fired = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        int t = slotHead[(lastTick + i) % TIMER_WHEEL_SLOTS];
+        while (t >= 0)
+        {
+            int next = timers[t].next;
+            if ((long)(now - timers[t].at) >= 0)
+            {
+                unlinkTimer(t);
+                fired |= 1u << t;
+                stats.byTimer[t]++;
+            }
+            t = next;
+        }
+    }
+    lastTick = nowTick;
+    return fired;
+}
+
+// 次に起きる時刻（タイマーがなければ false）
+// 今の目盛りからホイールを1周たどり、最初に見つかったスロットの1周以内のタイマーが最も早い
+static bool nextDeadline(unsigned long now, unsigned long &at)
+{
+    uint32_t nowTick = tickOf(now);
+    for (uint32_t i = 0; i < TIMER_WHEEL_SLOTS; i++)
+    {
+        bool found = false;
+        for (int t = slotHead[(nowTick + i) % TIMER_WHEEL_SLOTS]; t >= 0; t = timers[t].next)
+        {
+            if (tickOf(timers[t].at) - nowTick >= TIMER_WHEEL_SLOTS)
+                continue;
+            if (!found || (long)(timers[t].at - at) < 0)
+                at = timers[t].at;
+            found = true;
+        }
+        if (found)
+            return true;
+    }
+
+    // 1周より先のタイマーだけ
+    bool found = false;
+    for (int t = 0; t < LOOP_TIMER_COUNT; t++)
+    {
+        if (timers[t].armed && (!found || (long)(timers[t].at - at) < 0))
+        {
+            at = timers[t].at;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void eventLoopInit()
+{
+    halEventInit();
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++)
+        slotHead[i] = -1;
+    for (int t = 0; t < LOOP_TIMER_COUNT; t++)
+        timers[t].armed = false;
+    lastTick = tickOf(millis());
+    eventLoopResetStats();
+}
+
+void eventLoopSetPolling(bool enable)
+{
+    polling = enable;
+}
+
+void eventLoopSchedule(LoopTimer timer, unsigned long at)
+{
+    unsigned long now = millis();
+    if ((long)(at - now) < EVENT_LOOP_TICK_MS)
+        at = now + EVENT_LOOP_TICK_MS;
+
+    WheelTimer &t = timers[timer];
+    if (t.armed)
+    {
+        if (t.at == at)
+            return;
+        unlinkTimer(timer);
+    }
+    t.at = at;
+    linkTimer(timer);
+}
+
+unsigned long eventLoopNextPoll(unsigned long now)
+{
+    return (now / EVENT_LOOP_POLL_MS + 1) * EVENT_LOOP_POLL_MS;
+}
+
+void eventLoopCancel(LoopTimer timer)
+{
+    if (timers[timer].armed)
+        unlinkTimer(timer);
+}
+
+void eventLoopWait()
+{
+    uint32_t t0 = micros();
+    uint32_t bits = 0;
+    uint32_t fired = 0;
+
+    if (polling)
+    {
+        delay(EVENT_LOOP_TICK_MS);
+    }
+    else
+    {
+        // 処理中に時刻が来たタイマーがあれば待たずに回る
+        unsigned long now = millis();
+        fired = advance(now);
+        uint32_t waitMs = EVENT_LOOP_MAX_SLEEP_MS;
+        unsigned long at = 0;
+        if (fired != 0)
+            waitMs = 0;
+        else if (nextDeadline(now, at))
+            waitMs = (long)(at - now) > 0 ? min((uint32_t)(at - now), (uint32_t)EVENT_LOOP_MAX_SLEEP_MS) : 0;
+
+        bits = halEventWait(waitMs);
+        fired |= advance(millis());
+    }
+
+    uint32_t t1 = micros();
+    stats.idleUs += t1 - t0;
+    stats.elapsedUs += t1 - lastMarkUs;
+    lastMarkUs = t1;
+
+    stats.wakeups++;
+    if (bits & HAL_EVENT_TOUCH)
+        stats.byCause[LOOP_WAKE_TOUCH]++;
+    else if (bits & HAL_EVENT_NETWORK)
+        stats.byCause[LOOP_WAKE_NETWORK]++;
+    else
+        stats.byCause[LOOP_WAKE_TIMER]++;
+}
+
+EventLoopStats eventLoopGetStats()
+{
+    return stats;
+}
+
+void eventLoopResetStats()
+{
+    stats = {};
+    lastMarkUs = micros();
+}
+
+void eventLoopPrint()
+{
+    double minutes = stats.elapsedUs / 60e6;
+    Serial.printf("Loop: wakeups=%lu (%.0f/min) touch=%lu network=%lu timer=%lu idle=%.1f%% mode=%s\n",
+                  (unsigned long)stats.wakeups, minutes > 0 ? stats.wakeups / minutes : 0.0,
+                  (unsigned long)stats.byCause[LOOP_WAKE_TOUCH], (unsigned long)stats.byCause[LOOP_WAKE_NETWORK],
+                  (unsigned long)stats.byCause[LOOP_WAKE_TIMER],
+                  stats.elapsedUs > 0 ? 100.0 * stats.idleUs / stats.elapsedUs : 0.0, polling ? "poll" : "event");
+    Serial.print("Loop timers:");
+    for (int t = 0; t < LOOP_TIMER_COUNT; t++)
+    {
+        Serial.printf(" %s=%lu", timerNames[t], (unsigned long)stats.byTimer[t]);
+    }
+    Serial.println();
+}
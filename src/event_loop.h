@@ -0,0 +1,88 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <Arduino.h>
+
+// メインループを要因（タッチ・API の完了・タイマー）が来たときだけ回す
+// 0 にすると従来どおり EVENT_LOOP_TICK_MS ごとに回す
+#ifndef EVENT_LOOP
+#define EVENT_LOOP 1
+#endif
+
+// 描画の転送中・完了通知が残っている間のループ間隔（従来の delay(10) と同じ）、タイマーの最短の待ち時間
+#define EVENT_LOOP_TICK_MS 10
+
+// 割り込みで起こせない入力（シリアル・Webhook の待ち受け）を見に行く間隔
+#define EVENT_LOOP_POLL_MS 500
+
+// タッチ割り込みが使えないとき、画面がついている間にタッチを見に行く間隔
+#define EVENT_LOOP_TOUCH_POLL_MS 20
+
+// タイマーが1つもないときでも、この時間で一度起きる
+#define EVENT_LOOP_MAX_SLEEP_MS 60000
+
+// タイマーホイール（1周 約1秒、それより先のタイマーは同じスロットに入り、時刻が来た周で発火する）
+#define TIMER_WHEEL_SLOTS 128
+#define TIMER_WHEEL_TICK_MS 8
+
+// ループを起こすタイマー（それぞれ1つだけ、設定し直すと置き換わる）
+enum LoopTimer
+{
+    LOOP_TIMER_ACTIVE,    // 描画の転送中・完了通知が残っている間（TICK ごと）、タッチを見に行く間隔
+    LOOP_TIMER_SERIAL,    // シリアルコマンド
+    LOOP_TIMER_WEBHOOK,   // Webhook の待ち受け・受信中の接続
+    LOOP_TIMER_BOOT,      // WiFi 接続・時刻同期の確認
+    LOOP_TIMER_METER,     // 温湿度の定期取得
+    LOOP_TIMER_BATTERY,   // バッテリー残量
+    LOOP_TIMER_SCREEN,    // 画面オフ・復帰直後のタッチ無視の終わり
+    LOOP_TIMER_BULB_OFF,  // 遅延OFF
+    LOOP_TIMER_RECONCILE, // 操作した電球の状態確認
+    LOOP_TIMER_COMMAND,   // 保留中のコマンド・シーンの再送
+    LOOP_TIMER_PREFETCH,  // 見込んだ復帰の前の先読み
+    LOOP_TIMER_GESTURE,   // ボタンの長押しの判定（触れたまま止まっている間）
+    LOOP_TIMER_COUNT
+};
+
+// ループが起きた要因
+enum LoopWake
+{
+    LOOP_WAKE_TOUCH,   // タッチ割り込み
+    LOOP_WAKE_NETWORK, // API ジョブの完了
+    LOOP_WAKE_TIMER,   // タイマー（従来の周期実行もここに数える）
+    LOOP_WAKE_COUNT
+};
+
+// 集計
+struct EventLoopStats
+{
+    uint32_t wakeups;                   // ループが起きた回数
+    uint32_t byCause[LOOP_WAKE_COUNT];  // 要因ごとの回数
+    uint32_t byTimer[LOOP_TIMER_COUNT]; // 発火したタイマーごとの回数
+    uint64_t idleUs;                    // 待っていた時間（アイドルタスクが動ける時間、消費電流の目安）
+    uint64_t elapsedUs;                 // 集計期間
+};
+
+// 初期化（halEventInit を含む、setup で M5.begin の後に呼ぶ）
+void eventLoopInit();
+
+// 比較用: true にすると従来どおり EVENT_LOOP_TICK_MS ごとに回す
+void eventLoopSetPolling(bool polling);
+
+// at（millis）にループを起こす（設定済みなら置き換える、TICK より近い時刻は TICK 後）
+void eventLoopSchedule(LoopTimer timer, unsigned long at);
+
+// now より後の EVENT_LOOP_POLL_MS の区切り（定期的に見に行く入力の時刻をそろえ、1回の起床にまとめる）
+unsigned long eventLoopNextPoll(unsigned long now);
+
+// タイマーを止める
+void eventLoopCancel(LoopTimer timer);
+
+// 次の要因が来るまで待つ（loop() の最後に呼ぶ、従来の delay(10) の代わり）
+void eventLoopWait();
+
+// 集計取得・リセット・シリアル出力
+EventLoopStats eventLoopGetStats();
+void eventLoopResetStats();
+void eventLoopPrint();
+
+#endif // EVENT_LOOP_H
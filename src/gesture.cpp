@@ -0,0 +1,323 @@
+#include "gesture.h"
+#include "ui_layout.h"
+
+// 入力（タッチの1サンプルを分類したもの、押下は押した部品の種類ごと）
+enum GestureInput
+{
+    INPUT_DOWN_BACKGROUND,
+    INPUT_DOWN_BUTTON,
+    INPUT_DOWN_SLIDER,
+    INPUT_MOVE,  // 状態ごとのしきい値を越えて動いた
+    INPUT_HOLD,  // 押してから GESTURE_LONG_PRESS_MS 経った
+    INPUT_LEAVE, // 押した部品の外に出た
+    INPUT_UP,    // 離した
+    INPUT_COUNT,
+    INPUT_NONE = INPUT_COUNT
+};
+
+// 遷移（次の状態と UI に渡す動作）
+struct GestureTransition
+{
+    GestureState next;
+    GestureAction action;
+};
+
+// 遷移表（状態 × 入力）
+// 押下は状態によらず新しい操作として始める（離したサンプルを取りこぼした場合）
+static const GestureTransition transitions[GESTURE_STATE_COUNT][INPUT_COUNT] = {
+    // IDLE
+    {{GESTURE_BACKGROUND, GESTURE_ACTION_PRESS},
+     {GESTURE_BUTTON, GESTURE_ACTION_PRESS},
+     {GESTURE_SLIDER, GESTURE_ACTION_PRESS},
+     {GESTURE_IDLE, GESTURE_ACTION_NONE},
+     {GESTURE_IDLE, GESTURE_ACTION_NONE},
+     {GESTURE_IDLE, GESTURE_ACTION_NONE},
+     {GESTURE_IDLE, GESTURE_ACTION_NONE}},
+    // BUTTON: 長押しで ON/OFF、外に出たら取り消し
+    {{GESTURE_BACKGROUND, GESTURE_ACTION_PRESS},
+     {GESTURE_BUTTON, GESTURE_ACTION_PRESS},
+     {GESTURE_SLIDER, GESTURE_ACTION_PRESS},
+     {GESTURE_BUTTON, GESTURE_ACTION_NONE},
+     {GESTURE_DONE, GESTURE_ACTION_LONG_PRESS},
+     {GESTURE_DONE, GESTURE_ACTION_CANCEL},
+     {GESTURE_IDLE, GESTURE_ACTION_TAP}},
+    // SLIDER: 横に動いたらドラッグ
+    {{GESTURE_BACKGROUND, GESTURE_ACTION_PRESS},
+     {GESTURE_BUTTON, GESTURE_ACTION_PRESS},
+     {GESTURE_SLIDER, GESTURE_ACTION_PRESS},
+     {GESTURE_DRAGGING, GESTURE_ACTION_DRAG},
+     {GESTURE_SLIDER, GESTURE_ACTION_NONE},
+     {GESTURE_SLIDER, GESTURE_ACTION_NONE},
+     {GESTURE_IDLE, GESTURE_ACTION_TAP}},
+    // DRAGGING
+    {{GESTURE_BACKGROUND, GESTURE_ACTION_PRESS},
+     {GESTURE_BUTTON, GESTURE_ACTION_PRESS},
+     {GESTURE_SLIDER, GESTURE_ACTION_PRESS},
+     {GESTURE_DRAGGING, GESTURE_ACTION_DRAG},
+     {GESTURE_DRAGGING, GESTURE_ACTION_NONE},
+     {GESTURE_DRAGGING, GESTURE_ACTION_NONE},
+     {GESTURE_IDLE, GESTURE_ACTION_DRAG_END}},
+    // BACKGROUND: しきい値を越えたら1ページだけ送る
+    {{GESTURE_BACKGROUND, GESTURE_ACTION_PRESS},
+     {GESTURE_BUTTON, GESTURE_ACTION_PRESS},
+     {GESTURE_SLIDER, GESTURE_ACTION_PRESS},
+     {GESTURE_DONE, GESTURE_ACTION_SWIPE},
+     {GESTURE_BACKGROUND, GESTURE_ACTION_NONE},
+     {GESTURE_BACKGROUND, GESTURE_ACTION_NONE},
+     {GESTURE_IDLE, GESTURE_ACTION_TAP}},
+    // DONE
+    {{GESTURE_BACKGROUND, GESTURE_ACTION_PRESS},
+     {GESTURE_BUTTON, GESTURE_ACTION_PRESS},
+     {GESTURE_SLIDER, GESTURE_ACTION_PRESS},
+     {GESTURE_DONE, GESTURE_ACTION_NONE},
+     {GESTURE_DONE, GESTURE_ACTION_NONE},
+     {GESTURE_DONE, GESTURE_ACTION_NONE},
+     {GESTURE_IDLE, GESTURE_ACTION_NONE}},
+};
+
+// 状態ごとの入力の作り方
+struct GestureRule
+{
+    int moveThreshold; // 横の移動のしきい値（-1 なら移動を入力にしない）
+    bool fromLast;     // 前のサンプルからの移動で測る（false なら押した位置から）
+    bool leave;        // 部品の外に出たことを入力にする
+};
+
+static const GestureRule rules[GESTURE_STATE_COUNT] = {
+    {-1, false, false},                     // IDLE
+    {-1, false, true},                      // BUTTON（ボタンの中で動いても長押しを続ける）
+    {GESTURE_DRAG_THRESHOLD, false, false}, // SLIDER
+    {1, true, false},                       // DRAGGING（指がスライダーから外れても追う）
+    {PAGE_SWIPE_THRESHOLD, false, false},   // BACKGROUND
+    {-1, false, false},                     // DONE
+};
+
+static const char *const actionNames[GESTURE_ACTION_COUNT] = {"none", "press",    "tap",   "long_press",
+                                                              "drag", "drag_end", "swipe", "cancel"};
+
+// 部品（パネル位置ごとのボタン・スライダー）と格子の索引
+#define GESTURE_MAX_WIDGETS (PANELS_PER_PAGE * 2)
+#define GESTURE_GRID_COLS ((SCREEN_WIDTH + GESTURE_CELL_SIZE - 1) / GESTURE_CELL_SIZE)
+#define GESTURE_GRID_ROWS ((SCREEN_HEIGHT + GESTURE_CELL_SIZE - 1) / GESTURE_CELL_SIZE)
+#define GESTURE_CELL_EMPTY 0xFF
+
+static const GestureWidget background = {WIDGET_BACKGROUND, -1, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+static GestureWidget widgets[GESTURE_MAX_WIDGETS];
+static int widgetCount = 0;
+static uint8_t grid[GESTURE_GRID_ROWS][GESTURE_GRID_COLS][GESTURE_CELL_WIDGETS];
+
+// 認識中の操作
+static GestureState state = GESTURE_IDLE;
+static const GestureWidget *target = &background;
+static int startX = 0;
+static int lastX = 0;
+static uint32_t downAt = 0;
+
+static GestureAcceptFn acceptFn = nullptr;
+static GestureHandlerFn handlerFn = nullptr;
+static GestureStats stats = {};
+
+// 矩形の中か（右端・下端を含む）
+static bool inside(const GestureWidget &w, int x, int y)
+{
+    return x >= w.x && x <= w.x + w.w && y >= w.y && y <= w.y + w.h;
+}
+
+// 部品を登録し、重なる升目に入れる
+static void addWidget(GestureWidgetKind kind, int slot, int x0, int y0, int x1, int y1)
+{
+    GestureWidget &w = widgets[widgetCount];
+    w = {kind, slot, x0, y0, x1 - x0, y1 - y0};
+
+    int c0 = max(x0, 0) / GESTURE_CELL_SIZE;
+    int c1 = min(x1, SCREEN_WIDTH - 1) / GESTURE_CELL_SIZE;
+    int r0 = max(y0, 0) / GESTURE_CELL_SIZE;
+    int r1 = min(y1, SCREEN_HEIGHT - 1) / GESTURE_CELL_SIZE;
+    for (int r = r0; r <= r1; r++)
+    {
+        for (int c = c0; c <= c1; c++)
+        {
+            uint8_t *cell = grid[r][c];
+            int i = 0;
+            while (i < GESTURE_CELL_WIDGETS && cell[i] != GESTURE_CELL_EMPTY)
+                i++;
+            if (i < GESTURE_CELL_WIDGETS)
+                cell[i] = (uint8_t)widgetCount;
+            else
+                stats.overflowCells++;
+        }
+    }
+    widgetCount++;
+    stats.indexedWidgets = widgetCount;
+}
+
+void gestureInit(GestureAcceptFn accept, GestureHandlerFn handler)
+{
+    acceptFn = accept;
+    handlerFn = handler;
+    stats = {};
+    widgetCount = 0;
+    memset(grid, GESTURE_CELL_EMPTY, sizeof(grid));
+
+    // 部品の位置はページによらない（どの電球かはパネル位置から UI が決める）
+    for (int slot = 0; slot < PANELS_PER_PAGE; slot++)
+    {
+        int panelX0 = getPanelX(slot);
+        int panelX1 = panelX0 + PANEL_WIDTH - 1;
+        int panelY0 = getPanelY();
+        int panelY1 = panelY0 + PANEL_HEIGHT - 1;
+
+        addWidget(WIDGET_BUTTON, slot, getButtonX(slot), getButtonY(), getButtonX(slot) + getButtonWidth(),
+                  getButtonY() + BUTTON_HEIGHT);
+        addWidget(WIDGET_SLIDER, slot, max(getSliderX(slot) - GESTURE_SLIDER_SLOP, panelX0),
+                  max(getSliderY() - GESTURE_SLIDER_SLOP, panelY0),
+                  min(getSliderX(slot) + getSliderWidth() + GESTURE_SLIDER_SLOP, panelX1),
+                  min(getSliderY() + SLIDER_HEIGHT + GESTURE_SLIDER_SLOP, panelY1));
+    }
+    if (stats.overflowCells > 0)
+        Serial.printf("Gesture: %lu cells overflowed\n", (unsigned long)stats.overflowCells);
+
+    state = GESTURE_IDLE;
+    target = &background;
+}
+
+const GestureWidget &gestureHitTest(int x, int y)
+{
+    if (x < 0 || y < 0 || x >= SCREEN_WIDTH || y >= SCREEN_HEIGHT)
+        return background;
+
+    const uint8_t *cell = grid[y / GESTURE_CELL_SIZE][x / GESTURE_CELL_SIZE];
+    for (int i = 0; i < GESTURE_CELL_WIDGETS && cell[i] != GESTURE_CELL_EMPTY; i++)
+    {
+        const GestureWidget &w = widgets[cell[i]];
+        if (inside(w, x, y))
+            return w;
+    }
+    return background;
+}
+
+// サンプルを入力に分類する（離す > はみ出し > 移動 > 長押し の順）
+static GestureInput classify(const TouchState &touch, uint32_t now, const GestureWidget **pressed)
+{
+    if (touch.wasPressed)
+    {
+        const GestureWidget *w = &gestureHitTest(touch.x, touch.y);
+        if (w->kind != WIDGET_BACKGROUND && acceptFn != nullptr && !acceptFn(*w))
+            w = &background;
+        *pressed = w;
+        return (GestureInput)(INPUT_DOWN_BACKGROUND + w->kind);
+    }
+    if (touch.wasReleased)
+        return INPUT_UP;
+    if (!touch.isPressed || state == GESTURE_IDLE)
+        return INPUT_NONE;
+
+    const GestureRule &rule = rules[state];
+    if (rule.leave && !inside(*target, touch.x, touch.y))
+        return INPUT_LEAVE;
+    int dx = abs(touch.x - (rule.fromLast ? lastX : startX));
+    if (rule.moveThreshold >= 0 && dx >= rule.moveThreshold)
+        return INPUT_MOVE;
+    if (now - downAt >= GESTURE_LONG_PRESS_MS)
+        return INPUT_HOLD;
+    return INPUT_NONE;
+}
+
+void gestureUpdate(const TouchState &touch, uint32_t now)
+{
+#if GESTURE_TRACE
+    if (touch.wasPressed || touch.isPressed || touch.wasReleased)
+        Serial.printf("T %lu %d %d %d\n", (unsigned long)now, touch.x, touch.y, touch.isPressed ? 1 : 0);
+#endif
+    stats.samples++;
+
+    const GestureWidget *pressed = nullptr;
+    GestureInput input = classify(touch, now, &pressed);
+    if (input == INPUT_NONE)
+        return;
+
+    const GestureTransition &t = transitions[state][input];
+    if (pressed != nullptr)
+    {
+        target = pressed;
+        startX = touch.x;
+        downAt = now;
+    }
+    state = t.next;
+
+    if (t.action != GESTURE_ACTION_NONE)
+    {
+        stats.actions[t.action]++;
+        if (handlerFn != nullptr)
+        {
+            GestureEvent event = {t.action, target, touch.x, touch.y, touch.x - startX, now};
+            handlerFn(event);
+        }
+    }
+    lastX = touch.x;
+    if (state == GESTURE_IDLE)
+        target = &background;
+}
+
+void gestureReset()
+{
+    state = GESTURE_IDLE;
+    target = &background;
+}
+
+bool gestureNextDeadline(uint32_t &at)
+{
+    // 長押しを入力にするのはボタンを押している間だけ（他の状態では時刻が経っても遷移しない）
+    if (state != GESTURE_BUTTON)
+        return false;
+    at = downAt + GESTURE_LONG_PRESS_MS;
+    return true;
+}
+
+GestureState gestureState()
+{
+    return state;
+}
+
+bool gestureActive()
+{
+    return state != GESTURE_IDLE;
+}
+
+int gestureWidgetCount()
+{
+    return widgetCount;
+}
+
+const GestureWidget &gestureWidget(int i)
+{
+    return widgets[i];
+}
+
+const char *gestureActionName(GestureAction action)
+{
+    return actionNames[action];
+}
+
+GestureStats gestureGetStats()
+{
+    return stats;
+}
+
+void gestureResetStats()
+{
+    uint32_t indexed = stats.indexedWidgets;
+    uint32_t overflow = stats.overflowCells;
+    stats = {};
+    stats.indexedWidgets = indexed;
+    stats.overflowCells = overflow;
+}
+
+void gesturePrint()
+{
+    Serial.printf("Gesture: samples=%lu", (unsigned long)stats.samples);
+    for (int i = GESTURE_ACTION_PRESS; i < GESTURE_ACTION_COUNT; i++)
+        Serial.printf(" %s=%lu", actionNames[i], (unsigned long)stats.actions[i]);
+    Serial.printf(" widgets=%lu overflow=%lu\n", (unsigned long)stats.indexedWidgets,
+                  (unsigned long)stats.overflowCells);
+}
@@ -0,0 +1,132 @@
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include <Arduino.h>
+#include "hal/hal_touch.h"
+
+// タッチ操作の認識（部品の当たり判定と、遷移表によるタップ・長押し・ドラッグ・ページ送りの判定）
+//
+// 部品（パネル位置ごとのボタン・スライダー）は起動時に格子の索引へ登録し、
+// 当たり判定はタッチ位置の升目に入っている部品（数個）だけを調べる
+// タッチの各サンプルを入力（押下・移動・長押し・はみ出し・離す）に分類し、
+// 状態と入力の表から次の状態と動作を決める
+
+// 長押しと判定する時間
+#define GESTURE_LONG_PRESS_MS 500
+
+// スライダーのドラッグを始める横の移動量
+#define GESTURE_DRAG_THRESHOLD 20
+
+// スライダーの当たり判定を上下左右に広げる幅（パネルの外には広げない）
+#define GESTURE_SLIDER_SLOP 20
+
+// 当たり判定の索引の升目（ピクセル）と、1升に入る部品の最大数
+#define GESTURE_CELL_SIZE 40
+#define GESTURE_CELL_WIDGETS 4
+
+// タッチの記録をシリアルに出力する（ホストの gesture-bench で再生できる形式）
+#ifndef GESTURE_TRACE
+#define GESTURE_TRACE 0
+#endif
+
+// 部品の種類
+enum GestureWidgetKind
+{
+    WIDGET_BACKGROUND, // 部品のない場所（ヘッダー・余白、操作できない部品もここ扱い）
+    WIDGET_BUTTON,     // 電源ボタン（長押しで ON/OFF）
+    WIDGET_SLIDER,     // 明るさのスライダー（横ドラッグ）
+    WIDGET_KIND_COUNT
+};
+
+// 部品（当たり判定の矩形は画面座標）
+struct GestureWidget
+{
+    GestureWidgetKind kind;
+    int slot; // ページ内のパネル位置（背景は -1）
+    int x, y, w, h;
+};
+
+// 認識の状態
+enum GestureState
+{
+    GESTURE_IDLE,       // 触れていない
+    GESTURE_BUTTON,     // ボタンを押している（長押し待ち）
+    GESTURE_SLIDER,     // スライダーを押している（ドラッグ待ち）
+    GESTURE_DRAGGING,   // スライダーをドラッグ中
+    GESTURE_BACKGROUND, // 部品以外を押している（ページ送り待ち）
+    GESTURE_DONE,       // 判定済み・取り消し（離すまで何もしない）
+    GESTURE_STATE_COUNT
+};
+
+// 動作（認識した結果として UI に渡す）
+enum GestureAction
+{
+    GESTURE_ACTION_NONE,
+    GESTURE_ACTION_PRESS,      // 部品・背景を押した
+    GESTURE_ACTION_TAP,        // 長押し・ドラッグ・ページ送りにならずに離した
+    GESTURE_ACTION_LONG_PRESS, // ボタンの長押し
+    GESTURE_ACTION_DRAG,       // スライダーのドラッグ（移動のたび）
+    GESTURE_ACTION_DRAG_END,   // ドラッグを終えて離した
+    GESTURE_ACTION_SWIPE,      // ページ送り（dx の向き）
+    GESTURE_ACTION_CANCEL,     // ボタンから外れた
+    GESTURE_ACTION_COUNT
+};
+
+// UI に渡す動作の内容
+struct GestureEvent
+{
+    GestureAction action;
+    const GestureWidget *widget;
+    int x, y;    // 現在のタッチ位置
+    int dx;      // 押した位置からの横の移動量
+    uint32_t at; // サンプルの時刻（ミリ秒）
+};
+
+// 集計
+struct GestureStats
+{
+    uint32_t samples;                       // 処理したタッチのサンプル
+    uint32_t actions[GESTURE_ACTION_COUNT]; // 動作ごとの回数
+    uint32_t indexedWidgets;                // 索引に登録した部品
+    uint32_t overflowCells;                 // 部品が入りきらなかった升目（0 であること）
+};
+
+// 押した部品で操作を始めてよいか（false なら背景として扱う、nullptr なら常に true）
+typedef bool (*GestureAcceptFn)(const GestureWidget &widget);
+
+// 動作の通知
+typedef void (*GestureHandlerFn)(const GestureEvent &event);
+
+// 部品を登録して索引を作る
+void gestureInit(GestureAcceptFn accept, GestureHandlerFn handler);
+
+// 画面座標の部品（なければ背景）
+const GestureWidget &gestureHitTest(int x, int y);
+
+// タッチの1サンプルを処理する（動作があれば handler を呼ぶ）
+void gestureUpdate(const TouchState &touch, uint32_t now);
+
+// 認識を途中でやめる（画面の減光・復帰時、離すまで何もしない）
+void gestureReset();
+
+// 指を動かさなくても時刻だけで入力になる次の時刻（ボタンの長押し、なければ false）
+// タッチの割り込みでループを起こすとき、触れたまま止まっている間はこの時刻にだけ起こせばよい
+bool gestureNextDeadline(uint32_t &at);
+
+// 現在の状態・操作中か（触れている間）
+GestureState gestureState();
+bool gestureActive();
+
+// 登録した部品（索引を使わない全件走査の比較用）
+int gestureWidgetCount();
+const GestureWidget &gestureWidget(int i);
+
+// 名前（記録・ベンチマークの出力用）
+const char *gestureActionName(GestureAction action);
+
+// 集計取得・リセット・シリアル出力
+GestureStats gestureGetStats();
+void gestureResetStats();
+void gesturePrint();
+
+#endif // GESTURE_H
@@ -0,0 +1,230 @@
+// M5Stack Tab5 用のHAL実装（時計・タッチ・電源・ヒープ・ストレージ・イベント）
+#include <M5Unified.h>
+#include <LittleFS.h>
+#include <esp_heap_caps.h>
+#include <freertos/event_groups.h>
+
+#include "hal/hal_clock.h"
+#include "hal/hal_event.h"
+#include "hal/hal_memory.h"
+#include "hal/hal_power.h"
+#include "hal/hal_storage.h"
+#include "hal/hal_touch.h"
+
+static TouchState touchState = {};
+
+// タッチコントローラ（GT911）の INT 端子（-1 にするとタッチは定期的に見に行く）
+// 触れている間、GT911 は報告ごとに INT を Low にパルスする
+#ifndef TAB5_TOUCH_INT_PIN
+#define TAB5_TOUCH_INT_PIN 23
+#endif
+
+// 触れたまま動いていない間は、報告ごとの INT では起こさずこの間隔でだけ起こす（離したことにはこの間隔で気づく）
+#ifndef TAB5_TOUCH_STILL_WAKE_MS
+#define TAB5_TOUCH_STILL_WAKE_MS 50
+#endif
+
+// メインループを起こす要因
+#define EVENT_BITS_ALL (HAL_EVENT_TOUCH | HAL_EVENT_NETWORK)
+static EventGroupHandle_t eventGroup = nullptr;
+
+// 直近に読んだタッチが、前に読んだ位置から動かずに触れたままか
+static bool touchStill = false;
+static uint32_t touchReadAt = 0;
+
+// ストレージ（huge_app.csv の spiffs パーティションを LittleFS で使う）
+#define STORAGE_PARTITION "spiffs"
+#define STORAGE_PATH_LEN 48
+static bool storageMounted = false;
+
+uint32_t halMillis()
+{
+    return millis();
+}
+
+uint32_t halMicros()
+{
+    return micros();
+}
+
+void halDelay(uint32_t ms)
+{
+    delay(ms);
+}
+
+static void IRAM_ATTR onTouchInterrupt()
+{
+    BaseType_t woken = pdFALSE;
+    xEventGroupSetBitsFromISR(eventGroup, HAL_EVENT_TOUCH, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void halEventInit()
+{
+    if (eventGroup != nullptr)
+        return;
+    eventGroup = xEventGroupCreate();
+
+#if TAB5_TOUCH_INT_PIN >= 0
+    // M5.begin() でタッチコントローラを初期化した後に呼ぶこと（INT 端子はアドレス選択にも使われる）
+    attachInterrupt(digitalPinToInterrupt(TAB5_TOUCH_INT_PIN), onTouchInterrupt, FALLING);
+#endif
+}
+
+void halEventSignal(uint32_t bits)
+{
+    if (eventGroup != nullptr)
+        xEventGroupSetBits(eventGroup, bits);
+}
+
+uint32_t halEventWait(uint32_t timeoutMs)
+{
+    if (eventGroup == nullptr)
+    {
+        delay(timeoutMs);
+        return 0;
+    }
+    uint32_t start = millis();
+    uint32_t bits =
+        xEventGroupWaitBits(eventGroup, EVENT_BITS_ALL, pdTRUE, pdFALSE, pdMS_TO_TICKS(timeoutMs)) & EVENT_BITS_ALL;
+    if (bits != HAL_EVENT_TOUCH || !touchStill)
+        return bits;
+
+    // 止まった指の報告だけなら、前に読んでから TAB5_TOUCH_STILL_WAKE_MS までは API の完了だけを待つ
+    uint32_t since = millis() - touchReadAt;
+    uint32_t waited = millis() - start;
+    if (since >= TAB5_TOUCH_STILL_WAKE_MS || waited >= timeoutMs)
+        return bits;
+    uint32_t holdMs = min(TAB5_TOUCH_STILL_WAKE_MS - since, timeoutMs - waited);
+    bits |= xEventGroupWaitBits(eventGroup, HAL_EVENT_NETWORK, pdTRUE, pdFALSE, pdMS_TO_TICKS(holdMs)) & EVENT_BITS_ALL;
+    xEventGroupClearBits(eventGroup, HAL_EVENT_TOUCH);
+    return bits;
+}
+
+bool halTouchCanWake()
+{
+    return TAB5_TOUCH_INT_PIN >= 0 && eventGroup != nullptr;
+}
+
+void halTouchUpdate()
+{
+    M5.update();
+
+    auto touch = M5.Touch.getDetail();
+    touchStill = touch.isPressed() && !touch.wasPressed() && touch.x == touchState.x && touch.y == touchState.y;
+    touchReadAt = millis();
+    touchState.x = touch.x;
+    touchState.y = touch.y;
+    touchState.wasPressed = touch.wasPressed();
+    touchState.isPressed = touch.isPressed();
+    touchState.wasReleased = touch.wasReleased();
+    touchState.isHolding = touch.isHolding();
+}
+
+TouchState halTouchRead()
+{
+    return touchState;
+}
+
+int halBatteryLevel()
+{
+    return M5.Power.getBatteryLevel();
+}
+
+bool halBatteryCharging()
+{
+    return M5.Power.isCharging() == m5::Power_Class::is_charging;
+}
+
+HalHeapInfo halHeapInfo()
+{
+    // String・HTTPClient が使う内部 RAM（PSRAM の温湿度の履歴は含めない）
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+
+    HalHeapInfo heap;
+    heap.freeBytes = info.total_free_bytes;
+    heap.largestFreeBlock = info.largest_free_block;
+    heap.minFreeBytes = info.minimum_free_bytes;
+    heap.allocatedBlocks = info.allocated_blocks;
+    return heap;
+}
+
+bool halHeapTaskCounts(uint32_t &allocs, uint32_t &frees)
+{
+    allocs = 0;
+    frees = 0;
+    return false;
+}
+
+// 初回の読み書きでマウント（フォーマットされていなければフォーマットする）
+static bool mountStorage()
+{
+    if (!storageMounted)
+    {
+        storageMounted = LittleFS.begin(true, "/littlefs", 5, STORAGE_PARTITION);
+        if (!storageMounted)
+            Serial.println("LittleFS mount failed");
+    }
+    return storageMounted;
+}
+
+static void storagePath(char *path, const char *name, const char *suffix)
+{
+    snprintf(path, STORAGE_PATH_LEN, "/%s%s", name, suffix);
+}
+
+bool halStorageRead(const char *name, void *buf, size_t size, size_t *len)
+{
+    if (!mountStorage())
+        return false;
+
+    char path[STORAGE_PATH_LEN];
+    storagePath(path, name, "");
+    if (!LittleFS.exists(path))
+        return false;
+
+    File file = LittleFS.open(path, "r");
+    if (!file)
+        return false;
+    size_t fileSize = file.size();
+    bool ok = fileSize <= size && file.read((uint8_t *)buf, fileSize) == fileSize;
+    file.close();
+    if (ok)
+        *len = fileSize;
+    return ok;
+}
+
+bool halStorageWrite(const char *name, const void *data, size_t len)
+{
+    if (!mountStorage())
+        return false;
+
+    char path[STORAGE_PATH_LEN];
+    char tmpPath[STORAGE_PATH_LEN];
+    storagePath(path, name, "");
+    storagePath(tmpPath, name, ".tmp");
+
+    File file = LittleFS.open(tmpPath, "w");
+    if (!file)
+        return false;
+    bool ok = file.write((const uint8_t *)data, len) == len;
+    file.close();
+
+    // LittleFS の rename は置き換え先があっても原子的に置き換わる
+    if (ok)
+        ok = LittleFS.rename(tmpPath, path);
+    if (!ok)
+        LittleFS.remove(tmpPath);
+    return ok;
+}
+
+void halStorageRemove(const char *name)
+{
+    if (!mountStorage())
+        return;
+
+    char path[STORAGE_PATH_LEN];
+    storagePath(path, name, "");
+    LittleFS.remove(path);
+}
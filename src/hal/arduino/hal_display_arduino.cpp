@@ -0,0 +1,133 @@
+// M5Stack Tab5 用の表示HAL（M5.Display と PSRAM 上の M5Canvas）
+#include <M5Unified.h>
+
+#include "hal/hal_display.h"
+
+struct HalSurface
+{
+    M5Canvas canvas;
+};
+
+// 描画先（nullptr は画面）
+static lgfx::LovyanGFX &target(HalSurface *s)
+{
+    if (s == nullptr)
+        return M5.Display;
+    return s->canvas;
+}
+
+static const lgfx::IFont *fontOf(HalFont font)
+{
+    switch (font)
+    {
+    case HAL_FONT_JP_28:
+        return &fonts::lgfxJapanGothic_28;
+    case HAL_FONT_JP_20:
+        return &fonts::lgfxJapanGothic_20;
+    case HAL_FONT_SANS_18:
+        return &fonts::FreeSansBold18pt7b;
+    case HAL_FONT_SANS_12:
+    default:
+        return &fonts::FreeSansBold12pt7b;
+    }
+}
+
+static textdatum_t datumOf(HalTextDatum datum)
+{
+    switch (datum)
+    {
+    case HAL_DATUM_ML:
+        return ML_DATUM;
+    case HAL_DATUM_MR:
+        return MR_DATUM;
+    case HAL_DATUM_MC:
+    default:
+        return MC_DATUM;
+    }
+}
+
+void halDisplayInit()
+{
+    M5.Display.setRotation(1);
+    M5.Display.initDMA();
+}
+
+void halDisplaySetBacklight(uint8_t level)
+{
+    M5.Display.setBrightness(level);
+}
+
+HalSurface *halSurfaceCreate(int w, int h)
+{
+    // 起動時に一度だけ確保する（解放はしない）
+    HalSurface *s = new HalSurface();
+    s->canvas.setColorDepth(16);
+    s->canvas.setPsram(true);
+    if (s->canvas.createSprite(w, h) == nullptr)
+    {
+        delete s;
+        return nullptr;
+    }
+    return s;
+}
+
+void halDrawFillRect(HalSurface *s, int x, int y, int w, int h, uint16_t color)
+{
+    target(s).fillRect(x, y, w, h, color);
+}
+
+void halDrawFillRoundRect(HalSurface *s, int x, int y, int w, int h, int r, uint16_t color)
+{
+    target(s).fillRoundRect(x, y, w, h, r, color);
+}
+
+void halDrawFillCircle(HalSurface *s, int cx, int cy, int r, uint16_t color)
+{
+    target(s).fillCircle(cx, cy, r, color);
+}
+
+void halDrawText(HalSurface *s, const char *text, int x, int y, HalFont font, HalTextDatum datum, uint16_t color)
+{
+    lgfx::LovyanGFX &dst = target(s);
+    dst.setTextSize(1);
+    dst.setFont(fontOf(font));
+    dst.setTextColor(color);
+    dst.setTextDatum(datumOf(datum));
+    dst.drawString(text, x, y);
+}
+
+void halDrawSetClip(HalSurface *s, int x, int y, int w, int h)
+{
+    target(s).setClipRect(x, y, w, h);
+}
+
+void halDrawClearClip(HalSurface *s)
+{
+    target(s).clearClipRect();
+}
+
+void halSurfaceCopy(HalSurface *src, HalSurface *dst, int x, int y)
+{
+    src->canvas.pushSprite(&target(dst), x, y);
+}
+
+void halDisplayStartWrite()
+{
+    M5.Display.startWrite();
+}
+
+void halDisplayEndWrite()
+{
+    M5.Display.endWrite();
+}
+
+void halDisplayPushSurface(HalSurface *src, int x, int y)
+{
+    M5Canvas &c = src->canvas;
+    M5.Display.pushImageDMA(x, y, c.width(), c.height(), (const lgfx::swap565_t *)c.getBuffer());
+}
+
+void halDisplayWaitDMA()
+{
+    M5.Display.waitDMA();
+}
@@ -0,0 +1,54 @@
+// HTTPSトランスポート（keep-aliveコネクションプール経由）
+#include "hal/hal_http.h"
+#include "api_connection.h"
+
+void halHttpInit() {
+    apiConnInit();
+}
+
+int halHttpRequest(const char* url, const HalHttpHeader* headers, int headerCount,
+                   const char* body, uint16_t timeoutMs, HalBodySink sink, void* ctx,
+                   HalHttpTiming* timing) {
+    HalHttpTiming t = {};
+    ApiConnection* conn = apiConnAcquire();
+    if (conn == nullptr) {
+        Serial.println("Error: no free API connection");
+        return -1;
+    }
+
+    // keep-alive中のセッションを再利用し、サーバー側で切断されていたら1回だけ再接続する
+    int code = -1;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (!apiConnBegin(conn, url, timeoutMs)) {
+            Serial.println("Failed to begin HTTPS");
+            break;
+        }
+
+        t.phaseUs[HAL_HTTP_PHASE_DNS] += conn->dnsUs;
+        t.phaseUs[HAL_HTTP_PHASE_CONNECT] += conn->connectUs;
+
+        unsigned long t0 = micros();
+        code = apiConnSend(conn, url, headers, headerCount, body);
+        unsigned long t1 = micros();
+        t.phaseUs[HAL_HTTP_PHASE_TTFB] += t1 - t0;
+
+        if (code > 0) {
+            if (!apiConnReadBody(conn, sink, ctx)) {
+                code = API_CONN_ERROR_READ_TIMEOUT;
+            }
+            t.phaseUs[HAL_HTTP_PHASE_BODY] += micros() - t1;
+        }
+
+        if (!apiConnEnd(conn, code)) {
+            break;
+        }
+        Serial.println("Connection closed by server, reconnecting...");
+    }
+
+    t.reused = conn->reused;
+    if (timing != nullptr) {
+        *timing = t;
+    }
+    apiConnRelease(conn);
+    return code;
+}
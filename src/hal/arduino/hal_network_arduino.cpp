@@ -0,0 +1,41 @@
+// WiFi接続・NTP時刻同期（M5Stack Tab5）
+#include <Arduino.h>
+#include <WiFi.h>
+#include <time.h>
+
+#include "secrets.h"
+#include "hal/hal_clock.h"
+#include "hal/hal_network.h"
+
+// Tab5 WiFi SDIO2 ピン設定
+// ESP32-P4とESP32-C6間のSDIO通信用
+#define TAB5_SDIO_CLK  12
+#define TAB5_SDIO_CMD  13
+#define TAB5_SDIO_D0   11
+#define TAB5_SDIO_D1   10
+#define TAB5_SDIO_D2   9
+#define TAB5_SDIO_D3   8
+#define TAB5_C6_RST    15
+
+void halNetworkBegin() {
+    // Tab5用SDIOピン設定（ESP32-C6との通信用）
+    // arduino-esp32 3.2.1以上でWiFi.setPins()が利用可能
+    WiFi.setPins(TAB5_SDIO_CLK, TAB5_SDIO_CMD, TAB5_SDIO_D0, TAB5_SDIO_D1, TAB5_SDIO_D2, TAB5_SDIO_D3, TAB5_C6_RST);
+    WiFi.begin(WIFI_SSID, WIFI_PASS);
+
+    // SNTP は接続後にバックグラウンドで同期する
+    configTime(9 * 3600, 0, "ntp.nict.jp", "pool.ntp.org");
+}
+
+bool halNetworkConnected() {
+    return WiFi.status() == WL_CONNECTED;
+}
+
+bool halNetworkTimeSynced() {
+    return time(nullptr) >= EPOCH_VALID;
+}
+
+void halNetworkReconnect() {
+    // Tab5 では WiFi.mode(WIFI_OFF) を使えないので reconnect だけ
+    WiFi.reconnect();
+}
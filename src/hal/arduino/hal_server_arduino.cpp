@@ -0,0 +1,69 @@
+// LAN からの接続を受け付ける TCP サーバー（M5Stack Tab5、WiFiServer）
+#include <Arduino.h>
+#include <WiFi.h>
+
+#include "hal/hal_server.h"
+
+static WiFiServer server;
+static WiFiClient clients[HAL_SERVER_MAX_CLIENTS];
+static bool used[HAL_SERVER_MAX_CLIENTS]; // WiFiClient の bool 変換は切断後に false になるので別に持つ
+static uint16_t listeningPort = 0;
+
+static bool validClient(int client) {
+    return client >= 0 && client < HAL_SERVER_MAX_CLIENTS && used[client];
+}
+
+bool halServerBegin(uint16_t port) {
+    if (listeningPort != 0) return true;
+    if (WiFi.status() != WL_CONNECTED) return false;
+
+    server.begin(port);
+    listeningPort = port;
+    return true;
+}
+
+uint16_t halServerPort() {
+    return listeningPort;
+}
+
+int halServerAccept() {
+    if (listeningPort == 0) return -1;
+
+    WiFiClient client = server.accept();
+    if (!client) return -1;
+
+    for (int i = 0; i < HAL_SERVER_MAX_CLIENTS; i++) {
+        if (!used[i]) {
+            clients[i] = client;
+            clients[i].setNoDelay(true);
+            used[i] = true;
+            return i;
+        }
+    }
+    // 空きがなければすぐに閉じる（送り元は再送する）
+    client.stop();
+    return -1;
+}
+
+int halServerRead(int client, char* buf, size_t size) {
+    if (!validClient(client)) return -1;
+
+    // 切断後も受信済みのデータは読める
+    int available = clients[client].available();
+    if (available > 0) {
+        return clients[client].read((uint8_t*)buf, min((size_t)available, size));
+    }
+    return clients[client].connected() ? 0 : -1;
+}
+
+void halServerWrite(int client, const char* data, size_t len) {
+    if (!validClient(client)) return;
+    clients[client].write((const uint8_t*)data, len);
+}
+
+void halServerClose(int client) {
+    if (!validClient(client)) return;
+    clients[client].stop();
+    clients[client] = WiFiClient();
+    used[client] = false;
+}
@@ -0,0 +1,19 @@
+#ifndef HAL_CLOCK_H
+#define HAL_CLOCK_H
+
+#include <stdint.h>
+
+// time() がこれより前なら時刻同期前（2024-01-01）
+// 同期前の時刻は保存・記録に使わない（状態・コマンドの記録・温湿度の履歴・呼び出し回数の日付）
+#define EPOCH_VALID 1704067200
+
+// 起動からの経過時間（ミリ秒）
+uint32_t halMillis();
+
+// 起動からの経過時間（マイクロ秒）
+uint32_t halMicros();
+
+// 指定時間待つ
+void halDelay(uint32_t ms);
+
+#endif // HAL_CLOCK_H
@@ -0,0 +1,58 @@
+#ifndef HAL_DISPLAY_H
+#define HAL_DISPLAY_H
+
+#include <stdint.h>
+
+// 描画面（実機では PSRAM 上の M5Canvas、ホストではメモリ上の RGB565 配列）
+// 描画関数の面に nullptr を渡すと画面そのものに描く
+struct HalSurface;
+
+// 文字のフォント（実機の LovyanGFX のフォントに対応する）
+enum HalFont
+{
+    HAL_FONT_JP_28,   // lgfxJapanGothic_28（電球名）
+    HAL_FONT_JP_20,   // lgfxJapanGothic_20（注記）
+    HAL_FONT_SANS_18, // FreeSansBold18pt7b（ボタン・ヘッダー）
+    HAL_FONT_SANS_12, // FreeSansBold12pt7b（明るさ表示）
+};
+
+// 文字の基準位置（縦はいずれも中央）
+enum HalTextDatum
+{
+    HAL_DATUM_ML, // 左端
+    HAL_DATUM_MC, // 中央
+    HAL_DATUM_MR, // 右端
+};
+
+// 画面の向きを設定してDMA転送を使えるようにする
+void halDisplayInit();
+
+// バックライト輝度（0-255）
+void halDisplaySetBacklight(uint8_t level);
+
+// w x h の描画面を確保する（実機では PSRAM、確保できなければ nullptr）
+HalSurface *halSurfaceCreate(int w, int h);
+
+// 描画（座標は面の左上が原点、クリップ範囲の外は描かない）
+void halDrawFillRect(HalSurface *s, int x, int y, int w, int h, uint16_t color);
+void halDrawFillRoundRect(HalSurface *s, int x, int y, int w, int h, int r, uint16_t color);
+void halDrawFillCircle(HalSurface *s, int cx, int cy, int r, uint16_t color);
+void halDrawText(HalSurface *s, const char *text, int x, int y, HalFont font, HalTextDatum datum, uint16_t color);
+
+// クリップ範囲の設定と解除
+void halDrawSetClip(HalSurface *s, int x, int y, int w, int h);
+void halDrawClearClip(HalSurface *s);
+
+// 面 src を面 dst の (x, y) に写す（dst のクリップ範囲だけ）
+void halSurfaceCopy(HalSurface *src, HalSurface *dst, int x, int y);
+
+// 画面への書き込みトランザクション
+void halDisplayStartWrite();
+void halDisplayEndWrite();
+
+// 面 src を画面の (x, y) にDMAで送る（画面のクリップ範囲だけ）
+// 転送中も src は読まれるため、次に書き換える前に halDisplayWaitDMA で完了を待つ
+void halDisplayPushSurface(HalSurface *src, int x, int y);
+void halDisplayWaitDMA();
+
+#endif // HAL_DISPLAY_H
@@ -0,0 +1,23 @@
+#ifndef HAL_EVENT_H
+#define HAL_EVENT_H
+
+#include <stdint.h>
+
+// 待機中のメインループを起こす要因（ビット）
+#define HAL_EVENT_TOUCH (1u << 0)   // タッチ割り込み
+#define HAL_EVENT_NETWORK (1u << 1) // API ジョブの完了（ワーカータスクから）
+
+// 初期化（他のタスクが halEventSignal を呼ぶ前に、UIスレッドで1回呼ぶ）
+void halEventInit();
+
+// 要因を通知してメインループを起こす（どのタスクからでも呼べる）
+void halEventSignal(uint32_t bits);
+
+// 要因が届くか timeoutMs が経つまで待つ（待っている間 CPU はアイドルタスクに渡る）
+// 戻り値: 届いた要因（タイムアウトなら 0）、返した要因は消える
+uint32_t halEventWait(uint32_t timeoutMs);
+
+// タッチ割り込みでループを起こせるか（false ならタッチは定期的に見に行く）
+bool halTouchCanWake();
+
+#endif // HAL_EVENT_H
@@ -0,0 +1,51 @@
+#ifndef HAL_HTTP_H
+#define HAL_HTTP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 同時に送れるリクエスト数の上限（実機では接続プールのサイズ）
+#ifndef HAL_HTTP_MAX_CONCURRENT
+#define HAL_HTTP_MAX_CONCURRENT 4
+#endif
+
+// リクエストヘッダー
+struct HalHttpHeader
+{
+    const char *name;
+    const char *value;
+};
+
+// リクエストの段階
+enum HalHttpPhase
+{
+    HAL_HTTP_PHASE_DNS,     // 名前解決（新規接続時のみ）
+    HAL_HTTP_PHASE_CONNECT, // TCP接続+TLSハンドシェイク（新規接続時のみ）
+    HAL_HTTP_PHASE_TTFB,    // リクエスト送信からレスポンスヘッダー受信まで
+    HAL_HTTP_PHASE_BODY,    // レスポンスボディの受信と解析
+    HAL_HTTP_PHASE_COUNT
+};
+
+// 段階ごとの所要時間（マイクロ秒、再接続した場合は合計）
+struct HalHttpTiming
+{
+    uint32_t phaseUs[HAL_HTTP_PHASE_COUNT];
+    bool reused; // 既存セッションを再利用したか
+};
+
+// レスポンスボディの受け取り先
+// 戻り値: 続きが必要=true, もう不要=false
+typedef bool (*HalBodySink)(void *ctx, const char *data, size_t len);
+
+// HTTPトランスポート初期化
+void halHttpInit();
+
+// HTTPSリクエストを送信し、レスポンスボディを sink に流す
+// body が nullptr なら GET、それ以外は POST
+// timing が nullptr でなければ段階ごとの所要時間を書き込む
+// 戻り値: HTTPステータスコード（負値は通信エラー）
+int halHttpRequest(const char *url, const HalHttpHeader *headers, int headerCount,
+                   const char *body, uint16_t timeoutMs, HalBodySink sink, void *ctx,
+                   HalHttpTiming *timing);
+
+#endif // HAL_HTTP_H
@@ -0,0 +1,23 @@
+#ifndef HAL_MEMORY_H
+#define HAL_MEMORY_H
+
+#include <stdint.h>
+
+// ヒープの状態（長時間動かしたときの断片化の確認用）
+// ホストでは空き・最大ブロックは取れないので 0（確保中のブロック数は C++ の new で数える）
+struct HalHeapInfo
+{
+    uint32_t freeBytes;        // 空き
+    uint32_t largestFreeBlock; // 一度に確保できる最大の大きさ
+    uint32_t minFreeBytes;     // 起動してからの空きの最小
+    uint32_t allocatedBlocks;  // 確保中のブロック数
+};
+
+// 内部 RAM のヒープの状態
+HalHeapInfo halHeapInfo();
+
+// 呼び出したタスクがこれまでに行った確保・解放の回数
+// 戻り値: 数えられる=true（実機はタスクごとに数えられないので false）
+bool halHeapTaskCounts(uint32_t &allocs, uint32_t &frees);
+
+#endif // HAL_MEMORY_H
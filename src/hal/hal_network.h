@@ -0,0 +1,18 @@
+#ifndef HAL_NETWORK_H
+#define HAL_NETWORK_H
+
+// ネットワーク接続と時刻同期（どちらもバックグラウンドで進み、呼び出し側を待たせない）
+
+// WiFi接続と NTP 時刻同期を開始
+void halNetworkBegin();
+
+// WiFiに接続しているか
+bool halNetworkConnected();
+
+// 時刻が同期済みか（API 署名のタイムスタンプに必要）
+bool halNetworkTimeSynced();
+
+// 接続をやり直す（接続できないまま時間が経ったとき）
+void halNetworkReconnect();
+
+#endif // HAL_NETWORK_H
@@ -0,0 +1,10 @@
+#ifndef HAL_POWER_H
+#define HAL_POWER_H
+
+// バッテリー残量（%、取得できなければ負値）
+int halBatteryLevel();
+
+// 外部電源から充電中か（判定できなければ false）
+bool halBatteryCharging();
+
+#endif // HAL_POWER_H
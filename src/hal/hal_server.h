@@ -0,0 +1,36 @@
+#ifndef HAL_SERVER_H
+#define HAL_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// LAN からの接続を受け付ける TCP サーバー（Webhook の受け口）
+// どの関数も待たずに戻るので、メインループから毎回呼んでよい
+
+// 同時に受け付ける接続数
+#ifndef HAL_SERVER_MAX_CLIENTS
+#define HAL_SERVER_MAX_CLIENTS 2
+#endif
+
+// 待ち受けを開始（開始済みなら何もしない、port が 0 なら空いているポートを使う）
+// 戻り値: 待ち受けている=true
+bool halServerBegin(uint16_t port);
+
+// 待ち受けているポート（開始していなければ 0）
+uint16_t halServerPort();
+
+// 新しい接続を受け付ける
+// 戻り値: 接続番号（0 から HAL_SERVER_MAX_CLIENTS-1）、新しい接続がない・空きがなければ -1
+int halServerAccept();
+
+// 受信済みのデータを読む
+// 戻り値: 読んだバイト数、まだ届いていなければ 0、切断された・エラーなら -1
+int halServerRead(int client, char *buf, size_t size);
+
+// データを送る
+void halServerWrite(int client, const char *data, size_t len);
+
+// 接続を閉じる
+void halServerClose(int client);
+
+#endif // HAL_SERVER_H
@@ -0,0 +1,18 @@
+#ifndef HAL_STORAGE_H
+#define HAL_STORAGE_H
+
+#include <stddef.h>
+
+// 不揮発ストレージ（名前付きの小さなバイナリ。実機は LittleFS、ホストはファイル）
+
+// name のデータを buf に読み込む（len に読み込んだバイト数）
+// 戻り値: 読めた=true, 存在しない・size より大きい=false
+bool halStorageRead(const char *name, void *buf, size_t size, size_t *len);
+
+// name にデータを書き込む（一時ファイルに書いてから置き換えるため、途中で電源が切れても前のデータが残る）
+bool halStorageWrite(const char *name, const void *data, size_t len);
+
+// name のデータを消す
+void halStorageRemove(const char *name);
+
+#endif // HAL_STORAGE_H
@@ -0,0 +1,23 @@
+#ifndef HAL_TOUCH_H
+#define HAL_TOUCH_H
+
+#include <stdint.h>
+
+// タッチ状態（1点のみ）
+struct TouchState
+{
+    int x;
+    int y;
+    bool wasPressed;  // このフレームで押された
+    bool isPressed;   // 押されている
+    bool wasReleased; // このフレームで離された
+    bool isHolding;   // 長押し中
+};
+
+// タッチ状態を更新（フレームごとに1回呼ぶ）
+void halTouchUpdate();
+
+// 最後に更新したタッチ状態
+TouchState halTouchRead();
+
+#endif // HAL_TOUCH_H
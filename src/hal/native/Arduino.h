@@ -0,0 +1,139 @@
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+// ホスト（native）ビルド用の Arduino 互換シム
+// このリポジトリで使っている範囲だけを実装する
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
+#include "hal/hal_clock.h"
+
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Arduino String の部分集合
+class String
+{
+public:
+    String() {}
+    String(const char *s) : str(s != nullptr ? s : "") {}
+    String(const std::string &s) : str(s) {}
+    explicit String(int v) : str(std::to_string(v)) {}
+    explicit String(long v) : str(std::to_string(v)) {}
+    explicit String(unsigned int v) : str(std::to_string(v)) {}
+    explicit String(unsigned long v) : str(std::to_string(v)) {}
+
+    const char *c_str() const { return str.c_str(); }
+    unsigned int length() const { return (unsigned int)str.length(); }
+    bool isEmpty() const { return str.empty(); }
+
+    // 従来の indexOf / substring による解析との比較用（見つからなければ -1）
+    int indexOf(const char *s, unsigned int from = 0) const
+    {
+        size_t pos = str.find(s, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    int indexOf(char c, unsigned int from = 0) const
+    {
+        size_t pos = str.find(c, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        if (from > to)
+            std::swap(from, to);
+        if (from >= str.length())
+            return String();
+        return String(str.substr(from, to - from));
+    }
+    long toInt() const { return atol(str.c_str()); }
+    float toFloat() const { return (float)atof(str.c_str()); }
+
+    String &operator+=(const String &rhs)
+    {
+        str += rhs.str;
+        return *this;
+    }
+    String &operator+=(const char *rhs)
+    {
+        str += rhs;
+        return *this;
+    }
+
+    bool operator==(const String &rhs) const { return str == rhs.str; }
+    bool operator==(const char *rhs) const { return str == rhs; }
+    bool operator!=(const String &rhs) const { return str != rhs.str; }
+
+    friend String operator+(const String &lhs, const String &rhs) { return String(lhs.str + rhs.str); }
+    friend String operator+(const String &lhs, const char *rhs) { return String(lhs.str + rhs); }
+    friend String operator+(const char *lhs, const String &rhs) { return String(lhs + rhs.str); }
+
+private:
+    std::string str;
+};
+
+// Stream の部分集合（HTTPClient::writeToStream の出力先）
+class Stream
+{
+public:
+    virtual ~Stream() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *data, size_t len)
+    {
+        for (size_t i = 0; i < len; i++)
+            write(data[i]);
+        return len;
+    }
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+// シリアル出力は標準出力へ
+class NativeSerial
+{
+public:
+    void begin(unsigned long) {}
+
+    int printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        va_list args;
+        va_start(args, format);
+        int n = vprintf(format, args);
+        va_end(args);
+        fflush(stdout);
+        return n;
+    }
+
+    void print(const char *s) { fputs(s, stdout); }
+    void print(const String &s) { print(s.c_str()); }
+    void println() { fputs("\n", stdout); }
+    void println(const char *s)
+    {
+        fputs(s, stdout);
+        fputs("\n", stdout);
+        fflush(stdout);
+    }
+    void println(const String &s) { println(s.c_str()); }
+};
+
+extern NativeSerial Serial;
+
+static inline unsigned long millis() { return halMillis(); }
+static inline unsigned long micros() { return halMicros(); }
+static inline void delay(unsigned long ms) { halDelay((uint32_t)ms); }
+
+// 乱数（nonce 生成用）
+uint32_t esp_random();
+
+#endif // ARDUINO_H
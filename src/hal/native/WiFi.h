@@ -0,0 +1,21 @@
+#ifndef WIFI_H
+#define WIFI_H
+
+// ホスト（native）ビルド用の WiFi の部分集合（名前解決だけ、TLS スタブと組み合わせて使う）
+
+#include <Arduino.h>
+
+class IPAddress
+{
+};
+
+class WiFiClass
+{
+public:
+    // 名前解決は常に成功する（時間はかからない）
+    bool hostByName(const char *host, IPAddress &ip);
+};
+
+extern WiFiClass WiFi;
+
+#endif // WIFI_H
@@ -0,0 +1,52 @@
+#ifndef WIFI_CLIENT_SECURE_H
+#define WIFI_CLIENT_SECURE_H
+
+// ホスト（native）ビルド用の WiFiClientSecure の部分集合（TLS スタブ）
+// 接続ごとにハンドシェイクの時間を待ち、書き込まれた HTTP/1.1 のリクエストをプロセス内の疑似サーバー
+// （halNativeHttpServe）で処理して、応答を HTTP/1.1 のバイト列として読ませる
+// サーバー側で閉じた接続は connected() が true のまま、次に書き込んだときに失敗する
+// リクエスト・応答は固定長のバッファで扱い、接続後の読み書きではヒープを確保しない
+
+#include <Arduino.h>
+
+#include <memory>
+
+// 1回のリクエスト（ヘッダーとボディ）の最大長
+#define NATIVE_TLS_REQUEST_MAX 2048
+
+// 1回の応答（ステータス行・ヘッダー・chunked の区切りを含む）の最大長
+#define NATIVE_TLS_RX_MAX 5120
+
+// サーバー側の接続（wifi_native.cpp）
+struct NativeTlsConnection;
+
+class WiFiClientSecure
+{
+public:
+    void setInsecure() {}
+    void setHandshakeTimeout(unsigned long seconds) { (void)seconds; }
+
+    // 戻り値: 接続した=1
+    int connect(const char *host, uint16_t port);
+    bool connected() const { return conn != nullptr || rxPos < rxLen; }
+    void stop();
+
+    // 戻り値: 書き込んだバイト数（サーバー側で閉じていれば 0）
+    size_t write(const uint8_t *buf, size_t size);
+
+    int available() const { return (int)(rxLen - rxPos); }
+    int read(uint8_t *buf, size_t size);
+
+private:
+    // 届いたリクエストを疑似サーバーで処理し、応答を受信バッファに入れる
+    void serve(size_t headerLen, size_t bodyLen);
+
+    std::shared_ptr<NativeTlsConnection> conn;
+    char tx[NATIVE_TLS_REQUEST_MAX + 1];
+    size_t txLen = 0;
+    char rx[NATIVE_TLS_RX_MAX];
+    size_t rxLen = 0;
+    size_t rxPos = 0;
+};
+
+#endif // WIFI_CLIENT_SECURE_H
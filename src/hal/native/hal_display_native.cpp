@@ -0,0 +1,218 @@
+// ホスト（native）ビルド用の表示HAL（メモリ上の RGB565 フレームバッファ）
+// 図形は実機と同じ座標・クリップで塗る。文字は字形の代わりに1文字ずつ文字色の矩形で塗る
+// （ASCII は高さの半分、それ以外は高さと同じ幅）
+#include <Arduino.h>
+
+#include <math.h>
+#include <new>
+
+#include "hal/hal_display.h"
+#include "hal/native/hal_native.h"
+#include "ui_layout.h"
+
+struct HalSurface
+{
+    int w;
+    int h;
+    uint16_t *pixels;
+    // クリップ範囲（x0 <= x < x1, y0 <= y < y1）
+    int clipX0;
+    int clipY0;
+    int clipX1;
+    int clipY1;
+};
+
+static uint16_t framebuffer[SCREEN_WIDTH * SCREEN_HEIGHT];
+static HalSurface screen = {SCREEN_WIDTH, SCREEN_HEIGHT, framebuffer, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT};
+static uint64_t displayPixels = 0;
+static uint8_t backlight = 0;
+
+static HalSurface *target(HalSurface *s)
+{
+    return s == nullptr ? &screen : s;
+}
+
+// 1行の [x0, x1) を塗る
+static void fillSpan(HalSurface *s, int x0, int x1, int y, uint16_t color)
+{
+    if (y < s->clipY0 || y >= s->clipY1)
+        return;
+    x0 = max(x0, s->clipX0);
+    x1 = min(x1, s->clipX1);
+    if (x0 >= x1)
+        return;
+
+    uint16_t *dst = s->pixels + y * s->w;
+    for (int x = x0; x < x1; x++)
+        dst[x] = color;
+    if (s == &screen)
+        displayPixels += x1 - x0;
+}
+
+// 中心から縦に dy 離れた行での円の横の半幅
+static int circleHalfWidth(int r, int dy)
+{
+    return (int)sqrtf((float)(r * r - dy * dy));
+}
+
+void halDisplayInit()
+{
+}
+
+void halDisplaySetBacklight(uint8_t level)
+{
+    backlight = level;
+}
+
+HalSurface *halSurfaceCreate(int w, int h)
+{
+    uint16_t *pixels = new (std::nothrow) uint16_t[w * h]();
+    if (pixels == nullptr)
+        return nullptr;
+    return new HalSurface{w, h, pixels, 0, 0, w, h};
+}
+
+void halDrawFillRect(HalSurface *s, int x, int y, int w, int h, uint16_t color)
+{
+    s = target(s);
+    for (int row = y; row < y + h; row++)
+        fillSpan(s, x, x + w, row, color);
+}
+
+void halDrawFillRoundRect(HalSurface *s, int x, int y, int w, int h, int r, uint16_t color)
+{
+    s = target(s);
+    r = min(r, min(w, h) / 2);
+    for (int row = 0; row < h; row++)
+    {
+        // 角の丸みの分だけ両端を削る
+        int dy = row < r ? r - 1 - row : (row >= h - r ? row - (h - r) : -1);
+        int inset = dy < 0 ? 0 : r - circleHalfWidth(r, dy);
+        fillSpan(s, x + inset, x + w - inset, y + row, color);
+    }
+}
+
+void halDrawFillCircle(HalSurface *s, int cx, int cy, int r, uint16_t color)
+{
+    s = target(s);
+    for (int dy = -r; dy <= r; dy++)
+    {
+        int dx = circleHalfWidth(r, dy);
+        fillSpan(s, cx - dx, cx + dx + 1, cy + dy, color);
+    }
+}
+
+// フォントの文字の高さ（ピクセル）
+static int fontHeight(HalFont font)
+{
+    switch (font)
+    {
+    case HAL_FONT_JP_28:
+        return 28;
+    case HAL_FONT_JP_20:
+        return 20;
+    case HAL_FONT_SANS_18:
+        return 25;
+    case HAL_FONT_SANS_12:
+    default:
+        return 17;
+    }
+}
+
+void halDrawText(HalSurface *s, const char *text, int x, int y, HalFont font, HalTextDatum datum, uint16_t color)
+{
+    int h = fontHeight(font);
+
+    // 文字列の幅（UTF-8 の先頭バイトごとに1文字）
+    int width = 0;
+    for (const char *p = text; *p != '\0'; p++)
+    {
+        uint8_t c = (uint8_t)*p;
+        if ((c & 0xC0) != 0x80)
+            width += c < 0x80 ? h / 2 : h;
+    }
+
+    int left = datum == HAL_DATUM_ML ? x : (datum == HAL_DATUM_MR ? x - width : x - width / 2);
+    int top = y - h / 3;
+    for (const char *p = text; *p != '\0'; p++)
+    {
+        uint8_t c = (uint8_t)*p;
+        if ((c & 0xC0) == 0x80)
+            continue;
+        int cellW = c < 0x80 ? h / 2 : h;
+        if (c != ' ')
+            halDrawFillRect(s, left + 1, top, cellW - 2, h * 2 / 3, color);
+        left += cellW;
+    }
+}
+
+void halDrawSetClip(HalSurface *s, int x, int y, int w, int h)
+{
+    s = target(s);
+    s->clipX0 = max(x, 0);
+    s->clipY0 = max(y, 0);
+    s->clipX1 = min(x + w, s->w);
+    s->clipY1 = min(y + h, s->h);
+}
+
+void halDrawClearClip(HalSurface *s)
+{
+    s = target(s);
+    s->clipX0 = 0;
+    s->clipY0 = 0;
+    s->clipX1 = s->w;
+    s->clipY1 = s->h;
+}
+
+void halSurfaceCopy(HalSurface *src, HalSurface *dst, int x, int y)
+{
+    dst = target(dst);
+    int y0 = max(y, dst->clipY0);
+    int y1 = min(y + src->h, dst->clipY1);
+    int x0 = max(x, dst->clipX0);
+    int x1 = min(x + src->w, dst->clipX1);
+    if (x0 >= x1)
+        return;
+
+    for (int row = y0; row < y1; row++)
+    {
+        const uint16_t *from = src->pixels + (row - y) * src->w + (x0 - x);
+        uint16_t *to = dst->pixels + row * dst->w + x0;
+        for (int col = 0; col < x1 - x0; col++)
+            to[col] = from[col];
+        if (dst == &screen)
+            displayPixels += x1 - x0;
+    }
+}
+
+void halDisplayStartWrite()
+{
+}
+
+void halDisplayEndWrite()
+{
+}
+
+void halDisplayPushSurface(HalSurface *src, int x, int y)
+{
+    halSurfaceCopy(src, &screen, x, y);
+}
+
+void halDisplayWaitDMA()
+{
+}
+
+const uint16_t *halNativeFramebuffer()
+{
+    return framebuffer;
+}
+
+uint64_t halNativeDisplayPixels()
+{
+    return displayPixels;
+}
+
+uint8_t halNativeBacklight()
+{
+    return backlight;
+}
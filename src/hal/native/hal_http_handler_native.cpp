@@ -0,0 +1,44 @@
+// ホスト（native）ビルド用の疑似HTTPサーバーの登録と呼び出し
+// プロセス内のトランスポート（hal_http_native）と TLS スタブ（wifi_native）の両方から使う
+#include <Arduino.h>
+#include "hal/native/hal_native.h"
+
+#include <atomic>
+
+static std::atomic<HalNativeHttpHandler> handler(nullptr);
+static void* handlerCtx = nullptr;
+static std::atomic<uint32_t> latencyMs(0);
+static std::atomic<size_t> chunkBytes(0);
+
+void halNativeSetHttpHandler(HalNativeHttpHandler h, void* ctx) {
+    handlerCtx = ctx;
+    handler = h;
+}
+
+void halNativeSetHttpLatency(uint32_t ms) {
+    latencyMs = ms;
+}
+
+void halNativeSetHttpChunk(size_t bytes) {
+    chunkBytes = bytes;
+}
+
+size_t halNativeHttpChunk() {
+    return chunkBytes;
+}
+
+int halNativeHttpServe(const char* url, const HalHttpHeader* headers, int headerCount, const char* body,
+                       uint16_t timeoutMs, char* response, size_t responseSize) {
+    HalNativeHttpHandler h = handler;
+    if (h == nullptr) return -1;
+
+    // 遅延がタイムアウトを超えたら通信エラー
+    uint32_t latency = latencyMs;
+    if (latency > 0) {
+        delay(min(latency, (uint32_t)timeoutMs));
+        if (latency > timeoutMs) return -11;  // HTTPC_ERROR_READ_TIMEOUT 相当
+    }
+
+    response[0] = '\0';
+    return h(handlerCtx, url, headers, headerCount, body, response, responseSize);
+}
@@ -0,0 +1,40 @@
+// ホスト（native）ビルド用のHTTPトランスポート（プロセス内の疑似サーバーへ転送、接続は持たない）
+#include <Arduino.h>
+#include "hal/hal_http.h"
+#include "hal/native/hal_native.h"
+
+// レスポンスの最大長
+#define NATIVE_HTTP_RESPONSE_MAX 4096
+
+void halHttpInit() {
+}
+
+int halHttpRequest(const char* url, const HalHttpHeader* headers, int headerCount,
+                   const char* body, uint16_t timeoutMs, HalBodySink sink, void* ctx,
+                   HalHttpTiming* timing) {
+    // 接続は常に再利用扱い（名前解決・接続の段階は0）
+    HalHttpTiming t = {};
+    t.reused = true;
+    if (timing != nullptr) *timing = t;
+
+    uint32_t t0 = micros();
+    char response[NATIVE_HTTP_RESPONSE_MAX];
+    int code = halNativeHttpServe(url, headers, headerCount, body, timeoutMs, response, sizeof(response));
+    uint32_t t1 = micros();
+    t.phaseUs[HAL_HTTP_PHASE_TTFB] = t1 - t0;
+    if (code <= 0) {
+        if (timing != nullptr) *timing = t;
+        return code;
+    }
+
+    // 実機と同じくチャンク単位で流し、不要になったら打ち切る
+    size_t len = strnlen(response, sizeof(response));
+    size_t chunk = halNativeHttpChunk();
+    if (chunk == 0) chunk = len;
+    for (size_t pos = 0; sink != nullptr && pos < len; pos += chunk) {
+        if (!sink(ctx, response + pos, min(chunk, len - pos))) break;
+    }
+    t.phaseUs[HAL_HTTP_PHASE_BODY] = micros() - t1;
+    if (timing != nullptr) *timing = t;
+    return code;
+}
@@ -0,0 +1,304 @@
+// ホスト（native）ビルド用のHAL実装（時計・タッチ・電源・ヒープ・ストレージ・ネットワーク・イベント）
+#include <Arduino.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+
+#include <sys/stat.h>
+
+#include "hal/hal_clock.h"
+#include "hal/hal_event.h"
+#include "hal/hal_memory.h"
+#include "hal/hal_network.h"
+#include "hal/hal_power.h"
+#include "hal/hal_storage.h"
+#include "hal/hal_touch.h"
+#include "hal/native/hal_native.h"
+
+// 長押しと判定するまでの時間（M5Unified の既定値に合わせる）
+#define NATIVE_HOLD_MS 500
+
+NativeSerial Serial;
+
+static const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+// タッチ
+static const HalNativeTouchEvent *touchScript = nullptr;
+static int touchScriptCount = 0;
+static int touchScriptPos = 0;
+static bool touchDown = false;
+static uint32_t touchDownTime = 0;
+static TouchState touchState = {};
+
+// イベント（タッチの台本の次の時刻を割り込みとして扱う）
+static std::mutex eventMutex;
+static std::condition_variable eventCv;
+static uint32_t eventBits = 0;
+
+// 電源
+static int batteryLevel = 100;
+static bool batteryCharging = false;
+
+// ヒープ（C++ の new / delete をスレッドごと・全体で数える）
+static thread_local uint32_t threadAllocs = 0;
+static thread_local uint32_t threadFrees = 0;
+static std::atomic<uint32_t> liveBlocks(0);
+
+// ネットワーク（halNetworkBegin からの経過時間で接続・時刻同期を模擬する）
+static bool networkBegun = false;
+static uint32_t networkBeginTime = 0;
+static uint32_t networkConnectMs = 0;
+static uint32_t networkTimeSyncMs = 0;
+
+// ストレージ（カレントディレクトリ下のディレクトリに1データ1ファイル）
+static std::string storageDir = ".native_storage";
+
+uint32_t halMillis()
+{
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+}
+
+uint32_t halMicros()
+{
+    auto elapsed = std::chrono::steady_clock::now() - startTime;
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+void halDelay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+uint32_t esp_random()
+{
+    // ワーカーごとに独立した系列（実機の esp_random と同じくスレッドセーフ）
+    thread_local std::mt19937 engine(std::random_device{}());
+    return engine();
+}
+
+void halNativeSetTouchScript(const HalNativeTouchEvent *events, int count)
+{
+    touchScript = events;
+    touchScriptCount = count;
+    touchScriptPos = 0;
+}
+
+bool halNativeTouchScriptDone()
+{
+    return touchScriptPos >= touchScriptCount;
+}
+
+void halTouchUpdate()
+{
+    uint32_t now = halMillis();
+    bool wasDown = touchDown;
+
+    // 時刻が来たイベントを順に適用（1フレームで押して離す操作も取りこぼさないよう、押下の変化は1つずつ）
+    while (touchScriptPos < touchScriptCount && touchScript[touchScriptPos].atMs <= now)
+    {
+        const HalNativeTouchEvent &ev = touchScript[touchScriptPos];
+        if (ev.down != touchDown && touchDown != wasDown)
+            break;
+
+        touchState.x = ev.x;
+        touchState.y = ev.y;
+        if (ev.down && !touchDown)
+            touchDownTime = now;
+        touchDown = ev.down;
+        touchScriptPos++;
+    }
+
+    touchState.wasPressed = touchDown && !wasDown;
+    touchState.wasReleased = !touchDown && wasDown;
+    touchState.isPressed = touchDown;
+    touchState.isHolding = touchDown && (now - touchDownTime >= NATIVE_HOLD_MS);
+}
+
+TouchState halTouchRead()
+{
+    return touchState;
+}
+
+void halEventInit()
+{
+}
+
+void halEventSignal(uint32_t bits)
+{
+    std::lock_guard<std::mutex> lock(eventMutex);
+    eventBits |= bits;
+    eventCv.notify_one();
+}
+
+uint32_t halEventWait(uint32_t timeoutMs)
+{
+    // 台本の次のタッチの時刻が先に来れば、そこで割り込みが入ったことにする
+    uint32_t now = halMillis();
+    uint32_t waitMs = timeoutMs;
+    bool touchFirst = false;
+    if (touchScriptPos < touchScriptCount)
+    {
+        int32_t untilTouch = (int32_t)(touchScript[touchScriptPos].atMs - now);
+        if (untilTouch < 0)
+            untilTouch = 0;
+        if ((uint32_t)untilTouch <= waitMs)
+        {
+            waitMs = untilTouch;
+            touchFirst = true;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(eventMutex);
+    bool signaled = eventCv.wait_for(lock, std::chrono::milliseconds(waitMs), [] { return eventBits != 0; });
+    uint32_t bits = eventBits;
+    eventBits = 0;
+    if (!signaled && touchFirst)
+        bits |= HAL_EVENT_TOUCH;
+    return bits;
+}
+
+bool halTouchCanWake()
+{
+    return true;
+}
+
+int halBatteryLevel()
+{
+    return batteryLevel;
+}
+
+void halNativeSetBatteryLevel(int level)
+{
+    batteryLevel = level;
+}
+
+bool halBatteryCharging()
+{
+    return batteryCharging;
+}
+
+void halNativeSetBatteryCharging(bool charging)
+{
+    batteryCharging = charging;
+}
+
+void *operator new(size_t size)
+{
+    void *p = malloc(size > 0 ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    threadAllocs++;
+    liveBlocks++;
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p == nullptr)
+        return;
+    threadFrees++;
+    liveBlocks--;
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+HalHeapInfo halHeapInfo()
+{
+    HalHeapInfo heap = {};
+    heap.allocatedBlocks = liveBlocks.load();
+    return heap;
+}
+
+bool halHeapTaskCounts(uint32_t &allocs, uint32_t &frees)
+{
+    allocs = threadAllocs;
+    frees = threadFrees;
+    return true;
+}
+
+void halNativeSetStorageDir(const char *dir)
+{
+    storageDir = dir;
+}
+
+static std::string storagePath(const char *name)
+{
+    return storageDir + "/" + name;
+}
+
+bool halStorageRead(const char *name, void *buf, size_t size, size_t *len)
+{
+    FILE *file = fopen(storagePath(name).c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    // size より大きいファイルは読まない（1バイト余分に読めたら超過）
+    size_t n = fread(buf, 1, size, file);
+    bool tooLarge = (n == size && fgetc(file) != EOF);
+    fclose(file);
+    if (tooLarge)
+        return false;
+    *len = n;
+    return true;
+}
+
+bool halStorageWrite(const char *name, const void *data, size_t len)
+{
+    mkdir(storageDir.c_str(), 0755);
+
+    std::string path = storagePath(name);
+    std::string tmpPath = path + ".tmp";
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    bool ok = fwrite(data, 1, len, file) == len;
+    ok = (fclose(file) == 0) && ok;
+
+    if (ok)
+        ok = rename(tmpPath.c_str(), path.c_str()) == 0;
+    if (!ok)
+        remove(tmpPath.c_str());
+    return ok;
+}
+
+void halStorageRemove(const char *name)
+{
+    remove(storagePath(name).c_str());
+}
+
+void halNativeSetNetworkDelay(uint32_t connectMs, uint32_t timeSyncMs)
+{
+    networkConnectMs = connectMs;
+    networkTimeSyncMs = timeSyncMs;
+}
+
+void halNetworkBegin()
+{
+    networkBegun = true;
+    networkBeginTime = halMillis();
+}
+
+bool halNetworkConnected()
+{
+    return networkBegun && halMillis() - networkBeginTime >= networkConnectMs;
+}
+
+bool halNetworkTimeSynced()
+{
+    return halNetworkConnected() && halMillis() - networkBeginTime >= networkTimeSyncMs;
+}
+
+void halNetworkReconnect()
+{
+}
@@ -0,0 +1,85 @@
+#ifndef HAL_NATIVE_H
+#define HAL_NATIVE_H
+
+// ホスト（native）ビルドのHALを外から操作するためのAPI
+// 疑似サーバー・タッチ操作の台本・フレームバッファの確認に使う
+
+#include <stddef.h>
+#include <stdint.h>
+#include "hal/hal_http.h"
+
+// 疑似HTTPサーバーのハンドラ
+// response に JSON を書き込み、HTTPステータスコードを返す（負値は通信エラー扱い）
+typedef int (*HalNativeHttpHandler)(void *ctx, const char *url, const HalHttpHeader *headers, int headerCount,
+                                    const char *body, char *response, size_t responseSize);
+
+// 疑似サーバーを登録（未登録なら全リクエストが通信エラー）
+void halNativeSetHttpHandler(HalNativeHttpHandler handler, void *ctx);
+
+// 1リクエストごとに加える遅延（ミリ秒）
+void halNativeSetHttpLatency(uint32_t ms);
+
+// レスポンスボディを sink に渡すチャンクの大きさ（0なら一括）
+void halNativeSetHttpChunk(size_t bytes);
+size_t halNativeHttpChunk();
+
+// 登録した疑似サーバーでリクエストを処理する（トランスポートから呼ぶ）
+// 遅延を加えてからハンドラを呼ぶ。遅延が timeoutMs を超えたら -11（HTTPC_ERROR_READ_TIMEOUT 相当）
+int halNativeHttpServe(const char *url, const HalHttpHeader *headers, int headerCount, const char *body,
+                       uint16_t timeoutMs, char *response, size_t responseSize);
+
+// TLS スタブ（WiFiClientSecure の代わり、api_connection をホストで動かすときに使う）
+// 新しい接続ごとに handshakeMs だけ待ち、書き込まれたリクエストは halNativeHttpServe で処理する
+void halNativeSetTlsHandshake(uint32_t handshakeMs);
+
+// サーバー側で接続を閉じる条件（idleMs: この時間使われなかった接続を閉じる、0 なら閉じない、
+// closeEachResponse: 毎回 Connection: close で応答する＝接続を再利用しない）
+// サーバー側で閉じた接続は、クライアントが次に送るまで気づかない
+void halNativeSetTlsServerClose(uint32_t idleMs, bool closeEachResponse);
+
+// 応答を chunked 転送で返す（チャンクの大きさは halNativeSetHttpChunk、0 なら 64 バイト）
+void halNativeSetTlsChunked(bool chunked);
+
+// サーバー側で今ある接続を全て閉じる
+void halNativeTlsCloseAll();
+
+// サーバーが受け付けたハンドシェイクの回数
+uint32_t halNativeTlsHandshakes();
+
+// タッチ操作の台本（atMs は halMillis() の時刻、down=false で指を離す）
+struct HalNativeTouchEvent
+{
+    uint32_t atMs;
+    int x;
+    int y;
+    bool down;
+};
+
+// 台本を設定（events は台本の再生中ずっと有効であること）
+void halNativeSetTouchScript(const HalNativeTouchEvent *events, int count);
+
+// 台本を最後まで再生したか
+bool halNativeTouchScriptDone();
+
+// 画面のフレームバッファ（SCREEN_WIDTH x SCREEN_HEIGHT、RGB565、hal_display_native.cpp）
+const uint16_t *halNativeFramebuffer();
+
+// これまでに画面へ書き込んだピクセル数（描画面への書き込みは数えない）
+uint64_t halNativeDisplayPixels();
+
+// バックライト輝度
+uint8_t halNativeBacklight();
+
+// バッテリー残量を設定（負値は取得失敗扱い）
+void halNativeSetBatteryLevel(int level);
+
+// 充電中かを設定（既定は false）
+void halNativeSetBatteryCharging(bool charging);
+
+// halNetworkBegin から WiFi 接続・時刻同期が完了するまでの時間（既定は 0: すぐに完了）
+void halNativeSetNetworkDelay(uint32_t connectMs, uint32_t timeSyncMs);
+
+// ストレージの保存先ディレクトリ（既定は ".native_storage"、書き込み時に作成）
+void halNativeSetStorageDir(const char *dir);
+
+#endif // HAL_NATIVE_H
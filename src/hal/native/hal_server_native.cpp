@@ -0,0 +1,94 @@
+// ホスト（native）ビルド用の TCP サーバー（ループバックの非ブロッキングソケット）
+// 記録した Webhook イベントをホストのプログラムや curl から送って確かめるのに使う
+#include <Arduino.h>
+#include "hal/hal_server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static int listenFd = -1;
+static int clientFds[HAL_SERVER_MAX_CLIENTS]; // 空きは -1（halServerBegin で初期化）
+static uint16_t listeningPort = 0;
+
+static bool validClient(int client) {
+    return listenFd >= 0 && client >= 0 && client < HAL_SERVER_MAX_CLIENTS && clientFds[client] >= 0;
+}
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool halServerBegin(uint16_t port) {
+    if (listenFd >= 0) return true;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    socklen_t addrLen = sizeof(addr);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0 || !setNonBlocking(fd) ||
+        getsockname(fd, (sockaddr*)&addr, &addrLen) != 0) {
+        Serial.printf("Error: cannot listen on port %u (errno=%d)\n", (unsigned)port, errno);
+        close(fd);
+        return false;
+    }
+
+    for (int i = 0; i < HAL_SERVER_MAX_CLIENTS; i++) clientFds[i] = -1;
+    listenFd = fd;
+    listeningPort = ntohs(addr.sin_port);
+    return true;
+}
+
+uint16_t halServerPort() {
+    return listeningPort;
+}
+
+int halServerAccept() {
+    if (listenFd < 0) return -1;
+
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) return -1;
+
+    for (int i = 0; i < HAL_SERVER_MAX_CLIENTS; i++) {
+        if (clientFds[i] < 0) {
+            setNonBlocking(fd);
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            clientFds[i] = fd;
+            return i;
+        }
+    }
+    close(fd);
+    return -1;
+}
+
+int halServerRead(int client, char* buf, size_t size) {
+    if (!validClient(client)) return -1;
+
+    ssize_t n = recv(clientFds[client], buf, size, 0);
+    if (n > 0) return (int)n;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+    return -1;
+}
+
+void halServerWrite(int client, const char* data, size_t len) {
+    if (!validClient(client)) return;
+    send(clientFds[client], data, len, MSG_NOSIGNAL);
+}
+
+void halServerClose(int client) {
+    if (!validClient(client)) return;
+    close(clientFds[client]);
+    clientFds[client] = -1;
+}
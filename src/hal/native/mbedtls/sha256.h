@@ -0,0 +1,24 @@
+#ifndef MBEDTLS_SHA256_H
+#define MBEDTLS_SHA256_H
+
+// ホスト（native）ビルド用の SHA-256（mbedtls と同じ関数名の部分集合）
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct mbedtls_sha256_context
+{
+    uint32_t state[8];
+    uint64_t total;       // 処理済みバイト数
+    unsigned char buffer[64];
+};
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx);
+void mbedtls_sha256_clone(mbedtls_sha256_context *dst, const mbedtls_sha256_context *src);
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224);
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t len);
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char output[32]);
+int mbedtls_sha256(const unsigned char *input, size_t len, unsigned char output[32], int is224);
+
+#endif // MBEDTLS_SHA256_H
@@ -0,0 +1,14 @@
+#ifndef SECRETS_H
+#define SECRETS_H
+
+// ホスト（native）ビルド用のダミー認証情報
+// 通信先は疑似サーバーなので実際の値は不要
+#define WIFI_SSID "native"
+#define WIFI_PASS "native"
+
+#define SWITCHBOT_TOKEN "native-token"
+#define SWITCHBOT_SECRET "native-secret"
+
+#define WEBHOOK_TOKEN "native-webhook-token"
+
+#endif // SECRETS_H
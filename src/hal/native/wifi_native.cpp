@@ -0,0 +1,210 @@
+// ホスト（native）ビルド用の WiFi / WiFiClientSecure の TLS スタブ
+// api_connection（接続プール）をホストで動かすため、接続の確立・サーバー側での切断・Connection: close・
+// chunked 転送を模擬する
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+#include "hal/native/hal_native.h"
+
+// レスポンスの最大長
+#define NATIVE_TLS_RESPONSE_MAX 4096
+
+// 疑似サーバーに渡す応答待ちのタイムアウト（これより長い遅延は応答せずに切る）
+#define NATIVE_TLS_TIMEOUT_MS 5000
+
+// サーバー側の接続（クライアントが閉じるか、サーバーが閉じるまで残る）
+struct NativeTlsConnection
+{
+    std::atomic<bool> serverOpen;
+    std::atomic<uint32_t> lastActivityMs;
+};
+
+WiFiClass WiFi;
+
+static std::atomic<uint32_t> handshakeMs(0);
+static std::atomic<uint32_t> serverIdleMs(0);
+static std::atomic<bool> closeEachResponse(false);
+static std::atomic<bool> chunkedResponse(false);
+static std::atomic<uint32_t> handshakes(0);
+
+// 今ある接続（halNativeTlsCloseAll 用、閉じた接続は次の接続のときに取り除く）
+static std::mutex connMutex;
+static std::vector<std::weak_ptr<NativeTlsConnection>> connections;
+
+void halNativeSetTlsHandshake(uint32_t ms) {
+    handshakeMs = ms;
+}
+
+void halNativeSetTlsServerClose(uint32_t idleMs, bool closeEach) {
+    serverIdleMs = idleMs;
+    closeEachResponse = closeEach;
+}
+
+void halNativeTlsCloseAll() {
+    std::lock_guard<std::mutex> lock(connMutex);
+    for (auto& weak : connections) {
+        std::shared_ptr<NativeTlsConnection> conn = weak.lock();
+        if (conn != nullptr) conn->serverOpen = false;
+    }
+}
+
+void halNativeSetTlsChunked(bool chunked) {
+    chunkedResponse = chunked;
+}
+
+uint32_t halNativeTlsHandshakes() {
+    return handshakes;
+}
+
+bool WiFiClass::hostByName(const char* host, IPAddress& ip) {
+    (void)host;
+    (void)ip;
+    return true;
+}
+
+int WiFiClientSecure::connect(const char* host, uint16_t port) {
+    (void)host;
+    (void)port;
+    stop();
+
+    // TCP 接続と TLS ハンドシェイクの時間
+    uint32_t cost = handshakeMs;
+    if (cost > 0) delay(cost);
+
+    conn = std::make_shared<NativeTlsConnection>();
+    conn->serverOpen = true;
+    conn->lastActivityMs = millis();
+    handshakes++;
+
+    std::lock_guard<std::mutex> lock(connMutex);
+    for (size_t i = 0; i < connections.size();) {
+        if (connections[i].expired()) {
+            connections[i] = connections.back();
+            connections.pop_back();
+        } else {
+            i++;
+        }
+    }
+    connections.push_back(conn);
+    return 1;
+}
+
+void WiFiClientSecure::stop() {
+    conn.reset();
+    txLen = 0;
+    rxLen = 0;
+    rxPos = 0;
+}
+
+int WiFiClientSecure::read(uint8_t* buf, size_t size) {
+    size_t n = min(size, rxLen - rxPos);
+    memcpy(buf, rx + rxPos, n);
+    rxPos += n;
+    return (int)n;
+}
+
+size_t WiFiClientSecure::write(const uint8_t* buf, size_t size) {
+    if (conn == nullptr) return 0;
+
+    // サーバーが閉じていた（アイドルで閉じた場合を含む）ことは送ってみて初めてわかる
+    uint32_t idle = serverIdleMs;
+    if (idle > 0 && millis() - conn->lastActivityMs >= idle) conn->serverOpen = false;
+    if (!conn->serverOpen || txLen + size > NATIVE_TLS_REQUEST_MAX) {
+        stop();
+        return 0;
+    }
+
+    memcpy(tx + txLen, buf, size);
+    txLen += size;
+    tx[txLen] = '\0';
+
+    // ヘッダーの終わりと Content-Length 分のボディが揃ったら処理する
+    const char* end = strstr(tx, "\r\n\r\n");
+    if (end == nullptr) return size;
+    size_t headerLen = end + 4 - tx;
+    size_t bodyLen = 0;
+    const char* length = strstr(tx, "\r\nContent-Length: ");
+    if (length != nullptr && length < end) bodyLen = strtoul(length + 18, nullptr, 10);
+    if (txLen < headerLen + bodyLen) return size;
+
+    serve(headerLen, bodyLen);
+    txLen = 0;
+    return size;
+}
+
+void WiFiClientSecure::serve(size_t headerLen, size_t bodyLen) {
+    // リクエストライン（"POST /path HTTP/1.1"）とヘッダーをその場で区切る
+    tx[headerLen - 2] = '\0';
+    char* line = tx;
+    char* next = strstr(line, "\r\n");
+    *next = '\0';
+    char* path = strchr(line, ' ');
+    if (path == nullptr) {
+        stop();
+        return;
+    }
+    path++;
+    char* version = strchr(path, ' ');
+    if (version != nullptr) *version = '\0';
+
+    const char* host = "";
+    HalHttpHeader headers[16];
+    int count = 0;
+    for (line = next + 2; *line != '\0'; line = next + 2) {
+        next = strstr(line, "\r\n");
+        if (next == nullptr) break;
+        *next = '\0';
+        char* colon = strchr(line, ':');
+        if (colon == nullptr) continue;
+        *colon = '\0';
+        char* value = colon + 1;
+        while (*value == ' ') value++;
+        if (strcmp(line, "Host") == 0) {
+            host = value;
+        } else if (strcmp(line, "Connection") != 0 && strcmp(line, "Content-Length") != 0 && count < 16) {
+            headers[count].name = line;
+            headers[count].value = value;
+            count++;
+        }
+    }
+
+    char url[256];
+    snprintf(url, sizeof(url), "https://%s%s", host, path);
+    const char* body = bodyLen > 0 ? tx + headerLen : nullptr;
+    char response[NATIVE_TLS_RESPONSE_MAX];
+    int code = halNativeHttpServe(url, headers, count, body, NATIVE_TLS_TIMEOUT_MS, response, sizeof(response));
+    conn->lastActivityMs = millis();
+    if (code <= 0) {
+        // 応答せずに接続を切る
+        stop();
+        return;
+    }
+
+    bool keepAlive = !closeEachResponse;
+    if (!keepAlive) conn->serverOpen = false;
+    size_t len = strnlen(response, sizeof(response));
+    rxPos = 0;
+    if (!chunkedResponse) {
+        rxLen = snprintf(rx, sizeof(rx), "HTTP/1.1 %d OK\r\nContent-Type: application/json\r\nContent-Length: %u\r\n"
+                         "Connection: %s\r\n\r\n%s",
+                         code, (unsigned)len, keepAlive ? "keep-alive" : "close", response);
+        return;
+    }
+
+    // chunked 転送（halNativeSetHttpChunk の大きさ、未設定なら 64 バイトずつ）
+    size_t chunk = halNativeHttpChunk();
+    if (chunk == 0) chunk = 64;
+    rxLen = snprintf(rx, sizeof(rx), "HTTP/1.1 %d OK\r\nTransfer-Encoding: chunked\r\nConnection: %s\r\n\r\n", code,
+                     keepAlive ? "keep-alive" : "close");
+    for (size_t pos = 0; pos < len && rxLen < sizeof(rx); pos += chunk) {
+        size_t n = min(chunk, len - pos);
+        rxLen += snprintf(rx + rxLen, sizeof(rx) - rxLen, "%x\r\n%.*s\r\n", (unsigned)n, (int)n, response + pos);
+    }
+    if (rxLen < sizeof(rx)) rxLen += snprintf(rx + rxLen, sizeof(rx) - rxLen, "0\r\n\r\n");
+    rxLen = min(rxLen, sizeof(rx) - 1);
+}
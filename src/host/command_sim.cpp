@@ -0,0 +1,440 @@
+// 電球コマンドの記録と送り直しの確認（疑似SwitchBotサーバーに障害・切断の時間帯を入れて実行）
+// 障害の間に出した指示が復旧後に最後の値だけ届くこと、切断中にまとめた指示の送信回数、
+// 再起動をまたいだ指示の再送、ワーカーが同じ電球のコマンドを投入順に1件ずつ送ること、
+// 記録した速いドラッグ・離してすぐのつかみ直しで送るコマンドの数と、疑似サーバーが最後に離した値になること、
+// 送り直しの上限であきらめて画面を実際の状態に合わせること、
+// フラッシュへの書き込みが送り直しのたびには起きないことを確かめ、
+// 場合ごとにリクエスト数・届いたコマンド数・送り直し・書き込み回数・かかった時間を1行ずつ出力する
+// 疑似サーバーの状態・リクエスト数が期待どおりでなければ終了コード 1
+// 実行: pio run -e native-command-sim -t exec
+#include <Arduino.h>
+
+#include "device_registry.h"
+#include "switchbot_api.h"
+#include "api_worker.h"
+#include "api_quota.h"
+#include "command_coalescer.h"
+#include "command_log.h"
+#include "hal/hal_storage.h"
+#include "hal/native/hal_native.h"
+#include "host/mock_switchbot.h"
+
+// 疑似サーバーの往復時間
+#define SIM_RTT_MS 30
+
+// 送り終えるまで待つ上限
+#define SIM_SETTLE_MS 10000
+
+// あきらめたコマンド（UI と同じく、すぐに状態を確かめる）
+static int failedCount = 0;
+static int failedIndex = -1;
+
+static void onResult(const ApiResult& result) {
+    if (result.success) return;
+    failedCount++;
+    failedIndex = result.index;
+}
+
+// UI ループと同じ処理を ms だけ回す
+static void pump(uint32_t ms) {
+    uint32_t t0 = millis();
+    while (millis() - t0 < ms) {
+        apiWorkerDispatch(API_JOB_QUEUE_LEN);
+        coalescerService(millis());
+        delay(1);
+    }
+}
+
+// 全ての指示を送り終えるまで回す（戻り値: 送り終えた）
+static bool settle() {
+    uint32_t t0 = millis();
+    while (millis() - t0 < SIM_SETTLE_MS) {
+        apiWorkerDispatch(API_JOB_QUEUE_LEN);
+        coalescerService(millis());
+        bool idle = apiWorkerPending() == 0;
+        for (int i = 0; i < bulbs.count && idle; i++) idle = coalescerIdle(i);
+        if (idle) return true;
+        delay(1);
+    }
+    Serial.println("FAILED: commands did not settle");
+    return false;
+}
+
+// 画面の操作と同じく、表示を先に変えてから指示を出す
+static void setPower(int index, bool on) {
+    bulbs.powerState[index] = on;
+    coalescerSetPower(index, on);
+}
+
+// 明るさの指示は消灯中の電球も点ける（疑似サーバーも同じ）
+static void setBrightness(int index, int brightness) {
+    bulbs.powerState[index] = true;
+    bulbs.brightness[index] = brightness;
+    coalescerSetBrightness(index, brightness, true);
+}
+
+// 疑似サーバー・画面・送信済みの値を全電球 OFF・明るさ100に戻す
+static void resetBulbs() {
+    for (int i = 0; i < bulbs.count; i++) {
+        mockSwitchBotSetBulb(i, false, 100);
+        bulbs.powerState[i] = false;
+        bulbs.brightness[i] = 100;
+    }
+    coalescerInit(onResult);
+    failedCount = 0;
+    failedIndex = -1;
+}
+
+// 画面と疑似サーバーの状態が一致するか
+static bool uiMatchesServer() {
+    for (int i = 0; i < bulbs.count; i++) {
+        MockBulb server = mockSwitchBotBulb(i);
+        if (server.power != bulbs.powerState[i] || server.brightness != bulbs.brightness[i]) {
+            Serial.printf("FAILED: bulb %d ui=%s/%d server=%s/%d\n", i, bulbs.powerState[i] ? "on" : "off",
+                          bulbs.brightness[i], server.power ? "on" : "off", server.brightness);
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t serverCommands() {
+    uint32_t total = 0;
+    for (int i = 0; i < bulbs.count; i++) total += mockSwitchBotBulb(i).commands;
+    return total;
+}
+
+// 1つの場合の計測
+struct SimCase {
+    const char* name;
+    uint32_t startMs;
+    uint32_t requests;
+    uint32_t commands;
+    CommandLogStats log;
+};
+
+static void beginCase(SimCase& c, const char* name) {
+    resetBulbs();
+    c.name = name;
+    c.startMs = millis();
+    c.requests = mockSwitchBotRequests();
+    c.commands = serverCommands();
+    c.log = commandLogGetStats();
+}
+
+// 結果を出力する（戻り値: リクエスト数と届いたコマンド数が期待どおり）
+static bool endCase(const SimCase& c, int intents, uint32_t expectedRequests, uint32_t expectedCommands) {
+    uint32_t requests = mockSwitchBotRequests() - c.requests;
+    uint32_t commands = serverCommands() - c.commands;
+    CommandLogStats log = commandLogGetStats();
+    bool ok = requests == expectedRequests && commands == expectedCommands;
+    printf("case=%s intents=%d requests=%lu expected=%lu delivered=%lu retries=%lu superseded=%lu failed=%lu "
+           "saves=%lu elapsed_ms=%lu %s\n",
+           c.name, intents, (unsigned long)requests, (unsigned long)expectedRequests, (unsigned long)commands,
+           (unsigned long)(log.retries - c.log.retries), (unsigned long)(log.superseded - c.log.superseded),
+           (unsigned long)(log.failed - c.log.failed), (unsigned long)(log.saves - c.log.saves),
+           (unsigned long)(millis() - c.startMs), ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// 障害なし: 指示1つにつきリクエスト1回、書き込みを待つ間に送れるのでフラッシュには書き込まない
+static bool runSteady() {
+    SimCase c;
+    beginCase(c, "steady");
+    for (int i = 0; i < bulbs.count; i++) {
+        setPower(i, true);
+        setBrightness(i, 30 + i * 10);
+    }
+    bool ok = settle();
+    pump(COMMAND_LOG_SAVE_DELAY_MS + 50);
+    ok = endCase(c, bulbs.count * 2, bulbs.count * 2, bulbs.count * 2) && ok;
+    uint32_t saves = commandLogGetStats().saves - c.log.saves;
+    if (saves != 0) {
+        Serial.printf("FAILED: %lu flash writes for delivered commands\n", (unsigned long)saves);
+        ok = false;
+    }
+    return uiMatchesServer() && ok;
+}
+
+// サーバーの障害の間に出した指示: 送り直しを続け、復旧後に最後の値だけが届く
+static bool runServerOutage() {
+    SimCase c;
+    beginCase(c, "server_outage");
+    mockSwitchBotSetDown(true);
+    uint32_t sentBefore = coalescerGetStats().sent;
+    setPower(0, true);
+    setBrightness(1, 40);
+    pump(100);
+    setPower(0, false);
+    setBrightness(1, 70);
+    pump(200);
+    mockSwitchBotSetDown(false);
+    bool ok = settle();
+
+    // 障害の間のリクエストは全て送信回数に数えられ、届いたのは電球ごとに最後の指示だけ
+    uint32_t sent = coalescerGetStats().sent - sentBefore;
+    ok = endCase(c, 4, sent, 2) && ok;
+    ok = failedCount == 0 && commandLogGetStats().retries > c.log.retries && ok;
+
+    // 送り直しでは書き込まない（指示の追加・削除のときだけ）
+    uint32_t saves = commandLogGetStats().saves - c.log.saves;
+    if (saves > 4) {
+        Serial.printf("FAILED: %lu flash writes for 4 intents\n", (unsigned long)saves);
+        ok = false;
+    }
+    return uiMatchesServer() && ok;
+}
+
+// 切断中の指示: 送信中の1件のほかは電球・種類ごとにまとめ、再接続後に記録した順に送る
+static bool runWifiDrop() {
+    SimCase c;
+    beginCase(c, "wifi_drop");
+    apiWorkerSetOnline(false);
+    int intents = 0;
+    for (int b = 10; b <= 90; b += 10, intents++) setBrightness(2, b);
+    setPower(2, true);
+    setPower(3, true);
+    intents += 2;
+    pump(100);
+    apiWorkerSetOnline(true);
+    bool ok = settle();
+
+    // 切断前に投入された明るさ10と、明るさ90・電球2の ON・電球3の ON
+    ok = endCase(c, intents, 4, 4) && ok;
+    return uiMatchesServer() && ok;
+}
+
+// 障害の間に再起動: 保存した記録を戻し、復旧後に届ける
+static bool runReboot() {
+    SimCase c;
+    beginCase(c, "reboot");
+    mockSwitchBotSetDown(true);
+    setPower(0, true);
+    setBrightness(0, 55);
+
+    // 最初の送信が失敗し、送り直しを待っている間に電源が切れる
+    uint32_t t0 = millis();
+    while (millis() - t0 < SIM_SETTLE_MS &&
+           (commandLogGetStats().retries == c.log.retries || apiWorkerPending() > 0)) {
+        apiWorkerDispatch(API_JOB_QUEUE_LEN);
+        delay(1);
+    }
+    commandLogFlush();
+    commandLogInit();
+    coalescerInit(onResult);
+    bulbs.powerState[0] = false;
+    bulbs.brightness[0] = 100;
+
+    int restored = coalescerRestore();
+    bool ok = restored == 2 && bulbs.powerState[0] && bulbs.brightness[0] == 55;
+    if (!ok) Serial.printf("FAILED: restored %d commands\n", restored);
+
+    mockSwitchBotSetDown(false);
+    ok = settle() && ok;
+    pump(COMMAND_LOG_SAVE_DELAY_MS + 50);
+    ok = endCase(c, 2, 3, 2) && ok;
+
+    // 送り終えたら保存した記録は消える
+    uint8_t buf[16];
+    size_t len = 0;
+    if (halStorageRead(COMMAND_LOG_NAME, buf, sizeof(buf), &len)) {
+        Serial.println("FAILED: command log was not removed");
+        ok = false;
+    }
+    return uiMatchesServer() && ok;
+}
+
+// ワーカーに直接続けて投入したコマンド: 同じ電球には投入順に1件ずつ届き、別の電球とは並列に送る
+// 電球0の応答だけを遅くし、後から投入したコマンドが先に届いたり重なったりしないことを確かめる
+static int orderDone = 0;
+
+static void onOrderDone(const ApiResult& result) {
+    (void)result;
+    orderDone++;
+}
+
+static bool runWorkerOrder() {
+    SimCase c;
+    beginCase(c, "worker_order");
+    mockSwitchBotSetBulbLatency(0, SIM_RTT_MS * 2);
+    uint32_t overlapped = mockSwitchBotStats().overlapped;
+    orderDone = 0;
+    int intents = 0;
+    for (int b = 10; b <= 60; b += 10, intents++) {
+        apiWorkerSubmit(API_JOB_BULB_BRIGHTNESS, bulbs.deviceId[0], 0, b, onOrderDone);
+        apiWorkerSubmit(API_JOB_BULB_BRIGHTNESS, bulbs.deviceId[1], 1, b, onOrderDone);
+        intents++;
+    }
+    uint32_t t0 = millis();
+    while (orderDone < intents && millis() - t0 < SIM_SETTLE_MS) {
+        apiWorkerDispatch(API_JOB_QUEUE_LEN);
+        delay(1);
+    }
+    mockSwitchBotSetBulbLatency(0, 0);
+
+    bool ok = endCase(c, intents, intents, intents);
+    overlapped = mockSwitchBotStats().overlapped - overlapped;
+    int last0 = mockSwitchBotBulb(0).brightness;
+    int last1 = mockSwitchBotBulb(1).brightness;
+    if (overlapped != 0 || last0 != 60 || last1 != 60) {
+        Serial.printf("FAILED: overlapped=%lu bulb0=%d bulb1=%d (expected 60)\n", (unsigned long)overlapped, last0,
+                      last1);
+        ok = false;
+    }
+    // 画面は触っていないので、疑似サーバーに合わせて戻す
+    for (int i = 0; i < 2; i++) {
+        bulbs.powerState[i] = mockSwitchBotBulb(i).power;
+        bulbs.brightness[i] = mockSwitchBotBulb(i).brightness;
+    }
+    return uiMatchesServer() && ok;
+}
+
+// 記録したスライダー操作（指の位置の変わり目、間は60Hz のサンプルで補う）
+struct DragKey {
+    uint16_t atMs;   // 操作の始まりからの時刻
+    uint8_t bulb;
+    uint8_t brightness;
+    bool release;    // ここで指を離す（確定値）
+};
+
+// 速く端まで動かして離す
+static const DragKey dragFlick[] = {
+    {0, 0, 100, false}, {180, 0, 5, false}, {200, 0, 5, true},
+};
+// 行き来してから離す・離した直後に同じ電球をつかみ直す（1回目の確定値の送信中に2回目を離す）
+static const DragKey dragRegrab[] = {
+    {0, 1, 50, false}, {300, 1, 90, false}, {600, 1, 20, false}, {900, 1, 60, false}, {920, 1, 60, true},
+    {940, 1, 60, false}, {980, 1, 35, false}, {990, 1, 35, true},
+};
+// 2台を交互に少しずつ動かす・連打のような短いドラッグ
+static const DragKey dragAlternate[] = {
+    {0, 2, 10, false},  {100, 2, 30, true},  {110, 3, 80, false}, {200, 3, 40, true},  {210, 2, 30, false},
+    {260, 2, 45, true}, {270, 3, 40, false}, {330, 3, 25, true},  {340, 2, 45, false}, {350, 2, 46, true},
+};
+
+#define DRAG_SAMPLE_MS 16
+
+// 操作を再生し、送ったコマンドの数と疑似サーバーの最後の値を確かめる
+// 送るのは電球ごとに、中間値を送る間隔ごとに1回と確定値（送信中に離したら送信完了後に最後の値だけ）まで
+static bool runDragReplay(const char* name, const DragKey* keys, int count) {
+    SimCase c;
+    beginCase(c, name);
+    // スライダーは点灯中の電球だけ動かせる
+    for (int i = 0; i < bulbs.count; i++) {
+        mockSwitchBotSetBulb(i, true, 100);
+        bulbs.powerState[i] = true;
+    }
+    uint32_t sentBefore = coalescerGetStats().sent;
+    int intents = 0;
+    uint32_t maxSent = 0;
+    int lastRelease[REGISTRY_MAX_BULBS];
+    int dragStart[REGISTRY_MAX_BULBS];
+    for (int i = 0; i < REGISTRY_MAX_BULBS; i++) lastRelease[i] = dragStart[i] = -1;
+
+    uint32_t t0 = millis();
+    for (int k = 0; k < count; k++) {
+        const DragKey& key = keys[k];
+        // 同じ電球の前の位置から、60Hz のサンプルで動かす
+        const DragKey* from = nullptr;
+        for (int j = k - 1; j >= 0 && from == nullptr; j--) {
+            if (keys[j].bulb == key.bulb && !keys[j].release) from = &keys[j];
+        }
+        if (from != nullptr && !key.release) {
+            for (uint32_t at = from->atMs + DRAG_SAMPLE_MS; at < key.atMs; at += DRAG_SAMPLE_MS) {
+                pump(t0 + at > millis() ? t0 + at - millis() : 0);
+                int b = from->brightness + (int)(key.brightness - from->brightness) * (int)(at - from->atMs) /
+                                               (int)(key.atMs - from->atMs);
+                bulbs.brightness[key.bulb] = b;
+                coalescerSetBrightness(key.bulb, b, false);
+                intents++;
+            }
+        }
+        if (!key.release && dragStart[key.bulb] < 0) dragStart[key.bulb] = key.atMs;
+        pump(t0 + key.atMs > millis() ? t0 + key.atMs - millis() : 0);
+        bulbs.brightness[key.bulb] = key.brightness;
+        coalescerSetBrightness(key.bulb, key.brightness, key.release);
+        intents++;
+        if (key.release) {
+            // 1回のドラッグで中間値は間隔ごとに1回（つかんだ直後を含む）、離した確定値が1回
+            if (dragStart[key.bulb] >= 0)
+                maxSent += (key.atMs - dragStart[key.bulb]) / COALESCE_STREAM_INTERVAL_MS + 1;
+            maxSent++;
+            lastRelease[key.bulb] = key.brightness;
+            dragStart[key.bulb] = -1;
+        }
+    }
+    bool ok = settle();
+
+    uint32_t sent = coalescerGetStats().sent - sentBefore;
+    ok = endCase(c, intents, sent, sent) && ok;
+    printf("case=%s sent=%lu max=%lu\n", name, (unsigned long)sent, (unsigned long)maxSent);
+    if (sent > maxSent) ok = false;
+    for (int i = 0; i < bulbs.count; i++) {
+        if (lastRelease[i] >= 0 && mockSwitchBotBulb(i).brightness != lastRelease[i]) {
+            Serial.printf("FAILED: bulb %d server=%d released=%d\n", i, mockSwitchBotBulb(i).brightness,
+                          lastRelease[i]);
+            ok = false;
+        }
+    }
+    return uiMatchesServer() && ok;
+}
+
+// 障害が続く: 送り直しの上限であきらめ、状態を確かめて画面を実際の状態に戻す
+static bool runGiveUp() {
+    SimCase c;
+    beginCase(c, "give_up");
+    mockSwitchBotSetDown(true);
+    setPower(1, true);
+    bool ok = settle();
+    ok = endCase(c, 1, COMMAND_RETRY_LIMIT, 0) && ok;
+    mockSwitchBotSetDown(false);
+
+    if (failedCount != 1 || failedIndex != 1) {
+        Serial.printf("FAILED: %d failures reported (bulb %d)\n", failedCount, failedIndex);
+        return false;
+    }
+    bool power = false;
+    int brightness = 0;
+    if (switchbotBulbStatus(bulbs.deviceId[1], power, brightness)) {
+        bulbs.powerState[1] = power;
+        bulbs.brightness[1] = brightness;
+    }
+
+    // 送り直しは倍々に間隔を空ける（揺らしても各間隔の半分以上）
+    uint32_t minBackoff = 0;
+    for (int attempt = 1; attempt < COMMAND_RETRY_LIMIT; attempt++) {
+        uint32_t delayMs = min((uint32_t)COMMAND_RETRY_BASE_MS << (attempt - 1), (uint32_t)COMMAND_RETRY_MAX_MS);
+        minBackoff += delayMs / 2;
+    }
+    uint32_t elapsed = millis() - c.startMs;
+    printf("case=give_up backoff_ms=%lu min_backoff_ms=%lu\n", (unsigned long)elapsed, (unsigned long)minBackoff);
+    return uiMatchesServer() && elapsed >= minBackoff && ok;
+}
+
+int main() {
+    halNativeSetStorageDir(".native_storage");
+    halStorageRemove(COMMAND_LOG_NAME);
+    registryInit();
+    mockSwitchBotInstall(SIM_RTT_MS, 0);
+
+    switchbotApiInit();
+    apiQuotaInit(API_QUOTA_DAILY_LIMIT, API_QUOTA_PANELS);
+    apiWorkerInit();
+    commandLogInit();
+    coalescerInit(onResult);
+
+    bool ok = true;
+    ok = runSteady() && ok;
+    ok = runServerOutage() && ok;
+    ok = runWifiDrop() && ok;
+    ok = runReboot() && ok;
+    ok = runWorkerOrder() && ok;
+    ok = runDragReplay("drag_flick", dragFlick, sizeof(dragFlick) / sizeof(dragFlick[0])) && ok;
+    ok = runDragReplay("drag_regrab", dragRegrab, sizeof(dragRegrab) / sizeof(dragRegrab[0])) && ok;
+    ok = runDragReplay("drag_alternate", dragAlternate, sizeof(dragAlternate) / sizeof(dragAlternate[0])) && ok;
+    ok = runGiveUp() && ok;
+    commandLogPrint();
+
+    Serial.println(ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
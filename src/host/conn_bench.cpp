@@ -0,0 +1,216 @@
+// HTTPS 接続プール（api_connection）の確認と1秒あたりのリクエスト数（TLS スタブと疑似SwitchBotサーバーに対して実行）
+// 実機と同じ api_connection / hal_http_arduino を、接続ごとにハンドシェイクの時間がかかる TLS スタブの上で動かし、
+//   reuse: 続けて送ると最初の1回だけハンドシェイクし、あとはセッションを再利用する
+//   lru: 並列に送って複数のセッションを作った後は、空のスロットではなくセッションのあるスロットを使う
+//   idle_timeout: API_CONN_IDLE_TIMEOUT_MS 使わなかったセッションは送る前に閉じる（再接続とは数えない）
+//   server_close: サーバー側で閉じたセッションは送って失敗したときに1回だけ再接続する
+//   server_idle: サーバーがアイドルで閉じた場合も同じく再接続する
+//   chunked: chunked 転送の応答（小さなチャンクに分けたもの）も同じ結果に解析し、セッションを続けて使う
+// を確かめ、最後に API_WORKER_COUNT 並列で再利用あり・なし（毎回 Connection: close）の1秒あたりのリクエスト数を出力する
+// 最後に apiConnPrintStats と同じハンドシェイクの原因（アイドル・Connection: close）と時間を出力する
+// ハンドシェイク・再接続の回数が期待どおりでないか、再利用ありの方が遅ければ終了コード 1
+// （ログは捨て、結果の行だけを標準出力に出す）
+// 実行: pio run -e native-conn-bench -t exec
+#include <Arduino.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#include "device_registry.h"
+#include "switchbot_api.h"
+#include "api_connection.h"
+#include "api_worker.h"
+#include "hal/native/hal_native.h"
+#include "host/mock_switchbot.h"
+
+// 疑似サーバーの往復時間と、新しい接続1本のハンドシェイクの時間
+#define BENCH_RTT_MS 20
+#define BENCH_HANDSHAKE_MS 80
+
+// 続けて送るリクエスト数と、1秒あたりのリクエスト数を測るときの1スレッドあたりのリクエスト数
+#define BENCH_SEQUENTIAL 20
+#define BENCH_THROUGHPUT_PER_THREAD 25
+
+static FILE* out = stdout;
+
+static bool sendStatus(int n) {
+    bool power = false;
+    int brightness = 0;
+    return switchbotBulbStatus(bulbs.deviceId[n % bulbs.count], power, brightness);
+}
+
+// threads 本のスレッドで perThread 回ずつ送る（戻り値: 失敗したリクエスト数）
+static int sendParallel(int threads, int perThread) {
+    std::vector<std::thread> workers;
+    std::vector<int> failed(threads, 0);
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([t, perThread, &failed] {
+            for (int n = 0; n < perThread; n++) {
+                if (!sendStatus(t * perThread + n)) failed[t]++;
+            }
+        });
+    }
+    int total = 0;
+    for (int t = 0; t < threads; t++) {
+        workers[t].join();
+        total += failed[t];
+    }
+    return total;
+}
+
+// 1つの場合の結果を出力する（戻り値: 期待どおり）
+static bool report(const char* name, const ApiConnStats& before, int failed, uint32_t expectedHandshakes,
+                   uint32_t expectedReconnects) {
+    ApiConnStats s = apiConnGetStats();
+    uint32_t handshakes = s.handshakes - before.handshakes;
+    uint32_t reconnects = s.reconnects - before.reconnects;
+    bool ok = failed == 0 && handshakes == expectedHandshakes && reconnects == expectedReconnects;
+    fprintf(out,
+            "case=%s requests=%lu reused=%lu handshakes=%lu expected=%lu reconnects=%lu expected=%lu failed=%d %s\n",
+            name, (unsigned long)(s.requests - before.requests), (unsigned long)(s.reused - before.reused),
+            (unsigned long)handshakes, (unsigned long)expectedHandshakes, (unsigned long)reconnects,
+            (unsigned long)expectedReconnects, failed, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// 続けて送る: 最初の1回だけハンドシェイク
+static bool runReuse() {
+    ApiConnStats before = apiConnGetStats();
+    int failed = 0;
+    for (int n = 0; n < BENCH_SEQUENTIAL; n++) {
+        if (!sendStatus(n)) failed++;
+    }
+    return report("reuse", before, failed, 1, 0);
+}
+
+// 2本並列に送ってから続けて送る: 続けて送る間は空のスロットを使わない
+static bool runLru() {
+    ApiConnStats before = apiConnGetStats();
+    int failed = sendParallel(2, 1);
+    bool ok = report("lru_parallel", before, failed, 1, 0);
+
+    before = apiConnGetStats();
+    failed = 0;
+    for (int n = 0; n < BENCH_SEQUENTIAL; n++) {
+        if (!sendStatus(n)) failed++;
+    }
+    return report("lru", before, failed, 0, 0) && ok;
+}
+
+// アイドルが続いたセッションは送る前に閉じる（プールの全てのセッションがアイドルなので、使ったスロットの分だけ）
+static bool runIdleTimeout() {
+    delay(API_CONN_IDLE_TIMEOUT_MS + 50);
+    ApiConnStats before = apiConnGetStats();
+    int failed = sendStatus(0) ? 0 : 1;
+    if (apiConnGetStats().idleCloses - before.idleCloses != 1) failed++;
+    return report("idle_timeout", before, failed, 1, 0);
+}
+
+// サーバー側で閉じたセッション: 送って失敗したら1回だけ再接続する
+static bool runServerClose() {
+    sendStatus(0);
+    halNativeTlsCloseAll();
+    ApiConnStats before = apiConnGetStats();
+    int failed = sendStatus(0) ? 0 : 1;
+    return report("server_close", before, failed, 1, 1);
+}
+
+// サーバーがクライアントより短いアイドルで閉じる
+static bool runServerIdle() {
+    uint32_t idleMs = API_CONN_IDLE_TIMEOUT_MS / 2;
+    halNativeSetTlsServerClose(idleMs, false);
+    sendStatus(0);
+    delay(idleMs + 50);
+    ApiConnStats before = apiConnGetStats();
+    int failed = sendStatus(0) ? 0 : 1;
+    halNativeSetTlsServerClose(0, false);
+    return report("server_idle", before, failed, 1, 1);
+}
+
+// chunked 転送の応答（7 バイトずつ）: 解析した状態が疑似サーバーと一致し、再接続しない
+static bool runChunked() {
+    const char* deviceId = bulbs.deviceId[0];
+    switchbotBulbPower(deviceId, true);
+    switchbotBulbBrightness(deviceId, 37);
+    halNativeSetTlsChunked(true);
+    halNativeSetHttpChunk(7);
+    ApiConnStats before = apiConnGetStats();
+    bool power = false;
+    int brightness = 0;
+    bool got = switchbotBulbStatus(deviceId, power, brightness);
+    halNativeSetTlsChunked(false);
+    halNativeSetHttpChunk(0);
+    int failed = got && power && brightness == 37 ? 0 : 1;
+    return report("chunked", before, failed, 0, 0);
+}
+
+// API_WORKER_COUNT 並列の1秒あたりのリクエスト数（reuse=false ではサーバーが毎回 Connection: close で応答する）
+static double measureThroughput(bool reuse, uint32_t& handshakes, int& failed) {
+    // 前の計測のセッションを引き継がない（閉じたことには最初のリクエストで気づき、その分も再接続する）
+    halNativeTlsCloseAll();
+    halNativeSetTlsServerClose(0, !reuse);
+    uint32_t handshakes0 = halNativeTlsHandshakes();
+    uint32_t t0 = millis();
+    failed = sendParallel(API_WORKER_COUNT, BENCH_THROUGHPUT_PER_THREAD);
+    uint32_t elapsed = millis() - t0;
+    handshakes = halNativeTlsHandshakes() - handshakes0;
+    halNativeSetTlsServerClose(0, false);
+
+    int requests = API_WORKER_COUNT * BENCH_THROUGHPUT_PER_THREAD;
+    double perSec = elapsed > 0 ? requests * 1000.0 / elapsed : 0.0;
+    fprintf(out,
+            "case=throughput reuse=%s workers=%d requests=%d handshakes=%lu failed=%d elapsed_ms=%lu req_per_s=%.1f\n",
+            reuse ? "on" : "off", API_WORKER_COUNT, requests, (unsigned long)handshakes, failed,
+            (unsigned long)elapsed, perSec);
+    return perSec;
+}
+
+int main() {
+    registryInit();
+    mockSwitchBotInstall(BENCH_RTT_MS, 0);
+    halNativeSetTlsHandshake(BENCH_HANDSHAKE_MS);
+    switchbotApiInit();
+
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    out = fdopen(saved, "w");
+
+    fprintf(out, "rtt_ms=%d handshake_ms=%d idle_timeout_ms=%d pool=%d\n", BENCH_RTT_MS, BENCH_HANDSHAKE_MS,
+            API_CONN_IDLE_TIMEOUT_MS, API_CONN_POOL_SIZE);
+    bool ok = runReuse();
+    ok = runLru() && ok;
+    ok = runIdleTimeout() && ok;
+    ok = runServerClose() && ok;
+    ok = runServerIdle() && ok;
+    ok = runChunked() && ok;
+
+    uint32_t onHandshakes = 0, offHandshakes = 0;
+    int onFailed = 0, offFailed = 0;
+    double on = measureThroughput(true, onHandshakes, onFailed);
+    double off = measureThroughput(false, offHandshakes, offFailed);
+    int requests = API_WORKER_COUNT * BENCH_THROUGHPUT_PER_THREAD;
+    bool faster = onFailed == 0 && offFailed == 0 && on > off && offHandshakes == (uint32_t)requests &&
+                  onHandshakes <= (uint32_t)API_CONN_POOL_SIZE;
+    fprintf(out, "case=throughput speedup=%.1fx %s\n", off > 0 ? on / off : 0.0, faster ? "ok" : "FAILED");
+    ok = faster && ok;
+
+    // apiConnPrintStats と同じ集計（ハンドシェイクの原因と時間）
+    ApiConnStats s = apiConnGetStats();
+    uint32_t avgMs = s.handshakes > 0 ? s.handshakeMsTotal / s.handshakes : 0;
+    bool timed = s.serverCloses >= (uint32_t)requests && avgMs >= BENCH_HANDSHAKE_MS && s.handshakeMsMax >= avgMs;
+    fprintf(out, "case=stats handshakes=%lu idle_closes=%lu server_closes=%lu reconnects=%lu handshake_avg_ms=%lu "
+                 "handshake_max_ms=%lu %s\n",
+            (unsigned long)s.handshakes, (unsigned long)s.idleCloses, (unsigned long)s.serverCloses,
+            (unsigned long)s.reconnects, (unsigned long)avgMs, (unsigned long)s.handshakeMsMax, timed ? "ok" : "FAILED");
+    ok = timed && ok;
+
+    fprintf(out, "%s\n", ok ? "OK" : "FAILED");
+    fflush(out);
+    return ok ? 0 : 1;
+}
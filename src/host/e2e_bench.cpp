@@ -0,0 +1,463 @@
+// 操作から疑似サーバーまでの負荷・レイテンシの計測（疑似SwitchBotサーバーに往復時間の揺れ・失敗・呼び出し回数の制限を入れ、
+// タッチ操作の記録を再生する）
+// UI ループ・コマンドの集約と記録・API ワーカーを実機の loop() と同じ組み合わせで動かし、場合ごとに
+//   コマンドの遅れ: 操作を終えて指示が出てから（ドラッグは離したとき、OFF は取り消しを待った後）疑似サーバーの値が
+//                   画面と一致するまで（指示を出さずに一致した分は数えない）
+//   状態の鮮度: 表示中のページの電球の値が疑似サーバーと違っている時間（50ms ごとに調べる）
+//   API 呼び出し: 疑似サーバーが受けたリクエストの内訳
+//   UI の停止: ループ1回の処理時間（待っている時間を除く）
+// のパーセンタイルを JSON で1行ずつ出力する（ログは捨て、結果の行だけを標準出力に出す）
+// 往復3秒の遅い疑似サーバー（slow_backend）では API ワーカーのキューに指示が溜まった状態で操作を続ける
+// コマンドの遅れの p95 が場合ごとの上限を超えるか、UI ループ1回の処理時間の最大が BENCH_LOOP_MAX_US を超えるか、
+// 最後まで画面と疑似サーバーが一致しなければ終了コード 1
+//
+// 引数（指定するとその条件の "custom" の1つの場合だけを実行）:
+//   --latency=ミリ秒 --jitter=ミリ秒 --errors=% --rate=回/秒 --burst=回 --budget=ミリ秒（p95 の上限）
+//   --trace=ファイル  -DGESTURE_TRACE=1 の実機のシリアル出力（"T 時刻 x y 押下" の行）を合成した操作の代わりに再生する
+// 実行: pio run -e native-e2e-bench -t exec
+#include <Arduino.h>
+
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+#include "device_registry.h"
+#include "device_discovery.h"
+#include "boot.h"
+#include "switchbot_api.h"
+#include "api_worker.h"
+#include "api_quota.h"
+#include "command_coalescer.h"
+#include "command_log.h"
+#include "state_cache.h"
+#include "event_loop.h"
+#include "gesture.h"
+#include "loop_profiler.h"
+#include "ui.h"
+#include "ui_layout.h"
+#include "ui_render.h"
+#include "hal/hal_storage.h"
+#include "hal/native/hal_native.h"
+#include "host/mock_switchbot.h"
+
+// ページ送りを計測に含めるため devices.h の電球の後ろに追加する疑似電球の数
+#define BENCH_EXTRA_BULBS 4
+
+// 状態の鮮度を調べる間隔
+#define BENCH_SAMPLE_MS 50
+
+// 記録の再生後、全ての指示が届くまで待つ上限
+#define BENCH_SETTLE_MS 30000
+
+// 各場合の始めの電球の状態（全て ON・明るさ50）
+#define BENCH_START_BRIGHTNESS 50
+
+// UI ループ1回の処理時間の上限（遅いループとして数える時間、通信の往復時間によらない）
+#define BENCH_LOOP_MAX_US PROFILE_SLOW_LOOP_US
+
+// 計測する場合（疑似サーバーの往復時間・障害と、コマンドの遅れの p95 の上限）
+struct BenchScenario {
+    const char* name;
+    uint32_t latencyMs;
+    MockFaults faults;
+    uint32_t budgetP95Ms;
+};
+
+static const BenchScenario scenarios[] = {
+    {"baseline", 150, {0, 0, 0, 0, 1}, 600},
+    {"jitter", 150, {250, 0, 0, 0, 2}, 1200},
+    {"lossy", 150, {50, 10, 0, 0, 3}, 6000},
+    {"rate_limited", 150, {50, 0, 1, 2, 4}, 8000},
+    {"slow_backend", 3000, {0, 0, 0, 0, 5}, 15000},
+};
+
+#define SCENARIO_COUNT (int)(sizeof(scenarios) / sizeof(scenarios[0]))
+
+// 再生するタッチ操作（halNativeSetTouchScript に渡す、時刻は再生開始からのミリ秒）
+static std::vector<HalNativeTouchEvent> trace;
+static std::vector<HalNativeTouchEvent> script;
+
+// 電球・項目ごとの画面と疑似サーバーの食い違い
+enum BenchField {
+    FIELD_POWER,
+    FIELD_BRIGHTNESS,
+    FIELD_COUNT
+};
+
+struct Divergence {
+    bool active;
+    bool issued;          // 画面の値を最後に変えてから指示が出た（コマンドの集約が空でなくなった）
+    uint32_t since;       // 食い違い始めた時刻
+    uint32_t issuedAt;    // 指示が出た時刻
+    int uiValue;
+};
+
+static Divergence divergence[REGISTRY_MAX_BULBS][FIELD_COUNT];
+
+// 1つの場合の計測値
+static std::vector<uint32_t> commandLatencyMs;
+static std::vector<uint32_t> staleMs;
+static std::vector<uint32_t> loopUs;
+static int pendingMax = 0;
+static uint32_t staleSamples = 0;
+static uint32_t nextSampleAt = 0;
+
+// 結果の出力先（ログを捨てる前の標準出力）
+static FILE* out = stdout;
+
+// 電源ボタンの長押し
+static void addPress(uint32_t& t, int x, int y) {
+    trace.push_back({t, x, y, true});
+    trace.push_back({t + GESTURE_LONG_PRESS_MS + 100, x, y, false});
+    t += GESTURE_LONG_PRESS_MS + 400;
+}
+
+// 指を from から to まで steps 回に分けて動かす（サンプル間隔 intervalMs）
+static void addStroke(uint32_t& t, int x0, int y0, int x1, int y1, int steps, uint32_t intervalMs) {
+    for (int i = 0; i <= steps; i++) {
+        trace.push_back({t + i * intervalMs, x0 + (x1 - x0) * i / steps, y0 + (y1 - y0) * i / steps, true});
+    }
+    t += steps * intervalMs;
+    trace.push_back({t + intervalMs, x1, y1, false});
+    t += 400;
+}
+
+static int buttonX(int slot) {
+    return getButtonX(slot) + getButtonWidth() / 2;
+}
+
+static int sliderX(int slot, int percent) {
+    return getSliderX(slot) + getSliderWidth() * percent / 100;
+}
+
+// 合成した操作（約10秒）: 1ページ目のスライダーのドラッグ・電源ボタンの長押し、2ページ目へ送って操作し、1ページ目に戻る
+static void buildTrace() {
+    uint32_t t = 200;
+    int by = getButtonY() + BUTTON_HEIGHT / 2;
+    int sy = getSliderY() + SLIDER_HEIGHT / 2;
+    int swipeY = getSliderY() + 100 + (SCREEN_HEIGHT - 40 - getSliderY() - 100) / 2;
+
+    for (int slot = 0; slot < PANELS_PER_PAGE; slot++) {
+        int percent = slot % 2 == 0 ? 20 + 5 * slot : 80 - 5 * slot;
+        addStroke(t, sliderX(slot, 50), sy, sliderX(slot, percent), sy, 8, 16);
+    }
+    addPress(t, buttonX(1), by);
+    addPress(t, buttonX(3), by);
+
+    addStroke(t, SCREEN_WIDTH - 300, swipeY, 300, swipeY, 12, 16);
+    addPress(t, buttonX(0), by);
+    addStroke(t, sliderX(2, 50), sy, sliderX(2, 85), sy, 20, 16);
+    addPress(t, buttonX(1), by);
+    addPress(t, buttonX(1), by);
+
+    addStroke(t, 300, swipeY, SCREEN_WIDTH - 300, swipeY, 12, 16);
+    addPress(t, buttonX(1), by);
+    addStroke(t, sliderX(0, 35), sy, sliderX(0, 90), sy, 30, 8);
+    addStroke(t, sliderX(0, 90), sy, sliderX(0, 60), sy, 10, 16);
+}
+
+// 実機のタッチの記録を読む（最初のサンプルを時刻 200ms にずらす）
+static bool loadTrace(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (f == nullptr) {
+        fprintf(stderr, "cannot open %s\n", path);
+        return false;
+    }
+
+    char line[128];
+    unsigned long at;
+    int x, y, down;
+    unsigned long first = 0;
+    while (fgets(line, sizeof(line), f) != nullptr) {
+        if (sscanf(line, "T %lu %d %d %d", &at, &x, &y, &down) != 4) continue;
+        if (trace.empty()) first = at;
+        trace.push_back({(uint32_t)(at - first + 200), x, y, down != 0});
+    }
+    fclose(f);
+    if (trace.empty()) {
+        fprintf(stderr, "no touch samples in %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+static int uiValue(int index, int field) {
+    return field == FIELD_POWER ? (bulbs.powerState[index] ? 1 : 0) : bulbs.brightness[index];
+}
+
+static int serverValue(const MockBulb& server, int field) {
+    return field == FIELD_POWER ? (server.power ? 1 : 0) : server.brightness;
+}
+
+// 画面と疑似サーバーの食い違いを更新する（一致したら指示が出てからの時間をコマンドの遅れとして記録）
+static void trackDivergence(uint32_t now) {
+    for (int i = 0; i < bulbs.count; i++) {
+        MockBulb server = mockSwitchBotBulb(i);
+        bool commandPending = !coalescerIdle(i);
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            Divergence& d = divergence[i][f];
+            int ui = uiValue(i, f);
+            if (ui != serverValue(server, f)) {
+                if (!d.active) {
+                    d = {true, false, now, 0, ui};
+                } else if (ui != d.uiValue) {
+                    d.issued = false;
+                    d.uiValue = ui;
+                }
+                if (!d.issued && commandPending) {
+                    d.issued = true;
+                    d.issuedAt = now;
+                }
+            } else if (d.active) {
+                if (d.issued) commandLatencyMs.push_back(now - d.issuedAt);
+                d.active = false;
+            }
+        }
+    }
+}
+
+// 表示中のページの電球が疑似サーバーと違っている時間（一致していれば 0）
+static void sampleFreshness(uint32_t now) {
+    int first = renderGetPage() * PANELS_PER_PAGE;
+    for (int i = first; i < first + PANELS_PER_PAGE && i < bulbs.count; i++) {
+        uint32_t age = 0;
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            if (divergence[i][f].active) age = max(age, now - divergence[i][f].since);
+        }
+        staleMs.push_back(age);
+        if (age > 0) staleSamples++;
+    }
+}
+
+static bool converged() {
+    for (int i = 0; i < bulbs.count; i++) {
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            if (divergence[i][f].active) return false;
+        }
+    }
+    return true;
+}
+
+// main.cpp の loop() と同じ処理（シリアル・温湿度の分はタイマーの設定だけ）
+static void loopOnce() {
+    uint32_t t0 = micros();
+    profilerLoopBegin();
+    bootService(millis());
+    uiUpdate();
+
+    unsigned long now = millis();
+    eventLoopSchedule(LOOP_TIMER_BOOT, eventLoopNextPoll(now));
+    eventLoopSchedule(LOOP_TIMER_SERIAL, eventLoopNextPoll(now));
+    profilerLoopEnd();
+    loopUs.push_back(micros() - t0);
+    pendingMax = max(pendingMax, apiWorkerPending());
+
+    trackDivergence(now);
+    while ((int32_t)(now - nextSampleAt) >= 0) {
+        sampleFreshness(now);
+        nextSampleAt += BENCH_SAMPLE_MS;
+    }
+    eventLoopWait();
+}
+
+// 全ての電球を ON・明るさ50 にそろえ、状態取得で確認したことにする
+static void resetBulbs() {
+    unsigned long now = millis();
+    for (int i = 0; i < bulbs.count; i++) {
+        mockSwitchBotSetBulb(i, true, BENCH_START_BRIGHTNESS);
+        uiUpdateBulbState(i, true, BENCH_START_BRIGHTNESS);
+        coalescerNoteStatus(i, true, BENCH_START_BRIGHTNESS);
+        stateCacheNoteConfirmed(i, now);
+        for (int f = 0; f < FIELD_COUNT; f++) divergence[i][f].active = false;
+    }
+}
+
+static uint32_t percentile(const std::vector<uint32_t>& sorted, int p) {
+    if (sorted.empty()) return 0;
+    return sorted[(sorted.size() - 1) * p / 100];
+}
+
+// "name":{"n":..,"p50":..,"p95":..,"p99":..,"max":..}
+static uint32_t printPercentiles(const char* name, std::vector<uint32_t>& values) {
+    std::sort(values.begin(), values.end());
+    uint32_t p95 = percentile(values, 95);
+    fprintf(out, "\"%s\":{\"n\":%zu,\"p50\":%lu,\"p95\":%lu,\"p99\":%lu,\"max\":%lu}", name, values.size(),
+            (unsigned long)percentile(values, 50), (unsigned long)p95, (unsigned long)percentile(values, 99),
+            (unsigned long)(values.empty() ? 0 : values.back()));
+    return p95;
+}
+
+// 1つの場合を実行して結果を1行出力する（戻り値: 上限内で最後まで一致した）
+static bool runScenario(const BenchScenario& scenario) {
+    mockSwitchBotInstall(scenario.latencyMs, 0);
+    resetBulbs();
+    renderSetPage(0);
+    while (apiWorkerPending() > 0) loopOnce();
+
+    mockSwitchBotSetFaults(scenario.faults);
+    commandLatencyMs.clear();
+    staleMs.clear();
+    loopUs.clear();
+    pendingMax = 0;
+    staleSamples = 0;
+    profilerReset();
+    CoalesceStats cs0 = coalescerGetStats();
+    CommandLogStats log0 = commandLogGetStats();
+
+    uint32_t t0 = millis();
+    nextSampleAt = t0;
+    script = trace;
+    for (HalNativeTouchEvent& ev : script) ev.atMs += t0;
+    halNativeSetTouchScript(script.data(), (int)script.size());
+
+    while (!halNativeTouchScriptDone()) loopOnce();
+    uint32_t traceEnd = millis();
+    bool settled = false;
+    while (millis() - traceEnd < BENCH_SETTLE_MS) {
+        loopOnce();
+        bool idle = apiWorkerPending() == 0 && converged();
+        for (int i = 0; i < bulbs.count && idle; i++) idle = coalescerIdle(i);
+        if (idle) {
+            settled = true;
+            break;
+        }
+    }
+    uint32_t elapsed = millis() - t0;
+
+    int unconverged = 0;
+    for (int i = 0; i < bulbs.count; i++) {
+        for (int f = 0; f < FIELD_COUNT; f++) {
+            if (divergence[i][f].active) unconverged++;
+        }
+    }
+    MockStats api = mockSwitchBotStats();
+    CoalesceStats cs = coalescerGetStats();
+    CommandLogStats log = commandLogGetStats();
+    uint32_t slowLoops = (uint32_t)std::count_if(loopUs.begin(), loopUs.end(),
+                                                 [](uint32_t us) { return us > PROFILE_SLOW_LOOP_US; });
+    uint32_t samples = (uint32_t)staleMs.size();
+
+    fprintf(out,
+            "{\"scenario\":\"%s\",\"latency_ms\":%lu,\"jitter_ms\":%lu,\"error_pct\":%d,\"rate_per_sec\":%d,"
+            "\"touch_events\":%zu,\"elapsed_ms\":%lu,",
+            scenario.name, (unsigned long)scenario.latencyMs, (unsigned long)scenario.faults.jitterMs,
+            scenario.faults.errorPercent, scenario.faults.ratePerSec, script.size(), (unsigned long)elapsed);
+    uint32_t p95 = printPercentiles("command_latency_ms", commandLatencyMs);
+    fputc(',', out);
+    printPercentiles("status_stale_ms", staleMs);
+    fprintf(out, ",\"status_mismatch_pct\":%.1f,", samples > 0 ? 100.0 * staleSamples / samples : 0.0);
+    fprintf(out,
+            "\"api\":{\"requests\":%lu,\"commands\":%lu,\"status\":%lu,\"errors\":%lu,\"rate_limited\":%lu,"
+            "\"intents\":%lu,\"sent\":%lu,\"retries\":%lu,\"failed\":%lu},",
+            (unsigned long)api.requests, (unsigned long)api.commands, (unsigned long)api.statuses,
+            (unsigned long)api.errors, (unsigned long)api.rateLimited, (unsigned long)(cs.intents - cs0.intents),
+            (unsigned long)(cs.sent - cs0.sent), (unsigned long)(log.retries - log0.retries),
+            (unsigned long)(log.failed - log0.failed));
+    printPercentiles("ui_loop_us", loopUs);
+    uint32_t loopMaxUs = loopUs.empty() ? 0 : loopUs.back();
+
+    bool ok = settled && unconverged == 0 && p95 <= scenario.budgetP95Ms && loopMaxUs <= BENCH_LOOP_MAX_US;
+    fprintf(out,
+            ",\"api_pending_max\":%d,\"slow_loops\":%lu,\"unconverged\":%d,\"budget_p95_ms\":%lu,"
+            "\"loop_max_bound_us\":%lu,\"ok\":%s}\n",
+            pendingMax, (unsigned long)slowLoops, unconverged, (unsigned long)scenario.budgetP95Ms,
+            (unsigned long)BENCH_LOOP_MAX_US, ok ? "true" : "false");
+    fflush(out);
+    return ok;
+}
+
+// "--name=値" なら値を返す
+static const char* optionValue(const char* arg, const char* name) {
+    size_t len = strlen(name);
+    if (strncmp(arg, name, len) != 0 || arg[len] != '=') return nullptr;
+    return arg + len + 1;
+}
+
+// 引数から "custom" の場合を作る（戻り値: 条件の指定があった）
+static bool parseArgs(int argc, char** argv, BenchScenario& custom, const char*& tracePath, bool& valid) {
+    bool specified = false;
+    valid = true;
+    for (int i = 1; i < argc; i++) {
+        const char* v;
+        if ((v = optionValue(argv[i], "--latency")) != nullptr) {
+            custom.latencyMs = (uint32_t)atoi(v);
+        } else if ((v = optionValue(argv[i], "--jitter")) != nullptr) {
+            custom.faults.jitterMs = (uint32_t)atoi(v);
+        } else if ((v = optionValue(argv[i], "--errors")) != nullptr) {
+            custom.faults.errorPercent = atoi(v);
+        } else if ((v = optionValue(argv[i], "--rate")) != nullptr) {
+            custom.faults.ratePerSec = atoi(v);
+        } else if ((v = optionValue(argv[i], "--burst")) != nullptr) {
+            custom.faults.rateBurst = atoi(v);
+        } else if ((v = optionValue(argv[i], "--budget")) != nullptr) {
+            custom.budgetP95Ms = (uint32_t)atoi(v);
+        } else if ((v = optionValue(argv[i], "--trace")) != nullptr) {
+            tracePath = v;
+            continue;
+        } else {
+            fprintf(stderr, "unknown option: %s\n", argv[i]);
+            valid = false;
+            continue;
+        }
+        specified = true;
+    }
+    return specified;
+}
+
+// ログ（Serial の出力）を捨て、結果の出力先を元の標準出力にする
+static void muteLogs() {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    out = fdopen(saved, "w");
+}
+
+int main(int argc, char** argv) {
+    BenchScenario custom = {"custom", 150, {0, 0, 0, 0, 1}, 60000};
+    const char* tracePath = nullptr;
+    bool valid = true;
+    bool single = parseArgs(argc, argv, custom, tracePath, valid);
+    if (!valid) return 2;
+    if (tracePath == nullptr) {
+        buildTrace();
+    } else if (!loadTrace(tracePath)) {
+        return 2;
+    }
+
+    muteLogs();
+    eventLoopInit();
+
+    // 保存した状態のない初回起動から始め、2ページ分の電球にする
+    halNativeSetStorageDir(".native_storage");
+    halStorageRemove(DISCOVERY_SNAPSHOT_NAME);
+    halStorageRemove(COMMAND_LOG_NAME);
+    discoveryInit();
+    for (int i = 0; i < BENCH_EXTRA_BULBS; i++) {
+        char id[DEVICE_ID_LEN];
+        char name[DEVICE_NAME_LEN];
+        snprintf(id, sizeof(id), "BENCHBULB%03d", i);
+        snprintf(name, sizeof(name), "疑似電球 %d", i + 1);
+        registryAddBulb(id, name);
+    }
+
+    mockSwitchBotInstall(0, 0);
+    switchbotApiInit();
+    apiQuotaInit(API_QUOTA_DAILY_LIMIT, API_QUOTA_PANELS);
+    apiWorkerInit();
+    uiInit();
+
+    bool ok = true;
+    if (single) {
+        ok = runScenario(custom);
+    } else {
+        for (int s = 0; s < SCENARIO_COUNT; s++) ok = runScenario(scenarios[s]) && ok;
+    }
+    halStorageRemove(COMMAND_LOG_NAME);
+
+    fprintf(out, "%s\n", ok ? "OK" : "FAILED");
+    fflush(out);
+    return ok ? 0 : 1;
+}
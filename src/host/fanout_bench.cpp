@@ -0,0 +1,188 @@
+// 表示中のページの状態取得（並列）の計測（電球ごとに往復時間の違う疑似SwitchBotサーバーに対して実行）
+// ページの電球の状態取得を一度に投入し、電球ごとに結果が画面に反映されるまでの時間と全体の時間を、
+// 1台ずつ順に取得した場合の時間（往復時間の合計）と並べて出力する
+// 取得の途中でページを切り替えた場合に、前のページの結果も捨てずに反映し、新しいページの結果が揃う前に終わったと数えないこと、
+// 結果を待っている電球に古い電球だけの取得（画面復帰・ページ送り・先読み）を重ねても取得を送り直さないことも確かめる
+// 全体の時間が順に取得した場合以上か、ページを切り替えた場合に結果を捨てるか揃う前に終わったとみなすか、
+// 古い電球だけの取得で同じ電球に2回取得すれば終了コード 1
+// 実行: pio run -e native-fanout-bench -t exec
+#include <Arduino.h>
+
+#include "device_registry.h"
+#include "switchbot_api.h"
+#include "api_worker.h"
+#include "api_quota.h"
+#include "state_cache.h"
+#include "ui.h"
+#include "ui_layout.h"
+#include "ui_render.h"
+#include "host/mock_switchbot.h"
+
+// 疑似サーバーの往復時間と、電球ごとに加える遅れ（ページ内の位置ごとに BENCH_STEP_MS ずつ延ばす）
+#define BENCH_RTT_MS 50
+#define BENCH_STEP_MS 100
+
+// 取得が終わるまで待つ上限
+#define BENCH_TIMEOUT_MS 10000
+
+// 全体の時間の許容（一番遅い電球の往復時間からの遅れ、UI ループの刻みとワーカーの待ちの分）
+#define BENCH_SLACK_MS 100
+
+// UI ループ1回分
+static void pumpLoop() {
+    uiUpdate();
+    delay(1);
+}
+
+// 画面の電球の状態が疑似サーバーと同じか
+static bool uiMatchesServer(int index) {
+    MockBulb server = mockSwitchBotBulb(index);
+    return bulbs.powerState[index] == server.power && bulbs.brightness[index] == server.brightness;
+}
+
+// このページの電球の往復時間（ページ内の位置ごとに遅くする）と、疑似サーバーの状態（画面と違う値）を設定する
+// 戻り値: 往復時間の合計（1台ずつ順に取得した場合の時間）
+static uint32_t preparePage(int page, uint32_t extraMs, int brightness) {
+    uint32_t total = 0;
+    for (int slot = 0; slot < PANELS_PER_PAGE; slot++) {
+        int i = page * PANELS_PER_PAGE + slot;
+        if (i >= bulbs.count) break;
+        uint32_t latency = extraMs + BENCH_STEP_MS * slot;
+        mockSwitchBotSetBulbLatency(i, latency);
+        mockSwitchBotSetBulb(i, !bulbs.powerState[i], brightness + slot);
+        total += BENCH_RTT_MS + latency;
+    }
+    return total;
+}
+
+// 1ページ分の取得: 電球ごとに反映されるまでの時間を出力する（戻り値: 全体の時間が順に取得した場合より短い）
+static bool runFanout(int page) {
+    renderSetPage(page);
+    uint32_t sequentialMs = preparePage(page, 0, 20);
+    int first = page * PANELS_PER_PAGE;
+    int last = min(first + PANELS_PER_PAGE, bulbs.count);
+
+    uint32_t appliedMs[PANELS_PER_PAGE] = {};
+    uint32_t t0 = millis();
+    uiRefreshVisibleBulbStatus();
+    int remaining = last - first;
+    while (remaining > 0 && millis() - t0 < BENCH_TIMEOUT_MS) {
+        pumpLoop();
+        for (int i = first; i < last; i++) {
+            if (appliedMs[i - first] == 0 && uiMatchesServer(i)) {
+                appliedMs[i - first] = millis() - t0;
+                remaining--;
+            }
+        }
+    }
+    uint32_t elapsed = millis() - t0;
+    uint32_t slowest = BENCH_RTT_MS + BENCH_STEP_MS * (last - first - 1);
+
+    for (int i = first; i < last; i++) {
+        printf("case=fanout page=%d device=%d rtt_ms=%lu applied_ms=%lu\n", page, i,
+               (unsigned long)(BENCH_RTT_MS + BENCH_STEP_MS * (i - first)), (unsigned long)appliedMs[i - first]);
+    }
+    printf("case=fanout page=%d bulbs=%d workers=%d elapsed_ms=%lu slowest_rtt_ms=%lu sequential_ms=%lu "
+           "speedup=%.1fx\n",
+           page, last - first, API_WORKER_COUNT, (unsigned long)elapsed, (unsigned long)slowest,
+           (unsigned long)sequentialMs, elapsed > 0 ? (double)sequentialMs / elapsed : 0.0);
+
+    bool ok = remaining == 0 && elapsed < sequentialMs;
+    if (last - first <= API_WORKER_COUNT) ok = ok && elapsed <= slowest + BENCH_SLACK_MS;
+    if (!ok) Serial.printf("FAILED: page %d fan-out took %lu ms\n", page, (unsigned long)elapsed);
+    return ok;
+}
+
+// 1ページ目の取得の途中で2ページ目に切り替える: 1ページ目の結果も反映し、両方の結果が揃うまで終わったと数えない
+static bool runPageSwitch() {
+    renderSetPage(0);
+    preparePage(0, BENCH_STEP_MS, 60);
+    preparePage(1, BENCH_STEP_MS * 2, 60);
+    int previous = min(PANELS_PER_PAGE, bulbs.count);
+
+    uint32_t t0 = millis();
+    uiRefreshVisibleBulbStatus();
+    while (millis() - t0 < BENCH_STEP_MS / 2) pumpLoop();
+    renderSetPage(1);
+    uiRefreshVisibleBulbStatus();
+    int requested = uiRefreshRemaining();
+
+    // 残りが 0 になった時点で、2ページ目の電球が全て反映されているか
+    int first = PANELS_PER_PAGE;
+    int last = min(first + PANELS_PER_PAGE, bulbs.count);
+    while (uiRefreshRemaining() > 0 && millis() - t0 < BENCH_TIMEOUT_MS) pumpLoop();
+    uint32_t doneMs = millis() - t0;
+    int applied = 0;
+    for (int i = first; i < last; i++) {
+        if (uiMatchesServer(i)) applied++;
+    }
+
+    // 前のページの結果は別の電球の取得なので捨てない
+    int previousApplied = 0;
+    for (int i = 0; i < previous; i++) {
+        if (uiMatchesServer(i)) previousApplied++;
+    }
+    while (apiWorkerPending() > 0) pumpLoop();
+
+    printf("case=page_switch requested=%d applied_at_done=%d previous_applied=%d done_ms=%lu\n", requested,
+           applied, previousApplied, (unsigned long)doneMs);
+    bool ok = requested == previous + last - first && applied == last - first && previousApplied == previous;
+    if (!ok) Serial.println("FAILED: page switch dropped results or finished before they arrived");
+    return ok;
+}
+
+// ページ全体の取得の結果を待つ間に古い電球だけの取得を重ねる: 結果を待っている電球には投入しない
+static bool runStaleOverlap() {
+    renderSetPage(0);
+    preparePage(0, BENCH_STEP_MS, 30);
+    // 確認した時刻を忘れさせ、全ての電球を古い扱いにする
+    stateCacheInit();
+    int count = min(PANELS_PER_PAGE, bulbs.count);
+    uint32_t statuses = mockSwitchBotStats().statuses;
+
+    uint32_t t0 = millis();
+    uiRefreshVisibleBulbStatus();
+    int requested = uiRefreshRemaining();
+    uiRefreshStaleBulbStatus();
+    uiRefreshStaleBulbStatus();
+    while (uiRefreshRemaining() > 0 && millis() - t0 < BENCH_TIMEOUT_MS) pumpLoop();
+    while (apiWorkerPending() > 0) pumpLoop();
+
+    int applied = 0;
+    for (int i = 0; i < count; i++) {
+        if (uiMatchesServer(i)) applied++;
+    }
+    uint32_t gets = mockSwitchBotStats().statuses - statuses;
+    printf("case=stale_overlap bulbs=%d requested=%d gets=%lu applied=%d\n", count, requested,
+           (unsigned long)gets, applied);
+    bool ok = requested == count && gets == (uint32_t)count && applied == count;
+    if (!ok) Serial.println("FAILED: stale-only refresh re-sent GETs for bulbs already in flight");
+    return ok;
+}
+
+int main() {
+    // devices.h の電球に、2ページ分に足りない分を加える
+    registryInit();
+    for (int i = 0; bulbs.count < PANELS_PER_PAGE * 2; i++) {
+        char id[DEVICE_ID_LEN];
+        char name[DEVICE_NAME_LEN];
+        snprintf(id, sizeof(id), "FANOUT%04d", i);
+        snprintf(name, sizeof(name), "疑似電球 %d", i + 1);
+        registryAddBulb(id, name);
+    }
+    mockSwitchBotInstall(BENCH_RTT_MS, 0);
+
+    switchbotApiInit();
+    apiQuotaInit(API_QUOTA_DAILY_LIMIT, API_QUOTA_PANELS);
+    apiWorkerInit();
+    uiInit();
+    while (apiWorkerPending() > 0) pumpLoop();
+
+    bool ok = runFanout(0);
+    ok = runFanout(1) && ok;
+    ok = runPageSwitch() && ok;
+    ok = runStaleOverlap() && ok;
+
+    Serial.println(ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,423 @@
+// タッチ操作の認識の計測（合成したタッチの記録、または実機で記録したタッチの記録を再生）
+// 種類ごとに正解の動作と判定できる時刻がわかっている操作（ボタンのタップ・長押し・外れ、スライダーのドラッグ・タップ、
+// ページ送り、背景のタップ）を、サンプル間隔の揺れ・座標の揺れ・サンプルの取りこぼしを加えて再生し、
+// 取りこぼした操作の割合と、判定できる時刻から動作までの遅れ（サンプルの時刻）・1サンプルの処理時間、
+// 当たり判定の時間（格子の索引と全件走査）を出力する
+// 取りこぼしがある、索引と全件走査の結果が違えば終了コード 1
+// 引数に記録のファイル（-DGESTURE_TRACE=1 の実機のシリアル出力、"T 時刻 x y 押下" の行）を渡すと、それを再生して動作を出力する
+// 実行: pio run -e native-gesture-bench -t exec
+#include <Arduino.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "gesture.h"
+#include "ui_layout.h"
+
+// 合成する操作の数と、サンプル間隔・座標の揺れ・取りこぼし
+#define BENCH_GESTURES 5000
+#define BENCH_SAMPLE_MIN_MS 8
+#define BENCH_SAMPLE_MAX_MS 16
+#define BENCH_JITTER_PX 2
+#define BENCH_DROP_PERCENT 2
+
+// 当たり判定の計測点の数
+#define BENCH_HIT_POINTS 1000000
+
+// 操作できない位置（電球が登録されていない・OFF の電球のスライダー）とみなすパネル位置
+#define BENCH_DISABLED_SLOT 3
+
+// 合成する操作の種類
+enum BenchKind
+{
+    KIND_BUTTON_TAP,
+    KIND_LONG_PRESS,
+    KIND_BUTTON_LEAVE,
+    KIND_SLIDER_DRAG,
+    KIND_SLIDER_TAP,
+    KIND_SWIPE,
+    KIND_DISABLED_SWIPE,
+    KIND_BACKGROUND_TAP,
+    KIND_COUNT
+};
+
+static const char *const kindNames[KIND_COUNT] = {"button_tap", "long_press", "button_leave",   "slider_drag",
+                                                  "slider_tap", "swipe",      "disabled_swipe", "background_tap"};
+
+// 指の位置（時刻の関数、down=false で離れている）
+struct Sample
+{
+    uint32_t at;
+    int x;
+    int y;
+    bool down;
+};
+
+// 1つの操作の正解（判定を決める動作と、それが判定できる時刻）
+struct Expected
+{
+    BenchKind kind;
+    GestureAction action;
+    uint32_t truthAt;
+    size_t firstEvent; // この操作の間に出た動作の範囲
+    size_t lastEvent;
+};
+
+// 認識した動作
+struct Recorded
+{
+    GestureAction action;
+    uint32_t at;
+    GestureWidgetKind widget;
+    int slot;
+};
+
+static std::vector<Recorded> events;
+
+// 再現性のための乱数（xorshift32）
+static uint32_t rngState = 0x9e3779b9u;
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static int randomIn(int lo, int hi)
+{
+    return lo + (int)(nextRandom() % (uint32_t)(hi - lo + 1));
+}
+
+static bool acceptWidget(const GestureWidget &widget)
+{
+    return widget.slot != BENCH_DISABLED_SLOT;
+}
+
+static void onGesture(const GestureEvent &event)
+{
+    events.push_back({event.action, event.at, event.widget->kind, event.widget->slot});
+}
+
+// 部品の中の点（端から margin 以上内側）
+static void pointIn(const GestureWidget &w, int margin, int &x, int &y)
+{
+    x = randomIn(w.x + margin, w.x + w.w - margin);
+    y = randomIn(w.y + margin, w.y + w.h - margin);
+}
+
+static const GestureWidget &findWidget(GestureWidgetKind kind, int slot)
+{
+    for (int i = 0; i < gestureWidgetCount(); i++)
+    {
+        const GestureWidget &w = gestureWidget(i);
+        if (w.kind == kind && w.slot == slot)
+            return w;
+    }
+    return gestureWidget(0);
+}
+
+// 指の軌跡: t0 から duration の間に (x0,y0) から (x1,y1) へ等速で動く
+struct Stroke
+{
+    uint32_t t0;
+    uint32_t duration;
+    int x0, y0, x1, y1;
+};
+
+// 操作を1つ作る（strokes を順に辿り、最後に離す。戻り値: 正解の動作）
+static GestureAction buildGesture(BenchKind kind, uint32_t t0, std::vector<Stroke> &strokes, uint32_t &truthAt,
+                                  uint32_t &releaseAt)
+{
+    strokes.clear();
+    int slot = randomIn(0, PANELS_PER_PAGE - 2); // 操作できるパネル位置
+    int x, y;
+    switch (kind)
+    {
+    case KIND_BUTTON_TAP:
+    case KIND_SLIDER_TAP:
+    {
+        pointIn(findWidget(kind == KIND_BUTTON_TAP ? WIDGET_BUTTON : WIDGET_SLIDER, slot), 15, x, y);
+        uint32_t d = randomIn(60, 300);
+        strokes.push_back({t0, d, x, y, x + randomIn(-6, 6), y + randomIn(-6, 6)});
+        releaseAt = truthAt = t0 + d;
+        return GESTURE_ACTION_TAP;
+    }
+    case KIND_LONG_PRESS:
+    {
+        pointIn(findWidget(WIDGET_BUTTON, slot), 15, x, y);
+        uint32_t d = randomIn(700, 1200);
+        strokes.push_back({t0, d, x, y, x + randomIn(-6, 6), y + randomIn(-6, 6)});
+        truthAt = t0 + GESTURE_LONG_PRESS_MS;
+        releaseAt = t0 + d;
+        return GESTURE_ACTION_LONG_PRESS;
+    }
+    case KIND_BUTTON_LEAVE:
+    {
+        // 押してから下に外れ、長押しの時間を過ぎてから離す
+        const GestureWidget &w = findWidget(WIDGET_BUTTON, slot);
+        pointIn(w, 15, x, y);
+        uint32_t hold = randomIn(100, 300);
+        int y1 = w.y + w.h + 60;
+        strokes.push_back({t0, hold, x, y, x, y});
+        strokes.push_back({t0 + hold, 50, x, y, x, y1});
+        strokes.push_back({t0 + hold + 50, 600, x, y1, x, y1});
+        truthAt = t0 + hold + 50 * (w.y + w.h + 1 - y) / (y1 - y);
+        releaseAt = t0 + hold + 650;
+        return GESTURE_ACTION_CANCEL;
+    }
+    case KIND_SLIDER_DRAG:
+    {
+        const GestureWidget &w = findWidget(WIDGET_SLIDER, slot);
+        pointIn(w, 25, x, y);
+        int distance = randomIn(60, 250) * (nextRandom() % 2 ? 1 : -1);
+        uint32_t d = randomIn(200, 600);
+        strokes.push_back({t0, d, x, y, x + distance, y + randomIn(-10, 10)});
+        strokes.push_back({t0 + d, 50, x + distance, y, x + distance, y});
+        truthAt = t0 + d * GESTURE_DRAG_THRESHOLD / abs(distance);
+        releaseAt = t0 + d + 50;
+        return GESTURE_ACTION_DRAG_END;
+    }
+    case KIND_SWIPE:
+    case KIND_DISABLED_SWIPE:
+    {
+        // パネルの下の余白・ヘッダー、または操作できないパネルのスライダーから
+        if (kind == KIND_DISABLED_SWIPE)
+            pointIn(findWidget(WIDGET_SLIDER, BENCH_DISABLED_SLOT), 25, x, y);
+        else if (nextRandom() % 2)
+            x = randomIn(400, 880), y = randomIn(10, HEADER_HEIGHT - 10);
+        else
+            x = randomIn(200, SCREEN_WIDTH - 200), y = randomIn(getSliderY() + 100, SCREEN_HEIGHT - 40);
+        int distance = randomIn(180, 400);
+        int dir = kind == KIND_DISABLED_SWIPE || nextRandom() % 2 ? -1 : 1;
+        x = constrain(x, 40 + (dir < 0 ? distance : 0), SCREEN_WIDTH - 40 - (dir > 0 ? distance : 0));
+        uint32_t d = randomIn(150, 400);
+        strokes.push_back({t0, d, x, y, x + dir * distance, y + randomIn(-20, 20)});
+        truthAt = t0 + d * PAGE_SWIPE_THRESHOLD / distance;
+        releaseAt = t0 + d;
+        return GESTURE_ACTION_SWIPE;
+    }
+    default:
+    {
+        x = randomIn(400, 880);
+        y = randomIn(10, HEADER_HEIGHT - 10);
+        uint32_t d = randomIn(60, 300);
+        strokes.push_back({t0, d, x, y, x + randomIn(-6, 6), y + randomIn(-6, 6)});
+        releaseAt = truthAt = t0 + d;
+        return GESTURE_ACTION_TAP;
+    }
+    }
+}
+
+// 時刻 t の指の位置（最後の軌跡の後は止まっている）
+static void positionAt(const std::vector<Stroke> &strokes, uint32_t t, int &x, int &y)
+{
+    for (const Stroke &s : strokes)
+    {
+        if (t < s.t0 + s.duration || &s == &strokes.back())
+        {
+            uint32_t dt = min(t - s.t0, s.duration);
+            x = s.x0 + (int)((int64_t)(s.x1 - s.x0) * dt / max(s.duration, 1u));
+            y = s.y0 + (int)((int64_t)(s.y1 - s.y0) * dt / max(s.duration, 1u));
+            return;
+        }
+    }
+}
+
+// 押下・離したフレームを付けて1サンプルを処理する
+static bool previousDown = false;
+static uint64_t updateUs = 0;
+static uint32_t updateCount = 0;
+static void feed(const Sample &s)
+{
+    TouchState touch = {};
+    touch.x = s.x;
+    touch.y = s.y;
+    touch.isPressed = s.down;
+    touch.wasPressed = s.down && !previousDown;
+    touch.wasReleased = !s.down && previousDown;
+    previousDown = s.down;
+
+    uint32_t startUs = micros();
+    gestureUpdate(touch, s.at);
+    updateUs += micros() - startUs;
+    updateCount++;
+}
+
+// 判定を決める動作（押下・ドラッグ中の更新以外）か
+static bool decisive(GestureAction action)
+{
+    return action != GESTURE_ACTION_PRESS && action != GESTURE_ACTION_DRAG;
+}
+
+static uint32_t percentile(std::vector<uint32_t> values, int p)
+{
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    return values[(values.size() - 1) * p / 100];
+}
+
+// 合成した操作を再生する（戻り値: 取りこぼした操作の数）
+static int runSynthetic()
+{
+    std::vector<Expected> expected;
+    std::vector<Stroke> strokes;
+    uint32_t t = 1000;
+    for (int i = 0; i < BENCH_GESTURES; i++)
+    {
+        BenchKind kind = (BenchKind)(nextRandom() % KIND_COUNT);
+        uint32_t truthAt = 0;
+        uint32_t releaseAt = 0;
+        GestureAction action = buildGesture(kind, t, strokes, truthAt, releaseAt);
+
+        size_t first = events.size();
+        for (uint32_t at = t; at < releaseAt; at += randomIn(BENCH_SAMPLE_MIN_MS, BENCH_SAMPLE_MAX_MS))
+        {
+            // 押した最初のサンプルは落とさない（押した位置が変わると正解も変わる）
+            if (at != t && nextRandom() % 100 < BENCH_DROP_PERCENT)
+                continue;
+            int x, y;
+            positionAt(strokes, at, x, y);
+            feed({at, x + randomIn(-BENCH_JITTER_PX, BENCH_JITTER_PX), y + randomIn(-BENCH_JITTER_PX, BENCH_JITTER_PX),
+                  true});
+        }
+        int x, y;
+        positionAt(strokes, releaseAt, x, y);
+        feed({releaseAt, x, y, false});
+        expected.push_back({kind, action, truthAt, first, events.size()});
+        t = releaseAt + randomIn(200, 800);
+    }
+
+    // 種類ごとの取りこぼしと遅れ（ドラッグは最初の更新までの遅れ）
+    int missed = 0;
+    int missedByKind[KIND_COUNT] = {};
+    int countByKind[KIND_COUNT] = {};
+    std::vector<uint32_t> latency[KIND_COUNT];
+    for (const Expected &e : expected)
+    {
+        countByKind[e.kind]++;
+        int decisiveCount = 0;
+        bool ok = false;
+        uint32_t firstDrag = 0;
+        for (size_t i = e.firstEvent; i < e.lastEvent; i++)
+        {
+            const Recorded &r = events[i];
+            if (r.action == GESTURE_ACTION_DRAG && firstDrag == 0)
+                firstDrag = r.at;
+            if (!decisive(r.action))
+                continue;
+            decisiveCount++;
+            if (r.action == e.action)
+            {
+                ok = true;
+                uint32_t at = e.action == GESTURE_ACTION_DRAG_END ? firstDrag : r.at;
+                latency[e.kind].push_back(at >= e.truthAt ? at - e.truthAt : 0);
+            }
+        }
+        if (!ok || decisiveCount != 1 || (e.action == GESTURE_ACTION_DRAG_END && firstDrag == 0))
+        {
+            missed++;
+            missedByKind[e.kind]++;
+        }
+    }
+
+    for (int k = 0; k < KIND_COUNT; k++)
+    {
+        printf("gesture=%s count=%d missed=%d latency_ms p50/p95/max=%lu/%lu/%lu\n", kindNames[k], countByKind[k],
+               missedByKind[k], (unsigned long)percentile(latency[k], 50), (unsigned long)percentile(latency[k], 95),
+               (unsigned long)percentile(latency[k], 100));
+    }
+    printf("gestures=%d missed=%d missed_rate=%.2f%% samples=%lu update_ns=%.0f\n", BENCH_GESTURES, missed,
+           100.0 * missed / BENCH_GESTURES, (unsigned long)updateCount,
+           updateCount > 0 ? updateUs * 1000.0 / updateCount : 0.0);
+    return missed;
+}
+
+// 索引を使わない当たり判定（登録順に全件を調べる）
+static const GestureWidget &linearHitTest(int x, int y)
+{
+    for (int i = 0; i < gestureWidgetCount(); i++)
+    {
+        const GestureWidget &w = gestureWidget(i);
+        if (x >= w.x && x <= w.x + w.w && y >= w.y && y <= w.y + w.h)
+            return w;
+    }
+    return gestureHitTest(-1, -1);
+}
+
+// 当たり判定（格子の索引と全件走査）の時間と結果の一致
+static int runHitTest()
+{
+    static int xs[1024];
+    static int ys[1024];
+    int mismatch = 0;
+    for (int i = 0; i < 1024; i++)
+    {
+        xs[i] = randomIn(0, SCREEN_WIDTH - 1);
+        ys[i] = randomIn(0, SCREEN_HEIGHT - 1);
+        if (&gestureHitTest(xs[i], ys[i]) != &linearHitTest(xs[i], ys[i]))
+            mismatch++;
+    }
+
+    // 最適化で消されないよう、見つけた部品の位置を足し合わせる
+    int checksum = 0;
+    uint32_t t0 = micros();
+    for (int i = 0; i < BENCH_HIT_POINTS; i++)
+        checksum += gestureHitTest(xs[i & 1023], ys[i & 1023]).slot;
+    double indexNs = (micros() - t0) * 1000.0 / BENCH_HIT_POINTS;
+
+    t0 = micros();
+    for (int i = 0; i < BENCH_HIT_POINTS; i++)
+        checksum -= linearHitTest(xs[i & 1023], ys[i & 1023]).slot;
+    double linearNs = (micros() - t0) * 1000.0 / BENCH_HIT_POINTS;
+
+    GestureStats stats = gestureGetStats();
+    printf("hit_index_ns=%.1f hit_linear_ns=%.1f widgets=%lu overflow=%lu mismatch=%d checksum=%d\n", indexNs,
+           linearNs, (unsigned long)stats.indexedWidgets, (unsigned long)stats.overflowCells, mismatch, checksum);
+    return mismatch + (int)stats.overflowCells;
+}
+
+// 記録のファイルを再生し、判定を決める動作を出力する
+static int replayTrace(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == nullptr)
+    {
+        printf("cannot open %s\n", path);
+        return 1;
+    }
+
+    char line[128];
+    unsigned long at;
+    int x, y, down;
+    while (fgets(line, sizeof(line), f) != nullptr)
+    {
+        if (sscanf(line, "T %lu %d %d %d", &at, &x, &y, &down) == 4)
+            feed({(uint32_t)at, x, y, down != 0});
+    }
+    fclose(f);
+
+    for (const Recorded &r : events)
+    {
+        if (decisive(r.action))
+            printf("t=%lu action=%s slot=%d\n", (unsigned long)r.at, gestureActionName(r.action), r.slot);
+    }
+    gesturePrint();
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    gestureInit(acceptWidget, onGesture);
+    if (argc > 1)
+        return replayTrace(argv[1]);
+
+    int missed = runSynthetic();
+    int hitErrors = runHitTest();
+    gesturePrint();
+
+    bool ok = missed == 0 && hitErrors == 0;
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+// 電球の登録数を変えたときの描画・当たり判定のベンチマーク
+// 登録数 4 / 64 / 512 で、当たり判定（格子計算と全件走査の比較）・全体描画・ページ送り・状態更新の時間を出力する
+// 描画の時間（host_*_us）は ui_render.cpp をホストの表示HAL（メモリ上のフレームバッファ）で動かした時間で、実機の描画時間ではない
+// 実機と共通なのは差分矩形の計算と転送ピクセル数（*_px）
+// 実行: pio run -e native-grid-bench -t exec
+#include <Arduino.h>
+
+#include <chrono>
+
+#include "device_registry.h"
+#include "ui_dirty.h"
+#include "ui_layout.h"
+#include "ui_render.h"
+#include "hal/native/hal_native.h"
+
+// 1ケースあたりの当たり判定の回数
+#define HIT_SAMPLES 200000
+
+// 全体描画・状態更新・ページ送りを繰り返して平均する回数と、計測前に回す回数（キャッシュ・初回の確保を除く）
+#define RENDER_ROUNDS 20
+#define WARMUP_ROUNDS 3
+
+static const int deviceCounts[] = {4, 64, 512};
+
+// 再現性のための乱数（xorshift32）
+static uint32_t rngState;
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static uint64_t nowNs()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// ui.cpp と同じ判定（パネル位置を割り算で求めてからボタン矩形を確かめる）
+static int hitGrid(int page, int tx, int ty)
+{
+    int slot = panelSlotAt(tx, ty);
+    if (slot < 0)
+        return -1;
+    if (ty < getButtonY() || ty > getButtonY() + BUTTON_HEIGHT)
+        return -1;
+    if (tx < getButtonX(slot) || tx > getButtonX(slot) + getButtonWidth())
+        return -1;
+    int device = page * PANELS_PER_PAGE + slot;
+    return device < bulbs.count ? device : -1;
+}
+
+// 比較用: 登録簿を先頭から走査し、表示中のページにある電球のボタン矩形と照合する
+static int hitLinear(int page, int tx, int ty)
+{
+    for (int i = 0; i < bulbs.count; i++)
+    {
+        int slot = i - page * PANELS_PER_PAGE;
+        if (slot < 0 || slot >= PANELS_PER_PAGE)
+            continue;
+        int btnX = getButtonX(slot);
+        if (tx >= btnX && tx <= btnX + getButtonWidth() && ty >= getButtonY() && ty <= getButtonY() + BUTTON_HEIGHT)
+            return i;
+    }
+    return -1;
+}
+
+static void fillRegistry(int count)
+{
+    registryClear();
+    for (int i = 0; i < count; i++)
+    {
+        char id[DEVICE_ID_LEN];
+        char name[DEVICE_NAME_LEN];
+        snprintf(id, sizeof(id), "BENCH%06d", i);
+        snprintf(name, sizeof(name), "電球 %d", i + 1);
+        int index = registryAddBulb(id, name);
+        bulbs.powerState[index] = (i % 3 != 0);
+        bulbs.brightness[index] = 1 + i % 100;
+    }
+}
+
+static void benchmark(int count)
+{
+    fillRegistry(count);
+    int pages = pageCount();
+    rngState = 0x2468ace1u;
+
+    // 当たり判定（最後のページを表示している想定: 全件走査では最悪に近い）
+    static int xs[1024];
+    static int ys[1024];
+    for (int i = 0; i < 1024; i++)
+    {
+        xs[i] = nextRandom() % SCREEN_WIDTH;
+        ys[i] = nextRandom() % SCREEN_HEIGHT;
+    }
+    int page = pages - 1;
+    int mismatches = 0;
+    long checksum = 0;
+
+    for (int round = 0; round < WARMUP_ROUNDS; round++)
+    {
+        for (int i = 0; i < 1024; i++)
+            checksum += hitGrid(page, xs[i], ys[i]) - hitLinear(page, xs[i], ys[i]);
+    }
+
+    uint64_t t0 = nowNs();
+    for (int i = 0; i < HIT_SAMPLES; i++)
+        checksum += hitGrid(page, xs[i & 1023], ys[i & 1023]);
+    uint64_t t1 = nowNs();
+    for (int i = 0; i < HIT_SAMPLES; i++)
+        checksum -= hitLinear(page, xs[i & 1023], ys[i & 1023]);
+    uint64_t t2 = nowNs();
+    for (int i = 0; i < 1024; i++)
+    {
+        if (hitGrid(page, xs[i], ys[i]) != hitLinear(page, xs[i], ys[i]))
+            mismatches++;
+    }
+
+    // 全体描画
+    renderInit();
+    for (int round = 0; round < WARMUP_ROUNDS; round++)
+    {
+        renderAll(80);
+        renderEndFrame();
+    }
+    uint64_t allNs = 0;
+    for (int round = 0; round < RENDER_ROUNDS; round++)
+    {
+        uint64_t a0 = nowNs();
+        renderAll(80);
+        renderEndFrame();
+        allNs += nowNs() - a0;
+    }
+    uint32_t allPixels = renderGetStats().lastFramePixels;
+
+    // 全電球の状態更新（表示中のページ以外は描画しない）
+    uint64_t updateNs = 0;
+    for (int round = -WARMUP_ROUNDS; round < RENDER_ROUNDS; round++)
+    {
+        uint64_t u0 = nowNs();
+        for (int i = 0; i < count; i++)
+        {
+            bulbs.brightness[i] = 1 + (bulbs.brightness[i] + 7) % 100;
+            renderBulbPanel(i);
+        }
+        renderEndFrame();
+        if (round >= 0)
+            updateNs += nowNs() - u0;
+    }
+
+    // ページ送り（1ページだけなら送り先がないので 0）
+    uint64_t flipNs = 0;
+    uint64_t flipPixels = 0;
+    int flips = 0;
+    if (pages > 1)
+    {
+        for (int round = -WARMUP_ROUNDS; round < RENDER_ROUNDS; round++)
+        {
+            uint64_t f0 = nowNs();
+            renderSetPage((renderGetPage() + 1) % pages);
+            renderEndFrame();
+            if (round < 0)
+                continue;
+            flipNs += nowNs() - f0;
+            flipPixels += renderGetStats().lastFramePixels;
+            flips++;
+        }
+    }
+
+    printf("devices=%d pages=%d hit_grid_ns=%.1f hit_linear_ns=%.1f hit_mismatch=%d "
+           "host_render_all_us=%.1f render_all_px=%lu host_update_all_us=%.1f host_flip_us=%.1f flip_px=%lu "
+           "checksum=%ld\n",
+           count, pages, (double)(t1 - t0) / HIT_SAMPLES, (double)(t2 - t1) / HIT_SAMPLES, mismatches,
+           (double)allNs / RENDER_ROUNDS / 1000.0, (unsigned long)allPixels, (double)updateNs / RENDER_ROUNDS / 1000.0,
+           flips > 0 ? (double)flipNs / flips / 1000.0 : 0.0, flips > 0 ? (unsigned long)(flipPixels / flips) : 0ul,
+           checksum);
+}
+
+int main()
+{
+    registrySetMeter("", "");
+
+    // 1行1ケース（key=value 形式）
+    for (int count : deviceCounts)
+    {
+        benchmark(count);
+    }
+    return 0;
+}
@@ -0,0 +1,160 @@
+// リクエストのヒープ確保の確認（疑似SwitchBotサーバーに電源・明るさ・色・状態取得を繰り返し送る）
+// 実機と同じ接続プール（api_connection / hal_http_arduino）を TLS スタブの上で動かし、
+// URL・ボディの組み立てから HTTP/1.1 の送信・応答の読み出し・解析までの確保を数える
+// （TLS スタブは接続後の読み書きで確保しない。実機の mbedtls の暗号化・lwIP の確保は含まない）
+// 1リクエストあたりの確保の回数と確保したまま残ったブロック数を、
+// 従来の String の連結で URL とボディを組み立てた場合の確保の回数と比べて出力する
+// 確保が 1 回でもあるか、ブロックが残れば終了コード 1
+// 実行: pio run -e native-heap-soak -t exec
+#include <Arduino.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "device_registry.h"
+#include "switchbot_api.h"
+#include "api_metrics.h"
+#include "hal/hal_memory.h"
+#include "host/mock_switchbot.h"
+
+// 送るリクエスト数（種類ごとに順に回す）
+#define SOAK_REQUESTS 20000
+
+// 計測前に送るリクエスト数（初回だけの確保を除く）
+#define SOAK_WARMUP 50
+
+// リクエストの種類
+enum SoakKind {
+    SOAK_POWER,
+    SOAK_BRIGHTNESS,
+    SOAK_COLOR,
+    SOAK_BULB_STATUS,
+    SOAK_METER_STATUS,
+    SOAK_KIND_COUNT
+};
+
+static const char* kindNames[SOAK_KIND_COUNT] = {"power", "brightness", "color", "bulb_status", "meter_status"};
+
+static bool sendRequest(SoakKind kind, int n) {
+    const char* deviceId = bulbs.deviceId[n % bulbs.count];
+    switch (kind) {
+    case SOAK_POWER:
+        return switchbotBulbPower(deviceId, n % 2 == 0);
+    case SOAK_BRIGHTNESS:
+        return switchbotBulbBrightness(deviceId, 1 + n % 100);
+    case SOAK_COLOR:
+        return switchbotBulbColor(deviceId, (uint32_t)n * 2654435761u & 0xFFFFFF);
+    case SOAK_BULB_STATUS: {
+        bool power = false;
+        int brightness = 0;
+        return switchbotBulbStatus(deviceId, power, brightness);
+    }
+    default: {
+        float temperature = 0.0f;
+        int humidity = 0;
+        return switchbotMeterStatus(meter.deviceId, temperature, humidity);
+    }
+    }
+}
+
+// 従来の組み立て（String の連結）で作る URL とボディの長さ（確保の回数を数えるため送信はしない）
+static size_t buildLegacy(SoakKind kind, int n) {
+    String deviceId(bulbs.deviceId[n % bulbs.count]);
+    if (kind == SOAK_BULB_STATUS || kind == SOAK_METER_STATUS) {
+        if (kind == SOAK_METER_STATUS) deviceId = meter.deviceId;
+        String url = "https://api.switch-bot.com/v1.1/devices/" + deviceId + "/status";
+        return url.length();
+    }
+
+    String command;
+    String parameter;
+    if (kind == SOAK_POWER) {
+        command = n % 2 == 0 ? "turnOn" : "turnOff";
+        parameter = "default";
+    } else if (kind == SOAK_BRIGHTNESS) {
+        command = "setBrightness";
+        parameter = String(1 + n % 100);
+    } else {
+        uint32_t rgb = (uint32_t)n * 2654435761u & 0xFFFFFF;
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%lu:%lu:%lu", (unsigned long)((rgb >> 16) & 0xFF),
+                 (unsigned long)((rgb >> 8) & 0xFF), (unsigned long)(rgb & 0xFF));
+        command = "setColor";
+        parameter = buf;
+    }
+    String url = "https://api.switch-bot.com/v1.1/devices/" + deviceId + "/commands";
+    String body = "{\"command\":\"" + command + "\",\"parameter\":\"" + parameter + "\",\"commandType\":\"command\"}";
+    return url.length() + body.length();
+}
+
+// 組み立てた長さの合計（最適化で組み立てが消えないように残す）
+static volatile size_t legacyBytes = 0;
+
+// 従来の組み立ての1リクエストあたりの確保の回数
+static double legacyAllocsPerRequest(SoakKind kind, int requests) {
+    uint32_t allocs0 = 0, frees0 = 0, allocs1 = 0, frees1 = 0;
+    halHeapTaskCounts(allocs0, frees0);
+    for (int n = 0; n < requests; n++) legacyBytes = legacyBytes + buildLegacy(kind, n);
+    halHeapTaskCounts(allocs1, frees1);
+    return (double)(allocs1 - allocs0) / requests;
+}
+
+// リクエストごとの出力を捨てる（dup した標準出力を返す）
+static int muteStdout() {
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    return saved;
+}
+
+static void restoreStdout(int saved) {
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+}
+
+int main() {
+    registryInit();
+    mockSwitchBotInstall(0, 0);
+    switchbotApiInit();
+
+    int saved = muteStdout();
+    for (int n = 0; n < SOAK_WARMUP; n++) sendRequest((SoakKind)(n % SOAK_KIND_COUNT), n);
+    apiMetricsReset();
+
+    // 組み立てから送信・解析までの全体を数える（api_metrics は送信から解析までの分）
+    uint32_t allocs0 = 0, frees0 = 0, allocs1 = 0, frees1 = 0;
+    uint32_t blocks0 = halHeapInfo().allocatedBlocks;
+    halHeapTaskCounts(allocs0, frees0);
+    uint32_t failed = 0;
+    uint32_t t0 = millis();
+    for (int n = 0; n < SOAK_REQUESTS; n++) {
+        if (!sendRequest((SoakKind)(n % SOAK_KIND_COUNT), n / SOAK_KIND_COUNT)) failed++;
+    }
+    uint32_t elapsed = millis() - t0;
+    halHeapTaskCounts(allocs1, frees1);
+    int32_t netBlocks = (int32_t)(halHeapInfo().allocatedBlocks - blocks0);
+    restoreStdout(saved);
+
+    uint32_t allocs = allocs1 - allocs0;
+    printf("requests=%d failed=%lu elapsed_ms=%lu allocs_per_request=%.2f net_blocks=%ld\n", SOAK_REQUESTS,
+           (unsigned long)failed, (unsigned long)elapsed, (double)allocs / SOAK_REQUESTS, (long)netBlocks);
+
+    // エンドポイントごとの確保と、従来の組み立ての確保
+    bool ok = failed == 0 && allocs == 0 && netBlocks == 0;
+    for (int e = 0; e < API_ENDPOINT_COUNT; e++) {
+        ApiHeapStats h = apiMetricsHeapStats((ApiEndpoint)e);
+        if (h.requests == 0) continue;
+        ok = ok && h.allocs == 0 && h.net == 0;
+    }
+    for (int k = 0; k < SOAK_KIND_COUNT; k++) {
+        printf("kind=%s legacy_allocs_per_request=%.2f\n", kindNames[k],
+               legacyAllocsPerRequest((SoakKind)k, SOAK_REQUESTS / SOAK_KIND_COUNT));
+    }
+    apiMetricsPrintHeap();
+
+    Serial.println(ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+// 温湿度の履歴の圧縮率と問い合わせの速さ（1年分の合成した記録で計測）
+// 1分ごとの取得に Webhook の不定期なイベントと電源断の空白を混ぜた1年分を記録し、
+// 生の記録の1件あたりのバイト数・保持できる日数、集約の段ごとに残っている日数と領域の大きさ、
+// ヘッダーの折れ線（24時間）・1時間・30日（1時間の段）・1年（1日の段）の問い合わせの時間を、全件を走査して求めた場合と比べて出力する
+// 問い合わせの結果が全件走査と違う、圧縮率が 4 倍未満、集約が1年分（BENCH_DAYS 日の全ての日）残っていない、
+// 保存から戻した折れ線・1年の日ごとの結果が違えば終了コード 1
+// 実行: pio run -e native-history-bench -t exec
+#include <Arduino.h>
+
+#include <vector>
+
+#include "meter_history.h"
+#include "device_registry.h"
+#include "ui_layout.h"
+#include "hal/hal_storage.h"
+#include "hal/native/hal_native.h"
+
+// 合成する期間（2025-01-01 から1年）と取得の間隔
+#define BENCH_START_EPOCH 1735689600u
+#define BENCH_DAYS 365
+#define BENCH_INTERVAL_SEC 60
+
+// Webhook のイベント（取得の間に不定期に届く、%）と電源断（日数ごとに数時間）
+#define BENCH_EVENT_PERCENT 3
+#define BENCH_OUTAGE_EVERY_DAYS 30
+#define BENCH_OUTAGE_SEC (5 * 3600)
+
+// 問い合わせの時間を測る繰り返し回数
+#define BENCH_REPEAT 200
+
+// 合成した1件（全件走査の基準）
+struct BenchSample
+{
+    uint32_t epoch;
+    int16_t temp; // ℃×10
+    uint8_t hum;
+};
+
+static std::vector<BenchSample> samples;
+
+// 再現性のための乱数（xorshift32）
+static uint32_t rngState = 0x2468ace1u;
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// 季節・1日の変化と、ゆっくりした揺らぎ
+static void buildSamples()
+{
+    double drift = 0.0;
+    uint32_t end = BENCH_START_EPOCH + BENCH_DAYS * 86400u;
+    for (uint32_t t = BENCH_START_EPOCH; t < end; t += BENCH_INTERVAL_SEC)
+    {
+        uint32_t day = (t - BENCH_START_EPOCH) / 86400;
+        if (day % BENCH_OUTAGE_EVERY_DAYS == 10 && (t - BENCH_START_EPOCH) % 86400 < BENCH_OUTAGE_SEC)
+            continue;
+
+        drift += ((int)(nextRandom() % 21) - 10) / 100.0;
+        drift *= 0.98;
+        double season = sin(2 * M_PI * (t - BENCH_START_EPOCH) / (365.0 * 86400) - M_PI / 2);
+        double daily = sin(2 * M_PI * ((t - BENCH_START_EPOCH) % 86400) / 86400.0 - M_PI / 2);
+        double temperature = 20.0 + 7.0 * season + 2.5 * daily + drift;
+        double humidity = 50.0 + 12.0 * season - 6.0 * daily + drift * 2;
+
+        BenchSample s = {t, (int16_t)lround(temperature * 10), (uint8_t)constrain((int)lround(humidity), 0, 100)};
+        samples.push_back(s);
+
+        // 取得の間に届くイベント
+        if (nextRandom() % 100 < BENCH_EVENT_PERCENT)
+        {
+            s.epoch = t + 1 + nextRandom() % (BENCH_INTERVAL_SEC - 1);
+            s.temp += (int)(nextRandom() % 3) - 1;
+            samples.push_back(s);
+        }
+    }
+}
+
+// 全件を走査して [from, to) を buckets 個の区間に分ける（meterHistoryQuery と比べる基準）
+static void scanAll(uint32_t from, uint32_t to, HistoryBucket *out, int buckets)
+{
+    static int64_t tempSum[400];
+    static int64_t humSum[400];
+    for (int k = 0; k < buckets; k++)
+    {
+        out[k] = {};
+        tempSum[k] = 0;
+        humSum[k] = 0;
+    }
+    for (const BenchSample &s : samples)
+    {
+        if (s.epoch < from || s.epoch >= to)
+            continue;
+        int k = (int)((uint64_t)(s.epoch - from) * buckets / (to - from));
+        HistoryBucket &b = out[k];
+        if (b.count == 0)
+        {
+            b.tempMin = b.tempMax = s.temp;
+            b.humMin = b.humMax = s.hum;
+        }
+        b.tempMin = min(b.tempMin, s.temp);
+        b.tempMax = max(b.tempMax, s.temp);
+        b.humMin = min(b.humMin, s.hum);
+        b.humMax = max(b.humMax, s.hum);
+        b.count++;
+        tempSum[k] += s.temp;
+        humSum[k] += s.hum;
+    }
+    for (int k = 0; k < buckets; k++)
+    {
+        HistoryBucket &b = out[k];
+        if (b.count == 0)
+            continue;
+        int64_t t = tempSum[k];
+        b.tempAvg = (int16_t)(t >= 0 ? (t + b.count / 2) / b.count : (t - (int64_t)(b.count / 2)) / b.count);
+        b.humAvg = (uint8_t)((humSum[k] + b.count / 2) / b.count);
+    }
+}
+
+static bool sameBuckets(const HistoryBucket *a, const HistoryBucket *b, int buckets)
+{
+    for (int k = 0; k < buckets; k++)
+    {
+        if (a[k].count != b[k].count || a[k].tempMin != b[k].tempMin || a[k].tempMax != b[k].tempMax ||
+            a[k].tempAvg != b[k].tempAvg || a[k].humMin != b[k].humMin || a[k].humMax != b[k].humMax ||
+            a[k].humAvg != b[k].humAvg)
+        {
+            printf("bucket %d: count=%lu/%lu temp=%d..%d avg %d / %d..%d avg %d\n", k, (unsigned long)a[k].count,
+                   (unsigned long)b[k].count, a[k].tempMin, a[k].tempMax, a[k].tempAvg, b[k].tempMin, b[k].tempMax,
+                   b[k].tempAvg);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 問い合わせ1件の時間と、全件走査の時間・結果の一致を出力
+// 戻り値: 全件走査と一致し、記録のあった区間が minFilled 以上
+static bool runQuery(const char *name, uint32_t from, uint32_t to, int buckets, int minFilled)
+{
+    static HistoryBucket history[400];
+    static HistoryBucket scan[400];
+
+    int filled = 0;
+    uint32_t t0 = micros();
+    for (int i = 0; i < BENCH_REPEAT; i++)
+        filled = meterHistoryQuery(from, to, history, buckets);
+    double historyUs = (double)(micros() - t0) / BENCH_REPEAT;
+
+    t0 = micros();
+    for (int i = 0; i < BENCH_REPEAT / 10; i++)
+        scanAll(from, to, scan, buckets);
+    double scanUs = (double)(micros() - t0) / (BENCH_REPEAT / 10);
+
+    bool same = sameBuckets(history, scan, buckets);
+    printf("query=%s buckets=%d filled=%d history_us=%.1f scan_us=%.1f speedup=%.0fx match=%s\n", name, buckets,
+           filled, historyUs, scanUs, historyUs > 0 ? scanUs / historyUs : 0.0, same ? "yes" : "no");
+    return same && filled >= minFilled;
+}
+
+int main()
+{
+    halNativeSetStorageDir(".native_storage");
+    halStorageRemove(METER_HISTORY_NAME);
+    registrySetMeter("BENCHMETER0001", "合成した温湿度計");
+    if (!meterHistoryInit())
+        return 1;
+
+    buildSamples();
+    uint32_t t0 = micros();
+    for (const BenchSample &s : samples)
+        meterHistoryAdd(s.epoch, s.temp / 10.0f, s.hum);
+    double addNs = (micros() - t0) * 1000.0 / samples.size();
+
+    MeterHistoryStats st = meterHistoryGetStats();
+    double bytesPerSample = (double)st.bytesUsed / st.samples;
+    double ratio = METER_HISTORY_RAW_SAMPLE_BYTES / bytesPerSample;
+    printf("samples=%lu kept=%lu span_days=%.1f bytes=%lu bytes_per_sample=%.2f ratio=%.1fx escapes=%.1f%% "
+           "add_ns=%.0f\n",
+           (unsigned long)samples.size(), (unsigned long)st.samples, (st.newest - st.oldest) / 86400.0,
+           (unsigned long)st.bytesUsed, bytesPerSample, ratio, 100.0 * st.escapes / st.added, addNs);
+
+    // 集約は古い期間ほど粗い段だけに残る（1日の段で1年分）
+    uint32_t last = samples.back().epoch;
+    uint32_t toDay = last - last % 86400 + 86400;
+    double retentionDays = st.rollupOldest > 0 ? (toDay - st.rollupOldest) / 86400.0 : 0.0;
+    bool retained = retentionDays >= BENCH_DAYS;
+    printf("rollup_retention_days=%.1f area_bytes=%lu budget_bytes=%d %s\n", retentionDays,
+           (unsigned long)st.areaBytes, METER_HISTORY_PSRAM_BUDGET, retained ? "ok" : "FAILED");
+    meterHistoryPrint();
+
+    // 最新の記録までの24時間（ヘッダーの折れ線）・1時間（生の記録）・30日（2時間ごと）・1年（日ごと、全ての日に記録がある）
+    uint32_t to = last - last % METER_HISTORY_ROLLUP_SEC + METER_HISTORY_ROLLUP_SEC;
+    uint32_t toHour = last - last % METER_HISTORY_HOURLY_SEC + METER_HISTORY_HOURLY_SEC;
+    bool ok = retained;
+    ok = runQuery("sparkline_24h", to - 86400, to, HEADER_SPARK_WIDTH, 0) && ok;
+    ok = runQuery("raw_1h", to - 3600, to, 60, 0) && ok;
+    ok = runQuery("hourly_30d", toHour - 30 * 86400u, toHour, 360, 0) && ok;
+    ok = runQuery("daily_365d", toDay - BENCH_DAYS * 86400u, toDay, BENCH_DAYS, BENCH_DAYS) && ok;
+
+    // 保存して戻すと同じ折れ線・1年の日ごとの結果になる
+    HistoryBucket before[HEADER_SPARK_WIDTH];
+    HistoryBucket after[HEADER_SPARK_WIDTH];
+    static HistoryBucket yearBefore[BENCH_DAYS];
+    static HistoryBucket yearAfter[BENCH_DAYS];
+    meterHistoryRecentDay(before, HEADER_SPARK_WIDTH);
+    meterHistoryQuery(toDay - BENCH_DAYS * 86400u, toDay, yearBefore, BENCH_DAYS);
+    bool saved = meterHistoryCheckpoint(true);
+    size_t checkpointBytes = meterHistoryGetStats().checkpointBytes;
+    meterHistoryClear();
+    int restored = meterHistoryRestore();
+    meterHistoryRecentDay(after, HEADER_SPARK_WIDTH);
+    meterHistoryQuery(toDay - BENCH_DAYS * 86400u, toDay, yearAfter, BENCH_DAYS);
+    bool sparkTrip = sameBuckets(before, after, HEADER_SPARK_WIDTH);
+    bool yearTrip = sameBuckets(yearBefore, yearAfter, BENCH_DAYS);
+    bool roundTrip = saved && restored > 0 && sparkTrip && yearTrip;
+    printf("checkpoint bytes=%lu restored_samples=%d sparkline_match=%s daily_match=%s\n",
+           (unsigned long)checkpointBytes, restored, sparkTrip ? "yes" : "no", yearTrip ? "yes" : "no");
+    meterHistoryPrint();
+
+    ok = ok && roundTrip && ratio >= 4.0;
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,380 @@
+// ホスト（native）ビルドのエントリポイント
+// 疑似SwitchBotサーバーとタッチ操作の台本で、実機の loop() と同じ処理を数秒間動かす
+#include <Arduino.h>
+
+#include "device_registry.h"
+#include "device_discovery.h"
+#include "last_state.h"
+#include "meter_history.h"
+#include "boot.h"
+#include "switchbot_api.h"
+#include "api_worker.h"
+#include "api_metrics.h"
+#include "loop_profiler.h"
+#include "api_quota.h"
+#include "command_coalescer.h"
+#include "command_log.h"
+#include "webhook.h"
+#include "event_loop.h"
+#include "poll_policy.h"
+#include "scene.h"
+#include "devices.h"
+#include "ui.h"
+#include "ui_layout.h"
+#include "ui_render.h"
+#include "ui_dirty.h"
+#include "gesture.h"
+#include "hal/hal_server.h"
+#include "hal/hal_storage.h"
+#include "hal/native/hal_native.h"
+#include "host/mock_switchbot.h"
+#include "host/webhook_relay.h"
+#include "secrets.h"
+
+// 実行時間（ミリ秒）
+#define HOST_RUN_MS 6500
+
+// ページ送りを確かめるため devices.h の電球の後ろに追加する疑似電球の数
+#define HOST_EXTRA_BULBS 4
+
+// 起動から WiFi 接続・時刻同期までの時間（最初の長押しのコマンドは接続待ちの間に溜まる）
+#define HOST_CONNECT_MS 600
+#define HOST_TIME_SYNC_MS 900
+
+// 温湿度計ステータス取得完了
+static void onMeterStatus(const ApiResult& result) {
+    if (!result.success) return;
+
+    meter.temperature = result.temperature;
+    meter.humidity = result.humidity;
+    meter.valid = true;
+    uiUpdateMeter();
+}
+
+// オンラインになったとき（main.cpp と同じ）
+static void onOnline() {
+    webhookBegin();
+    apiWorkerSubmit(API_JOB_METER_STATUS, meter.deviceId, 0, 0, onMeterStatus);
+    uiRefreshVisibleBulbStatus();
+    discoveryRevalidate();
+}
+
+// Webhook のイベントを送るときの分割の大きさ（ヘッダー・JSON の途中で切れるように小さくする）
+#define HOST_WEBHOOK_CHUNK 7
+
+// 記録した Webhook イベント（SwitchBot から LAN 内の中継が受けたもの）
+// 壁のスイッチ・アプリで変わった電球と、温湿度計の変化
+static const char* const webhookBulbOffPage =
+    "{\"eventType\":\"changeReport\",\"eventVersion\":\"1\",\"context\":{\"deviceType\":\"WoBulb\","
+    "\"deviceMac\":\"94:A9:90:76:A0:8A\",\"powerState\":\"ON\",\"brightness\":35,\"color\":\"255:245:235\","
+    "\"colorTemperature\":3500,\"timeOfSample\":1717000000123}}";
+static const char* const webhookBulbVisible =
+    "{\"eventType\":\"changeReport\",\"eventVersion\":\"1\",\"context\":{\"deviceType\":\"WoBulb\","
+    "\"deviceMac\":\"HOSTBULB0001\",\"powerState\":\"OFF\",\"brightness\":50,\"color\":\"255:245:235\","
+    "\"colorTemperature\":3500,\"timeOfSample\":1717000004567}}";
+static const char* const webhookMeter =
+    "{\"eventType\":\"changeReport\",\"eventVersion\":\"1\",\"context\":{\"deviceType\":\"WoMeter\","
+    "\"deviceMac\":\"ca323435166c\",\"temperature\":18.5,\"humidity\":62,\"scale\":\"CELSIUS\","
+    "\"timeOfSample\":1717000009000}}";
+static const char* const webhookUnknown =
+    "{\"eventType\":\"changeReport\",\"eventVersion\":\"1\",\"context\":{\"deviceType\":\"WoPlug\","
+    "\"deviceMac\":\"6055F92FCFD2\",\"powerState\":\"ON\",\"timeOfSample\":1717000010000}}";
+
+// UI ループ1回分（main.cpp の loop() と同じ）
+static void pumpLoop() {
+    profilerLoopBegin();
+    bootService(millis());
+    uiUpdate();
+    profilerLoopEnd();
+    delay(1);
+}
+
+// 記録したイベントを待ち受けポートへ送り、変化した部品だけ描き直されるか確かめる
+static bool replayWebhookEvents() {
+    uint16_t port = halServerPort();
+    if (port == 0) {
+        Serial.println("FAILED: webhook listener is not running");
+        return false;
+    }
+
+    // 合言葉のないリクエストは拒否し、登録されていないデバイスのイベントでは定期取得を延ばさない
+    int noToken = webhookRelayPost(port, "POST", WEBHOOK_PATH, nullptr, webhookBulbVisible, 0, pumpLoop);
+    int wrongToken = webhookRelayPost(port, "POST", WEBHOOK_PATH, "wrong", webhookBulbVisible, 0, pumpLoop);
+    int wrongQuery =
+        webhookRelayPost(port, "POST", WEBHOOK_PATH "?token=wrong", nullptr, webhookBulbVisible, 0, pumpLoop);
+    int unknown = webhookRelayPost(port, "POST", WEBHOOK_PATH, WEBHOOK_TOKEN, webhookUnknown, HOST_WEBHOOK_CHUNK,
+                                   pumpLoop);
+    if (noToken != 401 || wrongToken != 401 || wrongQuery != 401 || unknown != 204 || webhookActive(millis())) {
+        Serial.printf("FAILED: unauthorized/ignored events (%d/%d/%d/%d, active=%d)\n", noToken, wrongToken,
+                      wrongQuery, unknown, webhookActive(millis()) ? 1 : 0);
+        return false;
+    }
+
+    // 表示中でないページの電球: 値だけ更新して描画しない
+    int offPage = registryFindBulb("94A99076A08A");
+    mockSwitchBotSetBulb(offPage, true, 35);
+    uint64_t px0 = halNativeDisplayPixels();
+    int code = webhookRelayPost(port, "POST", WEBHOOK_PATH, WEBHOOK_TOKEN, webhookBulbOffPage, HOST_WEBHOOK_CHUNK,
+                                pumpLoop);
+    pumpLoop();
+    uint64_t offPagePixels = halNativeDisplayPixels() - px0;
+    if (code != 204 || !bulbs.powerState[offPage] || bulbs.brightness[offPage] != 35 || offPagePixels != 0) {
+        Serial.printf("FAILED: off-page event (code=%d, drawn=%llupx)\n", code, (unsigned long long)offPagePixels);
+        return false;
+    }
+
+    // 表示中の電球: そのパネルの中だけ描き直す
+    int visible = registryFindBulb("HOSTBULB0001");
+    mockSwitchBotSetBulb(visible, false, 50);
+    px0 = halNativeDisplayPixels();
+    // 合言葉はクエリでも送れる
+    code = webhookRelayPost(port, "POST", WEBHOOK_PATH "?src=relay&token=" WEBHOOK_TOKEN, nullptr, webhookBulbVisible,
+                            HOST_WEBHOOK_CHUNK, pumpLoop);
+    pumpLoop();
+    uint64_t visiblePixels = halNativeDisplayPixels() - px0;
+    if (code != 204 || bulbs.powerState[visible] || visiblePixels == 0 ||
+        visiblePixels > (uint64_t)PANEL_WIDTH * PANEL_HEIGHT) {
+        Serial.printf("FAILED: visible event (code=%d, drawn=%llupx)\n", code, (unsigned long long)visiblePixels);
+        return false;
+    }
+
+    // 温湿度計（deviceMac は小文字でも同じデバイス）
+    code = webhookRelayPost(port, "POST", WEBHOOK_PATH, WEBHOOK_TOKEN, webhookMeter, 0, pumpLoop);
+    if (code != 204 || meter.humidity != 62 || meter.temperature != 18.5f) {
+        Serial.printf("FAILED: meter event (code=%d)\n", code);
+        return false;
+    }
+
+    // 不正なリクエストは拒否する
+    int malformed = webhookRelayPost(port, "POST", WEBHOOK_PATH, WEBHOOK_TOKEN, "{\"eventType\":", 0, pumpLoop);
+    int wrongMethod = webhookRelayPost(port, "GET", WEBHOOK_PATH, WEBHOOK_TOKEN, "", 0, pumpLoop);
+    int wrongPath = webhookRelayPost(port, "POST", "/other", WEBHOOK_TOKEN, webhookMeter, 0, pumpLoop);
+    WebhookStats ws = webhookGetStats();
+    webhookPrint();
+    Serial.printf("Webhook drawn: off-page=%llupx visible=%llupx (panel=%dpx)\n", (unsigned long long)offPagePixels,
+                  (unsigned long long)visiblePixels, PANEL_WIDTH * PANEL_HEIGHT);
+    if (unknown != 204 || malformed != 400 || wrongMethod != 405 || wrongPath != 404 || ws.applied != 3 ||
+        ws.ignored != 1 || ws.rejected != 6) {
+        Serial.printf("FAILED: webhook responses (%d/%d/%d/%d)\n", unknown, malformed, wrongMethod, wrongPath);
+        return false;
+    }
+
+    // イベントが届いている間は、温湿度・電球の定期取得を安全のための間隔まで延ばす
+    if (webhookPollInterval(60000, millis()) != WEBHOOK_SAFETY_INTERVAL_MS) {
+        Serial.println("FAILED: polling did not fall back to the safety interval");
+        return false;
+    }
+    return true;
+}
+
+// 電球0を長押しでON（接続待ちの間）、電球1のスライダーを50%から80%までドラッグ
+// 続けて左スワイプで2ページ目へ送り、その先頭の電球を長押しでON
+// もう一度左スワイプでシーン・グループのページへ送り、3番目のボタン（グループ「全部」）を長押しで OFF
+static HalNativeTouchEvent script[48];
+
+// パネル上部（電球名の辺り）から左へスワイプ
+static int addSwipe(int n, uint32_t at) {
+    int wx = getPanelX(2) + PANEL_WIDTH / 2;
+    int wy = getPanelY() + 20;
+    for (int step = 0; step <= 4; step++) {
+        script[n++] = {at + step * 50, wx - step * (PAGE_SWIPE_THRESHOLD / 3), wy, true};
+    }
+    script[n++] = {at + 300, wx - 4 * (PAGE_SWIPE_THRESHOLD / 3), wy, false};
+    return n;
+}
+
+static int buildScript(uint32_t t0) {
+    int n = 0;
+    int bx = getButtonX(0) + getButtonWidth() / 2;
+    int by = getButtonY() + BUTTON_HEIGHT / 2;
+    script[n++] = {t0 + 300, bx, by, true};
+    script[n++] = {t0 + 1000, bx, by, false};
+
+    int sy = getSliderY() + SLIDER_HEIGHT / 2;
+    for (int step = 0; step <= 6; step++) {
+        int percent = 50 + step * 5;
+        script[n++] = {t0 + 1500 + step * 100, getSliderX(1) + getSliderWidth() * percent / 100, sy, true};
+    }
+    script[n++] = {t0 + 2200, getSliderX(1) + getSliderWidth() * 80 / 100, sy, false};
+
+    n = addSwipe(n, t0 + 2500);
+    script[n++] = {t0 + 3100, bx, by, true};
+    script[n++] = {t0 + 3800, bx, by, false};
+
+    n = addSwipe(n, t0 + 4100);
+    int gx = getButtonX(2) + getButtonWidth() / 2;
+    script[n++] = {t0 + 4700, gx, by, true};
+    script[n++] = {t0 + 5400, gx, by, false};
+    return n;
+}
+
+int main() {
+    Serial.println("SwitchBot Bulb Controller (native)");
+    eventLoopInit();
+
+    // スナップショット・保存した状態のない初回起動から始める（devices.h の設定を読み込む）
+    halNativeSetStorageDir(".native_storage");
+    halStorageRemove(DISCOVERY_SNAPSHOT_NAME);
+    halStorageRemove(LAST_STATE_NAME);
+    halStorageRemove(COMMAND_LOG_NAME);
+    discoveryInit();
+    for (int i = 0; i < HOST_EXTRA_BULBS; i++) {
+        char id[DEVICE_ID_LEN];
+        char name[DEVICE_NAME_LEN];
+        snprintf(id, sizeof(id), "HOSTBULB%04d", i);
+        snprintf(name, sizeof(name), "疑似電球 %d", i + 1);
+        registryAddBulb(id, name);
+    }
+
+    // 各ページの先頭の電球だけ OFF
+    mockSwitchBotInstall(150, 64);
+    for (int i = 0; i < bulbs.count; i++) {
+        mockSwitchBotSetBulb(i, i % PANELS_PER_PAGE != 0, 50);
+    }
+
+    bootNoteRestored(lastStateRestore());
+    coalescerRestore();
+    if (meterHistoryInit()) meterHistoryRestore();
+    switchbotApiInit();
+    apiQuotaInit(API_QUOTA_DAILY_LIMIT, API_QUOTA_PANELS);
+    apiWorkerInit();
+
+    halNativeSetNetworkDelay(HOST_CONNECT_MS, HOST_TIME_SYNC_MS);
+    bootBegin(onOnline);
+    uiInit();
+    renderEndFrame();
+    bootNoteFirstFrame();
+    bootNoteInteractive();
+
+    uint32_t t0 = millis();
+    halNativeSetTouchScript(script, buildScript(t0));
+
+    // 台本の再生と送信中のリクエストが終わるまで回す
+    while (millis() - t0 < HOST_RUN_MS || apiWorkerPending() > 0) {
+        profilerLoopBegin();
+        bootService(millis());
+        uiUpdate();
+        unsigned long now = millis();
+        eventLoopSchedule(LOOP_TIMER_BOOT, bootPhase() != BOOT_ONLINE ? now + BOOT_POLL_MS : eventLoopNextPoll(now));
+        profilerLoopEnd();
+        eventLoopWait();
+    }
+
+    CoalesceStats cs = coalescerGetStats();
+    RenderStats rs = renderGetStats();
+    Serial.printf("Requests: %lu\n", (unsigned long)mockSwitchBotRequests());
+    Serial.printf("Commands: intents=%lu sent=%lu skipped=%lu retries=%lu\n",
+                  (unsigned long)cs.intents, (unsigned long)cs.sent, (unsigned long)cs.skipped,
+                  (unsigned long)cs.retries);
+    commandLogPrint();
+    Serial.printf("Render: frames=%lu last=%lupx peak=%lupx total=%llupx compose=%lu/%luus\n",
+                  (unsigned long)rs.frames, (unsigned long)rs.lastFramePixels,
+                  (unsigned long)rs.peakFramePixels, (unsigned long long)rs.totalPixels,
+                  (unsigned long)rs.lastComposeUs, (unsigned long)rs.peakComposeUs);
+    bootPrint();
+    apiMetricsPrint();
+    apiQuotaPrint();
+    profilerPrint();
+    eventLoopPrint();
+    pollPolicyPrint(millis());
+    meterHistoryPrint();
+    gesturePrint();
+    for (int i = 0; i < bulbs.count; i++) {
+        MockBulb server = mockSwitchBotBulb(i);
+        Serial.printf("Bulb %d: ui=%s/%d server=%s/%d\n", i, bulbs.powerState[i] ? "on" : "off", bulbs.brightness[i],
+                      server.power ? "on" : "off", server.brightness);
+    }
+
+    // シーン・グループのページに送られ、グループ「全部」の電球が OFF になり、UIと疑似サーバーの状態が一致していれば成功
+    if (renderGetPage() != bulbPageCount()) {
+        Serial.printf("FAILED: page=%d (expected the scene page %d)\n", renderGetPage() + 1, bulbPageCount() + 1);
+        return 1;
+    }
+    const GroupConfig& all = groupConfigs[0];
+    for (int i = 0; i < all.count; i++) {
+        int device = registryFindBulb(all.deviceIds[i]);
+        if (device >= 0 && mockSwitchBotBulb(device).power) {
+            Serial.printf("FAILED: bulb %d was not turned off from the group button\n", device);
+            return 1;
+        }
+    }
+    for (int i = 0; i < bulbs.count; i++) {
+        MockBulb server = mockSwitchBotBulb(i);
+        if (bulbs.powerState[i] != server.power || (bulbs.powerState[i] && bulbs.brightness[i] != server.brightness)) {
+            Serial.println("FAILED: UI and server state differ");
+            return 1;
+        }
+    }
+
+    // 送ったコマンドは全て届き、記録は空になっている
+    if (commandLogCount() != 0 || commandLogGetStats().delivered == 0) {
+        Serial.println("FAILED: commands left in the log");
+        return 1;
+    }
+
+    // 全てのリクエストの署名を疑似サーバーが受け付けた
+    if (mockSwitchBotStats().unauthorized != 0) {
+        Serial.printf("FAILED: %lu requests with a bad signature\n", (unsigned long)mockSwitchBotStats().unauthorized);
+        return 1;
+    }
+
+    // 接続前に画面を出し、接続待ちの間に溜めたコマンドを接続後に送る
+    BootStats boot = bootGetStats();
+    if (boot.firstFrameMs == 0 || boot.firstFrameMs >= boot.onlineMs || boot.queuedAtOnline == 0 ||
+        boot.statusMs < boot.onlineMs) {
+        Serial.println("FAILED: boot sequence");
+        return 1;
+    }
+
+    // Webhook のイベントで電球・温湿度計の表示が変わる（定期取得は間隔を延ばす）
+    // 2ページ目（HOSTBULB0001 の並ぶページ）に戻して確かめる
+    renderSetPage(1);
+    renderEndFrame();
+    uint32_t requestsBefore = mockSwitchBotRequests();
+    if (!replayWebhookEvents()) return 1;
+    if (mockSwitchBotRequests() != requestsBefore) {
+        Serial.println("FAILED: webhook events caused API requests");
+        return 1;
+    }
+
+    // 温湿度の取得・イベントは履歴に記録され、ヘッダーの折れ線に使われる
+    HistoryBucket day[HEADER_SPARK_WIDTH];
+    if (meterHistoryGetStats().added == 0 || meterHistoryRecentDay(day, HEADER_SPARK_WIDTH) == 0) {
+        Serial.println("FAILED: meter history was not recorded");
+        return 1;
+    }
+
+    // 保存した状態を読み直すと UI の状態に戻る
+    lastStateSave(true);
+    int savedBulbs = bulbs.count;
+    bool savedPower[REGISTRY_MAX_BULBS];
+    for (int i = 0; i < bulbs.count; i++) {
+        savedPower[i] = bulbs.powerState[i];
+        bulbs.powerState[i] = !bulbs.powerState[i];
+    }
+    if (lastStateRestore() != savedBulbs) {
+        Serial.println("FAILED: last state was not restored");
+        return 1;
+    }
+    for (int i = 0; i < bulbs.count; i++) {
+        if (bulbs.powerState[i] != savedPower[i]) {
+            Serial.println("FAILED: restored state differs");
+            return 1;
+        }
+    }
+
+    // デバイス一覧を取得して反映・保存し、次の起動ではスナップショットから同じ登録簿を作る
+    if (discoverySource() != DISCOVERY_SOURCE_CLOUD) {
+        Serial.println("FAILED: device list was not applied");
+        return 1;
+    }
+    int listedBulbs = bulbs.count;
+    discoveryInit();
+    if (discoverySource() != DISCOVERY_SOURCE_SNAPSHOT || bulbs.count != listedBulbs ||
+        registryFindBulb("HOSTBULB0000") < 0) {
+        Serial.printf("FAILED: snapshot has %d bulbs (expected %d)\n", bulbs.count, listedBulbs);
+        return 1;
+    }
+    Serial.println("OK");
+    return 0;
+}
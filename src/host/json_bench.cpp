@@ -0,0 +1,106 @@
+// 状態取得の応答の解析の時間とメモリ（DeviceStatusParser と従来の indexOf / substring による解析の比較）
+// json_fuzz と同じ生成器で作った電球の応答を1回で与え、1件あたりの時間・確保の回数・解析中に持つメモリの最大を出力する
+// 正しさの確認は AddressSanitizer 付きの json_fuzz で行い、ここでは -O2 のビルドで時間とメモリだけを測る
+// 時間は両方を交互に BENCH_ROUNDS 回ずつ測り、それぞれの最小で比べる（ホストの揺らぎを両方に同じように入れる）
+// メモリは、DeviceStatusParser は自身の大きさ（スタック、ヒープは使わない）、
+// 従来の解析は HTTPClient::getString() が持つ応答全体の String と読み出し用のバッファの和とする
+// DeviceStatusParser の解析で確保があるか、時間が従来の BENCH_MAX_TIME_RATIO 倍を超えるか、
+// メモリが従来の最小より多ければ終了コード 1
+// 実行: pio run -e native-json-bench -t exec
+#include <Arduino.h>
+
+#include "device_status.h"
+#include "hal/hal_memory.h"
+#include "host/status_docs.h"
+
+// 時間を比べる応答の数と、その中で使い回す応答の種類
+#define BENCH_DOCS 200000
+#define BENCH_DISTINCT 64
+
+// 交互に測る回数（1回あたり BENCH_DOCS / BENCH_ROUNDS 件）
+#define BENCH_ROUNDS 5
+
+// 従来の解析に対する時間の上限（ホストでは String の確保が安く、strstr も速いため従来が有利に出る）
+#define BENCH_MAX_TIME_RATIO 3.0
+
+// HTTPClient が応答を String に読み出すときに確保するバッファの上限（HTTP_TCP_BUFFER_SIZE）
+#define LEGACY_READ_BUFFER_MAX 1460
+
+static StatusDoc docs[BENCH_DISTINCT];
+static StatusTruth truths[BENCH_DISTINCT];
+static volatile int sink = 0;
+
+static uint32_t runScanner(int count)
+{
+    uint32_t t0 = micros();
+    for (int n = 0; n < count; n++)
+    {
+        const StatusDoc &doc = docs[n % BENCH_DISTINCT];
+        DeviceStatusParser parser(STATUS_FIELDS_BULB);
+        parser.feed(doc.text, doc.len);
+        sink = sink + parser.result().brightness;
+    }
+    return micros() - t0;
+}
+
+static uint32_t runLegacy(int count)
+{
+    uint32_t t0 = micros();
+    for (int n = 0; n < count; n++)
+    {
+        const StatusDoc &doc = docs[n % BENCH_DISTINCT];
+        StatusTruth legacy = truths[n % BENCH_DISTINCT];
+        legacyStatusParse(String(doc.text), true, legacy);
+        sink = sink + legacy.brightness;
+    }
+    return micros() - t0;
+}
+
+int main()
+{
+    // 従来の解析は応答全体（終端含む）と読み出し用のバッファ（応答の長さまで）を同時に持つ
+    size_t legacyPeakMin = SIZE_MAX, legacyPeakMax = 0;
+    for (int i = 0; i < BENCH_DISTINCT; i++)
+    {
+        statusDocGenerate(docs[i], truths[i], true);
+        size_t peak = (docs[i].len + 1) + min(docs[i].len, (size_t)LEGACY_READ_BUFFER_MAX);
+        legacyPeakMin = min(legacyPeakMin, peak);
+        legacyPeakMax = max(legacyPeakMax, peak);
+    }
+
+    const int perRound = BENCH_DOCS / BENCH_ROUNDS;
+    uint32_t scannerUs = UINT32_MAX, legacyUs = UINT32_MAX;
+    uint32_t scannerAllocs = 0, legacyAllocs = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++)
+    {
+        uint32_t allocs0 = 0, allocs1 = 0, allocs2 = 0, frees = 0;
+        halHeapTaskCounts(allocs0, frees);
+        scannerUs = min(scannerUs, runScanner(perRound));
+        halHeapTaskCounts(allocs1, frees);
+        legacyUs = min(legacyUs, runLegacy(perRound));
+        halHeapTaskCounts(allocs2, frees);
+        scannerAllocs += allocs1 - allocs0;
+        legacyAllocs += allocs2 - allocs1;
+    }
+
+    int docsRun = perRound * BENCH_ROUNDS;
+    double scannerNs = scannerUs * 1000.0 / perRound;
+    double legacyNs = legacyUs * 1000.0 / perRound;
+    double ratio = legacyNs > 0 ? scannerNs / legacyNs : 0;
+    bool timingOk = scannerAllocs == 0 && ratio <= BENCH_MAX_TIME_RATIO;
+    printf("case=timing docs=%d scanner_ns_per_doc=%.0f scanner_allocs_per_doc=%.2f legacy_ns_per_doc=%.0f "
+           "legacy_allocs_per_doc=%.2f ratio=%.2f max_ratio=%.2f %s\n",
+           docsRun, scannerNs, (double)scannerAllocs / docsRun, legacyNs, (double)legacyAllocs / docsRun, ratio,
+           BENCH_MAX_TIME_RATIO, timingOk ? "ok" : "FAILED");
+
+    // DeviceStatusParser は応答の長さによらず自身の大きさだけを持つ
+    size_t scannerPeak = sizeof(DeviceStatusParser);
+    bool memoryOk = scannerPeak <= legacyPeakMin;
+    printf("case=memory scanner_peak_bytes=%u scanner_heap_bytes=0 legacy_peak_bytes_min=%u legacy_peak_bytes_max=%u "
+           "%s\n",
+           (unsigned)scannerPeak, (unsigned)legacyPeakMin, (unsigned)legacyPeakMax, memoryOk ? "ok" : "FAILED");
+
+    bool ok = timingOk && memoryOk;
+    Serial.println(ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+// 状態取得の応答の解析（JsonScanner / DeviceStatusParser）のファジング
+// 電球・温湿度計の応答を、フィールドの順序・空白・入れ子の同名キー（"power" など）を乱数で変えて作り、
+// 乱数の位置で区切って少しずつ与える（区切りごとにちょうどの大きさの確保に写すので、範囲外の読み出しは
+// AddressSanitizer 付きのビルドで検出できる）
+// 途中で切った応答・でたらめな文字列も与え、取り出したフィールドが作った値と一致するかを確かめ、
+// 従来の indexOf / substring による解析が間違えた件数を並べて出力する（時間の比較は json_bench で -O2 のビルドで行う）
+// 取り出したフィールドが1つでも違うか、完全な応答で全てのフィールドが揃わなければ終了コード 1
+// 実行: pio run -e native-json-fuzz -t exec
+#include <Arduino.h>
+
+#include "device_status.h"
+#include "host/status_docs.h"
+
+// 生成する応答の数（種類ごと）
+#define FUZZ_CASES 20000
+
+// len バイトまでを乱数の位置で区切って与える（区切りごとにちょうどの大きさの確保に写す）
+static void feedChunked(DeviceStatusParser &parser, const char *text, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len)
+    {
+        size_t n = min(len - pos, (size_t)(1 + statusDocRange(statusDocRange(4) == 0 ? 64 : 8)));
+        char *chunk = (char *)malloc(n);
+        memcpy(chunk, text + pos, n);
+        bool more = parser.feed(chunk, n);
+        free(chunk);
+        pos += n;
+        if (!more)
+            break;
+    }
+}
+
+// 取り出したフィールドが正しい値と一致するか（取り出せなかったフィールドは問わない）
+static bool fieldsMatch(const DeviceStatus &s, const StatusTruth &t)
+{
+    if ((s.found & STATUS_FIELD_STATUS_CODE) && s.statusCode != t.statusCode)
+        return false;
+    if ((s.found & STATUS_FIELD_TEMPERATURE) && fabsf(s.temperature - t.temperatureTenths / 10.0f) > 0.05f)
+        return false;
+    if ((s.found & STATUS_FIELD_HUMIDITY) && s.humidity != t.humidity)
+        return false;
+    if ((s.found & STATUS_FIELD_POWER) && s.power != t.power)
+        return false;
+    if ((s.found & STATUS_FIELD_BRIGHTNESS) && s.brightness != t.brightness)
+        return false;
+    if ((s.found & STATUS_FIELD_COLOR) &&
+        (s.colorR != t.colorR || s.colorG != t.colorG || s.colorB != t.colorB))
+        return false;
+    if ((s.found & STATUS_FIELD_COLOR_TEMPERATURE) && s.colorTemperature != t.colorTemperature)
+        return false;
+    return true;
+}
+
+static uint16_t wantedFields(bool bulb)
+{
+    return bulb ? (STATUS_FIELDS_BULB | STATUS_FIELD_COLOR | STATUS_FIELD_COLOR_TEMPERATURE) : STATUS_FIELDS_METER;
+}
+
+// 完全な応答: 全てのフィールドが揃い、作った値と一致する
+static bool runComplete(bool bulb)
+{
+    int incomplete = 0, wrong = 0, legacyWrong = 0;
+    for (int n = 0; n < FUZZ_CASES; n++)
+    {
+        StatusDoc doc;
+        StatusTruth truth;
+        statusDocGenerate(doc, truth, bulb);
+
+        DeviceStatusParser parser(wantedFields(bulb));
+        feedChunked(parser, doc.text, doc.len);
+        if (!parser.complete())
+            incomplete++;
+        else if (!fieldsMatch(parser.result(), truth))
+            wrong++;
+
+        StatusTruth legacy = truth;
+        if (!legacyStatusParse(String(doc.text), bulb, legacy) || !legacyStatusMatches(legacy, truth))
+            legacyWrong++;
+    }
+    printf("case=complete kind=%s docs=%d incomplete=%d wrong=%d legacy_wrong=%d\n", bulb ? "bulb" : "meter",
+           FUZZ_CASES, incomplete, wrong, legacyWrong);
+    return incomplete == 0 && wrong == 0;
+}
+
+// 途中で切った応答: 取り出せたフィールドだけが正しい値で、切った後ろの値を読まない
+static bool runTruncated(bool bulb)
+{
+    int completed = 0, wrong = 0;
+    for (int n = 0; n < FUZZ_CASES; n++)
+    {
+        StatusDoc doc;
+        StatusTruth truth;
+        statusDocGenerate(doc, truth, bulb);
+        size_t cut = (size_t)statusDocRange((int)doc.len);
+
+        DeviceStatusParser parser(wantedFields(bulb));
+        feedChunked(parser, doc.text, cut);
+        if (parser.complete())
+            completed++;
+        if (!fieldsMatch(parser.result(), truth))
+            wrong++;
+    }
+    printf("case=truncated kind=%s docs=%d completed_before_cut=%d wrong=%d\n", bulb ? "bulb" : "meter", FUZZ_CASES,
+           completed, wrong);
+    return wrong == 0;
+}
+
+// でたらめな文字列（JSON の記号と "power" などの断片を混ぜる）: 止まらず、範囲外を読まない
+static bool runRandom()
+{
+    static const char *pieces[] = {"{", "}", "[", "]", ":", ",", "\"", "\\", "\\u", "D8", "00", " ",
+                                   "\"power\"", "\"body\"", "\"on\"", "1", "-", ".", "true", "null", "e9",
+                                   "\"brightness\"", "\"statusCode\"", "\xE3\x81\x82"};
+    const int pieceCount = sizeof(pieces) / sizeof(pieces[0]);
+    int failed = 0, completed = 0;
+    for (int n = 0; n < FUZZ_CASES; n++)
+    {
+        StatusDoc doc;
+        doc.len = 0;
+        doc.text[0] = '\0';
+        int count = 1 + statusDocRange(80);
+        for (int i = 0; i < count; i++)
+        {
+            if (statusDocRange(8) == 0)
+                statusDocAppend(doc, "%c", (char)(1 + statusDocRange(255)));
+            else
+                statusDocAppend(doc, "%s", pieces[statusDocRange(pieceCount)]);
+        }
+
+        DeviceStatusParser parser(STATUS_FIELDS_BULB);
+        feedChunked(parser, doc.text, doc.len);
+        if (parser.failed())
+            failed++;
+        if (parser.complete())
+            completed++;
+    }
+    printf("case=random docs=%d failed=%d completed=%d\n", FUZZ_CASES, failed, completed);
+    return true;
+}
+
+int main()
+{
+    bool ok = runComplete(true);
+    ok = runComplete(false) && ok;
+    ok = runTruncated(true) && ok;
+    ok = runTruncated(false) && ok;
+    ok = runRandom() && ok;
+
+    Serial.println(ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+// メインループの起床回数とアイドル時間の計測（疑似SwitchBotサーバーとタッチ操作の台本で実行）
+// 同じ操作を従来の 10ms ごとのループ（poll）とイベント駆動のループ（event）で再生し、
+// 操作中・触れたまま止まっている間・操作後（画面オン）・減光中のそれぞれについて
+// 1分あたりの起床回数・待っていた時間の割合・TICK の回数を出力する
+// イベント駆動の方が起床回数が多い、触れたまま止まっている間に TICK で回ったか定期の見回り以外で起きた、
+// または UI と疑似サーバーの状態が違えば終了コード 1
+// 実行: pio run -e native-loop-bench -t exec
+#include <Arduino.h>
+
+#include "device_registry.h"
+#include "device_discovery.h"
+#include "boot.h"
+#include "switchbot_api.h"
+#include "api_worker.h"
+#include "api_quota.h"
+#include "webhook.h"
+#include "event_loop.h"
+#include "loop_profiler.h"
+#include "ui.h"
+#include "ui_layout.h"
+#include "hal/hal_storage.h"
+#include "hal/native/hal_native.h"
+#include "host/mock_switchbot.h"
+
+// 疑似サーバーの往復時間
+#define BENCH_RTT_MS 150
+
+// 1回の再生の区切り（再生開始からのミリ秒、減光は SCREEN_OFF_TIMEOUT_MS=3000 でビルドした前提）
+// 0〜100ms のヘッダーのタップは前の再生で減光した画面を戻すため（どちらの再生も同じ状態から始める）
+#define BENCH_ACTIVE_START_MS 500
+#define BENCH_HOLD_START_MS 2500
+#define BENCH_IDLE_START_MS 4500
+#define BENCH_DIMMED_START_MS 8000
+#define BENCH_END_MS 13000
+
+// 計測する区間
+enum BenchPhase {
+    PHASE_ACTIVE, // タッチ操作・コマンドの送信中
+    PHASE_HOLD,   // ヘッダーに触れたまま止まっている間
+    PHASE_IDLE,   // 操作後、画面がついている間
+    PHASE_DIMMED, // 減光中
+    PHASE_COUNT
+};
+
+static const char* const phaseNames[PHASE_COUNT] = {"active", "hold", "idle", "dimmed"};
+static const uint32_t phaseStart[PHASE_COUNT] = {BENCH_ACTIVE_START_MS, BENCH_HOLD_START_MS, BENCH_IDLE_START_MS,
+                                                 BENCH_DIMMED_START_MS};
+static const uint32_t phaseEnd[PHASE_COUNT] = {BENCH_HOLD_START_MS, BENCH_IDLE_START_MS, BENCH_DIMMED_START_MS,
+                                               BENCH_END_MS};
+
+static HalNativeTouchEvent script[32];
+
+// 1分あたりの起床回数
+static double wakeupsPerMin(const EventLoopStats& stats) {
+    return stats.elapsedUs > 0 ? stats.wakeups * 60e6 / stats.elapsedUs : 0.0;
+}
+
+// タップ・ボタンの短押し・スライダーのドラッグ（percent まで）・ヘッダーに触れたまま止める
+static int buildScript(uint32_t t0, int percent) {
+    int n = 0;
+    script[n++] = {t0, SCREEN_WIDTH / 2, HEADER_HEIGHT / 2, true};
+    script[n++] = {t0 + 100, SCREEN_WIDTH / 2, HEADER_HEIGHT / 2, false};
+
+    int bx = getButtonX(0) + getButtonWidth() / 2;
+    int by = getButtonY() + BUTTON_HEIGHT / 2;
+    script[n++] = {t0 + 600, bx, by, true};
+    script[n++] = {t0 + 700, bx, by, false};
+
+    int sy = getSliderY() + SLIDER_HEIGHT / 2;
+    for (int step = 0; step <= 6; step++) {
+        int p = 30 + (percent - 30) * step / 6;
+        script[n++] = {t0 + 1000 + step * 100, getSliderX(0) + getSliderWidth() * p / 100, sy, true};
+    }
+    script[n++] = {t0 + 1700, getSliderX(0) + getSliderWidth() * percent / 100, sy, false};
+
+    // 計測区間の少し前に触れ、区間の終わりの少し後に離す
+    script[n++] = {t0 + BENCH_HOLD_START_MS - 100, SCREEN_WIDTH / 2, HEADER_HEIGHT / 2, true};
+    script[n++] = {t0 + BENCH_IDLE_START_MS + 100, SCREEN_WIDTH / 2, HEADER_HEIGHT / 2, false};
+    return n;
+}
+
+// main.cpp の loop() と同じ処理（シリアル・温湿度の分はタイマーの設定だけ）
+static void loopOnce() {
+    profilerLoopBegin();
+    bootService(millis());
+    uiUpdate();
+
+    unsigned long now = millis();
+    eventLoopSchedule(LOOP_TIMER_BOOT, eventLoopNextPoll(now));
+    eventLoopSchedule(LOOP_TIMER_SERIAL, eventLoopNextPoll(now));
+    profilerLoopEnd();
+    eventLoopWait();
+}
+
+// 1つのモードで台本を再生し、区間ごとの集計を出力する
+// perMin: 区間ごとの1分あたりの起床回数、stats: 区間ごとの集計を返す
+static void runMode(bool polling, int percent, double perMin[PHASE_COUNT], EventLoopStats phaseStats[PHASE_COUNT]) {
+    const char* mode = polling ? "poll" : "event";
+    eventLoopSetPolling(polling);
+
+    uint32_t t0 = millis();
+    halNativeSetTouchScript(script, buildScript(t0, percent));
+
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        while (millis() - t0 < phaseStart[phase]) loopOnce();
+        eventLoopResetStats();
+        while (millis() - t0 < phaseEnd[phase]) loopOnce();
+
+        EventLoopStats stats = eventLoopGetStats();
+        phaseStats[phase] = stats;
+        perMin[phase] = wakeupsPerMin(stats);
+        Serial.printf("mode=%s phase=%s wakeups=%lu per_min=%.0f idle_pct=%.1f touch=%lu network=%lu timer=%lu "
+                      "ticks=%lu\n",
+                      mode, phaseNames[phase], (unsigned long)stats.wakeups, perMin[phase],
+                      stats.elapsedUs > 0 ? 100.0 * stats.idleUs / stats.elapsedUs : 0.0,
+                      (unsigned long)stats.byCause[LOOP_WAKE_TOUCH], (unsigned long)stats.byCause[LOOP_WAKE_NETWORK],
+                      (unsigned long)stats.byCause[LOOP_WAKE_TIMER], (unsigned long)stats.byTimer[LOOP_TIMER_ACTIVE]);
+    }
+}
+
+int main() {
+    eventLoopInit();
+
+    // devices.h の設定から始め、1台目の電球を ON にしておく（スライダーを動かせるように）
+    halNativeSetStorageDir(".native_storage");
+    halStorageRemove(DISCOVERY_SNAPSHOT_NAME);
+    discoveryInit();
+    mockSwitchBotInstall(BENCH_RTT_MS, 0);
+    mockSwitchBotSetBulb(0, true, 30);
+    bulbs.powerState[0] = true;
+    bulbs.brightness[0] = 30;
+
+    switchbotApiInit();
+    apiQuotaInit(API_QUOTA_DAILY_LIMIT, API_QUOTA_PANELS);
+    apiWorkerInit();
+    uiInit();
+    webhookBegin();
+
+    // 同じ値は送らないので、再生ごとにドラッグ先を変える
+    double pollPerMin[PHASE_COUNT];
+    double eventPerMin[PHASE_COUNT];
+    EventLoopStats pollStats[PHASE_COUNT];
+    EventLoopStats eventStats[PHASE_COUNT];
+    runMode(true, 70, pollPerMin, pollStats);
+    runMode(false, 60, eventPerMin, eventStats);
+    while (apiWorkerPending() > 0) loopOnce();
+
+    bool ok = true;
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        Serial.printf("phase=%s per_min_poll=%.0f per_min_event=%.0f reduction=%.1fx\n", phaseNames[phase],
+                      pollPerMin[phase], eventPerMin[phase],
+                      eventPerMin[phase] > 0 ? pollPerMin[phase] / eventPerMin[phase] : 0.0);
+        ok = ok && eventPerMin[phase] < pollPerMin[phase];
+    }
+
+    // 触れたまま止まっている間は、シリアル・Webhook などを見に行く EVENT_LOOP_POLL_MS ごとにだけ起きる
+    const EventLoopStats& hold = eventStats[PHASE_HOLD];
+    uint32_t holdPolls = (BENCH_IDLE_START_MS - BENCH_HOLD_START_MS) / EVENT_LOOP_POLL_MS + 1;
+    if (hold.byTimer[LOOP_TIMER_ACTIVE] != 0 || hold.wakeups > holdPolls) {
+        Serial.printf("FAILED: hold wakeups=%lu ticks=%lu (max %lu wakeups, no ticks)\n", (unsigned long)hold.wakeups,
+                      (unsigned long)hold.byTimer[LOOP_TIMER_ACTIVE], (unsigned long)holdPolls);
+        ok = false;
+    }
+
+    MockBulb server = mockSwitchBotBulb(0);
+    if (!server.power || server.brightness != bulbs.brightness[0] || bulbs.brightness[0] != 60) {
+        Serial.printf("FAILED: bulb 0 ui=%d server=%d\n", bulbs.brightness[0], server.brightness);
+        ok = false;
+    }
+
+    Serial.println(ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
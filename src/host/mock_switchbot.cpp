@@ -0,0 +1,313 @@
+#include "mock_switchbot.h"
+
+#include <Arduino.h>
+#include <mbedtls/base64.h>
+#include <mbedtls/sha256.h>
+#include <mutex>
+
+#include "device_registry.h"
+#include "hal/native/hal_native.h"
+#include "secrets.h"
+
+static MockBulb mockBulbs[REGISTRY_MAX_BULBS];
+static int failNext[REGISTRY_MAX_BULBS];
+static uint32_t bulbLatency[REGISTRY_MAX_BULBS];
+static int bulbActive[REGISTRY_MAX_BULBS];
+static std::mutex mockMutex;
+static uint32_t mockRequests = 0;
+static bool mockDown = false;
+static MockFaults faults = {};
+static MockStats stats = {};
+static uint32_t rngState = 1;
+
+// 呼び出し回数の制限（トークンバケット、1000倍した残り回数）
+static int64_t rateTokens = 0;
+static uint32_t rateRefillMs = 0;
+
+// 揺れ・失敗を決める乱数（xorshift32、mockMutex の中で呼ぶ）
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// 呼び出し回数の制限の残りから1回使う（戻り値: 受け付けられる、mockMutex の中で呼ぶ）
+static bool takeRateToken() {
+    if (faults.ratePerSec <= 0) return true;
+
+    int64_t burst = (int64_t)(faults.rateBurst > 0 ? faults.rateBurst : faults.ratePerSec) * 1000;
+    uint32_t now = millis();
+    rateTokens = min(burst, rateTokens + (int64_t)(now - rateRefillMs) * faults.ratePerSec);
+    rateRefillMs = now;
+    if (rateTokens < 1000) return false;
+    rateTokens -= 1000;
+    return true;
+}
+
+// 名前が name のヘッダーの値（なければ nullptr）
+static const char* findHeader(const HalHttpHeader* headers, int headerCount, const char* name) {
+    for (int i = 0; i < headerCount; i++) {
+        if (strcmp(headers[i].name, name) == 0) return headers[i].value;
+    }
+    return nullptr;
+}
+
+// 署名の確認（sign = Base64(HMAC-SHA256(secret, token + t + nonce))）
+// request_signer の鍵スケジュールの事前計算を通らずに HMAC をそのまま計算して比べる
+static bool authorized(const HalHttpHeader* headers, int headerCount) {
+    const char* token = findHeader(headers, headerCount, "Authorization");
+    const char* t = findHeader(headers, headerCount, "t");
+    const char* nonce = findHeader(headers, headerCount, "nonce");
+    const char* sign = findHeader(headers, headerCount, "sign");
+    if (token == nullptr || t == nullptr || nonce == nullptr || sign == nullptr) return false;
+    if (strcmp(token, SWITCHBOT_TOKEN) != 0) return false;
+
+    // 鍵はブロック長（64バイト）に収まる長さを前提にする
+    unsigned char key[64] = {};
+    memcpy(key, SWITCHBOT_SECRET, min(strlen(SWITCHBOT_SECRET), sizeof(key)));
+    unsigned char pad[64];
+    unsigned char inner[32];
+    unsigned char mac[32];
+    mbedtls_sha256_context ctx;
+
+    for (int i = 0; i < 64; i++) pad[i] = key[i] ^ 0x36;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, pad, sizeof(pad));
+    mbedtls_sha256_update(&ctx, (const unsigned char*)token, strlen(token));
+    mbedtls_sha256_update(&ctx, (const unsigned char*)t, strlen(t));
+    mbedtls_sha256_update(&ctx, (const unsigned char*)nonce, strlen(nonce));
+    mbedtls_sha256_finish(&ctx, inner);
+
+    for (int i = 0; i < 64; i++) pad[i] = key[i] ^ 0x5c;
+    mbedtls_sha256_starts(&ctx, 0);
+    mbedtls_sha256_update(&ctx, pad, sizeof(pad));
+    mbedtls_sha256_update(&ctx, inner, sizeof(inner));
+    mbedtls_sha256_finish(&ctx, mac);
+    mbedtls_sha256_free(&ctx);
+
+    unsigned char expected[48];
+    size_t len = 0;
+    if (mbedtls_base64_encode(expected, sizeof(expected), &len, mac, sizeof(mac)) != 0) return false;
+    return strcmp((const char*)expected, sign) == 0;
+}
+
+// URL の /devices/{id}/ から電球を探す
+static int findBulb(const char* url) {
+    const char* p = strstr(url, "/devices/");
+    if (p == nullptr) return -1;
+    p += strlen("/devices/");
+
+    char id[DEVICE_ID_LEN];
+    size_t len = strcspn(p, "/");
+    if (len == 0 || len >= sizeof(id)) return -1;
+    memcpy(id, p, len);
+    id[len] = '\0';
+    return registryFindBulb(id);
+}
+
+// デバイス一覧（登録簿の電球・温湿度計に、対象外のハブと赤外線リモコンを混ぜる）
+static int deviceListResponse(char* response, size_t responseSize) {
+    size_t len = snprintf(response, responseSize,
+                          "{\"statusCode\":100,\"body\":{\"deviceList\":["
+                          "{\"deviceId\":\"MOCKHUB0001\",\"deviceName\":\"\\u30cf\\u30d6\","
+                          "\"deviceType\":\"Hub Mini\",\"enableCloudService\":false,\"hubDeviceId\":\"000000000000\"}");
+    if (meter.deviceId[0] != '\0') {
+        len += snprintf(response + len, responseSize - len,
+                        ",{\"deviceId\":\"%s\",\"deviceName\":\"%s\",\"deviceType\":\"Meter\","
+                        "\"enableCloudService\":true,\"hubDeviceId\":\"MOCKHUB0001\"}",
+                        meter.deviceId, meter.name);
+    }
+    for (int i = 0; i < bulbs.count && len < responseSize; i++) {
+        len += snprintf(response + len, responseSize - len,
+                        ",{\"deviceId\":\"%s\",\"deviceName\":\"%s\",\"deviceType\":\"Color Bulb\","
+                        "\"enableCloudService\":true,\"hubDeviceId\":\"\"}",
+                        bulbs.deviceId[i], bulbs.name[i]);
+    }
+    if (len < responseSize) {
+        len += snprintf(response + len, responseSize - len,
+                        "],\"infraredRemoteList\":[{\"deviceId\":\"02-000000000000-01\",\"deviceName\":\"TV\","
+                        "\"remoteType\":\"TV\",\"hubDeviceId\":\"MOCKHUB0001\"}]},\"message\":\"success\"}");
+    }
+    // 収まらなければ途中で切れた JSON になり、パーサーが失敗として扱う
+    return 200;
+}
+
+// 往復時間の後の応答（署名・障害・呼び出し回数の制限・電球の状態の更新）
+static int respond(int target, bool signedOk, const char* url, const char* body, char* response,
+                   size_t responseSize) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    mockRequests++;
+    stats.requests++;
+
+    if (!signedOk) {
+        stats.unauthorized++;
+        snprintf(response, responseSize, "{\"message\":\"Unauthorized\"}");
+        return 401;
+    }
+
+    if (mockDown) {
+        stats.errors++;
+        snprintf(response, responseSize, "{\"message\":\"Service unavailable\"}");
+        return 503;
+    }
+    if (!takeRateToken()) {
+        stats.rateLimited++;
+        snprintf(response, responseSize, "{\"message\":\"Too Many Requests\"}");
+        return 429;
+    }
+    if (faults.errorPercent > 0 && (int)(nextRandom() % 100) < faults.errorPercent) {
+        stats.errors++;
+        snprintf(response, responseSize, "{\"message\":\"Internal server error\"}");
+        return 500;
+    }
+
+    size_t urlLen = strlen(url);
+    if (body == nullptr && urlLen >= 8 && strcmp(url + urlLen - 8, "/devices") == 0) {
+        return deviceListResponse(response, responseSize);
+    }
+
+    if (meter.deviceId[0] != '\0' && strstr(url, meter.deviceId) != nullptr) {
+        stats.statuses++;
+        snprintf(response, responseSize,
+                 "{\"statusCode\":100,\"body\":{\"deviceId\":\"%s\",\"deviceType\":\"Meter\","
+                 "\"temperature\":23.4,\"humidity\":45},\"message\":\"success\"}",
+                 meter.deviceId);
+        return 200;
+    }
+
+    int i = target;
+    if (i < 0) {
+        snprintf(response, responseSize, "{\"statusCode\":152,\"body\":{},\"message\":\"device not found\"}");
+        return 200;
+    }
+
+    MockBulb& bulb = mockBulbs[i];
+    if (body != nullptr) {
+        if (failNext[i] > 0) {
+            failNext[i]--;
+            stats.errors++;
+            snprintf(response, responseSize, "{\"message\":\"Internal server error\"}");
+            return 500;
+        }
+        if (strstr(body, "\"turnOn\"") != nullptr) bulb.power = true;
+        if (strstr(body, "\"turnOff\"") != nullptr) bulb.power = false;
+        const char* param = strstr(body, "\"setBrightness\",\"parameter\":\"");
+        if (param != nullptr) {
+            // 消灯中の電球も明るさのコマンドで点灯する
+            bulb.brightness = atoi(param + strlen("\"setBrightness\",\"parameter\":\""));
+            bulb.power = true;
+        }
+        param = strstr(body, "\"setColor\",\"parameter\":\"");
+        if (param != nullptr) {
+            unsigned r = 0, g = 0, b = 0;
+            sscanf(param + strlen("\"setColor\",\"parameter\":\""), "%u:%u:%u", &r, &g, &b);
+            bulb.color = ((r & 0xFF) << 16) | ((g & 0xFF) << 8) | (b & 0xFF);
+        }
+        bulb.commands++;
+        stats.commands++;
+        snprintf(response, responseSize, "{\"statusCode\":100,\"body\":{},\"message\":\"success\"}");
+        return 200;
+    }
+
+    stats.statuses++;
+    snprintf(response, responseSize,
+             "{\"statusCode\":100,\"body\":{\"deviceId\":\"%s\",\"deviceType\":\"Color Bulb\","
+             "\"power\":\"%s\",\"brightness\":%d,\"color\":\"%lu:%lu:%lu\",\"colorTemperature\":4000},"
+             "\"message\":\"success\"}",
+             bulbs.deviceId[i], bulb.power ? "on" : "off", bulb.brightness,
+             (unsigned long)((bulb.color >> 16) & 0xFF), (unsigned long)((bulb.color >> 8) & 0xFF),
+             (unsigned long)(bulb.color & 0xFF));
+    return 200;
+}
+
+static int handleRequest(void* ctx, const char* url, const HalHttpHeader* headers, int headerCount,
+                         const char* body, char* response, size_t responseSize) {
+    (void)ctx;
+    bool signedOk = authorized(headers, headerCount);
+
+    // 揺れ・電球ごとの遅れの分は他のリクエストを止めないようロックの外で待つ
+    // 同じ電球へのリクエストを処理している間に届いたものは重なったとして数える
+    uint32_t jitterMs = 0;
+    int target = findBulb(url);
+    {
+        std::lock_guard<std::mutex> lock(mockMutex);
+        if (faults.jitterMs > 0) jitterMs = nextRandom() % (faults.jitterMs + 1);
+        if (target >= 0) {
+            jitterMs += bulbLatency[target];
+            if (bulbActive[target]++ > 0) stats.overlapped++;
+        }
+    }
+    if (jitterMs > 0) delay(jitterMs);
+
+    int code = respond(target, signedOk, url, body, response, responseSize);
+    if (target >= 0) {
+        std::lock_guard<std::mutex> lock(mockMutex);
+        bulbActive[target]--;
+    }
+    return code;
+}
+
+void mockSwitchBotInstall(uint32_t latencyMs, size_t chunkBytes) {
+    {
+        std::lock_guard<std::mutex> lock(mockMutex);
+        for (int i = 0; i < REGISTRY_MAX_BULBS; i++) {
+            mockBulbs[i] = {false, 100, 0xFFFFFF, 0};
+            failNext[i] = 0;
+            bulbLatency[i] = 0;
+            bulbActive[i] = 0;
+        }
+        mockRequests = 0;
+        mockDown = false;
+        faults = {};
+        stats = {};
+    }
+    halNativeSetHttpHandler(handleRequest, nullptr);
+    halNativeSetHttpLatency(latencyMs);
+    halNativeSetHttpChunk(chunkBytes);
+}
+
+MockBulb mockSwitchBotBulb(int index) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    return mockBulbs[index];
+}
+
+void mockSwitchBotSetBulb(int index, bool power, int brightness) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    mockBulbs[index].power = power;
+    mockBulbs[index].brightness = brightness;
+}
+
+void mockSwitchBotFailNext(int index, int count) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    failNext[index] = count;
+}
+
+void mockSwitchBotSetBulbLatency(int index, uint32_t extraMs) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    bulbLatency[index] = extraMs;
+}
+
+void mockSwitchBotSetDown(bool down) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    mockDown = down;
+}
+
+void mockSwitchBotSetFaults(const MockFaults& f) {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    faults = f;
+    rngState = f.seed != 0 ? f.seed : 0x9e3779b9u;
+    rateTokens = (int64_t)(f.rateBurst > 0 ? f.rateBurst : f.ratePerSec) * 1000;
+    rateRefillMs = millis();
+}
+
+uint32_t mockSwitchBotRequests() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    return mockRequests;
+}
+
+MockStats mockSwitchBotStats() {
+    std::lock_guard<std::mutex> lock(mockMutex);
+    return stats;
+}
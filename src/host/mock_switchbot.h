@@ -0,0 +1,67 @@
+#ifndef MOCK_SWITCHBOT_H
+#define MOCK_SWITCHBOT_H
+
+// ホスト用の疑似SwitchBotサーバー
+// GET /v1.1/devices、GET /v1.1/devices/{id}/status と POST /v1.1/devices/{id}/commands を模擬する
+// 電球はデバイス登録簿（device_registry）の番号で、温湿度計は meter.deviceId で識別する
+// 全てのリクエストの署名を secrets.h のトークン・シークレットで確かめ、合わなければ HTTP 401 で断る
+// デバイス一覧はリクエスト時点の登録簿の電球・温湿度計を返す
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 疑似サーバーが保持する電球の状態
+struct MockBulb {
+    bool power;
+    int brightness;
+    uint32_t color;     // 0xRRGGBB
+    uint32_t commands;  // 受け付けたコマンド数（失敗させた分を除く）
+};
+
+// 障害の設定（全て 0 なら障害なし）
+struct MockFaults {
+    uint32_t jitterMs;    // 往復時間に加える揺れ（0〜jitterMs ミリ秒）
+    int errorPercent;     // HTTP 500 で失敗させるリクエストの割合（%）
+    int ratePerSec;       // 1秒あたりに受け付けるリクエスト数（超えた分は HTTP 429、0 なら制限なし）
+    int rateBurst;        // 続けて受け付けるリクエスト数の上限（0 なら ratePerSec）
+    uint32_t seed;        // 揺れ・失敗を決める乱数の種（0 なら既定）
+};
+
+// 受け付けたリクエストの内訳
+struct MockStats {
+    uint32_t requests;     // 全てのリクエスト
+    uint32_t commands;     // 受け付けたコマンド
+    uint32_t statuses;     // 答えた状態取得（電球・温湿度計）
+    uint32_t errors;       // HTTP 500・503 で失敗させた
+    uint32_t rateLimited;  // HTTP 429 で断った
+    uint32_t overlapped;   // 同じ電球へのリクエストを処理している間に届いたリクエスト
+    uint32_t unauthorized; // 署名（Authorization・t・nonce・sign）が合わず HTTP 401 で断った
+};
+
+// 疑似サーバーを登録（全電球をOFF・明るさ100にする）
+// latencyMs: 1リクエストの往復時間, chunkBytes: レスポンスを渡す単位（0なら一括）
+void mockSwitchBotInstall(uint32_t latencyMs, size_t chunkBytes);
+
+// 電球の状態
+MockBulb mockSwitchBotBulb(int index);
+void mockSwitchBotSetBulb(int index, bool power, int brightness);
+
+// この電球への次の count 回のコマンドを HTTP 500 で失敗させる
+void mockSwitchBotFailNext(int index, int count);
+
+// この電球へのリクエストだけ往復時間に extraMs を加える（mockSwitchBotInstall で 0 に戻る）
+void mockSwitchBotSetBulbLatency(int index, uint32_t extraMs);
+
+// 障害の間（down=true）は全てのリクエストを HTTP 503 で失敗させる
+void mockSwitchBotSetDown(bool down);
+
+// 往復時間の揺れ・失敗の割合・呼び出し回数の制限を設定（mockSwitchBotInstall で障害なしに戻る）
+void mockSwitchBotSetFaults(const MockFaults& faults);
+
+// 受け付けたリクエスト数
+uint32_t mockSwitchBotRequests();
+
+// リクエストの内訳
+MockStats mockSwitchBotStats();
+
+#endif // MOCK_SWITCHBOT_H
@@ -0,0 +1,248 @@
+// 画面・電源によるポーリングの方針の比較（1日分の利用を再生）
+// 従来の固定の間隔（温湿度は60秒ごと、バッテリーは画面オンの間10秒ごと、復帰時に古い電球を取得）と、
+// ポリシー（poll_policy）で、バッテリー駆動とドック（充電中）の1日を仮想時刻で再生し、
+// 温湿度・電球の状態取得の回数、復帰時に取得せずに表示できた電球の割合を数える
+// ドックは呼び出し回数の割り当てに余裕がない（間隔を引き延ばしている）1日も再生し、先読みを見送ることを確かめる
+// 決まった間隔で使う1日（バッテリー駆動）も再生し、見込んだ復帰の前の先読みで復帰時の取得が減ることを確かめる
+// どの1日でも、電球の取得・温湿度と電球の取得の合計・復帰時の新しさが従来より悪い、残量の確認が従来の1.25倍を超える、
+// 決まった間隔の1日で復帰時の新しさが従来以下、バッテリー駆動で温湿度の取得が従来以上、割り当てに余裕がないのに先読みした、
+// またはバッテリー残量が取れないだけで充電中とみなせば終了コード 1
+// 実行: pio run -e native-policy-sim -t exec
+#include <Arduino.h>
+
+#include "poll_policy.h"
+#include "state_cache.h"
+#include "ui_layout.h"
+
+// 従来の間隔（main.cpp・ui.cpp）
+#define FIXED_METER_INTERVAL_MS 60000
+#define FIXED_BATTERY_INTERVAL_MS 10000
+
+// 画面を消すまでの時間（ui.cpp の SCREEN_OFF_TIMEOUT_MS）
+#define SIM_SCREEN_OFF_MS 30000
+
+// 再生の刻みと、1日の利用（7:00-23:00 に散らした画面復帰、1回につき最後の操作まで20秒）
+#define SIM_TICK_MS 1000
+#define SIM_DAY_MS (24 * 3600 * 1000u)
+#define SIM_SESSIONS 40
+#define SIM_SESSION_MS 20000
+
+// 決まった間隔で使う1日（24分ごと、前後5秒ずれる）
+#define SIM_ROUTINE_GAP_MS (24 * 60 * 1000u)
+#define SIM_ROUTINE_JITTER_MS 10000
+
+// バッテリー駆動: 0:00 に 90%、1時間に 4% 減る（17:30 頃に節電の残量を下回る）
+#define SIM_BATTERY_START 90
+#define SIM_BATTERY_DRAIN_PER_HOUR 4
+
+// 再生する1日の条件
+struct SimProfile
+{
+    const char *name;
+    bool docked;     // 1日中充電中
+    bool quotaTight; // 呼び出し回数の割り当てに余裕がない
+    bool routine;    // 決まった間隔で使う
+};
+
+// 1回の再生の結果
+struct SimResult
+{
+    uint32_t meterGets;
+    uint32_t bulbGets;
+    uint32_t batteryChecks;
+    uint32_t wakeBulbs;
+    uint32_t wakeFresh;
+    uint32_t wakes;
+    uint32_t prefetchRuns;
+};
+
+static uint32_t sessionStart[SIM_SESSIONS];
+static uint32_t routineStart[SIM_SESSIONS];
+
+// 再現性のための乱数（xorshift32）
+static uint32_t rngState;
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static void buildSessions()
+{
+    rngState = 0x13579bdfu;
+    uint32_t at = 7 * 3600 * 1000u;
+    uint32_t span = 16 * 3600 * 1000u / SIM_SESSIONS;
+    for (int i = 0; i < SIM_SESSIONS; i++)
+    {
+        at += span / 2 + nextRandom() % span;
+        sessionStart[i] = at;
+    }
+
+    uint32_t base = 7 * 3600 * 1000u;
+    for (int i = 0; i < SIM_SESSIONS; i++)
+        routineStart[i] = base + i * SIM_ROUTINE_GAP_MS + nextRandom() % SIM_ROUTINE_JITTER_MS;
+}
+
+static int batteryAt(const SimProfile &profile, uint32_t now)
+{
+    if (profile.docked)
+        return 100;
+    int level = SIM_BATTERY_START - (int)(now / 3600000u) * SIM_BATTERY_DRAIN_PER_HOUR;
+    return max(level, 1);
+}
+
+// 1日を再生（adaptive: ポリシーを使う）
+static SimResult replay(const SimProfile &profile, bool adaptive)
+{
+    SimResult result = {};
+    stateCacheInit();
+    pollPolicyInit(0);
+    pollPolicyNotePower(batteryAt(profile, 0), profile.docked);
+
+    uint32_t lastMeter = 0;
+    uint32_t lastBattery = 0;
+    uint32_t lastInteraction = 0;
+    bool dimmed = true;
+    int session = 0;
+    const uint32_t *starts = profile.routine ? routineStart : sessionStart;
+
+    for (uint32_t now = 0; now < SIM_DAY_MS; now += SIM_TICK_MS)
+    {
+        // 画面復帰・操作中・減光
+        bool wake = false;
+        if (session < SIM_SESSIONS && now >= starts[session])
+        {
+            wake = dimmed;
+            dimmed = false;
+            if (now < starts[session] + SIM_SESSION_MS)
+                lastInteraction = now;
+            else
+                session++;
+        }
+        if (!dimmed && now - lastInteraction >= SIM_SCREEN_OFF_MS)
+            dimmed = true;
+
+        // バッテリー（従来は画面オンの間だけ）
+        uint32_t batteryInterval = adaptive ? pollPolicyRates().batteryMs : FIXED_BATTERY_INTERVAL_MS;
+        if ((adaptive || !dimmed) && now - lastBattery >= batteryInterval)
+        {
+            lastBattery = now;
+            pollPolicyNotePower(batteryAt(profile, now), profile.docked);
+            result.batteryChecks++;
+        }
+        if (adaptive)
+            pollPolicyUpdate(now, dimmed, lastInteraction);
+
+        // 温湿度
+        uint32_t meterInterval = adaptive ? pollPolicyMeterInterval(FIXED_METER_INTERVAL_MS) : FIXED_METER_INTERVAL_MS;
+        if (now - lastMeter >= meterInterval)
+        {
+            lastMeter = now;
+            result.meterGets++;
+        }
+
+        // 復帰時・先読みで表示中のページの古い電球を取得（応答はすぐ届く扱い）
+        bool prefetch = adaptive && dimmed && pollPolicyPrefetchDue(now);
+        if (prefetch && profile.quotaTight)
+        {
+            pollPolicyNotePrefetchSkipped();
+            prefetch = false;
+        }
+        if (!wake && !prefetch)
+            continue;
+
+        int fresh = 0;
+        int requested = 0;
+        for (int i = 0; i < PANELS_PER_PAGE; i++)
+        {
+            if (!stateCacheStale(i, now, STATE_TTL_MS))
+            {
+                fresh++;
+                continue;
+            }
+            stateCacheNoteConfirmed(i, now);
+            requested++;
+        }
+        result.bulbGets += requested;
+        if (prefetch)
+        {
+            pollPolicyNotePrefetch(requested);
+            result.prefetchRuns++;
+        }
+        else
+        {
+            result.wakes++;
+            result.wakeBulbs += PANELS_PER_PAGE;
+            result.wakeFresh += fresh;
+            if (adaptive)
+                pollPolicyNoteWake(PANELS_PER_PAGE, fresh);
+        }
+    }
+    return result;
+}
+
+static void printResult(const SimProfile &profile, const char *mode, const SimResult &r)
+{
+    printf("profile=%s mode=%s meter_gets=%lu bulb_gets=%lu battery_checks=%lu prefetches=%lu wakes=%lu "
+           "wake_fresh=%lu/%lu (%.0f%%)\n",
+           profile.name, mode, (unsigned long)r.meterGets, (unsigned long)r.bulbGets,
+           (unsigned long)r.batteryChecks, (unsigned long)r.prefetchRuns, (unsigned long)r.wakes,
+           (unsigned long)r.wakeFresh, (unsigned long)r.wakeBulbs,
+           r.wakeBulbs > 0 ? 100.0 * r.wakeFresh / r.wakeBulbs : 0.0);
+}
+
+// バッテリー残量が取れない（負値）ときは、充電中とも残量が少ないともみなさない
+static bool checkUnknownBattery()
+{
+    pollPolicyInit(0);
+    pollPolicyNotePower(-1, false);
+    pollPolicyUpdate(1000, false, 1000);
+    PolicyState on = pollPolicyState();
+    pollPolicyUpdate(SIM_SCREEN_OFF_MS + 1000, true, 1000);
+    PolicyState dimmed = pollPolicyState();
+    bool ok = on == POLICY_ACTIVE && dimmed == POLICY_DIMMED;
+    printf("case=unknown_battery on=%s dimmed=%s %s\n", pollPolicyStateName(on), pollPolicyStateName(dimmed),
+           ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    buildSessions();
+    static const SimProfile profiles[] = {{"battery", false, false, false},
+                                          {"docked", true, false, false},
+                                          {"docked_quota", true, true, false},
+                                          {"routine", false, false, true}};
+
+    bool ok = true;
+    for (const SimProfile &profile : profiles)
+    {
+        SimResult fixed = replay(profile, false);
+        SimResult adaptive = replay(profile, true);
+        printResult(profile, "fixed", fixed);
+        printResult(profile, "policy", adaptive);
+        pollPolicyPrint(SIM_DAY_MS);
+
+        // 先読みは復帰時の取得を前に出すだけで、呼び出しも残量の確認も増やさない
+        bool same = adaptive.bulbGets <= fixed.bulbGets &&
+                    adaptive.meterGets + adaptive.bulbGets <= fixed.meterGets + fixed.bulbGets &&
+                    adaptive.wakeFresh >= fixed.wakeFresh && adaptive.prefetchRuns <= adaptive.wakes + 1 &&
+                    adaptive.batteryChecks <= fixed.batteryChecks + fixed.batteryChecks / 4;
+        if (!same)
+            printf("FAILED: profile=%s calls or battery checks above fixed, or wake freshness below fixed\n",
+                   profile.name);
+        ok = ok && same;
+        if (!profile.docked)
+            ok = ok && adaptive.meterGets < fixed.meterGets;
+        if (profile.quotaTight)
+            ok = ok && adaptive.prefetchRuns == 0;
+        if (profile.routine)
+            ok = ok && adaptive.wakeFresh > fixed.wakeFresh;
+    }
+    ok = checkUnknownBattery() && ok;
+
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+// 呼び出し回数の割り当て（api_quota）のシミュレーション
+// 1日分の利用を仮想時刻で再生し、パネル台数ごとの使用回数と最大の情報の古さを出力する
+// 実行: pio run -e native-quota-sim -t exec
+#include <Arduino.h>
+
+#include "api_quota.h"
+#include "state_cache.h"
+
+// main.cpp と同じ間隔（電球の状態取得の間隔は state_cache.h）
+#define METER_UPDATE_INTERVAL 60000
+#define BULBS 4
+
+// 再生する日（2026-01-01 00:00 UTC）
+#define SIM_DAY_START 1767225600u
+#define SIM_SECONDS 86400u
+
+// 利用パターン
+struct SimProfile
+{
+    const char *name;
+    int sessions;         // 1日の操作回数（画面復帰→コマンド→送れなかった電球の状態確認）
+    int commandsPerSession;
+};
+
+static const SimProfile profiles[] = {
+    {"typical", 40, 2},
+    {"heavy", 150, 4},
+};
+
+// 結果
+struct SimResult
+{
+    ApiQuotaStats quota;
+    uint32_t meterStalenessSec;  // 温湿度の最大の古さ
+    uint32_t bulbStalenessSec;   // 画面復帰直後に表示している電球状態の最大の古さ
+    uint32_t commandsRequested;
+};
+
+// 再現性のための乱数（xorshift32）
+static uint32_t rngState;
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static bool acquireMany(ApiPriority priority, int calls, uint32_t now)
+{
+    bool all = true;
+    for (int i = 0; i < calls; i++)
+        all = apiQuotaAcquire(priority, now) && all;
+    return all;
+}
+
+static SimResult simulate(const SimProfile &profile, int panels)
+{
+    apiQuotaInit(API_QUOTA_DAILY_LIMIT, panels);
+    rngState = 0x12345678u;
+
+    // 操作は 7:00-23:00 に一様に散らす
+    static uint32_t sessionAt[256];
+    int sessions = min(profile.sessions, 256);
+    for (int i = 0; i < sessions; i++)
+        sessionAt[i] = 7 * 3600 + nextRandom() % (16 * 3600);
+
+    SimResult result = {};
+    uint32_t lastMeter = 0;
+    uint32_t lastBulbRefresh = 0;
+    uint32_t nextMeter = 0;
+    uint32_t pendingRefreshAt = 0; // 操作後の状態確認の予定時刻（0=なし）
+    int pendingRefreshBulbs = 0;
+
+    for (uint32_t sec = 0; sec < SIM_SECONDS; sec++)
+    {
+        uint32_t now = SIM_DAY_START + sec;
+
+        // 温湿度の定期取得
+        if (sec >= nextMeter)
+        {
+            if (apiQuotaAcquire(API_PRIORITY_BACKGROUND, now))
+                lastMeter = sec;
+            nextMeter = sec + apiQuotaPollInterval(API_POLL_METER, METER_UPDATE_INTERVAL, 1, now) / 1000;
+        }
+        result.meterStalenessSec = max(result.meterStalenessSec, sec - lastMeter);
+
+        // 操作
+        for (int i = 0; i < sessions; i++)
+        {
+            if (sessionAt[i] != sec)
+                continue;
+
+            if ((sec - lastBulbRefresh) * 1000 >= apiQuotaStretch(STATE_TTL_MS, now) &&
+                acquireMany(API_PRIORITY_REFRESH, BULBS, now))
+            {
+                lastBulbRefresh = sec;
+            }
+            result.bulbStalenessSec = max(result.bulbStalenessSec, sec - lastBulbRefresh);
+
+            // 成功応答で受け付けられたコマンドの電球は確かめない（送れなかった電球だけ後で確かめる）
+            int denied = 0;
+            for (int c = 0; c < profile.commandsPerSession; c++)
+            {
+                if (!apiQuotaAcquire(API_PRIORITY_COMMAND, now))
+                    denied++;
+            }
+            result.commandsRequested += profile.commandsPerSession;
+            if (denied > 0)
+            {
+                pendingRefreshBulbs = min(pendingRefreshBulbs + denied, BULBS);
+                pendingRefreshAt = sec + apiQuotaStretch(STATE_RECONCILE_DELAY_MS, now) / 1000;
+            }
+        }
+
+        // 操作後の状態確認（送れなかった電球だけ、1回の操作で別々の電球を操作したとみなす）
+        if (pendingRefreshAt != 0 && sec >= pendingRefreshAt)
+        {
+            acquireMany(API_PRIORITY_REFRESH, pendingRefreshBulbs, now);
+            pendingRefreshAt = 0;
+            pendingRefreshBulbs = 0;
+        }
+    }
+
+    result.quota = apiQuotaGetStats();
+    return result;
+}
+
+int main()
+{
+    // 1行1ケース（key=value 形式）
+    for (const SimProfile &profile : profiles)
+    {
+        for (int panels = 1; panels <= 6; panels++)
+        {
+            SimResult r = simulate(profile, panels);
+            const ApiQuotaStats &q = r.quota;
+            printf("profile=%s panels=%d budget=%lu used=%lu command=%lu/%lu refresh=%lu background=%lu "
+                   "denied=%lu/%lu/%lu stretch_peak=%lu%% meter_stale_max=%lus bulb_stale_max=%lus\n",
+                   profile.name, panels, (unsigned long)q.budget, (unsigned long)q.used,
+                   (unsigned long)q.usedBy[API_PRIORITY_COMMAND], (unsigned long)r.commandsRequested,
+                   (unsigned long)q.usedBy[API_PRIORITY_REFRESH], (unsigned long)q.usedBy[API_PRIORITY_BACKGROUND],
+                   (unsigned long)q.deniedBy[API_PRIORITY_COMMAND], (unsigned long)q.deniedBy[API_PRIORITY_REFRESH],
+                   (unsigned long)q.deniedBy[API_PRIORITY_BACKGROUND], (unsigned long)q.peakStretchPercent,
+                   (unsigned long)r.meterStalenessSec, (unsigned long)r.bulbStalenessSec);
+        }
+    }
+    return 0;
+}
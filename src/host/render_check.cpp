@@ -0,0 +1,151 @@
+// 描画の確認（実機と同じ ui_render.cpp をホストの表示HALで動かし、フレームバッファの色を確かめる）
+// ボタン・スライダー・つまみ・空き位置・ヘッダー・シーン・グループのボタンの色と、
+// 状態更新で差分矩形の外が書き換わらないことを見る
+// 文字はホストでは1文字ずつ文字色の矩形になるため、文字の有無だけを確かめる
+// 実行: pio run -e native-render-check -t exec
+#include <Arduino.h>
+
+#include <string.h>
+
+#include "device_registry.h"
+#include "ui_dirty.h"
+#include "ui_layout.h"
+#include "ui_render.h"
+#include "hal/native/hal_native.h"
+
+static int failures = 0;
+
+static uint16_t pixelAt(int x, int y)
+{
+    return halNativeFramebuffer()[y * SCREEN_WIDTH + x];
+}
+
+static void expect(const char *name, bool ok)
+{
+    printf("case=%s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok)
+        failures++;
+}
+
+// 画面上の (x, y) が color か
+static void expectPixel(const char *name, int x, int y, uint16_t color)
+{
+    uint16_t actual = pixelAt(x, y);
+    if (actual != color)
+        printf("  %s: (%d,%d) = 0x%04X, want 0x%04X\n", name, x, y, actual, color);
+    expect(name, actual == color);
+}
+
+// パネル位置 slot のボタン左端・スライダーの中段の行
+static int buttonEdgeX(int slot) { return getButtonX(slot) + 5; }
+static int buttonMidY() { return getButtonY() + BUTTON_HEIGHT / 2; }
+static int sliderMidY() { return getSliderY() + SLIDER_HEIGHT / 2; }
+
+static int addBulb(const char *id, const char *name, bool on, int brightness)
+{
+    int index = registryAddBulb(id, name);
+    bulbs.powerState[index] = on;
+    bulbs.brightness[index] = brightness;
+    return index;
+}
+
+int main()
+{
+    registryClear();
+    registrySetMeter("", "");
+    addBulb("CHECK0", "居間", true, 50);
+    addBulb("CHECK1", "寝室", false, 30);
+    addBulb("CHECK2", "台所", true, 100);
+    addBulb("", "廊下", true, 50); // ID未設定
+    addBulb("CHECK4", "玄関", true, 10);
+
+    renderInit();
+    renderAll(80);
+    renderEndFrame();
+
+    // ヘッダーと余白
+    expectPixel("header_bg", HEADER_PAGE_X + 2, 2, COLOR_HEADER);
+    expectPixel("header_title_text", 20 + 3, HEADER_HEIGHT / 2, COLOR_TEXT);
+    expectPixel("margin_bg", PANEL_MARGIN / 2, getPanelY() + 100, COLOR_BG);
+    expectPixel("panel_bg", getPanelX(0) + PANEL_WIDTH / 2, getPanelY() + PANEL_BUTTON_Y - 5, COLOR_PANEL);
+
+    // ボタンの色は状態で決まり、文字は中央に描かれる
+    expectPixel("button_on", buttonEdgeX(0), buttonMidY(), COLOR_ON);
+    expectPixel("button_off", buttonEdgeX(1), buttonMidY(), COLOR_OFF);
+    expectPixel("button_disabled", buttonEdgeX(3), buttonMidY(), COLOR_DISABLED);
+    expectPixel("button_text", getButtonX(0) + PANEL_BUTTON_WIDTH / 2 - 5, buttonMidY(), COLOR_TEXT);
+
+    // スライダー: 点灯中は明るさの分だけ塗り、消灯中は溝だけ、ID未設定はつまみもない
+    int halfW = PANEL_SLIDER_WIDTH / 2;
+    expectPixel("slider_fill", getSliderX(0) + 5, sliderMidY(), COLOR_SLIDER_FG);
+    expectPixel("slider_groove", getSliderX(0) + halfW + SLIDER_HANDLE_RADIUS + 5, sliderMidY(), COLOR_SLIDER_BG);
+    expectPixel("slider_handle", getPanelX(0) + sliderHandleX(50), sliderMidY(), COLOR_TEXT);
+    expectPixel("slider_off", getSliderX(1) + 5, sliderMidY(), COLOR_SLIDER_BG);
+    expectPixel("slider_full", getSliderX(2) + PANEL_SLIDER_WIDTH - SLIDER_HANDLE_RADIUS * 2 - 5, sliderMidY(),
+                COLOR_SLIDER_FG);
+    expectPixel("slider_disabled", getPanelX(3) + sliderHandleX(50), sliderMidY(), COLOR_SLIDER_BG);
+
+    // 明るさを変えると塗りが伸び、パネル0のスライダーと明るさ表示の行より外は書き換わらない
+    static uint16_t before[SCREEN_WIDTH * SCREEN_HEIGHT];
+    memcpy(before, halNativeFramebuffer(), sizeof(before));
+    bulbs.brightness[0] = 80;
+    renderBulbPanel(0);
+    renderEndFrame();
+    expectPixel("slider_grown", getSliderX(0) + halfW + SLIDER_HANDLE_RADIUS + 5, sliderMidY(), COLOR_SLIDER_FG);
+    int outside = 0;
+    int changed = 0;
+    for (int y = 0; y < SCREEN_HEIGHT; y++)
+    {
+        for (int x = 0; x < SCREEN_WIDTH; x++)
+        {
+            if (before[y * SCREEN_WIDTH + x] == pixelAt(x, y))
+                continue;
+            changed++;
+            bool inPanel = x >= getPanelX(0) && x < getPanelX(0) + PANEL_WIDTH;
+            bool inRows = y >= getSliderY() - SLIDER_HANDLE_RADIUS && y < getPanelY() + PANEL_HEIGHT;
+            if (!inPanel || !inRows)
+                outside++;
+        }
+    }
+    printf("  brightness: changed_px=%d frame_px=%lu\n", changed, (unsigned long)renderGetStats().lastFramePixels);
+    expect("dirty_only", changed > 0 && outside == 0);
+    expect("dirty_frame_px", renderGetStats().lastFramePixels < (uint32_t)(PANEL_WIDTH * PANEL_HEIGHT));
+
+    // ON/OFF を切り替えるとボタンの色が変わる
+    bulbs.powerState[1] = true;
+    renderBulbPanel(1);
+    renderEndFrame();
+    expectPixel("button_toggled", buttonEdgeX(1), buttonMidY(), COLOR_ON);
+
+    // 2ページ目: 電球のない位置は背景色で消える
+    renderSetPage(1);
+    renderEndFrame();
+    expectPixel("page2_bulb", buttonEdgeX(0), buttonMidY(), COLOR_ON);
+    expectPixel("page2_empty", buttonEdgeX(1), buttonMidY(), COLOR_BG);
+    expectPixel("page2_empty_last", getPanelX(PANELS_PER_PAGE - 1) + PANEL_WIDTH / 2, sliderMidY(), COLOR_BG);
+
+    // シーン・グループのページ: ボタンの色はシーン・グループの ON/OFF で決まり、変化したボタンだけ描き直す
+    static ShortcutPanel shortcuts[] = {{"夕方", false, false}, {"全部", true, true}, {"水回り", true, false}};
+    renderSetShortcuts(shortcuts, 3);
+    renderSetPage(bulbPageCount());
+    renderEndFrame();
+    expect("shortcut_page", renderGetPage() == bulbPageCount());
+    expectPixel("shortcut_scene", buttonEdgeX(0), buttonMidY(), COLOR_SCENE);
+    expectPixel("shortcut_group_on", buttonEdgeX(1), buttonMidY(), COLOR_ON);
+    expectPixel("shortcut_group_off", buttonEdgeX(2), buttonMidY(), COLOR_OFF);
+    expectPixel("shortcut_empty", buttonEdgeX(3), buttonMidY(), COLOR_BG);
+    shortcuts[2].on = true;
+    renderShortcutPanels();
+    renderEndFrame();
+    expectPixel("shortcut_toggled", buttonEdgeX(2), buttonMidY(), COLOR_ON);
+    expect("shortcut_dirty_px", renderGetStats().lastFramePixels == (uint32_t)(PANEL_WIDTH * PANEL_HEIGHT));
+
+    // 電球のページに戻るとパネル全体を描き直す
+    renderSetPage(0);
+    renderEndFrame();
+    expectPixel("back_to_bulbs", buttonEdgeX(0), buttonMidY(), COLOR_ON);
+    expectPixel("back_to_bulbs_slider", getSliderX(0) + 5, sliderMidY(), COLOR_SLIDER_FG);
+
+    printf("result=%s failures=%d\n", failures == 0 ? "ok" : "FAILED", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,225 @@
+// シーン・グループ実行の計測（疑似SwitchBotサーバーに対して実行）
+// 電球間は並列に（同じ電球へは電源・明るさ・色の順に、明るさを送る電球は電源を省いて）送ったときの実行時間を、
+// 1台ずつ順に送った場合（従来の操作）と比べて出力する
+// 疑似サーバーの状態がシーンの目標と一致しなければ終了コード 1
+// 実行: pio run -e native-scene-bench -t exec
+#include <Arduino.h>
+
+#include "device_registry.h"
+#include "devices.h"
+#include "switchbot_api.h"
+#include "api_worker.h"
+#include "api_quota.h"
+#include "command_coalescer.h"
+#include "scene.h"
+#include "host/mock_switchbot.h"
+
+// 疑似サーバーの往復時間
+#define BENCH_RTT_MS 150
+
+static bool sceneDone = false;
+static SceneSummary lastSummary;
+
+static void onSceneDone(const SceneSummary& summary) {
+    lastSummary = summary;
+    sceneDone = true;
+}
+
+// シーンの完了まで UI ループと同じ処理を回す
+static void runUntilDone() {
+    while (!sceneDone) {
+        apiWorkerDispatch(API_JOB_QUEUE_LEN);
+        sceneService(millis());
+        delay(1);
+    }
+    // 完了通知の残りを処理
+    while (apiWorkerPending() > 0) {
+        apiWorkerDispatch(API_JOB_QUEUE_LEN);
+        delay(1);
+    }
+}
+
+// 1台ずつ順にコマンドを送った場合の時間（従来の switchbotBulbPower / switchbotBulbBrightness の直列実行）
+static uint32_t runSequential(const SceneConfig& config) {
+    uint32_t t0 = millis();
+    for (int i = 0; i < config.count; i++) {
+        const SceneTarget& target = config.targets[i];
+        switchbotBulbPower(target.deviceId, target.power);
+        if (!target.power) continue;
+        if (target.brightness >= 0) switchbotBulbBrightness(target.deviceId, target.brightness);
+        if (target.color >= 0) switchbotBulbColor(target.deviceId, (uint32_t)target.color);
+    }
+    return millis() - t0;
+}
+
+// グループの電球を1台ずつ順に操作した場合の時間
+static uint32_t runSequentialGroup(int group, bool on, int brightness) {
+    const GroupConfig& config = groupConfigs[group];
+    uint32_t t0 = millis();
+    for (int i = 0; i < config.count; i++) {
+        switchbotBulbPower(config.deviceIds[i], on);
+        if (on && brightness >= 0) switchbotBulbBrightness(config.deviceIds[i], brightness);
+    }
+    return millis() - t0;
+}
+
+// 疑似サーバーの状態がシーンの目標と一致するか
+static bool verifyScene(const SceneConfig& config) {
+    bool ok = true;
+    for (int i = 0; i < config.count; i++) {
+        const SceneTarget& target = config.targets[i];
+        int device = registryFindBulb(target.deviceId);
+        if (device < 0) continue;
+
+        MockBulb server = mockSwitchBotBulb(device);
+        bool match = server.power == target.power;
+        if (target.power && target.brightness >= 0) match = match && server.brightness == target.brightness;
+        if (target.power && target.color >= 0) match = match && server.color == (uint32_t)target.color;
+        if (!match) {
+            Serial.printf("FAILED: bulb %d power=%d brightness=%d color=%06lX\n", device, server.power,
+                          server.brightness, (unsigned long)server.color);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// 疑似サーバーでグループの電球が全て on の状態か
+static bool verifyGroup(int group, bool on) {
+    const GroupConfig& config = groupConfigs[group];
+    for (int i = 0; i < config.count; i++) {
+        int device = registryFindBulb(config.deviceIds[i]);
+        if (device >= 0 && mockSwitchBotBulb(device).power != on) {
+            Serial.printf("FAILED: group %d bulb %d is not %s\n", group, device, on ? "on" : "off");
+            return false;
+        }
+    }
+    return true;
+}
+
+// 状態が不明な電球へ送るコマンド数（明るさを送る電球は ON を省く）
+static int expectedColdCommands(const SceneConfig& config) {
+    int commands = 0;
+    for (int i = 0; i < config.count; i++) {
+        const SceneTarget& target = config.targets[i];
+        if (registryFindBulb(target.deviceId) < 0) continue;
+        commands++; // 電源か明るさのどちらか
+        if (target.power && target.color >= 0) commands++;
+    }
+    return commands;
+}
+
+// 全電球を OFF にして、送信済みの値を不明に戻す
+static void resetBulbs() {
+    for (int i = 0; i < bulbs.count; i++) {
+        mockSwitchBotSetBulb(i, false, 100);
+        bulbs.powerState[i] = false;
+        bulbs.brightness[i] = 100;
+    }
+    coalescerInit(nullptr);
+}
+
+// kind: "scene" または "group"、number: シーン・グループの番号
+static void printResult(const char* name, const char* kind, int number, uint32_t sequentialMs) {
+    const SceneSummary& s = lastSummary;
+    printf("case=%s %s=%d bulbs=%d commands=%d ok=%d failed=%d retries=%d skipped=%d "
+           "elapsed_ms=%lu rtt_ms=%d rounds=%.1f sequential_ms=%lu\n",
+           name, kind, number, bulbs.count, s.commands, s.succeeded, s.failed, s.retries, s.skipped,
+           (unsigned long)s.elapsedMs, BENCH_RTT_MS, (double)s.elapsedMs / BENCH_RTT_MS,
+           (unsigned long)sequentialMs);
+}
+
+// シーンを1回実行して結果を出力（戻り値: 疑似サーバーの状態が目標どおりか）
+static bool runCase(const char* name, int scene, uint32_t sequentialMs) {
+    sceneDone = false;
+    if (!sceneActivate(scene)) {
+        Serial.printf("FAILED: scene %d did not start\n", scene);
+        return false;
+    }
+    runUntilDone();
+    printResult(name, "scene", scene, sequentialMs);
+    return verifyScene(sceneConfigs[scene]) && lastSummary.failed == 0;
+}
+
+// シーンの実行中に1台目を単体の操作で OFF にする: シーンのコマンドの後に送られ、OFF で終わる
+static bool runUserOverride(int scene, uint32_t sequentialMs) {
+    resetBulbs();
+    int device = registryFindBulb(sceneConfigs[scene].targets[0].deviceId);
+    sceneDone = false;
+    if (device < 0 || !sceneActivate(scene)) return device < 0;
+    coalescerSetPower(device, false);
+    runUntilDone();
+    while (!coalescerIdle(device)) {
+        apiWorkerDispatch(API_JOB_QUEUE_LEN);
+        coalescerService(millis());
+        delay(1);
+    }
+    printResult("user_override", "scene", scene, sequentialMs);
+    MockBulb server = mockSwitchBotBulb(device);
+    if (server.power) {
+        Serial.printf("FAILED: scene %d bulb %d was not left off by the user command\n", scene, device);
+        return false;
+    }
+    return lastSummary.failed == 0;
+}
+
+int main() {
+    registryInit();
+    mockSwitchBotInstall(BENCH_RTT_MS, 0);
+
+    switchbotApiInit();
+    apiQuotaInit(API_QUOTA_DAILY_LIMIT, API_QUOTA_PANELS);
+    apiWorkerInit();
+    coalescerInit(nullptr);
+    sceneInit(onSceneDone);
+
+    bool ok = true;
+    for (int scene = 0; scene < sceneCount(); scene++) {
+        // 順に送った場合
+        resetBulbs();
+        uint32_t sequentialMs = runSequential(sceneConfigs[scene]);
+
+        // 電球の状態が不明（起動直後）: 全コマンドを送る
+        resetBulbs();
+        ok = runCase("cold", scene, sequentialMs) && ok;
+        if (lastSummary.commands != expectedColdCommands(sceneConfigs[scene])) {
+            Serial.printf("FAILED: scene %d sent %d commands (expected %d)\n", scene, lastSummary.commands,
+                          expectedColdCommands(sceneConfigs[scene]));
+            ok = false;
+        }
+
+        // 同じシーンをもう一度: 確認済みの電源・明るさは省略される
+        ok = runCase("repeat", scene, sequentialMs) && ok;
+
+        // 1台目へのコマンドを1回失敗させる: 再試行で完了する
+        resetBulbs();
+        int device = registryFindBulb(sceneConfigs[scene].targets[0].deviceId);
+        mockSwitchBotFailNext(device, 1);
+        ok = runCase("retry", scene, sequentialMs) && ok;
+
+        ok = runUserOverride(scene, sequentialMs) && ok;
+    }
+
+    // グループ: 全電球を ON にしてから OFF
+    for (int group = 0; group < groupCount(); group++) {
+        resetBulbs();
+        uint32_t sequentialOnMs = runSequentialGroup(group, true, 70);
+        uint32_t sequentialOffMs = runSequentialGroup(group, false, -1);
+
+        resetBulbs();
+        sceneDone = false;
+        sceneSetGroup(group, true, 70);
+        runUntilDone();
+        printResult("group_on", "group", group, sequentialOnMs);
+        ok = lastSummary.failed == 0 && verifyGroup(group, true) && ok;
+
+        sceneDone = false;
+        sceneSetGroup(group, false, -1);
+        runUntilDone();
+        printResult("group_off", "group", group, sequentialOffMs);
+        ok = lastSummary.failed == 0 && verifyGroup(group, false) && ok;
+    }
+
+    Serial.println(ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,365 @@
+// 電球の状態取得回数の比較（操作の記録を再生）
+// 操作後に表示中のページ全体を取り直す従来の方式と、状態キャッシュ（state_cache）で操作した電球だけを確かめ、
+// 古くなった電球だけを取り直す方式で、同じ操作の記録を再生して状態取得（GET）の回数を数える
+// 確認の結果を捨てたときに予定が残ることも確かめる
+// 従来に対する状態取得の減り方が全体で SIM_MIN_REDUCTION 倍・操作後で SIM_MIN_AFTER_OPS_REDUCTION 倍に届かないか、
+// 最も早い状態確認の予定の時刻が電球ごとの予定と合わないか、捨てた確認が失われれば終了コード 1
+// 実行: pio run -e native-state-sim -t exec
+#include <Arduino.h>
+
+#include "state_cache.h"
+#include "ui_layout.h"
+
+// ui.cpp の従来の間隔
+#define LEGACY_STATUS_UPDATE_INTERVAL_MS 10000
+#define LEGACY_WAKE_REFRESH_MIN_MS 30000
+
+// 登録する電球の数と、再生の刻み
+#define SIM_BULBS 16
+#define SIM_PAGES (SIM_BULBS / PANELS_PER_PAGE)
+#define SIM_TICK_MS 100
+
+// 1日分の記録の操作回数（画面復帰から操作まで）
+#define SIM_DAY_SESSIONS 40
+
+// 失敗するコマンドの割合（この回数に1回）
+#define SIM_FAIL_EVERY 20
+
+// 従来の方式に対して、状態取得の回数をこれ以上の倍率で減らせなければ失敗
+// （操作後の確認は成功応答で省けるので大きく減り、全体は画面復帰・ページ送りの取得が残る分だけ小さくなる）
+#define SIM_MIN_REDUCTION 1.5
+#define SIM_MIN_AFTER_OPS_REDUCTION 5.0
+
+// 記録する操作
+enum LogAction
+{
+    LOG_WAKE,       // 画面復帰
+    LOG_POWER,      // 電源の切り替え（arg: 電球）
+    LOG_BRIGHTNESS, // 明るさの変更（arg: 電球）
+    LOG_PAGE        // ページ送り（arg: ページ）
+};
+
+struct LogEvent
+{
+    uint32_t atMs;
+    LogAction action;
+    int arg;
+};
+
+// 夕方の操作の記録（帰宅して数台を点け、ページを送って別の部屋も点け、寝る前に消す）
+static const LogEvent eveningLog[] = {
+    {0, LOG_WAKE, 0},
+    {2000, LOG_POWER, 0},
+    {3500, LOG_POWER, 1},
+    {6000, LOG_BRIGHTNESS, 1},
+    {7000, LOG_BRIGHTNESS, 1},
+    {9000, LOG_PAGE, 1},
+    {11000, LOG_POWER, 4},
+    {13000, LOG_BRIGHTNESS, 4},
+    {15000, LOG_PAGE, 0},
+    {600000, LOG_WAKE, 0},
+    {602000, LOG_BRIGHTNESS, 0},
+    {1800000, LOG_WAKE, 0},
+    {1801000, LOG_PAGE, 1},
+    {1803000, LOG_POWER, 4},
+    {1804000, LOG_PAGE, 2},
+    {1806000, LOG_POWER, 9},
+    {1807000, LOG_POWER, 10},
+    {1809000, LOG_PAGE, 1},
+    {1810000, LOG_PAGE, 0},
+    {1812000, LOG_POWER, 0},
+    {1813000, LOG_POWER, 1},
+};
+
+// 再現性のための乱数（xorshift32）
+static uint32_t rngState;
+static uint32_t nextRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+// 1日分の記録を作る（7:00-23:00 に操作を散らし、1回につき画面復帰・ページ送り・1〜3台の操作）
+static int buildDayLog(LogEvent *log, int maxEvents)
+{
+    rngState = 0x2468ace1u;
+    int n = 0;
+    uint32_t at = 7 * 3600 * 1000u;
+    uint32_t span = 16 * 3600 * 1000u / SIM_DAY_SESSIONS;
+    for (int session = 0; session < SIM_DAY_SESSIONS && n + 8 <= maxEvents; session++)
+    {
+        at += span / 2 + nextRandom() % span;
+        uint32_t t = at;
+        log[n++] = {t, LOG_WAKE, 0};
+
+        int page = 0;
+        if (nextRandom() % 3 == 0)
+        {
+            page = 1 + nextRandom() % (SIM_PAGES - 1);
+            t += 1500;
+            log[n++] = {t, LOG_PAGE, page};
+        }
+        int ops = 1 + nextRandom() % 3;
+        for (int i = 0; i < ops; i++)
+        {
+            int device = page * PANELS_PER_PAGE + nextRandom() % PANELS_PER_PAGE;
+            t += 1000 + nextRandom() % 4000;
+            log[n++] = {t, nextRandom() % 2 ? LOG_POWER : LOG_BRIGHTNESS, device};
+        }
+        if (page != 0)
+        {
+            t += 2000;
+            log[n++] = {t, LOG_PAGE, 0};
+        }
+    }
+    return n;
+}
+
+// 従来の方式（ui.cpp の operationOccurred とページごとの取得時刻）
+struct LegacyPolicy
+{
+    uint32_t gets;
+    uint32_t afterOperations; // 操作後のページ全体の取得
+    int page;
+    uint32_t lastStatusUpdate;
+    bool operationOccurred;
+    uint32_t pageRefreshTime[SIM_PAGES];
+    bool pageRefreshed[SIM_PAGES];
+
+    void refreshPage(uint32_t now)
+    {
+        gets += PANELS_PER_PAGE;
+        lastStatusUpdate = now;
+        pageRefreshTime[page] = now;
+        pageRefreshed[page] = true;
+    }
+
+    void handle(const LogEvent &event)
+    {
+        switch (event.action)
+        {
+        case LOG_WAKE:
+            if (event.atMs - lastStatusUpdate >= LEGACY_WAKE_REFRESH_MIN_MS)
+                refreshPage(event.atMs);
+            break;
+        case LOG_POWER:
+        case LOG_BRIGHTNESS:
+            operationOccurred = true;
+            lastStatusUpdate = event.atMs;
+            break;
+        case LOG_PAGE:
+            page = event.arg;
+            if (!pageRefreshed[page] || event.atMs - pageRefreshTime[page] >= LEGACY_WAKE_REFRESH_MIN_MS)
+                refreshPage(event.atMs);
+            break;
+        }
+    }
+
+    void tick(uint32_t now)
+    {
+        if (operationOccurred && now - lastStatusUpdate >= LEGACY_STATUS_UPDATE_INTERVAL_MS)
+        {
+            refreshPage(now);
+            afterOperations += PANELS_PER_PAGE;
+            operationOccurred = false;
+        }
+    }
+};
+
+// 状態キャッシュの方式（ui.cpp の refreshVisible / reconcileOperatedBulbs / onBulbCommand と同じ手順、応答はすぐ届く扱い）
+// コマンドは SIM_FAIL_EVERY 回に1回失敗し、それ以外は成功応答で受け付けられる
+// 成功しても、一度も状態取得で確認していない電球（明るさが分からない）は予定どおり確かめる
+struct CachePolicy
+{
+    uint32_t gets;
+    int page;
+    uint32_t nextErrors; // 最も早い予定の時刻が、各電球の予定から求めた時刻と違った回数
+    uint32_t commands;
+    bool known[SIM_BULBS]; // 状態取得で確認したことがある
+
+    void confirm(int i, uint32_t now)
+    {
+        stateCacheNoteConfirmed(i, now);
+        known[i] = true;
+        gets++;
+    }
+
+    // 覚えている最も早い予定の時刻が、電球ごとの予定と一致するか（その時刻より前に予定の来る電球がなく、その時刻に来る電球がある）
+    void checkNext()
+    {
+        unsigned long at = 0;
+        bool found = stateCacheNextReconcile(at);
+        bool dueAt = false;
+        for (int i = 0; i < SIM_BULBS; i++)
+        {
+            if (stateCacheReconcileDue(i, at - 1))
+                nextErrors++;
+            dueAt = dueAt || stateCacheReconcileDue(i, at);
+        }
+        if (found != (stateCacheReconcilePending() > 0) || (found && !dueAt))
+            nextErrors++;
+    }
+
+    void refreshStale(uint32_t now)
+    {
+        for (int i = page * PANELS_PER_PAGE; i < (page + 1) * PANELS_PER_PAGE; i++)
+        {
+            if (!stateCacheStale(i, now, STATE_TTL_MS))
+            {
+                stateCacheNoteFresh();
+                continue;
+            }
+            stateCacheNoteRequested(i, false);
+            confirm(i, now);
+        }
+    }
+
+    void handle(const LogEvent &event)
+    {
+        switch (event.action)
+        {
+        case LOG_WAKE:
+            refreshStale(event.atMs);
+            break;
+        case LOG_POWER:
+        case LOG_BRIGHTNESS:
+            stateCacheNoteOptimistic(event.arg, event.atMs, STATE_RECONCILE_DELAY_MS);
+            if (++commands % SIM_FAIL_EVERY == 0)
+                stateCacheNoteFailed(event.arg, event.atMs);
+            else if (known[event.arg])
+                stateCacheNoteAccepted(event.arg, event.atMs);
+            break;
+        case LOG_PAGE:
+            page = event.arg;
+            refreshStale(event.atMs);
+            break;
+        }
+    }
+
+    void tick(uint32_t now)
+    {
+        checkNext();
+        if (stateCacheReconcilePending() == 0)
+            return;
+        for (int i = 0; i < SIM_BULBS; i++)
+        {
+            if (!stateCacheReconcileDue(i, now))
+                continue;
+            stateCacheNoteRequested(i, true);
+            confirm(i, now);
+        }
+    }
+};
+
+// 記録を再生（起動直後に1ページ目を取得した状態から始める）
+template <typename Policy>
+static uint32_t replay(Policy &policy, const LogEvent *log, int count)
+{
+    uint32_t start = log[0].atMs;
+    uint32_t end = log[count - 1].atMs + 60000;
+    int next = 0;
+    for (uint32_t now = start; now <= end; now += SIM_TICK_MS)
+    {
+        while (next < count && log[next].atMs <= now)
+            policy.handle(log[next++]);
+        policy.tick(now);
+    }
+    return policy.gets;
+}
+
+// 1つの記録を両方の方式で再生して1行出力（戻り値: 決めた倍率以上に減らせた）
+static bool compare(const char *name, const LogEvent *log, int count)
+{
+    int operations = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (log[i].action == LOG_POWER || log[i].action == LOG_BRIGHTNESS)
+            operations++;
+    }
+
+    LegacyPolicy legacy = {};
+    legacy.lastStatusUpdate = log[0].atMs;
+    legacy.refreshPage(log[0].atMs);
+    uint32_t legacyGets = replay(legacy, log, count);
+
+    // 集計は累計なので、この記録の前との差を出す
+    stateCacheInit();
+    StateCacheStats before = stateCacheGetStats();
+    CachePolicy cache = {};
+    cache.refreshStale(log[0].atMs);
+    uint32_t cacheGets = replay(cache, log, count);
+    StateCacheStats after = stateCacheGetStats();
+    uint32_t reconciles = after.reconciles - before.reconciles;
+
+    // after_ops: 操作後の取得（従来はページ全体、キャッシュは操作した電球だけ）
+    // 確認の取得がなければ、操作後の取得の倍率は従来の取得の回数そのものとみなす
+    double reduction = cacheGets > 0 ? (double)legacyGets / cacheGets : legacyGets;
+    double afterOpsReduction = reconciles > 0 ? (double)legacy.afterOperations / reconciles : legacy.afterOperations;
+    printf("log=%s bulbs=%d events=%d operations=%d legacy_gets=%lu cache_gets=%lu reduction=%.1fx "
+           "legacy_after_ops=%lu cache_after_ops=%lu after_ops_reduction=%.1fx accepted=%lu refreshes=%lu fresh=%lu\n",
+           name, SIM_BULBS, count, operations, (unsigned long)legacyGets, (unsigned long)cacheGets, reduction,
+           (unsigned long)legacy.afterOperations, (unsigned long)reconciles, afterOpsReduction,
+           (unsigned long)(after.accepted - before.accepted), (unsigned long)(after.refreshes - before.refreshes),
+           (unsigned long)(after.fresh - before.fresh));
+    bool ok = true;
+    if (cache.nextErrors > 0)
+    {
+        printf("FAILED: log=%s next reconcile time was wrong %lu times\n", name, (unsigned long)cache.nextErrors);
+        ok = false;
+    }
+    if (reduction < SIM_MIN_REDUCTION || afterOpsReduction < SIM_MIN_AFTER_OPS_REDUCTION)
+    {
+        printf("FAILED: log=%s reduction below %.1fx overall or %.1fx after operations\n", name, SIM_MIN_REDUCTION,
+               SIM_MIN_AFTER_OPS_REDUCTION);
+        ok = false;
+    }
+    return ok;
+}
+
+// 確認の結果を捨てたとき（失敗・操作中）に予定が残り、確かめ直すこと
+// 結果を待つ間に操作し直したら、捨てた結果ではなく新しい予定で確かめること
+static bool checkDroppedReconcile()
+{
+    stateCacheInit();
+    bool ok = true;
+    unsigned long at = 0;
+
+    // 投入しても確認するまで予定は残るが、結果を待つ間は確かめる時刻にならない
+    stateCacheNoteOptimistic(0, 1000, STATE_RECONCILE_DELAY_MS);
+    stateCacheNoteRequested(0, true);
+    ok = ok && stateCacheReconcilePending() == 1 && !stateCacheReconcileDue(0, 20000) && !stateCacheNextReconcile(at);
+
+    // 失敗して捨てたら delayMs 後に確かめ直す
+    stateCacheNoteDropped(0, 20000, STATE_RECONCILE_DELAY_MS);
+    ok = ok && !stateCacheReconcileDue(0, 20000) && stateCacheReconcileDue(0, 20000 + STATE_RECONCILE_DELAY_MS);
+    ok = ok && stateCacheNextReconcile(at) && at == 20000 + STATE_RECONCILE_DELAY_MS;
+
+    // 結果を待つ間に操作し直したら、後から捨てた結果は予定を変えない
+    stateCacheNoteRequested(0, true);
+    stateCacheNoteOptimistic(0, 31000, STATE_RECONCILE_DELAY_MS);
+    stateCacheNoteDropped(0, 32000, 0);
+    ok = ok && !stateCacheReconcileDue(0, 32000) && stateCacheReconcileDue(0, 31000 + STATE_RECONCILE_DELAY_MS);
+
+    // 確認したら予定は消える
+    stateCacheNoteRequested(0, true);
+    stateCacheNoteConfirmed(0, 42000);
+    ok = ok && stateCacheReconcilePending() == 0 && !stateCacheNextReconcile(at);
+
+    printf("dropped_reconcile=%s\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main()
+{
+    // 1行1記録（key=value 形式）
+    bool ok = compare("evening", eveningLog, sizeof(eveningLog) / sizeof(eveningLog[0]));
+
+    static LogEvent dayLog[SIM_DAY_SESSIONS * 8];
+    ok = compare("day", dayLog, buildDayLog(dayLog, SIM_DAY_SESSIONS * 8)) && ok;
+    ok = checkDroppedReconcile() && ok;
+
+    printf("%s\n", ok ? "OK" : "FAILED");
+    return ok ? 0 : 1;
+}
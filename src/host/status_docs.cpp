@@ -0,0 +1,205 @@
+// 状態取得の応答の生成（json_fuzz / json_bench 共通）
+#include "host/status_docs.h"
+
+#include <stdarg.h>
+
+#include <utility>
+
+// 乱数（再現できるように固定の種から）
+static uint32_t rngState = 0x12345678;
+
+uint32_t statusDocRandom()
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+int statusDocRange(int n)
+{
+    return (int)(statusDocRandom() % (uint32_t)n);
+}
+
+void statusDocAppend(StatusDoc &doc, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(doc.text + doc.len, sizeof(doc.text) - doc.len, format, args);
+    va_end(args);
+    if (n > 0)
+        doc.len = min(doc.len + (size_t)n, sizeof(doc.text) - 1);
+}
+
+// 区切りの空白（なし・空白・改行とインデント）
+static const char *space()
+{
+    static const char *spaces[] = {"", "", " ", "\n  ", "\t"};
+    return spaces[statusDocRange(5)];
+}
+
+// 入れ子の同名キー（"body" 直下以外の "power" / "brightness" などは無視されるべき値）
+static void appendDecoy(StatusDoc &doc)
+{
+    switch (statusDocRange(4))
+    {
+    case 0:
+        statusDocAppend(doc, "\"context\":{%s\"power\":\"%s\",\"brightness\":%d}", space(),
+                        statusDocRange(2) ? "on" : "off", statusDocRange(101));
+        break;
+    case 1:
+        statusDocAppend(doc, "\"scenes\":[{\"power\":\"on\",\"temperature\":%d.5},{\"humidity\":%d}]",
+                        statusDocRange(40), statusDocRange(100));
+        break;
+    case 2:
+        statusDocAppend(doc, "\"label\":\"\\\"power\\\":\\\"on\\\",\\\"brightness\\\":%d\"", statusDocRange(101));
+        break;
+    default:
+        statusDocAppend(doc, "\"meta\":{\"inner\":{\"power\":\"off\",\"color\":\"1:2:3\"},\"statusCode\":%d}",
+                        statusDocRange(500));
+        break;
+    }
+}
+
+// "body" のメンバーを乱数の順序で並べる
+static void appendBody(StatusDoc &doc, const StatusTruth &t)
+{
+    const int memberCount = 8;
+    int order[memberCount];
+    for (int i = 0; i < memberCount; i++)
+        order[i] = i;
+    for (int i = memberCount - 1; i > 0; i--)
+        std::swap(order[i], order[statusDocRange(i + 1)]);
+
+    statusDocAppend(doc, "{");
+    bool first = true;
+    for (int i = 0; i < memberCount; i++)
+    {
+        if (!first)
+            statusDocAppend(doc, ",%s", space());
+        first = false;
+        switch (order[i])
+        {
+        case 0:
+            statusDocAppend(doc, "\"deviceId\":\"%08X\"", (unsigned)statusDocRandom());
+            break;
+        case 1:
+            appendDecoy(doc);
+            break;
+        case 2:
+            if (t.bulb)
+                statusDocAppend(doc, "\"power\":%s\"%s\"", space(), t.power ? "on" : "off");
+            else
+                statusDocAppend(doc, "\"temperature\":%s%s%d.%d", space(), t.temperatureTenths < 0 ? "-" : "",
+                                abs(t.temperatureTenths) / 10, abs(t.temperatureTenths) % 10);
+            break;
+        case 3:
+            if (t.bulb)
+                statusDocAppend(doc, "\"brightness\":%s%d", space(), t.brightness);
+            else
+                statusDocAppend(doc, "\"humidity\":%s%d", space(), t.humidity);
+            break;
+        case 4:
+            if (t.bulb)
+                statusDocAppend(doc, "\"color\":\"%d:%d:%d\"", t.colorR, t.colorG, t.colorB);
+            else
+                statusDocAppend(doc, "\"battery\":%d", statusDocRange(101));
+            break;
+        case 5:
+            if (t.bulb)
+                statusDocAppend(doc, "\"colorTemperature\":%d", t.colorTemperature);
+            else
+                statusDocAppend(doc, "\"version\":\"V%d.%d\"", statusDocRange(10), statusDocRange(10));
+            break;
+        case 6:
+            statusDocAppend(doc, "\"deviceType\":\"%s\"", t.bulb ? "Color Bulb" : "Meter");
+            break;
+        default:
+            statusDocAppend(doc, "\"hubDeviceId\":\"%08X\"", (unsigned)statusDocRandom());
+            break;
+        }
+    }
+    statusDocAppend(doc, "}");
+}
+
+// 応答全体を作る（statusCode・body・message の順序も乱数で変える）
+void statusDocGenerate(StatusDoc &doc, StatusTruth &t, bool bulb)
+{
+    t.bulb = bulb;
+    t.statusCode = statusDocRange(4) ? 100 : 190;
+    t.temperatureTenths = statusDocRange(900) - 200;
+    t.humidity = statusDocRange(101);
+    t.power = statusDocRange(2) != 0;
+    t.brightness = 1 + statusDocRange(100);
+    t.colorR = (uint8_t)statusDocRandom();
+    t.colorG = (uint8_t)statusDocRandom();
+    t.colorB = (uint8_t)statusDocRandom();
+    t.colorTemperature = 2700 + statusDocRange(3801);
+
+    doc.len = 0;
+    doc.text[0] = '\0';
+    int order[3] = {0, 1, 2};
+    for (int i = 2; i > 0; i--)
+        std::swap(order[i], order[statusDocRange(i + 1)]);
+
+    statusDocAppend(doc, "{%s", space());
+    for (int i = 0; i < 3; i++)
+    {
+        if (i > 0)
+            statusDocAppend(doc, ",%s", space());
+        if (order[i] == 0)
+            statusDocAppend(doc, "\"statusCode\":%d", t.statusCode);
+        else if (order[i] == 1)
+        {
+            statusDocAppend(doc, "\"body\":%s", space());
+            appendBody(doc, t);
+        }
+        else
+            statusDocAppend(doc, "\"message\":\"success\"");
+    }
+    statusDocAppend(doc, "%s}", space());
+}
+
+// switchbot_api.cpp の従来の解析（電球: power / brightness、温湿度計: temperature / humidity）
+bool legacyStatusParse(const String &resp, bool bulb, StatusTruth &out)
+{
+    if (bulb)
+    {
+        int powerIdx = resp.indexOf("\"power\":");
+        int brightnessIdx = resp.indexOf("\"brightness\":");
+        if (powerIdx < 0 || brightnessIdx < 0)
+            return false;
+        int powerStart = resp.indexOf("\"", powerIdx + 8) + 1;
+        int powerEnd = resp.indexOf("\"", powerStart);
+        out.power = resp.substring(powerStart, powerEnd) == "on";
+        int brightStart = brightnessIdx + 13;
+        int brightEnd = resp.indexOf(",", brightStart);
+        if (brightEnd < 0)
+            brightEnd = resp.indexOf("}", brightStart);
+        out.brightness = resp.substring(brightStart, brightEnd).toInt();
+        return true;
+    }
+
+    int tempIdx = resp.indexOf("\"temperature\":");
+    int humIdx = resp.indexOf("\"humidity\":");
+    if (tempIdx < 0 || humIdx < 0)
+        return false;
+    int tempStart = tempIdx + 14;
+    int tempEnd = resp.indexOf(",", tempStart);
+    if (tempEnd < 0)
+        tempEnd = resp.indexOf("}", tempStart);
+    out.temperatureTenths = (int)lroundf(resp.substring(tempStart, tempEnd).toFloat() * 10.0f);
+    int humStart = humIdx + 11;
+    int humEnd = resp.indexOf(",", humStart);
+    if (humEnd < 0)
+        humEnd = resp.indexOf("}", humStart);
+    out.humidity = resp.substring(humStart, humEnd).toInt();
+    return true;
+}
+
+bool legacyStatusMatches(const StatusTruth &got, const StatusTruth &t)
+{
+    if (t.bulb)
+        return got.power == t.power && got.brightness == t.brightness;
+    return got.temperatureTenths == t.temperatureTenths && got.humidity == t.humidity;
+}
@@ -0,0 +1,46 @@
+#ifndef STATUS_DOCS_H
+#define STATUS_DOCS_H
+
+// ホスト用の状態取得の応答の生成（json_fuzz・json_bench 共通）
+// 電球・温湿度計の応答を、フィールドの順序・空白・入れ子の同名キー（"power" など）を乱数で変えて作る
+// 従来の indexOf / substring による解析（switchbot_api.cpp にあったもの）も比べるために残す
+
+#include <Arduino.h>
+
+// 生成する応答の大きさの上限
+#define STATUS_DOC_MAX 1024
+
+// 生成した応答の正しい値
+struct StatusTruth
+{
+    bool bulb;
+    int statusCode;
+    int temperatureTenths;
+    int humidity;
+    bool power;
+    int brightness;
+    uint8_t colorR, colorG, colorB;
+    int colorTemperature;
+};
+
+struct StatusDoc
+{
+    char text[STATUS_DOC_MAX];
+    size_t len;
+};
+
+// 乱数（再現できるように固定の種から、生成と区切りの位置などで同じ列を使う）
+uint32_t statusDocRandom();
+int statusDocRange(int n);
+
+// 応答全体を作る（statusCode・body・message の順序も乱数で変える）
+void statusDocGenerate(StatusDoc &doc, StatusTruth &t, bool bulb);
+
+// 書式を付けて末尾に足す（上限で切る）
+void statusDocAppend(StatusDoc &doc, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+// 従来の解析（電球: power / brightness、温湿度計: temperature / humidity）と、その結果が正しい値と一致するか
+bool legacyStatusParse(const String &resp, bool bulb, StatusTruth &out);
+bool legacyStatusMatches(const StatusTruth &got, const StatusTruth &t);
+
+#endif // STATUS_DOCS_H
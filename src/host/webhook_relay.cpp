@@ -0,0 +1,81 @@
+#include "webhook_relay.h"
+
+#include <Arduino.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// 応答を待つ時間
+#define RELAY_TIMEOUT_MS 2000
+
+static bool sendAll(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+int webhookRelayPost(uint16_t port, const char* method, const char* path, const char* token, const char* body,
+                     size_t chunkBytes, WebhookRelayPump pump) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // リクエスト全体を組み立ててから、チャンクに分けて送る
+    char request[4096];
+    char tokenHeader[128] = "";
+    if (token != nullptr) snprintf(tokenHeader, sizeof(tokenHeader), "X-Webhook-Token: %s\r\n", token);
+    size_t bodyLen = strlen(body);
+    int len = snprintf(request, sizeof(request),
+                       "%s %s HTTP/1.1\r\nHost: 127.0.0.1:%u\r\nContent-Type: application/json\r\n%s"
+                       "Content-Length: %u\r\n\r\n%s",
+                       method, path, (unsigned)port, tokenHeader, (unsigned)bodyLen, body);
+    if (len < 0 || (size_t)len >= sizeof(request)) {
+        close(fd);
+        return -1;
+    }
+
+    size_t step = chunkBytes > 0 ? chunkBytes : (size_t)len;
+    for (size_t pos = 0; pos < (size_t)len; pos += step) {
+        if (!sendAll(fd, request + pos, min(step, (size_t)len - pos))) {
+            // 途中で応答して閉じられた（不正なリクエスト）: 応答は読める
+            break;
+        }
+        pump();
+    }
+
+    // 応答（"HTTP/1.1 204 No Content"）を待つ
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    char response[128];
+    size_t received = 0;
+    uint32_t t0 = millis();
+    while (millis() - t0 < RELAY_TIMEOUT_MS && received < sizeof(response) - 1) {
+        ssize_t n = recv(fd, response + received, sizeof(response) - 1 - received, 0);
+        if (n > 0) {
+            received += n;
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) break;
+        pump();
+    }
+    close(fd);
+
+    response[received] = '\0';
+    int code = -1;
+    if (sscanf(response, "HTTP/1.1 %d", &code) != 1) return -1;
+    return code;
+}
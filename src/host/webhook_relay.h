@@ -0,0 +1,21 @@
+#ifndef WEBHOOK_RELAY_H
+#define WEBHOOK_RELAY_H
+
+// ホスト用の疑似 Webhook 中継
+// 記録したイベントを、LAN 内の中継と同じく HTTP POST でパネルの待ち受けポートへ送る
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 送信中・応答待ちの間に呼ぶ処理（UI ループを1回分回す）
+typedef void (*WebhookRelayPump)();
+
+// 127.0.0.1:port の path へ body を POST し、応答のステータスコードを返す
+// token は X-Webhook-Token ヘッダーで送る（nullptr なら付けない）
+// chunkBytes ごとに分けて送り、その間に pump を呼ぶ（パーサーがチャンク境界をまたいで読めるか確かめる）
+// method を変えると不正なリクエストを送れる
+// 戻り値: HTTPステータスコード（接続できない・応答がなければ -1）
+int webhookRelayPost(uint16_t port, const char* method, const char* path, const char* token, const char* body,
+                     size_t chunkBytes, WebhookRelayPump pump);
+
+#endif // WEBHOOK_RELAY_H
@@ -0,0 +1,477 @@
+#include "json_scanner.h"
+
+#include <string.h>
+
+static bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// 数値・true/false/null を構成しうる文字
+static bool isScalarChar(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           c == '-' || c == '+' || c == '.';
+}
+
+// 16進数1桁の値（16進数でなければ -1）
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+JsonScanner::JsonScanner(JsonValueHandler handler, void *ctx)
+    : handler(handler), objectEndHandler(nullptr), ctx(ctx), depthLimit(JSON_MAX_DEPTH)
+{
+    reset();
+}
+
+void JsonScanner::setDepthLimit(int limit)
+{
+    depthLimit = limit < 1 ? 1 : (limit > JSON_MAX_DEPTH ? JSON_MAX_DEPTH : limit);
+}
+
+void JsonScanner::reset()
+{
+    state = STATE_VALUE;
+    stopped = false;
+    depth = 0;
+    memset(isObject, 0, sizeof(isObject));
+    keys[0][0] = '\0';
+    readingKey = false;
+    escape = false;
+    unicodeDigits = 0;
+    unicodeValue = 0;
+    highSurrogate = 0;
+    skipDepth = 0;
+    skipInString = false;
+    skipEscape = false;
+    valueLen = 0;
+    valueTruncated = false;
+}
+
+bool JsonScanner::feed(const char *data, size_t len)
+{
+    const char *p = data;
+    const char *end = data + len;
+    while (p < end && !stopped)
+    {
+        // 文字列・数値の中身と飛ばす入れ子は1文字ずつ状態を見ずにまとめて進める
+        if (state == STATE_STRING && !escape && unicodeDigits == 0)
+        {
+            p = scanString(p, end);
+            if (p == end)
+                break;
+        }
+        else if (state == STATE_SCALAR)
+        {
+            p = scanScalar(p, end);
+            if (p == end)
+                break;
+            // 区切り文字は次の状態で読む
+            if (!endScalar())
+            {
+                state = STATE_ERROR;
+                return false;
+            }
+        }
+        else if (state == STATE_SKIP)
+        {
+            p = skipNested(p, end);
+            continue;
+        }
+        if (!step(*p++))
+        {
+            state = STATE_ERROR;
+            return false;
+        }
+    }
+    return state != STATE_ERROR;
+}
+
+// 文字列の '"' か '\\' の手前までを値に写す
+// 戻り値: '"' か '\\' の位置（なければ end）
+const char *JsonScanner::scanString(const char *p, const char *end)
+{
+    const char *quote = (const char *)memchr(p, '"', end - p);
+    const char *limit = quote != nullptr ? quote : end;
+    const char *backslash = (const char *)memchr(p, '\\', limit - p);
+    const char *stop = backslash != nullptr ? backslash : limit;
+    size_t n = stop - p;
+    if (n == 0)
+        return stop;
+
+    if (highSurrogate != 0)
+    {
+        // 後半のないサロゲート
+        highSurrogate = 0;
+        appendValue('?');
+    }
+    size_t room = JSON_VALUE_MAX - 1 - valueLen;
+    if (n > room)
+    {
+        n = room;
+        valueTruncated = true;
+    }
+    memcpy(value + valueLen, p, n);
+    valueLen += n;
+    return stop;
+}
+
+// 数値・true/false/null を構成しうる文字の並びを値に写す
+// 戻り値: 並びの次の位置（なければ end）
+const char *JsonScanner::scanScalar(const char *p, const char *end)
+{
+    const char *stop = p;
+    while (stop < end && isScalarChar(*stop))
+        stop++;
+
+    size_t n = stop - p;
+    size_t room = JSON_VALUE_MAX - 1 - valueLen;
+    if (n > room)
+    {
+        n = room;
+        valueTruncated = true;
+    }
+    memcpy(value + valueLen, p, n);
+    valueLen += n;
+    return stop;
+}
+
+// 読む深さより深い入れ子を、括弧と文字列の境目だけを数えて飛ばす
+// 戻り値: 読み進めた位置（入れ子を閉じたらその次、閉じなければ end）
+const char *JsonScanner::skipNested(const char *p, const char *end)
+{
+    while (p < end)
+    {
+        if (skipInString)
+        {
+            if (skipEscape)
+            {
+                skipEscape = false;
+                p++;
+                continue;
+            }
+            const char *quote = (const char *)memchr(p, '"', end - p);
+            const char *limit = quote != nullptr ? quote : end;
+            const char *backslash = (const char *)memchr(p, '\\', limit - p);
+            if (backslash != nullptr)
+            {
+                skipEscape = true;
+                p = backslash + 1;
+                continue;
+            }
+            if (quote == nullptr)
+                return end;
+            skipInString = false;
+            p = quote + 1;
+            continue;
+        }
+
+        char c = *p++;
+        if (c == '"')
+        {
+            skipInString = true;
+        }
+        else if (c == '{' || c == '[')
+        {
+            skipDepth++;
+        }
+        else if ((c == '}' || c == ']') && --skipDepth == 0)
+        {
+            state = (depth == 0) ? STATE_DONE : STATE_AFTER_VALUE;
+            return p;
+        }
+    }
+    return end;
+}
+
+void JsonScanner::openContainer(bool object)
+{
+    depth++;
+    if (depth > JSON_MAX_DEPTH)
+        return;
+
+    isObject[depth] = object ? 1 : 0;
+
+    // 配列は親のキーを引き継ぐ（配列内オブジェクトの parentKey が配列のキーになる）
+    if (object)
+        keys[depth][0] = '\0';
+    else
+        memcpy(keys[depth], keys[depth - 1], JSON_KEY_MAX);
+}
+
+bool JsonScanner::closeContainer(bool object)
+{
+    if (depth <= 0)
+        return false;
+    if (depth <= JSON_MAX_DEPTH && (isObject[depth] != 0) != object)
+        return false;
+
+    if (object && objectEndHandler != nullptr && depth <= JSON_MAX_DEPTH)
+        objectEndHandler(ctx, keys[depth - 1]);
+
+    depth--;
+    state = (depth == 0) ? STATE_DONE : STATE_AFTER_VALUE;
+    return true;
+}
+
+void JsonScanner::appendValue(char c)
+{
+    if (valueLen < JSON_VALUE_MAX - 1)
+        value[valueLen++] = c;
+    else
+        valueTruncated = true;
+}
+
+void JsonScanner::appendCodepoint(uint32_t cp)
+{
+    // サロゲートペアは前半を覚えておき、後半と組み合わせる
+    if (cp >= 0xD800 && cp < 0xDC00)
+    {
+        if (highSurrogate != 0)
+            appendValue('?');
+        highSurrogate = (uint16_t)cp;
+        return;
+    }
+    if (cp >= 0xDC00 && cp < 0xE000)
+    {
+        if (highSurrogate == 0)
+        {
+            appendValue('?');
+            return;
+        }
+        cp = 0x10000 + ((uint32_t)(highSurrogate - 0xD800) << 10) + (cp - 0xDC00);
+    }
+    else if (highSurrogate != 0)
+    {
+        appendValue('?');
+    }
+    highSurrogate = 0;
+
+    if (cp == 0)
+    {
+        appendValue('?'); // 終端と区別できないので置き換える
+    }
+    else if (cp < 0x80)
+    {
+        appendValue((char)cp);
+    }
+    else if (cp < 0x800)
+    {
+        appendValue((char)(0xC0 | (cp >> 6)));
+        appendValue((char)(0x80 | (cp & 0x3F)));
+    }
+    else if (cp < 0x10000)
+    {
+        appendValue((char)(0xE0 | (cp >> 12)));
+        appendValue((char)(0x80 | ((cp >> 6) & 0x3F)));
+        appendValue((char)(0x80 | (cp & 0x3F)));
+    }
+    else
+    {
+        appendValue((char)(0xF0 | (cp >> 18)));
+        appendValue((char)(0x80 | ((cp >> 12) & 0x3F)));
+        appendValue((char)(0x80 | ((cp >> 6) & 0x3F)));
+        appendValue((char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+void JsonScanner::emitValue(JsonValueType type)
+{
+    value[valueLen] = '\0';
+
+    // オブジェクトのメンバーだけを通知
+    if (handler != nullptr && depth >= 1 && depth <= JSON_MAX_DEPTH && isObject[depth])
+    {
+        handler(ctx, keys[depth - 1], keys[depth], type, value, valueTruncated);
+    }
+    state = (depth == 0) ? STATE_DONE : STATE_AFTER_VALUE;
+}
+
+// 数値・true/false/null を読み終えて通知する
+// 戻り値: 正しい値=true
+bool JsonScanner::endScalar()
+{
+    value[valueLen] = '\0';
+    if (strcmp(value, "true") == 0 || strcmp(value, "false") == 0)
+        emitValue(JSON_BOOL);
+    else if (strcmp(value, "null") == 0)
+        emitValue(JSON_NULL);
+    else if (value[0] == '-' || (value[0] >= '0' && value[0] <= '9'))
+        emitValue(JSON_NUMBER);
+    else
+        return false;
+    return true;
+}
+
+bool JsonScanner::step(char c)
+{
+    switch (state)
+    {
+    case STATE_VALUE:
+        if (isWhitespace(c))
+            return true;
+        if ((c == '{' || c == '[') && depth >= depthLimit)
+        {
+            skipDepth = 1;
+            skipInString = false;
+            skipEscape = false;
+            state = STATE_SKIP;
+            return true;
+        }
+        if (c == '{')
+        {
+            openContainer(true);
+            state = STATE_KEY;
+            return true;
+        }
+        if (c == '[')
+        {
+            openContainer(false);
+            state = STATE_VALUE;
+            return true;
+        }
+        if (c == ']')
+            return closeContainer(false); // 空配列
+        if (c == '"')
+        {
+            readingKey = false;
+            escape = false;
+            unicodeDigits = 0;
+            highSurrogate = 0;
+            valueLen = 0;
+            valueTruncated = false;
+            state = STATE_STRING;
+            return true;
+        }
+        if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n')
+        {
+            valueLen = 0;
+            valueTruncated = false;
+            appendValue(c);
+            state = STATE_SCALAR;
+            return true;
+        }
+        return false;
+
+    case STATE_KEY:
+        if (isWhitespace(c))
+            return true;
+        if (c == '"')
+        {
+            readingKey = true;
+            escape = false;
+            unicodeDigits = 0;
+            highSurrogate = 0;
+            valueLen = 0;
+            valueTruncated = false;
+            state = STATE_STRING;
+            return true;
+        }
+        if (c == '}')
+            return closeContainer(true);
+        return false;
+
+    case STATE_COLON:
+        if (isWhitespace(c))
+            return true;
+        if (c == ':')
+        {
+            state = STATE_VALUE;
+            return true;
+        }
+        return false;
+
+    case STATE_AFTER_VALUE:
+        if (isWhitespace(c))
+            return true;
+        if (c == ',')
+        {
+            bool inObject = depth > JSON_MAX_DEPTH || isObject[depth];
+            state = inObject ? STATE_KEY : STATE_VALUE;
+            return true;
+        }
+        if (c == '}')
+            return closeContainer(true);
+        if (c == ']')
+            return closeContainer(false);
+        return false;
+
+    case STATE_STRING:
+        if (unicodeDigits > 0)
+        {
+            int h = hexValue(c);
+            if (h < 0)
+                return false;
+            unicodeValue = (uint16_t)((unicodeValue << 4) | h);
+            if (--unicodeDigits == 0)
+                appendCodepoint(unicodeValue);
+            return true;
+        }
+        if (escape)
+        {
+            escape = false;
+            switch (c)
+            {
+            case 'n': appendValue('\n'); break;
+            case 't': appendValue('\t'); break;
+            case 'r': appendValue('\r'); break;
+            case 'b': appendValue('\b'); break;
+            case 'f': appendValue('\f'); break;
+            case 'u': unicodeDigits = 4; unicodeValue = 0; break;
+            default: appendValue(c); break;
+            }
+            return true;
+        }
+        if (c == '\\')
+        {
+            escape = true;
+            return true;
+        }
+        if (highSurrogate != 0)
+        {
+            // 後半のないサロゲート
+            highSurrogate = 0;
+            appendValue('?');
+        }
+        if (c == '"')
+        {
+            if (readingKey)
+            {
+                if (depth >= 1 && depth <= JSON_MAX_DEPTH)
+                {
+                    // 長すぎるキーはどのフィールドにも一致させない
+                    size_t n = (valueTruncated || valueLen >= JSON_KEY_MAX) ? 0 : valueLen;
+                    memcpy(keys[depth], value, n);
+                    keys[depth][n] = '\0';
+                }
+                state = STATE_COLON;
+            }
+            else
+            {
+                emitValue(JSON_STRING);
+            }
+            return true;
+        }
+        appendValue(c);
+        return true;
+
+    case STATE_SCALAR:
+    case STATE_SKIP:
+        return false; // feed が scanScalar / skipNested で読む
+
+    case STATE_DONE:
+        return isWhitespace(c);
+
+    case STATE_ERROR:
+        return false;
+    }
+    return false;
+}
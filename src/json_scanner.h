@@ -0,0 +1,117 @@
+#ifndef JSON_SCANNER_H
+#define JSON_SCANNER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ネストの最大深さ（超えた部分は中身を読まずに飛ばす）
+#define JSON_MAX_DEPTH 8
+
+// キー・値バッファの長さ（終端含む、超えた分は切り捨て）
+// 値はデバイス名（DEVICE_NAME_LEN）より長くしておき、切り捨てた名前を文字の境目で切り直せるようにする
+#define JSON_KEY_MAX 24
+#define JSON_VALUE_MAX 64
+
+// 値の種類
+enum JsonValueType
+{
+    JSON_STRING,
+    JSON_NUMBER,
+    JSON_BOOL,
+    JSON_NULL
+};
+
+// スカラー値の通知
+// parentKey: 値を含むオブジェクトのキー（ルートオブジェクトなら空文字列）
+// key: 値のキー
+// value: 値の文字列表現（文字列はエスケープ解除済み、truncated なら切り捨てあり）
+typedef void (*JsonValueHandler)(void *ctx, const char *parentKey, const char *key,
+                                 JsonValueType type, const char *value, bool truncated);
+
+// オブジェクトの終わりの通知（配列要素のオブジェクトを1件ずつ確定させるのに使う）
+// parentKey: 閉じたオブジェクトのキー（配列要素なら配列のキー、ルートオブジェクトなら空文字列）
+typedef void (*JsonObjectEndHandler)(void *ctx, const char *parentKey);
+
+// インクリメンタルなJSONトークナイザ
+// 入力はチャンク単位で渡せる（チャンク境界はどこでもよい）。ヒープは使わない。
+// オブジェクトのメンバーであるスカラー値だけを通知し、配列要素は読み飛ばす。
+// 文字列の \uXXXX（サロゲートペアを含む）は UTF-8 に変換する。
+// 文字列の中身は memchr で '"' と '\\' までまとめて写し、読む深さより深い入れ子は括弧と文字列の境目だけを数えて飛ばす。
+class JsonScanner
+{
+public:
+    JsonScanner(JsonValueHandler handler, void *ctx);
+
+    // オブジェクトの終わりの通知先を設定（nullptr なら通知しない）
+    void setObjectEndHandler(JsonObjectEndHandler handler) { objectEndHandler = handler; }
+
+    // 読む深さを設定（1〜JSON_MAX_DEPTH、ルートオブジェクトの中が1）
+    // これより深い入れ子は値もオブジェクトの終わりも通知せず、括弧の対応も確かめずに飛ばす
+    void setDepthLimit(int limit);
+
+    // 残りを読まずに止める（以降の feed は何もしない、finished() は true）
+    void stop() { stopped = true; }
+
+    // 状態を初期化
+    void reset();
+
+    // チャンクを投入
+    // 戻り値: 処理を続けられる=true, 構文エラー=false
+    bool feed(const char *data, size_t len);
+
+    // 構文エラーが発生したか
+    bool failed() const { return state == STATE_ERROR; }
+
+    // ルートの値を読み終えたか
+    bool finished() const { return state == STATE_DONE || stopped; }
+
+private:
+    enum State
+    {
+        STATE_VALUE,       // 値を待っている
+        STATE_KEY,         // キー（または '}'）を待っている
+        STATE_COLON,       // ':' を待っている
+        STATE_AFTER_VALUE, // ',' または閉じ括弧を待っている
+        STATE_STRING,      // 文字列の途中
+        STATE_SCALAR,      // 数値・true/false/null の途中
+        STATE_SKIP,        // 読む深さより深い入れ子を飛ばしている途中
+        STATE_DONE,
+        STATE_ERROR
+    };
+
+    bool step(char c);
+    const char *scanString(const char *p, const char *end);
+    const char *scanScalar(const char *p, const char *end);
+    bool endScalar();
+    const char *skipNested(const char *p, const char *end);
+    void openContainer(bool isObject);
+    bool closeContainer(bool isObject);
+    void appendValue(char c);
+    void appendCodepoint(uint32_t cp);
+    void emitValue(JsonValueType type);
+
+    JsonValueHandler handler;
+    JsonObjectEndHandler objectEndHandler;
+    void *ctx;
+
+    State state;
+    bool stopped;
+    int depthLimit;              // 読む深さ
+    int depth;                   // 現在のネスト深さ（ルートオブジェクトの中が1）
+    uint8_t isObject[JSON_MAX_DEPTH + 1];
+    char keys[JSON_MAX_DEPTH + 1][JSON_KEY_MAX]; // 各深さで最後に読んだキー
+
+    bool readingKey;  // 文字列がキーかどうか
+    bool escape;      // 直前がバックスラッシュ
+    uint8_t unicodeDigits;  // \uXXXX の残り桁数
+    uint16_t unicodeValue;  // 読み途中の \uXXXX
+    uint16_t highSurrogate; // サロゲートペアの前半（なければ0）
+    int skipDepth;       // 飛ばしている入れ子の深さ
+    bool skipInString;   // 飛ばしている入れ子の文字列の中か
+    bool skipEscape;     // 飛ばしている文字列で直前がバックスラッシュ
+    char value[JSON_VALUE_MAX];
+    size_t valueLen;
+    bool valueTruncated;
+};
+
+#endif // JSON_SCANNER_H
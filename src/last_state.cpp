@@ -0,0 +1,161 @@
+#include "last_state.h"
+#include "crc32.h"
+#include "device_registry.h"
+#include "state_cache.h"
+#include "hal/hal_clock.h"
+#include "hal/hal_storage.h"
+
+#include <string.h>
+#include <time.h>
+
+// 保存形式（リトルエンディアン）
+//   ヘッダー: magic "SBLS" / version u16 / 電球の数 u16 / 保存時刻 u32 / 以降の CRC32 u32
+//   温湿度計: IDの長さ u8 / ID / 有効 u8 / 温度×10 i16 / 湿度 u8
+//   電球: IDの長さ u8 / ID / 電源 u8 / 明るさ u8
+#define STATE_MAGIC "SBLS"
+#define STATE_HEADER_SIZE 16
+#define STATE_METER_MAX (1 + DEVICE_ID_LEN + 4)
+#define STATE_BULB_MAX (1 + DEVICE_ID_LEN + 2)
+#define STATE_MAX (STATE_HEADER_SIZE + STATE_METER_MAX + REGISTRY_MAX_BULBS * STATE_BULB_MAX)
+
+static uint8_t buffer[STATE_MAX];
+static uint32_t savedCrc = 0;
+static uint32_t savedAt = 0;
+static unsigned long lastSaveTime = 0;
+static bool saved = false;
+
+// IDを書き込む（戻り値: 書いた後の位置）
+static uint8_t *putId(uint8_t *p, const char *id)
+{
+    size_t len = strlen(id);
+    *p++ = (uint8_t)len;
+    memcpy(p, id, len);
+    return p + len;
+}
+
+// IDを読む（戻り値: 読んだ後の位置、範囲外・長すぎる場合 nullptr）
+static const uint8_t *getId(const uint8_t *p, const uint8_t *end, char *id)
+{
+    if (p >= end)
+        return nullptr;
+    size_t len = *p++;
+    if (len >= DEVICE_ID_LEN || (size_t)(end - p) < len)
+        return nullptr;
+    memcpy(id, p, len);
+    id[len] = '\0';
+    return p + len;
+}
+
+// 現在の状態を buffer に書き込む（戻り値: バイト数）
+static size_t encodeState()
+{
+    uint8_t *p = buffer + STATE_HEADER_SIZE;
+
+    p = putId(p, meter.deviceId);
+    int16_t temperature = (int16_t)lroundf(meter.temperature * 10.0f);
+    *p++ = meter.valid ? 1 : 0;
+    *p++ = (uint8_t)temperature;
+    *p++ = (uint8_t)((uint16_t)temperature >> 8);
+    *p++ = (uint8_t)constrain(meter.humidity, 0, 100);
+
+    for (int i = 0; i < bulbs.count; i++)
+    {
+        p = putId(p, bulbs.deviceId[i]);
+        *p++ = bulbs.powerState[i] ? 1 : 0;
+        *p++ = bulbs.brightness[i];
+    }
+
+    size_t len = p - buffer;
+    memcpy(buffer, STATE_MAGIC, 4);
+    buffer[4] = (uint8_t)LAST_STATE_VERSION;
+    buffer[5] = (uint8_t)(LAST_STATE_VERSION >> 8);
+    buffer[6] = (uint8_t)bulbs.count;
+    buffer[7] = (uint8_t)(bulbs.count >> 8);
+    putU32(buffer + 12, crc32(buffer + STATE_HEADER_SIZE, len - STATE_HEADER_SIZE));
+    return len;
+}
+
+int lastStateRestore()
+{
+    size_t len = 0;
+    if (!halStorageRead(LAST_STATE_NAME, buffer, sizeof(buffer), &len))
+        return 0;
+    if (len < STATE_HEADER_SIZE || memcmp(buffer, STATE_MAGIC, 4) != 0 ||
+        (buffer[4] | (buffer[5] << 8)) != LAST_STATE_VERSION ||
+        crc32(buffer + STATE_HEADER_SIZE, len - STATE_HEADER_SIZE) != getU32(buffer + 12))
+    {
+        Serial.println("Last state: invalid, ignored");
+        return 0;
+    }
+
+    int count = buffer[6] | (buffer[7] << 8);
+    const uint8_t *p = buffer + STATE_HEADER_SIZE;
+    const uint8_t *end = buffer + len;
+    char id[DEVICE_ID_LEN];
+
+    p = getId(p, end, id);
+    if (p == nullptr || end - p < 4)
+        return 0;
+    if (strcmp(id, meter.deviceId) == 0 && p[0] != 0)
+    {
+        meter.valid = true;
+        meter.temperature = (int16_t)(p[1] | (p[2] << 8)) / 10.0f;
+        meter.humidity = p[3];
+    }
+    p += 4;
+
+    // 登録簿にない電球（一覧から外れた）は読み飛ばす
+    int restored = 0;
+    for (int i = 0; i < count; i++)
+    {
+        p = getId(p, end, id);
+        if (p == nullptr || end - p < 2)
+            break;
+        int index = registryFindBulb(id);
+        if (index >= 0)
+        {
+            bulbs.powerState[index] = p[0] != 0;
+            bulbs.brightness[index] = constrain(p[1], 1, 100);
+            stateCacheNoteRestored(index);
+            restored++;
+        }
+        p += 2;
+    }
+
+    // 同じ内容を保存し直さないよう CRC を覚えておく（戻さなかった電球があれば次の保存で書き直される）
+    savedCrc = getU32(buffer + 12);
+    savedAt = getU32(buffer + 8);
+    saved = true;
+    return restored;
+}
+
+uint32_t lastStateSavedAt()
+{
+    return savedAt;
+}
+
+bool lastStateSave(bool force)
+{
+    unsigned long now = millis();
+    if (!force && saved && now - lastSaveTime < LAST_STATE_SAVE_INTERVAL_MS)
+        return false;
+
+    size_t len = encodeState();
+    uint32_t crc = getU32(buffer + 12);
+    if (saved && crc == savedCrc)
+        return false;
+
+    // 保存時刻は CRC の範囲外（時刻だけが変わっても書き直さない）
+    time_t epoch = time(nullptr);
+    putU32(buffer + 8, epoch >= EPOCH_VALID ? (uint32_t)epoch : 0);
+    lastSaveTime = now;
+    if (!halStorageWrite(LAST_STATE_NAME, buffer, len))
+    {
+        Serial.println("Last state: save failed");
+        return false;
+    }
+    savedCrc = crc;
+    savedAt = getU32(buffer + 8);
+    saved = true;
+    return true;
+}
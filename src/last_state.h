@@ -0,0 +1,24 @@
+#ifndef LAST_STATE_H
+#define LAST_STATE_H
+
+#include <Arduino.h>
+
+// 最後に表示していた電球・温湿度計の状態（フラッシュに保存し、起動直後の表示に使う）
+#define LAST_STATE_NAME "state.bin"
+#define LAST_STATE_VERSION 1
+
+// 内容が変わっていれば保存する最短の間隔（フラッシュの書き込み回数を抑える）
+#define LAST_STATE_SAVE_INTERVAL_MS 300000
+
+// 保存済みの状態を登録簿に戻す（デバイスIDで照合、登録簿を作った後に呼ぶ）
+// 戻り値: 状態を戻した電球の数（保存がなければ 0）
+int lastStateRestore();
+
+// 保存した時刻（UNIX時刻、時刻同期前に保存した・保存がなければ 0）
+uint32_t lastStateSavedAt();
+
+// 内容が変わっていれば保存（force=false なら LAST_STATE_SAVE_INTERVAL_MS に1回まで）
+// 戻り値: 書き込んだ=true
+bool lastStateSave(bool force);
+
+#endif // LAST_STATE_H
@@ -0,0 +1,204 @@
+#include "loop_profiler.h"
+
+#include <Arduino.h>
+#include <algorithm>
+#include "hal/hal_clock.h"
+
+// 区分の入れ子の最大深さ
+#define PROFILE_MAX_DEPTH 4
+
+// 入れ子の1段分
+struct SectionFrame
+{
+    ProfileSection section;
+    uint32_t startUs;
+    uint32_t childUs; // 内側の区分で使った時間
+};
+
+static const char *const sectionNames[PROFILE_SECTION_COUNT] = {"touch", "render", "network", "battery", "other"};
+
+// 現在のループ
+static uint32_t loopStartUs = 0;
+static bool inLoop = false;
+static uint32_t sectionUs[PROFILE_SECTION_COUNT];
+static SectionFrame stack[PROFILE_MAX_DEPTH];
+static int depth = 0;
+
+// リングバッファ
+static uint32_t loopRing[PROFILE_LOOP_RING];
+static uint32_t inputRing[PROFILE_INPUT_RING];
+
+// 表示待ちの入力
+static uint32_t pendingInputUs = 0; // タッチを読み取った時刻
+static bool inputPending = false;
+
+static LoopProfile profile = {};
+
+void profilerLoopBegin()
+{
+    loopStartUs = halMicros();
+    inLoop = true;
+    depth = 0;
+    memset(sectionUs, 0, sizeof(sectionUs));
+}
+
+void profilerLoopEnd()
+{
+    if (!inLoop)
+        return;
+    inLoop = false;
+
+    uint32_t totalUs = halMicros() - loopStartUs;
+
+    // 区分に入らなかった時間は「その他」
+    uint32_t accounted = 0;
+    for (int i = 0; i < PROFILE_SECTION_COUNT; i++)
+        accounted += sectionUs[i];
+    if (totalUs > accounted)
+        sectionUs[PROFILE_OTHER] += totalUs - accounted;
+
+    loopRing[profile.loops % PROFILE_LOOP_RING] = totalUs;
+    profile.loops++;
+
+    if (totalUs > PROFILE_SLOW_LOOP_US)
+    {
+        // 一番時間を使った区分を主因とする
+        int cause = 0;
+        for (int i = 1; i < PROFILE_SECTION_COUNT; i++)
+        {
+            if (sectionUs[i] > sectionUs[cause])
+                cause = i;
+        }
+        profile.slowLoops++;
+        profile.slowByCause[cause]++;
+    }
+
+    if (totalUs > profile.stallUs)
+    {
+        profile.stallUs = totalUs;
+        profile.stallAtMs = halMillis();
+        memcpy(profile.stallSectionUs, sectionUs, sizeof(sectionUs));
+    }
+}
+
+void profilerEnter(ProfileSection section)
+{
+    if (depth >= PROFILE_MAX_DEPTH)
+    {
+        depth++; // 深すぎる分は外側の区分に含める
+        return;
+    }
+    stack[depth].section = section;
+    stack[depth].startUs = halMicros();
+    stack[depth].childUs = 0;
+    depth++;
+}
+
+void profilerLeave()
+{
+    if (depth <= 0)
+        return;
+    depth--;
+    if (depth >= PROFILE_MAX_DEPTH)
+        return;
+
+    SectionFrame &frame = stack[depth];
+    uint32_t elapsed = halMicros() - frame.startUs;
+    uint32_t self = elapsed > frame.childUs ? elapsed - frame.childUs : 0;
+    if (inLoop)
+        sectionUs[frame.section] += self;
+    if (depth > 0)
+        stack[depth - 1].childUs += elapsed;
+}
+
+void profilerNoteInput(uint32_t sampleUs)
+{
+    // 表示前に次の入力が来たら古い方（長い方）を残す
+    if (!inputPending)
+    {
+        pendingInputUs = sampleUs;
+        inputPending = true;
+    }
+}
+
+void profilerNotePresent()
+{
+    if (!inputPending)
+        return;
+    inputPending = false;
+
+    uint32_t latency = halMicros() - pendingInputUs;
+    inputRing[profile.inputs % PROFILE_INPUT_RING] = latency;
+    profile.inputs++;
+}
+
+// リングバッファの p50/p95/max
+static void ringPercentiles(const uint32_t *ring, int size, uint32_t count, uint32_t &p50, uint32_t &p95,
+                            uint32_t &maxUs)
+{
+    static uint32_t sorted[PROFILE_LOOP_RING];
+    int n = (int)min(count, (uint32_t)size);
+    if (n == 0)
+    {
+        p50 = p95 = maxUs = 0;
+        return;
+    }
+    memcpy(sorted, ring, n * sizeof(uint32_t));
+    std::sort(sorted, sorted + n);
+    p50 = sorted[(n - 1) * 50 / 100];
+    p95 = sorted[(n - 1) * 95 / 100];
+    maxUs = sorted[n - 1];
+}
+
+LoopProfile profilerGetSummary()
+{
+    LoopProfile summary = profile;
+    ringPercentiles(loopRing, PROFILE_LOOP_RING, profile.loops, summary.loopP50Us, summary.loopP95Us,
+                    summary.loopMaxUs);
+    ringPercentiles(inputRing, PROFILE_INPUT_RING, profile.inputs, summary.inputP50Us, summary.inputP95Us,
+                    summary.inputMaxUs);
+    return summary;
+}
+
+void profilerReset()
+{
+    memset(&profile, 0, sizeof(profile));
+    inputPending = false;
+}
+
+void profilerPrint()
+{
+    LoopProfile p = profilerGetSummary();
+
+    Serial.printf("loop n=%lu p50/p95/max=%.1f/%.1f/%.1fms slow=%lu\n", (unsigned long)p.loops,
+                  p.loopP50Us / 1000.0f, p.loopP95Us / 1000.0f, p.loopMaxUs / 1000.0f, (unsigned long)p.slowLoops);
+    if (p.slowLoops > 0)
+    {
+        Serial.print("loop slow by cause:");
+        for (int i = 0; i < PROFILE_SECTION_COUNT; i++)
+        {
+            if (p.slowByCause[i] > 0)
+                Serial.printf(" %s=%lu", sectionNames[i], (unsigned long)p.slowByCause[i]);
+        }
+        Serial.println();
+    }
+    Serial.printf("input n=%lu touch-to-pixel p50/p95/max=%.1f/%.1f/%.1fms\n", (unsigned long)p.inputs,
+                  p.inputP50Us / 1000.0f, p.inputP95Us / 1000.0f, p.inputMaxUs / 1000.0f);
+
+    if (p.stallUs > 0)
+    {
+        int cause = 0;
+        for (int i = 1; i < PROFILE_SECTION_COUNT; i++)
+        {
+            if (p.stallSectionUs[i] > p.stallSectionUs[cause])
+                cause = i;
+        }
+        Serial.printf("stall %.1fms at %lums cause=%s:", p.stallUs / 1000.0f, (unsigned long)p.stallAtMs,
+                      sectionNames[cause]);
+        for (int i = 0; i < PROFILE_SECTION_COUNT; i++)
+        {
+            Serial.printf(" %s=%.1f", sectionNames[i], p.stallSectionUs[i] / 1000.0f);
+        }
+        Serial.println();
+    }
+}
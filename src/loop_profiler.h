@@ -0,0 +1,64 @@
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <stdint.h>
+
+// ループ時間を保持する件数（リングバッファ）
+#define PROFILE_LOOP_RING 256
+
+// 入力遅延を保持する件数（リングバッファ）
+#define PROFILE_INPUT_RING 64
+
+// この時間を超えたループを「遅いフレーム」として数える（30fps相当）
+#define PROFILE_SLOW_LOOP_US 33000
+
+// ループ内の処理区分（停止の原因として報告する）
+enum ProfileSection
+{
+    PROFILE_TOUCH,   // タッチ読み取り
+    PROFILE_RENDER,  // 描画・転送
+    PROFILE_NETWORK, // API完了通知の処理・コマンド投入
+    PROFILE_BATTERY, // バッテリー読み取り
+    PROFILE_OTHER,   // 区分外（ログ出力など）
+    PROFILE_SECTION_COUNT
+};
+
+// 集計結果
+struct LoopProfile
+{
+    uint32_t loops;                              // 計測したループ数
+    uint32_t slowLoops;                          // PROFILE_SLOW_LOOP_US を超えたループ数
+    uint32_t slowByCause[PROFILE_SECTION_COUNT]; // 遅いループの主因ごとの件数
+    uint32_t loopP50Us;                          // 直近 PROFILE_LOOP_RING 件のループ時間
+    uint32_t loopP95Us;
+    uint32_t loopMaxUs;
+    uint32_t inputs;                             // 計測した入力数
+    uint32_t inputP50Us;                         // 直近 PROFILE_INPUT_RING 件のタッチ→表示遅延
+    uint32_t inputP95Us;
+    uint32_t inputMaxUs;
+    uint32_t stallUs;                            // 最長ループの時間
+    uint32_t stallAtMs;                          // 最長ループの発生時刻（millis）
+    uint32_t stallSectionUs[PROFILE_SECTION_COUNT]; // 最長ループの区分ごとの内訳
+};
+
+// ループの開始・終了（loop() の処理部分を囲む。delay は含めない）
+void profilerLoopBegin();
+void profilerLoopEnd();
+
+// 区分の開始・終了（入れ子にでき、内側の時間は外側から差し引く）
+void profilerEnter(ProfileSection section);
+void profilerLeave();
+
+// タッチ入力で表示を更新した（sampleUs: タッチを読み取った時刻）
+void profilerNoteInput(uint32_t sampleUs);
+
+// 表示への転送が完了した（保留中の入力があれば遅延を記録）
+// 完了は次のループの renderEndFrame で確認するため、ループ間の delay を含む上限値になる
+void profilerNotePresent();
+
+// 集計取得・リセット・シリアル出力（UIスレッドからのみ呼ぶ）
+LoopProfile profilerGetSummary();
+void profilerReset();
+void profilerPrint();
+
+#endif // LOOP_PROFILER_H
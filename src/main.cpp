@@ -1,122 +1,185 @@
 #include <Arduino.h>
 #include <M5Unified.h>
-#include <WiFi.h>
 
-#include "secrets.h"
-#include "devices.h"
+#include "device_registry.h"
+#include "device_discovery.h"
+#include "last_state.h"
+#include "meter_history.h"
+#include "state_cache.h"
+#include "poll_policy.h"
+#include "webhook.h"
+#include "boot.h"
 #include "switchbot_api.h"
+#include "api_connection.h"
+#include "api_worker.h"
+#include "api_metrics.h"
+#include "loop_profiler.h"
+#include "api_quota.h"
+#include "command_coalescer.h"
+#include "command_log.h"
 #include "ui.h"
+#include "ui_render.h"
+#include "gesture.h"
+#include "event_loop.h"
 
-// Tab5 WiFi SDIO2 ピン設定
-// ESP32-P4とESP32-C6間のSDIO通信用
-#define TAB5_SDIO_CLK  12
-#define TAB5_SDIO_CMD  13
-#define TAB5_SDIO_D0   11
-#define TAB5_SDIO_D1   10
-#define TAB5_SDIO_D2   9
-#define TAB5_SDIO_D3   8
-#define TAB5_C6_RST    15
-
-// WiFi接続中の表示
-void showConnecting() {
-    M5.Display.fillScreen(TFT_BLACK);
-    M5.Display.setTextColor(TFT_WHITE);
-    M5.Display.setTextSize(3);
-    M5.Display.setTextDatum(MC_DATUM);
-    M5.Display.drawString("Connecting to WiFi...", M5.Display.width() / 2, M5.Display.height() / 2);
+// 温湿度更新間隔（ミリ秒、呼び出し回数の割り当てが厳しいときは引き延ばす）
+// Webhook のイベントが届いている間は WEBHOOK_SAFETY_INTERVAL_MS ごとの確認だけにする
+// 減光中・バッテリー残量が少ないときはポリシー（poll_policy.h）の倍率で延ばす
+#define METER_UPDATE_INTERVAL 60000
+static unsigned long lastMeterUpdate = 0;
+
+// 温湿度計ステータス取得完了（UIスレッドで呼ばれる）
+static void onMeterStatus(const ApiResult& result) {
+    if (!result.success) return;
+
+    meter.temperature = result.temperature;
+    meter.humidity = result.humidity;
+    meter.valid = true;
+    uiUpdateMeter();
 }
 
-// WiFi接続エラー表示
-void showWiFiError() {
-    M5.Display.fillScreen(TFT_RED);
-    M5.Display.setTextColor(TFT_WHITE);
-    M5.Display.setTextSize(2);
-    M5.Display.setTextDatum(MC_DATUM);
-    M5.Display.drawString("WiFi Connection Failed", M5.Display.width() / 2, M5.Display.height() / 2 - 30);
-    M5.Display.drawString("Check SSID and Password", M5.Display.width() / 2, M5.Display.height() / 2 + 30);
+// オンラインになったとき（UIスレッド、再接続のたびに呼ばれる）
+// 前回の状態で表示していた温湿度・電球の状態を API から取り直し、デバイス一覧を確かめる
+static void onOnline() {
+    webhookBegin();
+    lastMeterUpdate = millis();
+    apiWorkerSubmit(API_JOB_METER_STATUS, meter.deviceId, 0, 0, onMeterStatus);
+    uiRefreshVisibleBulbStatus();
+    discoveryRevalidate();
 }
 
 void setup() {
     auto cfg = M5.config();
     M5.begin(cfg);
+    eventLoopInit();
 
     Serial.begin(115200);
     Serial.println("M5Stack Tab5 SwitchBot Bulb Controller");
 
-    // WiFi接続
-    showConnecting();
+    // 前回保存したデバイス一覧（なければ devices.h の設定）をデバイス登録簿に読み込み、
+    // 最後に表示していた電球・温湿度計の状態を戻す
+    discoveryInit();
+    bootNoteRestored(lastStateRestore());
 
-    // Tab5用SDIOピン設定（ESP32-C6との通信用）
-    // arduino-esp32 3.2.1以上でWiFi.setPins()が利用可能
-    WiFi.setPins(TAB5_SDIO_CLK, TAB5_SDIO_CMD, TAB5_SDIO_D0, TAB5_SDIO_D1, TAB5_SDIO_D2, TAB5_SDIO_D3, TAB5_C6_RST);
-    WiFi.begin(WIFI_SSID, WIFI_PASS);
+    // 送り終えていなかった電球コマンド（オンラインになってから古い順に送る）
+    coalescerRestore();
 
-    int retryCount = 0;
-    const int maxRetries = 30;  // 30秒タイムアウト
-
-    while (WiFi.status() != WL_CONNECTED && retryCount < maxRetries) {
-        delay(1000);
-        retryCount++;
-        Serial.printf("Connecting... (%d/%d)\n", retryCount, maxRetries);
-
-        // 接続中のドット表示
-        M5.Display.print(".");
-    }
+    // 温湿度の履歴（PSRAM に確保し、保存した直近の分を戻す）
+    if (meterHistoryInit()) meterHistoryRestore();
 
-    if (WiFi.status() != WL_CONNECTED) {
-        Serial.println("WiFi connection failed");
-        showWiFiError();
-        while (1) {
-            delay(1000);
-        }
-    }
-
-    Serial.println("WiFi connected");
-    Serial.print("IP: ");
-    Serial.println(WiFi.localIP());
-
-    // NTP時刻同期
-    configTime(9 * 3600, 0, "ntp.nict.jp", "pool.ntp.org");
-    Serial.println("Waiting for NTP sync...");
-    struct tm timeinfo;
-    while (!getLocalTime(&timeinfo)) {
-        delay(500);
-        Serial.print(".");
-    }
-    Serial.println("\nNTP synced");
-
-    // SwitchBot API初期化
+    // SwitchBot API初期化（ワーカーはオンラインになるまでジョブを溜める）
     switchbotApiInit();
+    apiQuotaInit(API_QUOTA_DAILY_LIMIT, API_QUOTA_PANELS);
+    apiWorkerInit();
+
+    // WiFi接続・NTP時刻同期はバックグラウンドで進め、待たずに画面を出す
+    bootBegin(onOnline);
 
-    // UI初期化
+    // UI初期化（前回の状態でパネル全体を描画）
     uiInit();
+    renderEndFrame();
+    bootNoteFirstFrame();
+    bootNoteInteractive();
+}
 
-    // 初回の温湿度取得
-    if (switchbotMeterStatus(meter.deviceId, meter.temperature, meter.humidity)) {
-        meter.valid = true;
-        uiUpdateMeter();
-    }
+// コマンドの送信・状態キャッシュの集計を出力する（シリアルの l）
+static void printCommandStats() {
+    CoalesceStats cs = coalescerGetStats();
+    Serial.printf("Commands: intents=%lu sent=%lu skipped=%lu retries=%lu\n",
+                  (unsigned long)cs.intents, (unsigned long)cs.sent, (unsigned long)cs.skipped,
+                  (unsigned long)cs.retries);
+    commandLogPrint();
+    StateCacheStats ss = stateCacheGetStats();
+    Serial.printf("State: optimistic=%lu confirmed=%lu accepted=%lu reconciles=%lu refreshes=%lu fresh=%lu\n",
+                  (unsigned long)ss.optimistic, (unsigned long)ss.confirmed, (unsigned long)ss.accepted,
+                  (unsigned long)ss.reconciles, (unsigned long)ss.refreshes, (unsigned long)ss.fresh);
+}
 
-    // 起動時に全電球の状態を取得
-    uiRefreshAllBulbStatus();
+// 差分描画の集計を出力する（シリアルの p）
+static void printRenderStats() {
+    RenderStats rs = renderGetStats();
+    Serial.printf("Render: frames=%lu last=%lupx peak=%lupx total=%llupx compose=%lu/%luus push=%lu/%luus\n",
+                  (unsigned long)rs.frames, (unsigned long)rs.lastFramePixels,
+                  (unsigned long)rs.peakFramePixels, (unsigned long long)rs.totalPixels,
+                  (unsigned long)rs.lastComposeUs, (unsigned long)rs.peakComposeUs,
+                  (unsigned long)rs.lastPushUs, (unsigned long)rs.peakPushUs);
 }
 
-// 温湿度更新間隔（ミリ秒）
-#define METER_UPDATE_INTERVAL 60000
-static unsigned long lastMeterUpdate = 0;
+// シリアルから1文字コマンドを受け付ける（集計は定期的には出力せず、ここで求められたときだけ出力する）
+// l: 通信レイテンシのヒストグラム・接続の再利用・呼び出し回数の割り当て・Webhook・コマンドの送信・状態キャッシュを出力
+// p: ループ時間・入力遅延・起床回数・ポーリングの方針・タッチ操作・差分描画を出力, r: 集計をリセット
+// h: 温湿度の履歴の使用量・圧縮率を出力, m: ヒープの空き・断片化とリクエストごとの確保の回数を出力
+// 1-9: シーンを実行, A-I: グループをまとめてON/OFF, d: デバイス一覧を取得し直す, b: 起動時間を出力
+static void handleSerialCommand() {
+    while (Serial.available() > 0) {
+        int c = Serial.read();
+        if (c >= '1' && c <= '9') {
+            uiActivateScene(c - '1');
+        } else if (c >= 'A' && c <= 'I') {
+            uiToggleGroup(c - 'A');
+        } else if (c == 'd') {
+            if (!discoveryRevalidate()) Serial.println("Device list: busy");
+        } else if (c == 'b') {
+            bootPrint();
+        } else if (c == 'l') {
+            apiMetricsPrint();
+            apiConnPrintStats();
+            apiQuotaPrint();
+            webhookPrint();
+            printCommandStats();
+        } else if (c == 'h') {
+            meterHistoryPrint();
+        } else if (c == 'm') {
+            apiMetricsPrintHeap();
+        } else if (c == 'p') {
+            profilerPrint();
+            eventLoopPrint();
+            pollPolicyPrint(millis());
+            gesturePrint();
+            printRenderStats();
+        } else if (c == 'r') {
+            apiMetricsReset();
+            profilerReset();
+            eventLoopResetStats();
+            gestureResetStats();
+            Serial.println("Metrics reset");
+        }
+    }
+}
 
 void loop() {
+    profilerLoopBegin();
+    bootService(millis());
     uiUpdate();
+    handleSerialCommand();
 
     // 定期的に温湿度を更新
     unsigned long now = millis();
-    if (now - lastMeterUpdate >= METER_UPDATE_INTERVAL) {
+    uint32_t meterBase = webhookPollInterval(pollPolicyMeterInterval(METER_UPDATE_INTERVAL), now);
+    uint32_t meterInterval = apiQuotaPollInterval(API_POLL_METER, meterBase, 1, apiQuotaNowSec());
+    if (bootPhase() == BOOT_ONLINE && now - lastMeterUpdate >= meterInterval) {
         lastMeterUpdate = now;
-        if (switchbotMeterStatus(meter.deviceId, meter.temperature, meter.humidity)) {
-            meter.valid = true;
-            uiUpdateMeter();
-        }
+        profilerEnter(PROFILE_NETWORK);
+        apiWorkerSubmit(API_JOB_METER_STATUS, meter.deviceId, 0, 0, onMeterStatus);
+        profilerLeave();
+        lastStateSave(false);
+        meterHistoryCheckpoint(false);
     }
 
-    delay(10);  // CPU負荷軽減
+    // 次にループを起こす時刻（接続待ち・温湿度・シリアル、UI の分は uiUpdate で設定済み）
+    now = millis();
+    if (bootPhase() != BOOT_ONLINE) {
+        eventLoopSchedule(LOOP_TIMER_BOOT, now + BOOT_POLL_MS);
+        eventLoopCancel(LOOP_TIMER_METER);
+    } else {
+        // 切断の検出はシリアルと同じ間隔で見る
+        eventLoopSchedule(LOOP_TIMER_BOOT, eventLoopNextPoll(now));
+        eventLoopSchedule(LOOP_TIMER_METER, lastMeterUpdate + meterInterval);
+    }
+    eventLoopSchedule(LOOP_TIMER_SERIAL, eventLoopNextPoll(now));
+
+    profilerLoopEnd();
+
+    // タッチ・API の完了・タイマーのどれかが来るまで CPU を休ませる
+    eventLoopWait();
 }
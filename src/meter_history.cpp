@@ -0,0 +1,726 @@
+#include "meter_history.h"
+#include "crc32.h"
+#include "device_registry.h"
+#include "hal/hal_clock.h"
+#include "hal/hal_storage.h"
+
+#include <string.h>
+
+// 生の記録のブロック（先頭の記録はヘッダーにそのまま、2件目以降を data に詰める）
+//   1バイト: 0tttthhh（時刻の差分の差分が 0、温度の差分 -8〜7、湿度の差分 -4〜3）
+//   それ以外: 0x80 に続けて時刻の差分の差分・温度の差分・湿度の差分（zigzag の可変長整数）
+#define BLOCK_HEADER_SIZE 16
+#define BLOCK_DATA_SIZE (METER_HISTORY_BLOCK_SIZE - BLOCK_HEADER_SIZE)
+#define SAMPLE_ESCAPE 0x80
+#define SAMPLE_MAX_BYTES 16
+
+struct HistoryBlock
+{
+    uint32_t start;   // 最初の記録の時刻
+    uint32_t end;     // 最後の記録の時刻
+    uint16_t count;   // 記録の件数
+    uint16_t used;    // data の使用バイト数
+    int16_t baseTemp; // 最初の記録の温度（℃×10）
+    uint8_t baseHum;  // 最初の記録の湿度
+    uint8_t reserved;
+    uint8_t data[BLOCK_DATA_SIZE];
+};
+
+// 集約（start が区切りの時刻と違えば空き、件数は 0xFFFF で止める）
+struct HistoryRollup
+{
+    uint32_t start;
+    int32_t tempSum;
+    uint32_t humSum;
+    int16_t tempMin;
+    int16_t tempMax;
+    uint8_t humMin;
+    uint8_t humMax;
+    uint16_t count;
+};
+
+// 集約の段（細かい順）
+struct RollupTier
+{
+    uint32_t sec;         // 区切り
+    uint32_t slots;       // 表の大きさ（区切りの数）
+    HistoryRollup *table; // 時刻から直接引く表
+    uint32_t since;       // 記録・復元した最古の区切り（なければ 0）
+};
+
+static_assert(sizeof(HistoryBlock) == METER_HISTORY_BLOCK_SIZE, "HistoryBlock size");
+
+#define ROLLUP_SLOTS (METER_HISTORY_ROLLUP_DAYS * 86400 / METER_HISTORY_ROLLUP_SEC)
+#define HOURLY_SLOTS (METER_HISTORY_HOURLY_DAYS * 86400 / METER_HISTORY_HOURLY_SEC)
+#define DAILY_SLOTS (METER_HISTORY_DAILY_DAYS * 86400 / METER_HISTORY_DAILY_SEC)
+#define TIER_COUNT 3
+#define TIER_DAILY (TIER_COUNT - 1)
+
+// 保存形式（リトルエンディアン、ブロック・集約は構造体のまま）
+//   ヘッダー: magic "SBMH" / version u16 / 10分の集約の数 u16 / ブロックの数 u16 / ブロックの大きさ u16
+//             / 最新の記録の時刻 u32 / 以降の CRC32 u32 / 温湿度計のID（DEVICE_ID_LEN）/ 1日の集約の数 u16
+//   10分の集約（古い順）・1日の集約（古い順）・ブロック（古い順）
+//   1時間の段は保存せず、戻した10分の集約から作り直す
+#define CHECKPOINT_MAGIC "SBMH"
+#define CHECKPOINT_HEADER_SIZE (22 + DEVICE_ID_LEN)
+#define CHECKPOINT_ROLLUPS (METER_HISTORY_CHECKPOINT_DAYS * 86400 / METER_HISTORY_ROLLUP_SEC)
+#define CHECKPOINT_MAX                                                                                                 \
+    (CHECKPOINT_HEADER_SIZE + (CHECKPOINT_ROLLUPS + DAILY_SLOTS) * sizeof(HistoryRollup) +                             \
+     METER_HISTORY_CHECKPOINT_BLOCKS * sizeof(HistoryBlock))
+
+// 確保する領域（ブロック・集約の段・保存用のバッファ）
+#define HISTORY_AREA_BYTES                                                                                             \
+    ((size_t)METER_HISTORY_BLOCKS * sizeof(HistoryBlock) +                                                             \
+     (size_t)(ROLLUP_SLOTS + HOURLY_SLOTS + DAILY_SLOTS) * sizeof(HistoryRollup) + CHECKPOINT_MAX)
+
+static_assert(CHECKPOINT_ROLLUPS <= ROLLUP_SLOTS, "checkpoint rollups exceed the 10-minute tier");
+static_assert(HISTORY_AREA_BYTES <= METER_HISTORY_PSRAM_BUDGET, "history exceeds the PSRAM budget");
+
+// 領域（ブロック・集約・保存用のバッファをまとめて確保）
+static HistoryBlock *blocks = nullptr;
+static uint8_t *checkpointBuffer = nullptr;
+static RollupTier tiers[TIER_COUNT] = {
+    {METER_HISTORY_ROLLUP_SEC, ROLLUP_SLOTS, nullptr, 0},
+    {METER_HISTORY_HOURLY_SEC, HOURLY_SLOTS, nullptr, 0},
+    {METER_HISTORY_DAILY_SEC, DAILY_SLOTS, nullptr, 0},
+};
+
+// リング（head: 最新のブロック、used: 使用中のブロック数）
+static int head = METER_HISTORY_BLOCKS - 1;
+static int used = 0;
+
+// 書き込み中のブロックの最後の記録（open=false なら次の記録から新しいブロック）
+static bool open = false;
+static uint32_t lastEpoch = 0;
+static int32_t lastDelta = 0;
+static int16_t lastTemp = 0;
+static uint8_t lastHum = 0;
+
+static uint32_t version = 0;
+static uint32_t checkpointVersion = 0;
+static unsigned long lastCheckpointTime = 0;
+static bool checkpointed = false;
+static MeterHistoryStats stats = {};
+
+// 可変長整数（zigzag）を書く（戻り値: 書いた後の位置）
+static uint8_t *putVarint(uint8_t *p, int32_t value)
+{
+    uint32_t v = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+    while (v >= 0x80)
+    {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+
+// 可変長整数を読む（戻り値: 読んだ後の位置、end を越える場合 nullptr）
+static const uint8_t *getVarint(const uint8_t *p, const uint8_t *end, int32_t *value)
+{
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (p >= end)
+            return nullptr;
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+        {
+            *value = (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// 1件を詰める（戻り値: バイト数）
+static size_t encodeSample(int32_t dod, int dt, int dh, uint8_t *buf)
+{
+    if (dod == 0 && dt >= -8 && dt <= 7 && dh >= -4 && dh <= 3)
+    {
+        buf[0] = (uint8_t)(((dt & 0x0F) << 3) | (dh & 0x07));
+        return 1;
+    }
+    uint8_t *p = buf;
+    *p++ = SAMPLE_ESCAPE;
+    p = putVarint(p, dod);
+    p = putVarint(p, dt);
+    p = putVarint(p, dh);
+    return p - buf;
+}
+
+// ブロック内の記録を順に読む
+struct HistoryCursor
+{
+    const HistoryBlock *block;
+    uint16_t pos;
+    uint16_t index;
+    uint32_t epoch;
+    int32_t delta;
+    int16_t temp;
+    uint8_t hum;
+};
+
+// 最初の記録を指す
+static void cursorBegin(HistoryCursor &c, const HistoryBlock *block)
+{
+    c.block = block;
+    c.pos = 0;
+    c.index = 0;
+    c.epoch = block->start;
+    c.delta = 0;
+    c.temp = block->baseTemp;
+    c.hum = block->baseHum;
+}
+
+// 次の記録に進む（戻り値: 進めた=true、ブロックの終わり・壊れていれば false）
+static bool cursorNext(HistoryCursor &c)
+{
+    if (c.index + 1 >= c.block->count || c.pos >= c.block->used)
+        return false;
+
+    const uint8_t *p = c.block->data + c.pos;
+    const uint8_t *end = c.block->data + c.block->used;
+    int32_t dod = 0;
+    int32_t dt;
+    int32_t dh;
+    if (*p != SAMPLE_ESCAPE)
+    {
+        // 4ビット・3ビットの符号付きに戻す
+        dt = (int8_t)((*p >> 3) << 4) >> 4;
+        dh = (int8_t)(*p << 5) >> 5;
+        p++;
+    }
+    else
+    {
+        p++;
+        if ((p = getVarint(p, end, &dod)) == nullptr || (p = getVarint(p, end, &dt)) == nullptr ||
+            (p = getVarint(p, end, &dh)) == nullptr)
+            return false;
+    }
+
+    c.delta += dod;
+    c.epoch += c.delta;
+    c.temp += dt;
+    c.hum += dh;
+    c.pos = p - c.block->data;
+    c.index++;
+    return true;
+}
+
+// 時刻順で i 番目（0 が最古）のブロック
+static HistoryBlock &blockAt(int i)
+{
+    return blocks[(head - used + 1 + i + METER_HISTORY_BLOCKS) % METER_HISTORY_BLOCKS];
+}
+
+static HistoryRollup &rollupAt(const RollupTier &tier, uint32_t start)
+{
+    return tier.table[(start / tier.sec) % tier.slots];
+}
+
+// 新しいブロックを始める（満杯なら最古のブロックを上書き）
+static void startBlock(uint32_t epoch, int16_t temp, uint8_t hum)
+{
+    head = (head + 1) % METER_HISTORY_BLOCKS;
+    if (used == METER_HISTORY_BLOCKS)
+        stats.samples -= blocks[head].count;
+    else
+        used++;
+
+    HistoryBlock &b = blocks[head];
+    b.start = epoch;
+    b.end = epoch;
+    b.count = 1;
+    b.used = 0;
+    b.baseTemp = temp;
+    b.baseHum = hum;
+    b.reserved = 0;
+    lastDelta = 0;
+    open = true;
+}
+
+static void appendSample(uint32_t epoch, int16_t temp, uint8_t hum)
+{
+    HistoryBlock &b = blocks[head];
+    uint8_t buf[SAMPLE_MAX_BYTES];
+    int32_t delta = (int32_t)(epoch - lastEpoch);
+    size_t n = 0;
+    if (open)
+        n = encodeSample(delta - lastDelta, temp - lastTemp, hum - lastHum, buf);
+
+    if (!open || b.used + n > BLOCK_DATA_SIZE || b.count == 0xFFFF)
+    {
+        startBlock(epoch, temp, hum);
+    }
+    else
+    {
+        memcpy(b.data + b.used, buf, n);
+        b.used += n;
+        b.count++;
+        b.end = epoch;
+        lastDelta = delta;
+        if (n > 1)
+            stats.escapes++;
+    }
+    lastEpoch = epoch;
+    lastTemp = temp;
+    lastHum = hum;
+    stats.samples++;
+}
+
+// 問い合わせの区間ごとの集計（長い区間では集約の件数を越えるため件数は 32 ビット）
+struct HistoryAccum
+{
+    int32_t tempSum;
+    uint32_t humSum;
+    int16_t tempMin;
+    int16_t tempMax;
+    uint8_t humMin;
+    uint8_t humMax;
+    uint32_t count;
+};
+
+static void accumAdd(HistoryAccum &acc, int32_t tempSum, uint32_t humSum, int16_t tempMin, int16_t tempMax,
+                     uint8_t humMin, uint8_t humMax, uint32_t count)
+{
+    if (acc.count == 0)
+    {
+        acc = {tempSum, humSum, tempMin, tempMax, humMin, humMax, count};
+        return;
+    }
+    acc.tempSum += tempSum;
+    acc.humSum += humSum;
+    acc.tempMin = min(acc.tempMin, tempMin);
+    acc.tempMax = max(acc.tempMax, tempMax);
+    acc.humMin = min(acc.humMin, humMin);
+    acc.humMax = max(acc.humMax, humMax);
+    acc.count += count;
+}
+
+// 段の区切り1つに集約を足す（区切りが古い集約なら置き換える）
+static void mergeRollup(RollupTier &tier, const HistoryRollup &add)
+{
+    uint32_t start = add.start - add.start % tier.sec;
+    if (tier.since == 0 || start < tier.since)
+        tier.since = start;
+
+    HistoryRollup &r = rollupAt(tier, start);
+    if (r.start != start || r.count == 0)
+    {
+        r = add;
+        r.start = start;
+        return;
+    }
+    r.tempSum += add.tempSum;
+    r.humSum += add.humSum;
+    r.tempMin = min(r.tempMin, add.tempMin);
+    r.tempMax = max(r.tempMax, add.tempMax);
+    r.humMin = min(r.humMin, add.humMin);
+    r.humMax = max(r.humMax, add.humMax);
+    r.count = (uint16_t)min((uint32_t)r.count + add.count, (uint32_t)0xFFFF);
+}
+
+static void addRollup(uint32_t epoch, int16_t temp, uint8_t hum)
+{
+    HistoryRollup sample = {epoch, temp, hum, temp, temp, hum, hum, 1};
+    for (RollupTier &tier : tiers)
+        mergeRollup(tier, sample);
+}
+
+// 段に残っている最古の区切り（記録がなければ 0）
+static uint32_t tierOldest(const RollupTier &tier)
+{
+    if (tier.since == 0)
+        return 0;
+    uint32_t newest = lastEpoch - lastEpoch % tier.sec;
+    uint32_t span = (tier.slots - 1) * tier.sec;
+    return newest > tier.since + span ? newest - span : tier.since;
+}
+
+// 問い合わせに使う段（区切りが区間の幅以下で from まで残っている最も細かい段、なければ幅以下の最も粗い段）
+static const RollupTier *tierFor(uint32_t from, uint32_t width)
+{
+    const RollupTier *chosen = nullptr;
+    for (const RollupTier &tier : tiers)
+    {
+        if (width < tier.sec)
+            break;
+        chosen = &tier;
+        uint32_t oldest = tierOldest(tier);
+        if (oldest != 0 && from >= oldest)
+            break;
+    }
+    return chosen;
+}
+
+// 四捨五入した平均
+static int32_t roundedAverage(int32_t sum, uint32_t count)
+{
+    int32_t n = (int32_t)count;
+    return sum >= 0 ? (sum + n / 2) / n : (sum - n / 2) / n;
+}
+
+static void finishBucket(const HistoryAccum &acc, HistoryBucket &out)
+{
+    out = {};
+    if (acc.count == 0)
+        return;
+    out.tempMin = acc.tempMin;
+    out.tempMax = acc.tempMax;
+    out.tempAvg = (int16_t)roundedAverage(acc.tempSum, acc.count);
+    out.humMin = acc.humMin;
+    out.humMax = acc.humMax;
+    out.humAvg = (uint8_t)roundedAverage((int32_t)acc.humSum, acc.count);
+    out.count = acc.count;
+}
+
+// k 番目の区間の始まり
+static uint32_t bucketStart(uint32_t from, uint32_t to, int buckets, int k)
+{
+    return from + (uint32_t)((uint64_t)(to - from) * k / buckets);
+}
+
+// 集約から求める（集約の始まりが区間に入っていれば、その区間に数える）
+static int queryRollups(const RollupTier &tier, uint32_t from, uint32_t to, HistoryBucket *out, int buckets)
+{
+    int filled = 0;
+    for (int k = 0; k < buckets; k++)
+    {
+        uint32_t bFrom = bucketStart(from, to, buckets, k);
+        uint32_t bTo = bucketStart(from, to, buckets, k + 1);
+        uint32_t s = (bFrom + tier.sec - 1) / tier.sec * tier.sec;
+
+        HistoryAccum acc = {};
+        for (; s < bTo; s += tier.sec)
+        {
+            const HistoryRollup &r = rollupAt(tier, s);
+            if (r.start == s && r.count > 0)
+                accumAdd(acc, r.tempSum, r.humSum, r.tempMin, r.tempMax, r.humMin, r.humMax, r.count);
+        }
+        finishBucket(acc, out[k]);
+        if (acc.count > 0)
+            filled++;
+    }
+    return filled;
+}
+
+// 生の記録から求める（from を含むブロックを二分探索し、to までだけ読む）
+static int queryRaw(uint32_t from, uint32_t to, HistoryBucket *out, int buckets)
+{
+    int lo = 0;
+    int hi = used;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (blockAt(mid).end < from)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    int filled = 0;
+    int k = 0;
+    HistoryAccum acc = {};
+    for (int i = lo; i < used && blockAt(i).start < to; i++)
+    {
+        HistoryCursor c;
+        cursorBegin(c, &blockAt(i));
+        do
+        {
+            if (c.epoch < from)
+                continue;
+            if (c.epoch >= to)
+                break;
+            int bucket = (int)((uint64_t)(c.epoch - from) * buckets / (to - from));
+            if (bucket != k)
+            {
+                finishBucket(acc, out[k]);
+                filled += acc.count > 0 ? 1 : 0;
+                for (k++; k < bucket; k++)
+                    out[k] = {};
+                acc = {};
+            }
+            accumAdd(acc, c.temp, c.hum, c.temp, c.temp, c.hum, c.hum, 1);
+        } while (cursorNext(c));
+    }
+    finishBucket(acc, out[k]);
+    filled += acc.count > 0 ? 1 : 0;
+    for (k++; k < buckets; k++)
+        out[k] = {};
+    return filled;
+}
+
+bool meterHistoryInit()
+{
+    if (blocks == nullptr)
+    {
+#ifdef BOARD_HAS_PSRAM
+        uint8_t *area = (uint8_t *)ps_malloc(HISTORY_AREA_BYTES);
+#else
+        uint8_t *area = (uint8_t *)malloc(HISTORY_AREA_BYTES);
+#endif
+        if (area == nullptr)
+        {
+            Serial.printf("History: allocation failed (%lu bytes)\n", (unsigned long)HISTORY_AREA_BYTES);
+            return false;
+        }
+        blocks = (HistoryBlock *)area;
+        uint8_t *p = area + (size_t)METER_HISTORY_BLOCKS * sizeof(HistoryBlock);
+        for (RollupTier &tier : tiers)
+        {
+            tier.table = (HistoryRollup *)p;
+            p += tier.slots * sizeof(HistoryRollup);
+        }
+        checkpointBuffer = p;
+    }
+    meterHistoryClear();
+    return true;
+}
+
+void meterHistoryClear()
+{
+    for (RollupTier &tier : tiers)
+    {
+        if (tier.table != nullptr)
+            memset(tier.table, 0, tier.slots * sizeof(HistoryRollup));
+        tier.since = 0;
+    }
+    head = METER_HISTORY_BLOCKS - 1;
+    used = 0;
+    open = false;
+    lastEpoch = 0;
+    version++;
+    checkpointVersion = version;
+    checkpointed = false;
+    stats = {};
+}
+
+bool meterHistoryAdd(uint32_t epoch, float temperature, int humidity)
+{
+    if (blocks == nullptr || epoch < EPOCH_VALID || epoch < lastEpoch)
+    {
+        stats.rejected++;
+        return false;
+    }
+
+    int16_t temp = (int16_t)lroundf(temperature * 10.0f);
+    uint8_t hum = (uint8_t)constrain(humidity, 0, 100);
+    addRollup(epoch, temp, hum);
+    appendSample(epoch, temp, hum);
+    stats.added++;
+    version++;
+    return true;
+}
+
+int meterHistoryQuery(uint32_t from, uint32_t to, HistoryBucket *out, int buckets)
+{
+    if (buckets <= 0)
+        return 0;
+    if (blocks == nullptr || to <= from)
+    {
+        memset(out, 0, buckets * sizeof(HistoryBucket));
+        return 0;
+    }
+
+    uint32_t startUs = micros();
+    const RollupTier *tier = tierFor(from, (to - from) / buckets);
+    int filled;
+    if (tier != nullptr)
+        filled = queryRollups(*tier, from, to, out, buckets);
+    else
+        filled = queryRaw(from, to, out, buckets);
+
+    stats.queries++;
+    stats.lastQueryUs = micros() - startUs;
+    stats.peakQueryUs = max(stats.peakQueryUs, stats.lastQueryUs);
+    return filled;
+}
+
+int meterHistoryRecentDay(HistoryBucket *out, int columns)
+{
+    if (lastEpoch == 0)
+    {
+        memset(out, 0, columns * sizeof(HistoryBucket));
+        return 0;
+    }
+    uint32_t to = lastEpoch - lastEpoch % METER_HISTORY_ROLLUP_SEC + METER_HISTORY_ROLLUP_SEC;
+    return meterHistoryQuery(to - 86400, to, out, columns);
+}
+
+uint32_t meterHistoryVersion()
+{
+    return version;
+}
+
+// 段の新しい方から count 個の区切りのうち記録のある集約を古い順に書く（戻り値: 書いた数、p は書いた後の位置）
+static int putRollups(const RollupTier &tier, uint32_t count, uint8_t *&p)
+{
+    uint32_t last = lastEpoch - lastEpoch % tier.sec;
+    uint32_t first = last - (count - 1) * tier.sec;
+    int written = 0;
+    for (uint32_t s = first; s <= last; s += tier.sec)
+    {
+        const HistoryRollup &r = rollupAt(tier, s);
+        if (r.start != s || r.count == 0)
+            continue;
+        memcpy(p, &r, sizeof(r));
+        p += sizeof(r);
+        written++;
+    }
+    return written;
+}
+
+bool meterHistoryCheckpoint(bool force)
+{
+    unsigned long now = millis();
+    if (blocks == nullptr || version == checkpointVersion)
+        return false;
+    if (!force && checkpointed && now - lastCheckpointTime < METER_HISTORY_CHECKPOINT_INTERVAL_MS)
+        return false;
+
+    // 直近 METER_HISTORY_CHECKPOINT_DAYS 日の10分の集約・残っている1日の集約と、新しい方のブロック
+    uint8_t *p = checkpointBuffer + CHECKPOINT_HEADER_SIZE;
+    int rollupCount = putRollups(tiers[0], CHECKPOINT_ROLLUPS, p);
+    int dailyCount = putRollups(tiers[TIER_DAILY], DAILY_SLOTS, p);
+    int blockCount = min(used, METER_HISTORY_CHECKPOINT_BLOCKS);
+    for (int i = used - blockCount; i < used; i++)
+    {
+        memcpy(p, &blockAt(i), sizeof(HistoryBlock));
+        p += sizeof(HistoryBlock);
+    }
+
+    size_t len = p - checkpointBuffer;
+    memcpy(checkpointBuffer, CHECKPOINT_MAGIC, 4);
+    putU16(checkpointBuffer + 4, METER_HISTORY_VERSION);
+    putU16(checkpointBuffer + 6, (uint16_t)rollupCount);
+    putU16(checkpointBuffer + 8, (uint16_t)blockCount);
+    putU16(checkpointBuffer + 10, sizeof(HistoryBlock));
+    putU32(checkpointBuffer + 12, lastEpoch);
+    memset(checkpointBuffer + 20, 0, DEVICE_ID_LEN);
+    memcpy(checkpointBuffer + 20, meter.deviceId, strnlen(meter.deviceId, DEVICE_ID_LEN - 1));
+    putU16(checkpointBuffer + 20 + DEVICE_ID_LEN, (uint16_t)dailyCount);
+    putU32(checkpointBuffer + 16, crc32(checkpointBuffer + 20, len - 20));
+
+    lastCheckpointTime = now;
+    checkpointed = true;
+    if (!halStorageWrite(METER_HISTORY_NAME, checkpointBuffer, len))
+    {
+        Serial.println("History: checkpoint failed");
+        return false;
+    }
+    checkpointVersion = version;
+    stats.checkpoints++;
+    stats.checkpointBytes = len;
+    return true;
+}
+
+int meterHistoryRestore()
+{
+    size_t len = 0;
+    if (blocks == nullptr || !halStorageRead(METER_HISTORY_NAME, checkpointBuffer, CHECKPOINT_MAX, &len))
+        return 0;
+
+    size_t rollupCount = len >= CHECKPOINT_HEADER_SIZE ? getU16(checkpointBuffer + 6) : 0;
+    size_t blockCount = len >= CHECKPOINT_HEADER_SIZE ? getU16(checkpointBuffer + 8) : 0;
+    size_t dailyCount = len >= CHECKPOINT_HEADER_SIZE ? getU16(checkpointBuffer + 20 + DEVICE_ID_LEN) : 0;
+    if (len < CHECKPOINT_HEADER_SIZE || memcmp(checkpointBuffer, CHECKPOINT_MAGIC, 4) != 0 ||
+        getU16(checkpointBuffer + 4) != METER_HISTORY_VERSION || getU16(checkpointBuffer + 10) != sizeof(HistoryBlock) ||
+        len != CHECKPOINT_HEADER_SIZE + (rollupCount + dailyCount) * sizeof(HistoryRollup) +
+                   blockCount * sizeof(HistoryBlock) ||
+        crc32(checkpointBuffer + 20, len - 20) != getU32(checkpointBuffer + 16))
+    {
+        Serial.println("History: invalid checkpoint, ignored");
+        return 0;
+    }
+
+    // 別の温湿度計の履歴は使わない
+    char id[DEVICE_ID_LEN];
+    memcpy(id, checkpointBuffer + 20, DEVICE_ID_LEN);
+    id[DEVICE_ID_LEN - 1] = '\0';
+    if (strcmp(id, meter.deviceId) != 0)
+        return 0;
+
+    // 10分の集約は1時間の段にも足す（1時間の段は保存していない）
+    meterHistoryClear();
+    const uint8_t *p = checkpointBuffer + CHECKPOINT_HEADER_SIZE;
+    for (size_t i = 0; i < rollupCount + dailyCount; i++)
+    {
+        HistoryRollup r;
+        memcpy(&r, p, sizeof(r));
+        p += sizeof(r);
+        if (r.count == 0)
+            continue;
+        if (i >= rollupCount)
+        {
+            mergeRollup(tiers[TIER_DAILY], r);
+            continue;
+        }
+        mergeRollup(tiers[0], r);
+        mergeRollup(tiers[1], r);
+    }
+    // 最初の1時間は10分の集約が揃っていないことがあるので、次の区切りから残っているとみなす
+    if (tiers[1].since != 0 && tiers[0].since % METER_HISTORY_HOURLY_SEC != 0)
+        tiers[1].since += METER_HISTORY_HOURLY_SEC;
+
+    // ブロックは閉じたものとして戻す（次の記録から新しいブロック）
+    int restored = 0;
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        head = (head + 1) % METER_HISTORY_BLOCKS;
+        used++;
+        memcpy(&blocks[head], p, sizeof(HistoryBlock));
+        p += sizeof(HistoryBlock);
+        restored += blocks[head].count;
+    }
+    stats.samples = restored;
+    lastEpoch = getU32(checkpointBuffer + 12);
+    checkpointVersion = version;
+    checkpointed = true;
+    lastCheckpointTime = millis();
+    Serial.printf("History: restored %d samples, %u rollups, %u daily\n", restored, (unsigned)rollupCount,
+                  (unsigned)dailyCount);
+    return restored;
+}
+
+MeterHistoryStats meterHistoryGetStats()
+{
+    MeterHistoryStats s = stats;
+    s.blocksUsed = used;
+    s.bytesUsed = 0;
+    for (int i = 0; i < used; i++)
+        s.bytesUsed += BLOCK_HEADER_SIZE + blockAt(i).used;
+    s.oldest = used > 0 ? blockAt(0).start : 0;
+    s.newest = lastEpoch;
+    s.rollupOldest = tierOldest(tiers[TIER_DAILY]);
+    s.areaBytes = blocks != nullptr ? HISTORY_AREA_BYTES : 0;
+    return s;
+}
+
+// 段に残っている日数（最古の区切りから最新の区切りの終わりまで）
+static double tierDays(const RollupTier &tier)
+{
+    uint32_t oldest = tierOldest(tier);
+    if (oldest == 0)
+        return 0.0;
+    return (lastEpoch - lastEpoch % tier.sec + tier.sec - oldest) / 86400.0;
+}
+
+void meterHistoryPrint()
+{
+    MeterHistoryStats s = meterHistoryGetStats();
+    Serial.printf("History: samples=%lu blocks=%lu/%d bytes=%lu (%.2f B/sample, x%.1f) span=%.1fd added=%lu "
+                  "rejected=%lu escapes=%lu\n",
+                  (unsigned long)s.samples, (unsigned long)s.blocksUsed, METER_HISTORY_BLOCKS,
+                  (unsigned long)s.bytesUsed, s.samples > 0 ? (double)s.bytesUsed / s.samples : 0.0,
+                  s.bytesUsed > 0 ? (double)s.samples * METER_HISTORY_RAW_SAMPLE_BYTES / s.bytesUsed : 0.0,
+                  s.samples > 0 ? (s.newest - s.oldest) / 86400.0 : 0.0, (unsigned long)s.added,
+                  (unsigned long)s.rejected, (unsigned long)s.escapes);
+    Serial.printf("History rollups: 10m=%.1fd 1h=%.1fd 1d=%.1fd area=%lu/%d bytes\n", tierDays(tiers[0]),
+                  tierDays(tiers[1]), tierDays(tiers[TIER_DAILY]), (unsigned long)s.areaBytes,
+                  METER_HISTORY_PSRAM_BUDGET);
+    Serial.printf("History queries: count=%lu last=%luus peak=%luus checkpoints=%lu (%lu bytes)\n",
+                  (unsigned long)s.queries, (unsigned long)s.lastQueryUs, (unsigned long)s.peakQueryUs,
+                  (unsigned long)s.checkpoints, (unsigned long)s.checkpointBytes);
+}
@@ -0,0 +1,111 @@
+#ifndef METER_HISTORY_H
+#define METER_HISTORY_H
+
+#include <Arduino.h>
+
+// 温湿度の履歴（実機は PSRAM に確保したリングに圧縮して保持し、一部をフラッシュに保存する）
+//
+// 生の記録: 固定長のブロックに、時刻は差分の差分、温度・湿度は差分で詰める
+//           （1分ごとの変化の小さい記録はほとんどが1バイト）。満杯になると古いブロックから上書き
+// 集約: 10分・1時間・1日ごとの最小・最大・合計・件数（段ごとに時刻から直接引ける固定の表）
+//       古い期間ほど粗い段だけに残り、1年分を PSRAM の予算に収める
+//       24時間の折れ線・長い期間の問い合わせは集約だけで答え、生の記録を読まない
+
+// 生の記録のブロック（大きさ・数、既定で 256KB、1分ごとの記録で約4か月分）
+#define METER_HISTORY_BLOCK_SIZE 256
+#ifndef METER_HISTORY_BLOCKS
+#define METER_HISTORY_BLOCKS 1024
+#endif
+
+// 集約の段の区切り（秒）と保持する日数（10分は折れ線と保存する7日分、1時間は約3か月、1日は1年分）
+#define METER_HISTORY_ROLLUP_SEC 600
+#define METER_HISTORY_ROLLUP_DAYS 8
+#define METER_HISTORY_HOURLY_SEC 3600
+#define METER_HISTORY_HOURLY_DAYS 92
+#define METER_HISTORY_DAILY_SEC 86400
+#define METER_HISTORY_DAILY_DAYS 370
+
+// 生の記録・集約・保存用のバッファを合わせた PSRAM の予算
+#define METER_HISTORY_PSRAM_BUDGET (384 * 1024)
+
+// フラッシュへの保存（直近の集約と生の記録、前回から記録が増えていれば保存する最短の間隔）
+#define METER_HISTORY_NAME "history.bin"
+#define METER_HISTORY_VERSION 2
+#define METER_HISTORY_CHECKPOINT_DAYS 7
+#define METER_HISTORY_CHECKPOINT_BLOCKS 8
+#ifndef METER_HISTORY_CHECKPOINT_INTERVAL_MS
+#define METER_HISTORY_CHECKPOINT_INTERVAL_MS 3600000
+#endif
+
+// 問い合わせの1区間の結果（温度は ℃×10、count=0 なら記録なし）
+struct HistoryBucket
+{
+    int16_t tempMin;
+    int16_t tempMax;
+    int16_t tempAvg;
+    uint8_t humMin;
+    uint8_t humMax;
+    uint8_t humAvg;
+    uint32_t count;
+};
+
+// 集計
+struct MeterHistoryStats
+{
+    uint32_t samples;     // 生の記録に残っている件数
+    uint32_t added;       // 記録した件数
+    uint32_t rejected;    // 時刻同期前・時刻が戻ったため記録しなかった件数
+    uint32_t escapes;     // 1バイトに収まらなかった記録
+    uint32_t blocksUsed;  // 使用中のブロック
+    uint32_t bytesUsed;   // 生の記録に使ったバイト数
+    uint32_t oldest;      // 生の記録の最古・最新の時刻（UNIX時刻、なければ 0）
+    uint32_t newest;
+    uint32_t rollupOldest; // 集約が残っている最古の時刻（1日の段、なければ 0）
+    uint32_t areaBytes;    // 確保した領域の大きさ
+    uint32_t queries;     // 問い合わせ回数
+    uint32_t lastQueryUs; // 直近の問い合わせの時間
+    uint32_t peakQueryUs; // 問い合わせの時間の最大値
+    uint32_t checkpoints; // フラッシュに保存した回数
+    uint32_t checkpointBytes;
+};
+
+// 1件の記録を詰めずに持った場合の大きさ（時刻 u32 / 温度 i16 / 湿度 u8、圧縮率の基準）
+#define METER_HISTORY_RAW_SAMPLE_BYTES 7
+
+// 領域を確保する（実機は PSRAM、確保できなければ記録しない）
+// 戻り値: 確保できた=true
+bool meterHistoryInit();
+
+// 保存した履歴を戻す（温湿度計のデバイスIDが違えば戻さない、登録簿を作った後に呼ぶ）
+// 戻り値: 戻した生の記録の件数
+int meterHistoryRestore();
+
+// 記録する（epoch: UNIX時刻）
+// 戻り値: 記録した=true（時刻同期前・前の記録より前の時刻なら false）
+bool meterHistoryAdd(uint32_t epoch, float temperature, int humidity);
+
+// [from, to) を buckets 個の区間に分けた最小・最大・平均
+// 区間が METER_HISTORY_ROLLUP_SEC 以上なら集約から、短ければ生の記録から求める
+// 集約は区間の幅以下の区切りで from まで残っている最も細かい段を使う（区切りの始まりが入る区間に数える）
+// 戻り値: 記録のあった区間の数
+int meterHistoryQuery(uint32_t from, uint32_t to, HistoryBucket *out, int buckets);
+
+// 最新の記録までの24時間を columns 個の区間に分けた結果（ヘッダーの折れ線用）
+// 戻り値: 記録のあった区間の数
+int meterHistoryRecentDay(HistoryBucket *out, int columns);
+
+// 記録・復元のたびに増える（描画済みの折れ線が古いかの判定用）
+uint32_t meterHistoryVersion();
+
+// 前回から記録が増えていれば保存（force=false なら METER_HISTORY_CHECKPOINT_INTERVAL_MS に1回まで）
+// 戻り値: 書き込んだ=true
+bool meterHistoryCheckpoint(bool force);
+
+// 記録を全て消す（領域は残す）
+void meterHistoryClear();
+
+// 集計取得・シリアル出力
+MeterHistoryStats meterHistoryGetStats();
+void meterHistoryPrint();
+
+#endif // METER_HISTORY_H
@@ -0,0 +1,228 @@
+#include "poll_policy.h"
+
+// 状態ごとの間隔（PolicyState の順）
+// 減光中の残量の確認は充電の有無・残量が少なくなったことに気づくためだけなので大きく間を空ける
+// （復帰すれば画面オンの間隔ですぐに確認する）
+static const PolicyRates ratesTable[POLICY_STATE_COUNT] = {
+    {1, true, false, 10000},     // ACTIVE
+    {2, true, false, 30000},     // SAVER
+    {5, false, true, 3600000},   // DIMMED
+    {15, false, false, 7200000}, // DIMMED_SAVER
+    {1, true, true, 3600000},    // DOCKED
+    {2, true, false, 7200000},   // DOCKED_IDLE
+};
+
+static const char *const stateNames[POLICY_STATE_COUNT] = {"active",       "saver",  "dimmed",
+                                                           "dimmed_saver", "docked", "docked_idle"};
+
+static PolicyState state = POLICY_ACTIVE;
+static unsigned long stateSince = 0;
+static int batteryLevel = -1;
+static bool charging = false;
+static bool dimmedNow = false;
+static unsigned long dimSince = 0;
+static bool prefetchDone = false; // この減光では先読みを済ませた（見送った場合を含む）
+// 直近の減光の長さ（リング）と、そこから見込んだ長さ・ばらつき
+static uint32_t dimHistory[POLICY_DIM_HISTORY];
+static int dimHistoryCount = 0;
+static int dimHistoryNext = 0;
+static uint32_t expectedDimMs = 0;
+static uint32_t dimSpreadMs = 0;
+static PolicyStats stats = {};
+
+// 外部電源で動いているか（バッテリー残量が取れないだけでは充電中とみなさない）
+static bool externalPower()
+{
+    return charging;
+}
+
+static PolicyState decide(unsigned long now, bool dimmed, unsigned long lastInteraction)
+{
+#if POLL_POLICY
+    bool low = !externalPower() && batteryLevel >= 0 && batteryLevel < POLICY_LOW_BATTERY_PERCENT;
+    if (!dimmed)
+        return low ? POLICY_SAVER : POLICY_ACTIVE;
+    if (externalPower())
+        return now - lastInteraction < POLICY_PREFETCH_WINDOW_MS ? POLICY_DOCKED : POLICY_DOCKED_IDLE;
+    return low ? POLICY_DIMMED_SAVER : POLICY_DIMMED;
+#else
+    return POLICY_ACTIVE;
+#endif
+}
+
+void pollPolicyInit(unsigned long now)
+{
+    state = POLICY_ACTIVE;
+    stateSince = now;
+    dimmedNow = false;
+    dimSince = now;
+    prefetchDone = false;
+    dimHistoryCount = 0;
+    dimHistoryNext = 0;
+    expectedDimMs = 0;
+    dimSpreadMs = 0;
+    stats = {};
+}
+
+void pollPolicyNotePower(int level, bool isCharging)
+{
+    batteryLevel = level;
+    charging = isCharging;
+}
+
+// 直近の減光の長さの中央値とばらつきを求め直す
+static void updateExpectedDim()
+{
+    uint32_t sorted[POLICY_DIM_HISTORY];
+    for (int i = 0; i < dimHistoryCount; i++)
+    {
+        // 挿入ソート（数個なので十分）
+        int j = i;
+        for (; j > 0 && sorted[j - 1] > dimHistory[i]; j--)
+            sorted[j] = sorted[j - 1];
+        sorted[j] = dimHistory[i];
+    }
+    int mid = dimHistoryCount / 2;
+    expectedDimMs = dimHistoryCount % 2 != 0 ? sorted[mid] : (sorted[mid - 1] + sorted[mid]) / 2;
+    dimSpreadMs = sorted[dimHistoryCount - 1] - sorted[0];
+}
+
+// 減光の始まりと、復帰までの長さ（使われていない時間帯の分は打ち切って記録する）
+static void noteDimmed(unsigned long now, bool dimmed)
+{
+    if (dimmed == dimmedNow)
+        return;
+    dimmedNow = dimmed;
+    if (dimmed)
+    {
+        dimSince = now;
+        prefetchDone = false;
+        return;
+    }
+    dimHistory[dimHistoryNext] = min((uint32_t)(now - dimSince), (uint32_t)POLICY_PREFETCH_WINDOW_MS);
+    dimHistoryNext = (dimHistoryNext + 1) % POLICY_DIM_HISTORY;
+    if (dimHistoryCount < POLICY_DIM_HISTORY)
+        dimHistoryCount++;
+    updateExpectedDim();
+}
+
+bool pollPolicyUpdate(unsigned long now, bool dimmed, unsigned long lastInteraction)
+{
+    noteDimmed(now, dimmed);
+    PolicyState next = decide(now, dimmed, lastInteraction);
+    if (next == state)
+        return false;
+
+    stats.secondsIn[state] += (now - stateSince) / 1000;
+    Serial.printf("Policy: %s -> %s (battery=%d%% charging=%d)\n", stateNames[state], stateNames[next], batteryLevel,
+                  charging ? 1 : 0);
+    state = next;
+    stateSince = now;
+    stats.transitions++;
+    return true;
+}
+
+PolicyState pollPolicyState()
+{
+    return state;
+}
+
+const char *pollPolicyStateName(PolicyState s)
+{
+    return stateNames[s];
+}
+
+const PolicyRates &pollPolicyRates()
+{
+    return ratesTable[state];
+}
+
+uint32_t pollPolicyMeterInterval(uint32_t baseMs)
+{
+    return baseMs * ratesTable[state].meterFactor;
+}
+
+// この減光で先読みするか（直近の減光の長さが揃っていて、見込んだ復帰が使われている時間帯のうち）
+static bool prefetchPlanned()
+{
+    if (!ratesTable[state].prefetch || !dimmedNow || prefetchDone)
+        return false;
+    return dimHistoryCount == POLICY_DIM_HISTORY && dimSpreadMs <= POLICY_PREFETCH_SPREAD_MS &&
+           expectedDimMs < POLICY_PREFETCH_WINDOW_MS;
+}
+
+// 見込んだ復帰より POLICY_PREFETCH_LEAD_MS 前（先読みした値が見込みの前後で新しいままになる）
+static unsigned long prefetchAt()
+{
+    return dimSince + (expectedDimMs > POLICY_PREFETCH_LEAD_MS ? expectedDimMs - POLICY_PREFETCH_LEAD_MS : 0);
+}
+
+bool pollPolicyPrefetchDue(unsigned long now)
+{
+    if (!prefetchPlanned())
+        return false;
+    return (long)(now - prefetchAt()) >= 0;
+}
+
+bool pollPolicyNextPrefetch(unsigned long &at)
+{
+    if (!prefetchPlanned())
+        return false;
+    at = prefetchAt();
+    return true;
+}
+
+void pollPolicyNotePrefetch(int requested)
+{
+    prefetchDone = true;
+    stats.prefetches += requested;
+}
+
+void pollPolicyNotePrefetchSkipped()
+{
+    prefetchDone = true;
+    stats.prefetchSkipped++;
+}
+
+void pollPolicyNoteDeferred()
+{
+    stats.deferred++;
+}
+
+void pollPolicyNoteWake(int bulbs, int fresh)
+{
+    stats.wakes++;
+    stats.wakeBulbs += bulbs;
+    stats.wakeFresh += fresh;
+}
+
+PolicyStats pollPolicyGetStats()
+{
+    stats.expectedDimMs = expectedDimMs;
+    stats.dimSpreadMs = dimSpreadMs;
+    return stats;
+}
+
+void pollPolicyPrint(unsigned long now)
+{
+    const PolicyRates &r = ratesTable[state];
+    Serial.printf("Policy: state=%s battery=%d%% charging=%d meter=x%u bulbs=%s prefetch=%s expected_dim=%lus "
+                  "dim_spread=%lus battery_check=%lus\n",
+                  stateNames[state], batteryLevel, charging ? 1 : 0, (unsigned)r.meterFactor,
+                  r.bulbBackground ? "on" : "deferred", r.prefetch ? "before_wake" : "off",
+                  (unsigned long)(expectedDimMs / 1000), (unsigned long)(dimSpreadMs / 1000),
+                  (unsigned long)(r.batteryMs / 1000));
+    Serial.printf("Policy decisions: transitions=%lu prefetches=%lu prefetch_skipped=%lu deferred=%lu wakes=%lu "
+                  "wake_fresh=%lu/%lu",
+                  (unsigned long)stats.transitions, (unsigned long)stats.prefetches,
+                  (unsigned long)stats.prefetchSkipped, (unsigned long)stats.deferred, (unsigned long)stats.wakes,
+                  (unsigned long)stats.wakeFresh, (unsigned long)stats.wakeBulbs);
+    for (int i = 0; i < POLICY_STATE_COUNT; i++)
+    {
+        uint32_t seconds = stats.secondsIn[i];
+        if (i == state)
+            seconds += (now - stateSince) / 1000;
+        Serial.printf(" %s=%lus", stateNames[i], (unsigned long)seconds);
+    }
+    Serial.println();
+}
@@ -0,0 +1,102 @@
+#ifndef POLL_POLICY_H
+#define POLL_POLICY_H
+
+#include <Arduino.h>
+#include "state_cache.h"
+
+// 画面・バッテリー・充電・最後の操作から状態取得の間隔を決める（0 にすると常に画面オンの間隔）
+#ifndef POLL_POLICY
+#define POLL_POLICY 1
+#endif
+
+// この残量（%）を下回り、充電していなければ節電する
+#define POLICY_LOW_BATTERY_PERCENT 20
+
+// 減光から復帰までの長さが直近で揃っていれば、1回の減光につき1回だけ、見込んだ復帰の少し前に表示中のページを先読みする
+// 先読みした値は通常の新しさ（STATE_TTL_MS）のまま使い、見込みの前後 STATE_TTL_MS の半分ずつに復帰すれば取得を待たずに表示する
+// 長さがばらつく使い方では先読みしない（外れた先読みは復帰時の取得に上乗せになるため）
+#define POLICY_PREFETCH_LEAD_MS (STATE_TTL_MS / 2)
+
+// 先読みを見込むのに使う直近の減光の数と、先読みするときの長さのばらつき（最長と最短の差）の上限
+#define POLICY_DIM_HISTORY 4
+#define POLICY_PREFETCH_SPREAD_MS STATE_TTL_MS
+
+// 最後の操作からこの時間を過ぎたら、ドック中でも先読みしない（使われていない時間帯）
+#define POLICY_PREFETCH_WINDOW_MS 3600000
+
+// ポリシーの状態
+enum PolicyState
+{
+    POLICY_ACTIVE,       // 画面オン
+    POLICY_SAVER,        // 画面オン・バッテリー残量が少ない
+    POLICY_DIMMED,       // 減光中（バッテリー）
+    POLICY_DIMMED_SAVER, // 減光中・バッテリー残量が少ない
+    POLICY_DOCKED,       // 減光中・充電中（最近使われている）
+    POLICY_DOCKED_IDLE,  // 減光中・充電中（しばらく使われていない）
+    POLICY_STATE_COUNT
+};
+
+// 状態ごとの間隔
+struct PolicyRates
+{
+    uint8_t meterFactor;   // 温湿度の定期取得の間隔の倍率
+    bool bulbBackground;   // 画面に出ていない間の電球の状態取得（再接続・シーン失敗時）を行うか
+    bool prefetch;         // 見込んだ復帰の前に表示中のページを先読みするか
+    uint32_t batteryMs;    // バッテリー残量・充電状態を見る間隔
+};
+
+// 集計
+struct PolicyStats
+{
+    uint32_t transitions;                   // 状態が変わった回数
+    uint32_t prefetches;                    // 先読みで投入した状態取得
+    uint32_t prefetchSkipped;               // 呼び出し回数の割り当てに余裕がなく見送った先読み
+    uint32_t deferred;                      // 復帰まで後回しにしたページ全体の状態取得
+    uint32_t wakes;                         // 画面復帰
+    uint32_t wakeBulbs;                     // 復帰時に表示したページの電球
+    uint32_t wakeFresh;                     // そのうち状態取得なしで表示できた電球
+    uint32_t expectedDimMs;                 // 見込んでいる減光の長さ（直近の中央値）
+    uint32_t dimSpreadMs;                   // 直近の減光の長さのばらつき
+    uint32_t secondsIn[POLICY_STATE_COUNT]; // 状態ごとの累計時間（秒）
+};
+
+// 初期化
+void pollPolicyInit(unsigned long now);
+
+// バッテリー残量（負値=取得できない、充電中とも残量が少ないともみなさない）・充電中かを記録
+void pollPolicyNotePower(int batteryLevel, bool charging);
+
+// 画面の状態と最後の操作の時刻から状態を決める（uiUpdate から毎ループ呼ぶ）
+// 減光から復帰までの長さもここで記録し、次の先読みの時刻を見込む
+// 戻り値: 状態が変わった=true
+bool pollPolicyUpdate(unsigned long now, bool dimmed, unsigned long lastInteraction);
+
+// 現在の状態と間隔
+PolicyState pollPolicyState();
+const char *pollPolicyStateName(PolicyState state);
+const PolicyRates &pollPolicyRates();
+
+// 温湿度の定期取得の間隔
+uint32_t pollPolicyMeterInterval(uint32_t baseMs);
+
+// 先読みする時刻か・次に先読みする時刻（先読みしない状態か、減光の長さが揃っていないか、この減光では先読みを済ませたなら false）
+bool pollPolicyPrefetchDue(unsigned long now);
+bool pollPolicyNextPrefetch(unsigned long &at);
+
+// 先読みした（requested: 投入した状態取得の数）
+void pollPolicyNotePrefetch(int requested);
+
+// 呼び出し回数の割り当てに余裕がないので、この減光での先読みを見送った
+void pollPolicyNotePrefetchSkipped();
+
+// ページ全体の状態取得を復帰まで後回しにした
+void pollPolicyNoteDeferred();
+
+// 画面復帰時の状態取得（bulbs: 表示したページの電球, fresh: 取得せずに済んだ電球）
+void pollPolicyNoteWake(int bulbs, int fresh);
+
+// 集計取得・シリアル出力
+PolicyStats pollPolicyGetStats();
+void pollPolicyPrint(unsigned long now);
+
+#endif // POLL_POLICY_H
@@ -0,0 +1,85 @@
+#include "request_signer.h"
+
+#include <sys/time.h>
+#include "mbedtls/base64.h"
+
+#define SHA256_BLOCK_SIZE 64
+#define SHA256_DIGEST_SIZE 32
+
+RequestSigner::RequestSigner() : ready(false) {
+    mbedtls_sha256_init(&inner);
+    mbedtls_sha256_init(&outer);
+}
+
+RequestSigner::~RequestSigner() {
+    mbedtls_sha256_free(&inner);
+    mbedtls_sha256_free(&outer);
+}
+
+void RequestSigner::begin(const char* token, const char* secret) {
+    unsigned char key[SHA256_BLOCK_SIZE];
+    unsigned char pad[SHA256_BLOCK_SIZE];
+    size_t secretLen = strlen(secret);
+
+    // ブロック長を超える鍵はハッシュ値を鍵にする（RFC 2104）
+    memset(key, 0, sizeof(key));
+    if (secretLen > SHA256_BLOCK_SIZE) {
+        mbedtls_sha256((const unsigned char*)secret, secretLen, key, 0);
+    } else {
+        memcpy(key, secret, secretLen);
+    }
+
+    // inner = SHA256((key ^ ipad) || token || ...)
+    for (int i = 0; i < SHA256_BLOCK_SIZE; i++) pad[i] = key[i] ^ 0x36;
+    mbedtls_sha256_starts(&inner, 0);
+    mbedtls_sha256_update(&inner, pad, sizeof(pad));
+    mbedtls_sha256_update(&inner, (const unsigned char*)token, strlen(token));
+
+    // outer = SHA256((key ^ opad) || inner)
+    for (int i = 0; i < SHA256_BLOCK_SIZE; i++) pad[i] = key[i] ^ 0x5c;
+    mbedtls_sha256_starts(&outer, 0);
+    mbedtls_sha256_update(&outer, pad, sizeof(pad));
+
+    memset(key, 0, sizeof(key));
+    memset(pad, 0, sizeof(pad));
+    ready = true;
+}
+
+void RequestSigner::signWith(const char* t, const char* nonce, char* out, size_t outSize) const {
+    unsigned char digest[SHA256_DIGEST_SIZE];
+    mbedtls_sha256_context ctx;
+
+    out[0] = '\0';
+    if (!ready) return;
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_clone(&ctx, &inner);
+    mbedtls_sha256_update(&ctx, (const unsigned char*)t, strlen(t));
+    mbedtls_sha256_update(&ctx, (const unsigned char*)nonce, strlen(nonce));
+    mbedtls_sha256_finish(&ctx, digest);
+
+    mbedtls_sha256_clone(&ctx, &outer);
+    mbedtls_sha256_update(&ctx, digest, sizeof(digest));
+    mbedtls_sha256_finish(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+
+    size_t len = 0;
+    if (mbedtls_base64_encode((unsigned char*)out, outSize, &len, digest, sizeof(digest)) != 0) {
+        out[0] = '\0';
+    }
+}
+
+void RequestSigner::sign(SignedHeaders& out) const {
+    // t は13桁ミリ秒（UNIXタイムスタンプ）
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    int64_t epochMs = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+    snprintf(out.t, sizeof(out.t), "%lld", (long long)epochMs);
+
+    // 簡易nonce生成
+    uint32_t r1 = esp_random();
+    uint32_t r2 = esp_random();
+    snprintf(out.nonce, sizeof(out.nonce), "%08lx%08lx", (unsigned long)r1, (unsigned long)r2);
+
+    signWith(out.t, out.nonce, out.sign, sizeof(out.sign));
+}
@@ -0,0 +1,41 @@
+#ifndef REQUEST_SIGNER_H
+#define REQUEST_SIGNER_H
+
+#include <Arduino.h>
+#include "mbedtls/sha256.h"
+
+// 署名ヘッダー（固定長バッファ）
+struct SignedHeaders
+{
+    char t[16];     // 13桁ミリ秒のUNIXタイムスタンプ
+    char nonce[20]; // 16桁の16進乱数
+    char sign[48];  // Base64(HMAC-SHA256) = 44文字
+};
+
+// SwitchBot API v1.1 のリクエスト署名
+// sign = Base64(HMAC-SHA256(secret, token + t + nonce))
+// 鍵から作るinner/outerパッドのハッシュ状態を初期化時に一度だけ計算しておき、
+// 署名ごとにはそのコピーへ t と nonce を追加するだけにする。ヒープは使わない。
+class RequestSigner
+{
+public:
+    RequestSigner();
+    ~RequestSigner();
+
+    // token と secret を設定してパッドを事前計算
+    void begin(const char* token, const char* secret);
+
+    // 現在時刻と乱数で t / nonce を作って署名
+    void sign(SignedHeaders& out) const;
+
+    // 指定した t / nonce で署名（既知解テスト用）
+    // out: Base64文字列の出力先（45バイト以上）
+    void signWith(const char* t, const char* nonce, char* out, size_t outSize) const;
+
+private:
+    mbedtls_sha256_context inner; // (key ^ ipad) || token まで処理済み
+    mbedtls_sha256_context outer; // (key ^ opad) まで処理済み
+    bool ready;
+};
+
+#endif // REQUEST_SIGNER_H
@@ -0,0 +1,361 @@
+#include "scene.h"
+#include "command_coalescer.h"
+#include "device_registry.h"
+#include "devices.h"
+
+// コマンドの進み具合
+enum SceneCommandState : uint8_t
+{
+    SCENE_CMD_PENDING,   // 送信待ち（再試行待ちを含む）
+    SCENE_CMD_IN_FLIGHT, // 送信中
+    SCENE_CMD_DONE,      // 成功
+    SCENE_CMD_FAILED     // 再試行しても失敗
+};
+
+// 実行中のシーンのコマンド1つ分
+struct SceneCommand
+{
+    int device;
+    ApiJobType type;
+    int value;
+    uint8_t attempts;
+    SceneCommandState state;
+    unsigned long retryAt; // この時刻以降に送る
+};
+
+static SceneCommand commands[SCENE_MAX_COMMANDS];
+static int commandCount = 0;
+static int inFlight = 0;
+static bool running = false;
+static bool overflow = false;
+static unsigned long startTime = 0;
+static SceneSummary summary = {};
+static SceneDoneCallback doneCallback = nullptr;
+
+// 実行の準備（実行中なら false）
+static bool beginRun(const char *name)
+{
+    if (running)
+    {
+        Serial.printf("Scene %s: previous scene still running\n", name);
+        return false;
+    }
+    commandCount = 0;
+    inFlight = 0;
+    overflow = false;
+    summary = {};
+    summary.name = name;
+    return true;
+}
+
+// コマンドを1つ追加（確認済みの状態と同じなら送らない）
+static void addCommand(int device, ApiJobType type, int value)
+{
+    if (coalescerConfirmed(device, type, value))
+    {
+        summary.skipped++;
+        return;
+    }
+    if (commandCount >= SCENE_MAX_COMMANDS)
+    {
+        overflow = true;
+        return;
+    }
+
+    SceneCommand &cmd = commands[commandCount++];
+    cmd.device = device;
+    cmd.type = type;
+    cmd.value = value;
+    cmd.attempts = 0;
+    cmd.state = SCENE_CMD_PENDING;
+    cmd.retryAt = 0;
+}
+
+// 電球1台分の目標を追加し、表示用の状態を先に目標値にする
+// 同じ電球へは電源・明るさ・色の順に1つずつ送る（OFFなら電源だけ）、別の電球へは並列に送る
+// 明るさのコマンドで電球は点灯するので、明るさを送るときは ON のコマンドを省く
+static void addTarget(int device, bool power, int brightness, int32_t color)
+{
+    if (!bulbEnabled(device))
+        return;
+
+    if (power && brightness >= 0)
+        brightness = constrain(brightness, 1, 100);
+    bool brightnessTurnsOn =
+        power && brightness >= 0 && !coalescerConfirmed(device, API_JOB_BULB_BRIGHTNESS, brightness);
+    if (!brightnessTurnsOn)
+        addCommand(device, API_JOB_BULB_POWER, power ? 1 : 0);
+    bulbs.powerState[device] = power;
+    if (!power)
+        return;
+
+    if (brightness >= 0)
+    {
+        addCommand(device, API_JOB_BULB_BRIGHTNESS, brightness);
+        bulbs.brightness[device] = brightness;
+    }
+    if (color >= 0)
+    {
+        addCommand(device, API_JOB_BULB_COLOR, (int)(color & 0xFFFFFF));
+    }
+}
+
+static void finishRun()
+{
+    running = false;
+    summary.elapsedMs = millis() - startTime;
+    Serial.printf("Scene %s: commands=%d ok=%d failed=%d retries=%d skipped=%d in %lu ms\n", summary.name,
+                  summary.commands, summary.succeeded, summary.failed, summary.retries, summary.skipped,
+                  (unsigned long)summary.elapsedMs);
+    if (doneCallback != nullptr)
+        doneCallback(summary);
+}
+
+// 追加したコマンドの送信を開始
+static bool commitRun()
+{
+    if (overflow)
+    {
+        Serial.printf("Scene %s: more than %d commands\n", summary.name, SCENE_MAX_COMMANDS);
+        return false;
+    }
+
+    summary.commands = commandCount;
+    startTime = millis();
+    running = true;
+    if (commandCount == 0)
+    {
+        // すべて確認済みの状態と同じ
+        finishRun();
+        return true;
+    }
+    sceneService(startTime);
+    return true;
+}
+
+// 全コマンドが成功・失敗のどちらかになったか
+static bool allSettled()
+{
+    for (int i = 0; i < commandCount; i++)
+    {
+        if (commands[i].state == SCENE_CMD_PENDING || commands[i].state == SCENE_CMD_IN_FLIGHT)
+            return false;
+    }
+    return true;
+}
+
+// 同じ電球への前のコマンドが送り終わり、単体の操作のコマンドも送信中でなく、このコマンドを送れるか
+static bool readyToSend(int i)
+{
+    const SceneCommand &cmd = commands[i];
+    for (int j = 0; j < i; j++)
+    {
+        if (commands[j].device == cmd.device &&
+            (commands[j].state == SCENE_CMD_PENDING || commands[j].state == SCENE_CMD_IN_FLIGHT))
+            return false;
+    }
+    return !coalescerSending(cmd.device);
+}
+
+// 単体の操作の指示は、この電球へのシーンのコマンドを送り終えるまで待たせる
+static bool holdUserCommands(int index)
+{
+    return !sceneIdle(index);
+}
+
+// コマンド完了（UIスレッドで呼ばれる、result.index はコマンド番号）
+static void onSceneCommand(const ApiResult &result)
+{
+    if (!running || result.index < 0 || result.index >= commandCount)
+        return;
+
+    SceneCommand &cmd = commands[result.index];
+    if (cmd.state != SCENE_CMD_IN_FLIGHT)
+        return;
+    inFlight--;
+
+    // 単体の操作で同じ値を送り直さないよう、結果を送信スロットにも記録する
+    // （この電球への単体の操作はシーンの間は待たせているので、新しい操作の結果を上書きしない）
+    coalescerNoteSent(cmd.device, cmd.type, cmd.value, result.success);
+    // 明るさのコマンドが届いた電球は点灯している
+    if (cmd.type == API_JOB_BULB_BRIGHTNESS && result.success)
+        coalescerNoteSent(cmd.device, API_JOB_BULB_POWER, 1, true);
+
+    if (result.success)
+    {
+        cmd.state = SCENE_CMD_DONE;
+        summary.succeeded++;
+    }
+    else if (cmd.attempts < SCENE_MAX_ATTEMPTS)
+    {
+        cmd.state = SCENE_CMD_PENDING;
+        cmd.retryAt = millis() + SCENE_RETRY_DELAY_MS * cmd.attempts;
+        summary.retries++;
+    }
+    else
+    {
+        cmd.state = SCENE_CMD_FAILED;
+        summary.failed++;
+        Serial.printf("Scene %s: bulb %d command failed (type=%d, value=%d)\n", summary.name, cmd.device,
+                      (int)cmd.type, cmd.value);
+    }
+
+    if (allSettled())
+        finishRun();
+}
+
+void sceneInit(SceneDoneCallback onDone)
+{
+    doneCallback = onDone;
+    coalescerSetHold(holdUserCommands);
+    running = false;
+    commandCount = 0;
+    inFlight = 0;
+}
+
+int sceneCount()
+{
+    return CONFIG_COUNT(sceneConfigs);
+}
+
+const char *sceneName(int scene)
+{
+    return (scene >= 0 && scene < sceneCount()) ? sceneConfigs[scene].name : "";
+}
+
+int groupCount()
+{
+    return CONFIG_COUNT(groupConfigs);
+}
+
+const char *groupName(int group)
+{
+    return (group >= 0 && group < groupCount()) ? groupConfigs[group].name : "";
+}
+
+bool sceneActivate(int scene)
+{
+    if (scene < 0 || scene >= sceneCount())
+        return false;
+
+    const SceneConfig &config = sceneConfigs[scene];
+    if (!beginRun(config.name))
+        return false;
+
+    for (int i = 0; i < config.count; i++)
+    {
+        const SceneTarget &target = config.targets[i];
+        addTarget(registryFindBulb(target.deviceId), target.power, target.brightness, target.color);
+    }
+    return commitRun();
+}
+
+bool sceneSetGroup(int group, bool on, int brightness)
+{
+    if (group < 0 || group >= groupCount())
+        return false;
+
+    const GroupConfig &config = groupConfigs[group];
+    if (!beginRun(config.name))
+        return false;
+
+    for (int i = 0; i < config.count; i++)
+    {
+        addTarget(registryFindBulb(config.deviceIds[i]), on, brightness, -1);
+    }
+    return commitRun();
+}
+
+bool sceneGroupAnyOn(int group)
+{
+    if (group < 0 || group >= groupCount())
+        return false;
+
+    const GroupConfig &config = groupConfigs[group];
+    for (int i = 0; i < config.count; i++)
+    {
+        int device = registryFindBulb(config.deviceIds[i]);
+        if (bulbEnabled(device) && bulbs.powerState[device])
+            return true;
+    }
+    return false;
+}
+
+void sceneService(unsigned long now)
+{
+    if (!running)
+        return;
+
+    bool timedOut = (now - startTime >= SCENE_TIMEOUT_MS);
+    for (int i = 0; i < commandCount && inFlight < SCENE_MAX_INFLIGHT; i++)
+    {
+        SceneCommand &cmd = commands[i];
+        if (cmd.state != SCENE_CMD_PENDING)
+            continue;
+
+        if (timedOut)
+        {
+            cmd.state = SCENE_CMD_FAILED;
+            summary.failed++;
+            continue;
+        }
+        if ((long)(now - cmd.retryAt) < 0 || !readyToSend(i))
+            continue;
+
+        // キューが満杯・割り当て超過なら次のループで再試行
+        if (!apiWorkerSubmit(cmd.type, bulbs.deviceId[cmd.device], i, cmd.value, onSceneCommand))
+            break;
+        cmd.state = SCENE_CMD_IN_FLIGHT;
+        cmd.attempts++;
+        inFlight++;
+    }
+
+    if (timedOut && allSettled())
+        finishRun();
+}
+
+bool sceneNextService(unsigned long now, unsigned long &at)
+{
+    if (!running)
+        return false;
+
+    at = startTime + SCENE_TIMEOUT_MS;
+    // 送信中が上限なら、次は完了したときに送る
+    if (inFlight >= SCENE_MAX_INFLIGHT)
+        return true;
+
+    for (int i = 0; i < commandCount; i++)
+    {
+        // 同じ電球への前のコマンド・単体の操作のコマンドは、完了したときに続けて送る
+        const SceneCommand &cmd = commands[i];
+        if (cmd.state != SCENE_CMD_PENDING || !readyToSend(i))
+            continue;
+        if ((long)(cmd.retryAt - now) <= 0)
+        {
+            at = now;
+            break;
+        }
+        if ((long)(cmd.retryAt - at) < 0)
+            at = cmd.retryAt;
+    }
+    return true;
+}
+
+bool sceneRunning()
+{
+    return running;
+}
+
+bool sceneIdle(int index)
+{
+    if (!running)
+        return true;
+
+    for (int i = 0; i < commandCount; i++)
+    {
+        const SceneCommand &cmd = commands[i];
+        if (cmd.device == index && (cmd.state == SCENE_CMD_PENDING || cmd.state == SCENE_CMD_IN_FLIGHT))
+            return false;
+    }
+    return true;
+}
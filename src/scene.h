@@ -0,0 +1,69 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <Arduino.h>
+#include "api_worker.h"
+
+// 1回のシーン実行で送るコマンドの最大数
+#define SCENE_MAX_COMMANDS 64
+
+// 同時に送信中にするコマンド数（ワーカー数まで並列、UIのコマンドが割り込む余地を残す）
+#ifndef SCENE_MAX_INFLIGHT
+#define SCENE_MAX_INFLIGHT API_WORKER_COUNT
+#endif
+
+// 1コマンドあたりの最大試行回数と、再試行までの待ち時間（試行回数に比例して延ばす）
+#define SCENE_MAX_ATTEMPTS 3
+#define SCENE_RETRY_DELAY_MS 500
+
+// この時間を過ぎても送れていないコマンドは失敗として打ち切る
+#define SCENE_TIMEOUT_MS 30000
+
+// シーン・グループ実行の結果
+struct SceneSummary
+{
+    const char *name;   // シーン名・グループ名
+    int commands;       // 送信したコマンド数（確認済みで省略した分を除く）
+    int succeeded;      // 成功したコマンド数
+    int failed;         // 再試行しても失敗したコマンド数
+    int retries;        // 再試行の回数
+    int skipped;        // 電球の状態が確認済みで同じため省略したコマンド数
+    uint32_t elapsedMs; // 実行開始から全コマンド完了までの時間
+};
+
+// 完了コールバック（UIスレッドで実行される）
+typedef void (*SceneDoneCallback)(const SceneSummary &summary);
+
+// 初期化
+void sceneInit(SceneDoneCallback onDone);
+
+// 登録されているシーン・グループ（devices.h）
+int sceneCount();
+const char *sceneName(int scene);
+int groupCount();
+const char *groupName(int group);
+
+// シーンを実行（電球の状態は先に目標値にしておき、コマンドは sceneService で電球ごとに順に、電球間は並列に送る）
+// 戻り値: 開始した=true, 実行中・番号が不正・コマンドが多すぎる=false
+bool sceneActivate(int scene);
+
+// グループの電球をまとめて操作（brightness が -1 なら明るさは変えない）
+// 戻り値: sceneActivate と同じ
+bool sceneSetGroup(int group, bool on, int brightness);
+
+// グループにONの電球があるか
+bool sceneGroupAnyOn(int group);
+
+// 送信待ちのコマンドを送る（uiUpdate から毎ループ呼ぶ）
+void sceneService(unsigned long now);
+
+// 次に sceneService で送れるコマンドがある時刻（再試行待ち・打ち切り、実行中でなければ false）
+bool sceneNextService(unsigned long now, unsigned long &at);
+
+// シーン実行中か
+bool sceneRunning();
+
+// この電球に送信待ち・送信中のシーンのコマンドがないか（false の間は単体の操作のコマンドを待たせる）
+bool sceneIdle(int index);
+
+#endif // SCENE_H
@@ -0,0 +1,210 @@
+#include "state_cache.h"
+
+// 項目ごとの配列（登録簿と同じく struct-of-arrays）
+static StateSource source[REGISTRY_MAX_BULBS];
+static uint32_t confirmedAt[REGISTRY_MAX_BULBS];  // 最後に状態取得で確認した時刻
+static uint32_t reconcileAt[REGISTRY_MAX_BULBS];  // 状態を確かめる予定の時刻
+static bool reconcilePending[REGISTRY_MAX_BULBS];
+static bool reconcileRequested[REGISTRY_MAX_BULBS]; // 確かめる取得を投入し、結果を待っている（予定の時刻は見ない）
+static int pendingCount = 0;
+static int requestedCount = 0;
+static unsigned long earliestAt = 0; // 最も早い予定の時刻（earliestKnown のときだけ有効）
+static bool earliestKnown = true;    // false なら次の stateCacheNextReconcile で数え直す
+static StateCacheStats stats = {};
+
+static bool validIndex(int index)
+{
+    return index >= 0 && index < REGISTRY_MAX_BULBS;
+}
+
+static void clearRequested(int index)
+{
+    if (reconcileRequested[index])
+    {
+        reconcileRequested[index] = false;
+        requestedCount--;
+    }
+}
+
+static void clearPending(int index)
+{
+    if (reconcilePending[index])
+    {
+        reconcilePending[index] = false;
+        pendingCount--;
+        // 最も早い予定だったなら数え直す（結果を待っている電球は予定に数えていない）
+        if (!reconcileRequested[index] && reconcileAt[index] == earliestAt)
+            earliestKnown = false;
+        clearRequested(index);
+    }
+}
+
+// 状態を確かめる予定を入れる（最も早い予定の時刻も合わせて更新する）
+static void schedule(int index, unsigned long at)
+{
+    // 最も早い予定を遅らせるなら数え直す
+    if (reconcilePending[index] && !reconcileRequested[index] && reconcileAt[index] == earliestAt &&
+        (long)(at - earliestAt) > 0)
+        earliestKnown = false;
+    if (!reconcilePending[index])
+    {
+        reconcilePending[index] = true;
+        pendingCount++;
+    }
+    // 結果を待っていた確認は、この予定で確かめ直す
+    clearRequested(index);
+    reconcileAt[index] = at;
+    if (earliestKnown && (pendingCount - requestedCount == 1 || (long)(at - earliestAt) < 0))
+        earliestAt = at;
+}
+
+void stateCacheInit()
+{
+    for (int i = 0; i < REGISTRY_MAX_BULBS; i++)
+    {
+        source[i] = STATE_SOURCE_NONE;
+        confirmedAt[i] = 0;
+        reconcileAt[i] = 0;
+        reconcilePending[i] = false;
+        reconcileRequested[i] = false;
+    }
+    pendingCount = 0;
+    requestedCount = 0;
+    earliestKnown = true;
+}
+
+void stateCacheNoteRestored(int index)
+{
+    if (validIndex(index) && source[index] == STATE_SOURCE_NONE)
+        source[index] = STATE_SOURCE_RESTORED;
+}
+
+void stateCacheNoteOptimistic(int index, unsigned long now, uint32_t delayMs)
+{
+    if (!validIndex(index))
+        return;
+
+    source[index] = STATE_SOURCE_OPTIMISTIC;
+    schedule(index, now + delayMs);
+    stats.optimistic++;
+}
+
+void stateCacheNoteFailed(int index, unsigned long now)
+{
+    if (!validIndex(index))
+        return;
+
+    source[index] = STATE_SOURCE_OPTIMISTIC;
+    schedule(index, now);
+}
+
+void stateCacheNoteConfirmed(int index, unsigned long now)
+{
+    if (!validIndex(index))
+        return;
+
+    source[index] = STATE_SOURCE_CONFIRMED;
+    confirmedAt[index] = now;
+    clearPending(index);
+    stats.confirmed++;
+}
+
+void stateCacheNoteAccepted(int index, unsigned long now)
+{
+    if (!validIndex(index))
+        return;
+
+    source[index] = STATE_SOURCE_CONFIRMED;
+    confirmedAt[index] = now;
+    if (reconcilePending[index])
+        stats.accepted++;
+    clearPending(index);
+}
+
+StateSource stateCacheSource(int index)
+{
+    return validIndex(index) ? source[index] : STATE_SOURCE_NONE;
+}
+
+bool stateCacheStale(int index, unsigned long now, uint32_t ttlMs)
+{
+    if (!validIndex(index))
+        return false;
+    // 操作した値も、確認するまでは取得の対象（確認の予定があればそちらに任せる）
+    if (reconcilePending[index])
+        return false;
+    return source[index] != STATE_SOURCE_CONFIRMED || (uint32_t)(now - confirmedAt[index]) >= ttlMs;
+}
+
+int stateCacheReconcilePending()
+{
+    return pendingCount;
+}
+
+bool stateCacheReconcileDue(int index, unsigned long now)
+{
+    return validIndex(index) && reconcilePending[index] && !reconcileRequested[index] &&
+           (long)(now - reconcileAt[index]) >= 0;
+}
+
+bool stateCacheNextReconcile(unsigned long &at)
+{
+    int scheduled = pendingCount - requestedCount;
+    if (scheduled == 0)
+        return false;
+
+    // 予定を取り消した・遅らせたときだけ数え直す（予定のある電球を全部見たら止める）
+    if (!earliestKnown)
+    {
+        int seen = 0;
+        for (int i = 0; i < REGISTRY_MAX_BULBS && seen < scheduled; i++)
+        {
+            if (!reconcilePending[i] || reconcileRequested[i])
+                continue;
+            if (seen == 0 || (long)(reconcileAt[i] - earliestAt) < 0)
+                earliestAt = reconcileAt[i];
+            seen++;
+        }
+        earliestKnown = true;
+    }
+    at = earliestAt;
+    return true;
+}
+
+void stateCacheNoteRequested(int index, bool reconcile)
+{
+    if (!validIndex(index))
+        return;
+
+    // 予定は結果を確認するまで残す（結果を捨てたら stateCacheNoteDropped で確かめ直す）
+    if (reconcile && reconcilePending[index] && !reconcileRequested[index])
+    {
+        reconcileRequested[index] = true;
+        requestedCount++;
+        if (reconcileAt[index] == earliestAt)
+            earliestKnown = false;
+    }
+    if (reconcile)
+        stats.reconciles++;
+    else
+        stats.refreshes++;
+}
+
+void stateCacheNoteDropped(int index, unsigned long now, uint32_t delayMs)
+{
+    // 結果を待つ間に操作して予定を入れ直していれば、そちらに任せる
+    if (!validIndex(index) || !reconcileRequested[index])
+        return;
+
+    schedule(index, now + delayMs);
+}
+
+void stateCacheNoteFresh()
+{
+    stats.fresh++;
+}
+
+StateCacheStats stateCacheGetStats()
+{
+    return stats;
+}
@@ -0,0 +1,78 @@
+#ifndef STATE_CACHE_H
+#define STATE_CACHE_H
+
+#include <Arduino.h>
+#include "device_registry.h"
+
+// 状態取得で確認した値をこの時間だけ新しいとみなす（画面復帰・ページ送りではこれより古い電球だけ取得する）
+#define STATE_TTL_MS 30000
+
+// コマンドを送ってから、その電球だけ状態を確かめるまでの時間（続けて操作するとその分延びる）
+#define STATE_RECONCILE_DELAY_MS 10000
+
+// 表示している値の出どころ
+enum StateSource : uint8_t
+{
+    STATE_SOURCE_NONE,       // 未取得（devices.h・デバイス一覧の既定値）
+    STATE_SOURCE_RESTORED,   // 前回の起動で保存した値
+    STATE_SOURCE_OPTIMISTIC, // 操作した値（コマンドの結果を確かめていない）
+    STATE_SOURCE_CONFIRMED   // 状態取得で確認した値
+};
+
+// 集計
+struct StateCacheStats
+{
+    uint32_t optimistic;  // 操作で値を書き換えた回数
+    uint32_t confirmed;   // 状態取得で確認した回数
+    uint32_t accepted;    // コマンドの成功応答で確認し、状態を確かめる取得を省いた回数
+    uint32_t reconciles;  // 操作した電球だけの状態取得の回数
+    uint32_t refreshes;   // 古くなった電球の状態取得の回数
+    uint32_t fresh;       // 新しいので取得を省いた回数
+};
+
+// 電球ごとの状態の出どころと時刻（登録簿と同じデバイス番号、登録簿を作り直したら初期化する）
+void stateCacheInit();
+
+// 前回の起動で保存した値を戻した
+void stateCacheNoteRestored(int index);
+
+// 操作で値を書き換えた（delayMs 後にこの電球だけ状態を確かめる）
+void stateCacheNoteOptimistic(int index, unsigned long now, uint32_t delayMs);
+
+// コマンドが失敗した（すぐに状態を確かめる）
+void stateCacheNoteFailed(int index, unsigned long now);
+
+// 状態取得で値を確認した
+void stateCacheNoteConfirmed(int index, unsigned long now);
+
+// コマンドの成功応答（statusCode 100）で、表示している値がすべて受け付けられた（状態を確かめる予定を取り消す）
+void stateCacheNoteAccepted(int index, unsigned long now);
+
+// 値の出どころ
+StateSource stateCacheSource(int index);
+
+// 確認してから ttlMs 以上経った、または確認していない
+bool stateCacheStale(int index, unsigned long now, uint32_t ttlMs);
+
+// 状態を確かめる予定の電球の数（結果を待っている電球を含む）
+int stateCacheReconcilePending();
+
+// この電球の状態を確かめる時刻になったか（結果を待っている間は false）
+bool stateCacheReconcileDue(int index, unsigned long now);
+
+// 最も早い状態を確かめる予定の時刻（予定がなければ false、予定を入れるときに覚えておき毎回は探さない）
+bool stateCacheNextReconcile(unsigned long &at);
+
+// 状態取得を投入した（reconcile: 操作した電球の確認=true, 古くなった電球の取得=false）
+// 確認の予定は stateCacheNoteConfirmed まで残し、結果を待つ間は stateCacheReconcileDue から外す
+void stateCacheNoteRequested(int index, bool reconcile);
+
+// 確認の状態取得の結果を反映しなかった（失敗・操作中で捨てた）: delayMs 後に確かめ直す
+void stateCacheNoteDropped(int index, unsigned long now, uint32_t delayMs);
+
+// 新しいので取得を省いた
+void stateCacheNoteFresh();
+
+StateCacheStats stateCacheGetStats();
+
+#endif // STATE_CACHE_H
@@ -1,234 +1,223 @@
 #include "switchbot_api.h"
 #include "secrets.h"
+#include "hal/hal_http.h"
+#include "request_signer.h"
+#include "api_metrics.h"
+
+#include <stdarg.h>
+
+// 署名器（switchbotApiInit で鍵を設定）
+static RequestSigner signer;
+
+// タイムアウト（ミリ秒）
+// ステータス取得は1台が応答しなくても他の電球の更新を待たせないよう短めにする
+#define API_COMMAND_TIMEOUT_MS 5000
+#define API_STATUS_TIMEOUT_MS 3000
+#define API_DEVICES_TIMEOUT_MS 8000
+
+// リクエストの URL とボディ（1リクエストごとにスタックに置き、String の連結でヒープを使わない）
+// 大きさはデバイスID（DEVICE_ID_LEN）と最も長いコマンド（setColor "255:255:255"）が収まる分
+#define API_HOST "https://api.switch-bot.com/v1.1"
+#define API_URL_LEN 96
+#define API_BODY_LEN 128
+
+struct RequestBuffer {
+    char url[API_URL_LEN];
+    char body[API_BODY_LEN];
+};
+
+// snprintf で buf に書き込む（戻り値: 切り詰めずに書けた=true）
+static bool formatInto(char* buf, size_t size, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+static bool formatInto(char* buf, size_t size, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buf, size, format, args);
+    va_end(args);
+    if (n < 0 || (size_t)n >= size) {
+        Serial.println("Error: request does not fit in buffer");
+        return false;
+    }
+    return true;
+}
 
-#include <WiFi.h>
-#include <HTTPClient.h>
-#include <WiFiClientSecure.h>
-#include "mbedtls/md.h"
-#include "mbedtls/base64.h"
-
-// Base64(HMAC-SHA256(secret, token + t + nonce))
-static String makeSign(const String& token, const String& secret, const String& t, const String& nonce) {
-    String data = token + t + nonce;
-
-    unsigned char hmacOut[32];
-    mbedtls_md_context_t ctx;
-    const mbedtls_md_info_t* info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
-
-    mbedtls_md_init(&ctx);
-    mbedtls_md_setup(&ctx, info, 1);
-    mbedtls_md_hmac_starts(&ctx, (const unsigned char*)secret.c_str(), secret.length());
-    mbedtls_md_hmac_update(&ctx, (const unsigned char*)data.c_str(), data.length());
-    mbedtls_md_hmac_finish(&ctx, hmacOut);
-    mbedtls_md_free(&ctx);
-
-    // base64 encode
-    unsigned char b64[64];
-    size_t b64len = 0;
-    mbedtls_base64_encode(b64, sizeof(b64), &b64len, hmacOut, sizeof(hmacOut));
-    return String((char*)b64, b64len);
+// パーサーにレスポンスボディを流し込む
+template <typename Parser>
+static bool feedParser(void* ctx, const char* data, size_t len) {
+    return static_cast<Parser*>(ctx)->feed(data, len);
 }
 
-// 簡易nonce生成
-static String makeNonce() {
-    uint32_t r1 = esp_random();
-    uint32_t r2 = esp_random();
-    char buf[32];
-    snprintf(buf, sizeof(buf), "%08lx%08lx", (unsigned long)r1, (unsigned long)r2);
-    return String(buf);
+// ステータスのパーサーとデバイス一覧のパーサーで statusCode の取り出し方をそろえる
+static int statusCodeOf(const DeviceStatusParser& parser) {
+    const DeviceStatus& status = parser.result();
+    return (status.found & STATUS_FIELD_STATUS_CODE) ? status.statusCode : -1;
 }
 
-// SwitchBot APIにコマンドを送信
-static bool sendCommand(const String& deviceId, const String& command, const String& parameter) {
-    if (deviceId.isEmpty()) {
-        Serial.println("Error: deviceId is empty");
-        return false;
-    }
+static int statusCodeOf(const DeviceListParser& parser) {
+    return parser.statusCode();
+}
 
-    WiFiClientSecure client;
-    client.setInsecure();
+// 署名ヘッダーを付けてリクエストを送信し、レスポンスボディを parser に流す
+// body が nullptr なら GET、それ以外は POST
+template <typename Parser>
+static int performRequest(const char* url, const char* body, Parser& parser, ApiEndpoint endpoint,
+                          uint16_t timeoutMs) {
+    unsigned long start = micros();
+    ApiHeapProbe heap;
+    apiMetricsHeapBegin(heap);
+
+    SignedHeaders auth;
+    signer.sign(auth);
+
+    HalHttpHeader headers[5];
+    int count = 0;
+    if (body != nullptr) {
+        headers[count++] = {"Content-Type", "application/json; charset=utf8"};
+    }
+    headers[count++] = {"Authorization", SWITCHBOT_TOKEN};
+    headers[count++] = {"t", auth.t};
+    headers[count++] = {"nonce", auth.nonce};
+    headers[count++] = {"sign", auth.sign};
 
-    HTTPClient https;
-    String url = "https://api.switch-bot.com/v1.1/devices/" + deviceId + "/commands";
+    HalHttpTiming timing;
+    int code = halHttpRequest(url, headers, count, body, timeoutMs, feedParser<Parser>, &parser, &timing);
 
-    // t は13桁ミリ秒（UNIXタイムスタンプ）
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    int64_t epochMs = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
-    String t = String(epochMs);
-    String nonce = makeNonce();
-    String sign = makeSign(SWITCHBOT_TOKEN, SWITCHBOT_SECRET, t, nonce);
+    uint32_t totalUs = micros() - start;
+    apiMetricsHeapEnd(endpoint, heap);
+    apiMetricsRecord(endpoint, timing, totalUs, code >= 200 && code < 300);
 
-    String body = "{\"command\":\"" + command + "\",\"parameter\":\"" + parameter + "\",\"commandType\":\"command\"}";
+    Serial.printf("HTTP %d statusCode=%d (%s, %lu ms)\n", code, statusCodeOf(parser),
+                  timing.reused ? "reused" : "new session", (unsigned long)(totalUs / 1000));
+    return code;
+}
 
-    Serial.printf("Sending command to %s: %s (param: %s)\n", deviceId.c_str(), command.c_str(), parameter.c_str());
+// HTTPステータスとレスポンスの statusCode から成否を判定
+template <typename Parser>
+static bool isSuccess(int code, const Parser& parser) {
+    if (code < 200 || code >= 300) {
+        return false;
+    }
+    int statusCode = statusCodeOf(parser);
+    if (statusCode >= 0 && statusCode != SWITCHBOT_STATUS_SUCCESS) {
+        Serial.printf("API error: statusCode=%d\n", statusCode);
+        return false;
+    }
+    return true;
+}
 
-    if (!https.begin(client, url)) {
-        Serial.println("Failed to begin HTTPS");
+// SwitchBot APIにコマンドを送信
+static bool sendCommand(const char* deviceId, const char* command, const char* parameter) {
+    if (deviceId == nullptr || deviceId[0] == '\0') {
+        Serial.println("Error: deviceId is empty");
         return false;
     }
 
-    https.addHeader("Content-Type", "application/json; charset=utf8");
-    https.addHeader("Authorization", SWITCHBOT_TOKEN);
-    https.addHeader("t", t);
-    https.addHeader("nonce", nonce);
-    https.addHeader("sign", sign);
+    RequestBuffer req;
+    if (!formatInto(req.url, sizeof(req.url), API_HOST "/devices/%s/commands", deviceId) ||
+        !formatInto(req.body, sizeof(req.body),
+                    "{\"command\":\"%s\",\"parameter\":\"%s\",\"commandType\":\"command\"}", command,
+                    parameter)) {
+        return false;
+    }
 
-    int code = https.POST(body);
-    String resp = https.getString();
-    https.end();
+    Serial.printf("Sending command to %s: %s (param: %s)\n", deviceId, command, parameter);
 
-    Serial.printf("HTTP %d\n%s\n", code, resp.c_str());
-    return (code >= 200 && code < 300);
+    DeviceStatusParser parser(STATUS_FIELD_STATUS_CODE);
+    int code = performRequest(req.url, req.body, parser, API_ENDPOINT_COMMAND, API_COMMAND_TIMEOUT_MS);
+    return isSuccess(code, parser);
 }
 
 void switchbotApiInit() {
-    // 将来の拡張用
+    signer.begin(SWITCHBOT_TOKEN, SWITCHBOT_SECRET);
+    halHttpInit();
 }
 
-bool switchbotBulbPower(const String& deviceId, bool on) {
+bool switchbotBulbPower(const char* deviceId, bool on) {
     return sendCommand(deviceId, on ? "turnOn" : "turnOff", "default");
 }
 
-bool switchbotBulbBrightness(const String& deviceId, int brightness) {
+bool switchbotBulbBrightness(const char* deviceId, int brightness) {
     // 明るさは1-100の範囲
-    brightness = constrain(brightness, 1, 100);
-    return sendCommand(deviceId, "setBrightness", String(brightness));
+    char parameter[8];
+    snprintf(parameter, sizeof(parameter), "%d", constrain(brightness, 1, 100));
+    return sendCommand(deviceId, "setBrightness", parameter);
+}
+
+bool switchbotBulbColor(const char* deviceId, uint32_t rgb) {
+    // パラメーターは "R:G:B"（各0-255）
+    char parameter[16];
+    snprintf(parameter, sizeof(parameter), "%lu:%lu:%lu", (unsigned long)((rgb >> 16) & 0xFF),
+             (unsigned long)((rgb >> 8) & 0xFF), (unsigned long)(rgb & 0xFF));
+    return sendCommand(deviceId, "setColor", parameter);
 }
 
-bool switchbotMeterStatus(const String& deviceId, float& temperature, int& humidity) {
-    if (deviceId.isEmpty()) {
+bool switchbotDeviceStatus(const char* deviceId, uint16_t fields, DeviceStatus& status) {
+    if (deviceId == nullptr || deviceId[0] == '\0') {
         Serial.println("Error: deviceId is empty");
         return false;
     }
 
-    WiFiClientSecure client;
-    client.setInsecure();
-
-    HTTPClient https;
-    String url = "https://api.switch-bot.com/v1.1/devices/" + deviceId + "/status";
-
-    // t は13桁ミリ秒（UNIXタイムスタンプ）
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    int64_t epochMs = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
-    String t = String(epochMs);
-    String nonce = makeNonce();
-    String sign = makeSign(SWITCHBOT_TOKEN, SWITCHBOT_SECRET, t, nonce);
-
-    Serial.printf("Getting status for %s\n", deviceId.c_str());
-
-    if (!https.begin(client, url)) {
-        Serial.println("Failed to begin HTTPS");
+    RequestBuffer req;
+    if (!formatInto(req.url, sizeof(req.url), API_HOST "/devices/%s/status", deviceId)) {
         return false;
     }
 
-    https.addHeader("Authorization", SWITCHBOT_TOKEN);
-    https.addHeader("t", t);
-    https.addHeader("nonce", nonce);
-    https.addHeader("sign", sign);
-
-    int code = https.GET();
-    String resp = https.getString();
-    https.end();
+    Serial.printf("Getting status for %s\n", deviceId);
 
-    Serial.printf("HTTP %d\n%s\n", code, resp.c_str());
+    // 必要なフィールドが揃った時点で解析を打ち切る
+    DeviceStatusParser parser(fields | STATUS_FIELD_STATUS_CODE);
+    int code = performRequest(req.url, nullptr, parser, API_ENDPOINT_STATUS, API_STATUS_TIMEOUT_MS);
+    status = parser.result();
 
-    if (code < 200 || code >= 300) {
+    if (!isSuccess(code, parser)) {
         return false;
     }
-
-    // 簡易JSONパース（temperatureとhumidityを抽出）
-    int tempIdx = resp.indexOf("\"temperature\":");
-    int humIdx = resp.indexOf("\"humidity\":");
-
-    if (tempIdx < 0 || humIdx < 0) {
+    if (!parser.complete()) {
         Serial.println("Failed to parse response");
         return false;
     }
-
-    // temperature の値を抽出
-    int tempStart = tempIdx + 14;
-    int tempEnd = resp.indexOf(",", tempStart);
-    if (tempEnd < 0) tempEnd = resp.indexOf("}", tempStart);
-    String tempStr = resp.substring(tempStart, tempEnd);
-    temperature = tempStr.toFloat();
-
-    // humidity の値を抽出
-    int humStart = humIdx + 11;
-    int humEnd = resp.indexOf(",", humStart);
-    if (humEnd < 0) humEnd = resp.indexOf("}", humStart);
-    String humStr = resp.substring(humStart, humEnd);
-    humidity = humStr.toInt();
-
-    Serial.printf("Parsed: temp=%.1f, humidity=%d\n", temperature, humidity);
     return true;
 }
 
-bool switchbotBulbStatus(const String& deviceId, bool& powerState, int& brightness) {
-    if (deviceId.isEmpty()) {
-        Serial.println("Error: deviceId is empty");
+bool switchbotMeterStatus(const char* deviceId, float& temperature, int& humidity) {
+    DeviceStatus status;
+    if (!switchbotDeviceStatus(deviceId, STATUS_FIELDS_METER, status)) {
         return false;
     }
 
-    WiFiClientSecure client;
-    client.setInsecure();
-
-    HTTPClient https;
-    String url = "https://api.switch-bot.com/v1.1/devices/" + deviceId + "/status";
-
-    // t は13桁ミリ秒（UNIXタイムスタンプ）
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    int64_t epochMs = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
-    String t = String(epochMs);
-    String nonce = makeNonce();
-    String sign = makeSign(SWITCHBOT_TOKEN, SWITCHBOT_SECRET, t, nonce);
-
-    Serial.printf("Getting bulb status for %s\n", deviceId.c_str());
+    temperature = status.temperature;
+    humidity = status.humidity;
+    Serial.printf("Parsed: temp=%.1f, humidity=%d\n", temperature, humidity);
+    return true;
+}
 
-    if (!https.begin(client, url)) {
-        Serial.println("Failed to begin HTTPS");
+bool switchbotBulbStatus(const char* deviceId, bool& powerState, int& brightness) {
+    DeviceStatus status;
+    if (!switchbotDeviceStatus(deviceId, STATUS_FIELDS_BULB, status)) {
         return false;
     }
 
-    https.addHeader("Authorization", SWITCHBOT_TOKEN);
-    https.addHeader("t", t);
-    https.addHeader("nonce", nonce);
-    https.addHeader("sign", sign);
+    powerState = status.power;
+    brightness = status.brightness;
+    Serial.printf("Parsed: power=%s, brightness=%d\n", powerState ? "on" : "off", brightness);
+    return true;
+}
 
-    int code = https.GET();
-    String resp = https.getString();
-    https.end();
+bool switchbotDeviceList(DeviceListHandler handler, void* ctx) {
+    Serial.println("Getting device list");
 
-    Serial.printf("HTTP %d\n%s\n", code, resp.c_str());
+    // 一覧は電球・温湿度計を1件ずつ handler に渡し、ボディ全体は保持しない
+    DeviceListParser parser(handler, ctx);
+    int code = performRequest(API_HOST "/devices", nullptr, parser, API_ENDPOINT_DEVICES,
+                              API_DEVICES_TIMEOUT_MS);
 
-    if (code < 200 || code >= 300) {
+    if (!isSuccess(code, parser)) {
         return false;
     }
-
-    // 簡易JSONパース（powerとbrightnessを抽出）
-    int powerIdx = resp.indexOf("\"power\":");
-    int brightnessIdx = resp.indexOf("\"brightness\":");
-
-    if (powerIdx < 0 || brightnessIdx < 0) {
-        Serial.println("Failed to parse bulb response");
+    if (parser.failed() || !parser.finished()) {
+        Serial.println("Failed to parse device list");
         return false;
     }
-
-    // power の値を抽出（"on" or "off"）
-    int powerStart = resp.indexOf("\"", powerIdx + 8) + 1;
-    int powerEnd = resp.indexOf("\"", powerStart);
-    String powerStr = resp.substring(powerStart, powerEnd);
-    powerState = (powerStr == "on");
-
-    // brightness の値を抽出
-    int brightStart = brightnessIdx + 13;
-    int brightEnd = resp.indexOf(",", brightStart);
-    if (brightEnd < 0) brightEnd = resp.indexOf("}", brightStart);
-    String brightStr = resp.substring(brightStart, brightEnd);
-    brightness = brightStr.toInt();
-
-    Serial.printf("Parsed: power=%s, brightness=%d\n", powerState ? "on" : "off", brightness);
+    Serial.printf("Device list: %d devices, %d bulbs/meters\n", parser.listed(), parser.accepted());
     return true;
 }
@@ -2,6 +2,8 @@
 #define SWITCHBOT_API_H
 
 #include <Arduino.h>
+#include "device_status.h"
+#include "device_list.h"
 
 // SwitchBot API初期化
 void switchbotApiInit();
@@ -10,26 +12,44 @@ void switchbotApiInit();
 // deviceId: デバイスID
 // on: true=ON, false=OFF
 // 戻り値: 成功=true, 失敗=false
-bool switchbotBulbPower(const String& deviceId, bool on);
+bool switchbotBulbPower(const char* deviceId, bool on);
 
 // 電球の明るさ制御
 // deviceId: デバイスID
 // brightness: 明るさ（1-100）
 // 戻り値: 成功=true, 失敗=false
-bool switchbotBulbBrightness(const String& deviceId, int brightness);
+bool switchbotBulbBrightness(const char* deviceId, int brightness);
+
+// 電球の色制御
+// deviceId: デバイスID
+// rgb: 色（0xRRGGBB）
+// 戻り値: 成功=true, 失敗=false
+bool switchbotBulbColor(const char* deviceId, uint32_t rgb);
+
+// デバイスのステータス取得（必要なフィールドだけをストリーミング解析）
+// deviceId: デバイスID
+// fields: 取り出すフィールド（STATUS_FIELD_* の組み合わせ）
+// status: 取得したステータスを格納
+// 戻り値: 成功（要求した全フィールドを取得）=true, 失敗=false
+bool switchbotDeviceStatus(const char* deviceId, uint16_t fields, DeviceStatus& status);
 
 // 温湿度計のステータス取得
 // deviceId: デバイスID
 // temperature: 取得した温度を格納
 // humidity: 取得した湿度を格納
 // 戻り値: 成功=true, 失敗=false
-bool switchbotMeterStatus(const String& deviceId, float& temperature, int& humidity);
+bool switchbotMeterStatus(const char* deviceId, float& temperature, int& humidity);
 
 // 電球のステータス取得
 // deviceId: デバイスID
 // powerState: 取得した電源状態を格納
 // brightness: 取得した明るさを格納
 // 戻り値: 成功=true, 失敗=false
-bool switchbotBulbStatus(const String& deviceId, bool& powerState, int& brightness);
+bool switchbotBulbStatus(const char* deviceId, bool& powerState, int& brightness);
+
+// デバイス一覧の取得（GET /v1.1/devices）
+// handler: 電球・温湿度計を1件見つけるごとに呼ばれる（呼び出したタスクで実行）
+// 戻り値: 一覧を最後まで読めた=true, 失敗=false（途中まで handler が呼ばれていることがある）
+bool switchbotDeviceList(DeviceListHandler handler, void* ctx);
 
 #endif // SWITCHBOT_API_H
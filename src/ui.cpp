@@ -1,6 +1,28 @@
 #include "ui.h"
-#include "switchbot_api.h"
-#include "devices.h"
+#include "api_worker.h"
+#include "command_coalescer.h"
+#include "scene.h"
+#include "device_registry.h"
+#include "device_discovery.h"
+#include "last_state.h"
+#include "meter_history.h"
+#include "state_cache.h"
+#include "poll_policy.h"
+#include "webhook.h"
+#include "boot.h"
+#include "event_loop.h"
+#include "ui_layout.h"
+#include "ui_render.h"
+#include "ui_dirty.h"
+#include "gesture.h"
+#include "loop_profiler.h"
+#include "api_quota.h"
+#include "hal/hal_display.h"
+#include "hal/hal_event.h"
+#include "hal/hal_power.h"
+#include "hal/hal_touch.h"
+
+#include <time.h>
 
 // バックライト制御用
 #define BACKLIGHT_MAX 255
@@ -8,285 +30,553 @@
 
 static void setBacklight(uint8_t brightness)
 {
-    M5.Display.setBrightness(brightness);
-}
-
-// 画面サイズ
-#define SCREEN_WIDTH 1280
-#define SCREEN_HEIGHT 720
-
-// UIレイアウト定数
-#define HEADER_HEIGHT 80
-#define PANEL_MARGIN 20
-#define PANEL_WIDTH ((SCREEN_WIDTH - PANEL_MARGIN * 5) / 4)
-#define PANEL_HEIGHT (SCREEN_HEIGHT - HEADER_HEIGHT - PANEL_MARGIN * 2)
-#define BUTTON_HEIGHT 150
-#define SLIDER_HEIGHT 40
-#define SLIDER_MARGIN 30
-
-// 色定義
-#define COLOR_BG 0x1082
-#define COLOR_PANEL 0x2945
-#define COLOR_HEADER 0x001F
-#define COLOR_ON 0x07E0
-#define COLOR_OFF 0xF800
-#define COLOR_SLIDER_BG 0x4208
-#define COLOR_SLIDER_FG 0xFFE0
-#define COLOR_TEXT 0xFFFF
-#define COLOR_DISABLED 0x6B4D
-
-// パネル用スプライト（1つを再利用）
-static M5Canvas panelSprite(&M5.Display);
-
-// スライダードラッグ状態（自前実装）
+    halDisplaySetBacklight(brightness);
+}
+
+// ドラッグ中のスライダーの電球（タッチ操作の認識は gesture.h）
 static int activeSlider = -1;
-static int sliderStartX = 0;
-static bool sliderDragged = false;
-#define SLIDER_DRAG_THRESHOLD 20
 
-// API呼び出し制御
-static unsigned long lastApiCall = 0;
-#define API_DEBOUNCE_MS 500
+// 電球のページの後ろに並べるシーン・グループのボタン（シーン、グループの順、長押しで実行）
+#define UI_SHORTCUT_MAX 16
+static ShortcutPanel shortcuts[UI_SHORTCUT_MAX];
+static int shortcutCount = 0;
 
-// ボタン長押し検出用
-static int pressedButtonIndex = -1;
-static unsigned long buttonPressStartTime = 0;
-#define BUTTON_LONG_PRESS_MS 500
+// ドラッグ中も明るさを送信する（送信間隔は COALESCE_STREAM_INTERVAL_MS で制限）
+#define SLIDER_STREAM_WHILE_DRAGGING 0
+
+// 1ループで処理するAPI完了通知の上限（uiUpdate の処理時間を抑える）
+#define API_DISPATCH_PER_LOOP 4
 
 // 画面オフ機能
 static unsigned long lastTouchTime = 0;
 static bool screenDimmed = false;
 static unsigned long wakeUpTime = 0;
+#ifndef SCREEN_OFF_TIMEOUT_MS
 #define SCREEN_OFF_TIMEOUT_MS 30000
+#endif
 #define WAKE_UP_IGNORE_MS 300
 
-// 状態取得機能
-static unsigned long lastStatusUpdate = 0;
-static bool operationOccurred = false;
-#define STATUS_UPDATE_INTERVAL_MS 10000
+// 状態取得の種類（ジョブの value に入れて結果で見分ける）
+// 表示中のページの取得は value に電球ごとの取得の番号（投入のたびに増やす、0 以上）を入れる
+#define STATUS_JOB_RECONCILE -1 // 操作した電球の確認
+
+// 表示中のページの状態取得（並列）の電球ごとの番号と経過計測
+// 同じ電球に新しい取得を投入したら、前の番号の結果は onBulbStatus で捨てる
+static int statusSeq[REGISTRY_MAX_BULBS];
+static bool statusInFlight[REGISTRY_MAX_BULBS]; // statusSeq の取得の結果を待っている
+static unsigned long refreshStartTime = 0;
+static int refreshRemaining = 0;                // 結果を待っている取得の数（全ページ）
+
+// refreshVisible で数えた表示中のページの電球
+struct RefreshCounts
+{
+    int submitted; // 投入した
+    int inFlight;  // 前の取得の結果を待っているので投入しなかった
+    int fresh;     // 新しいので取得を省いた
+};
 
 // 遅延OFF機能
 static int pendingOffBulbIndex = -1;
 static unsigned long pendingOffStartTime = 0;
 #define BULB_OFF_DELAY_MS 5000
 
-// バッテリー監視
+// バッテリー監視（間隔はポリシーの batteryMs、画面オンで10秒）
 static int batteryLevel = -1;
 static unsigned long lastBatteryUpdate = 0;
-#define BATTERY_UPDATE_INTERVAL_MS 10000
-
-// 座標計算
-static int getPanelX(int index) { return PANEL_MARGIN + index * (PANEL_WIDTH + PANEL_MARGIN); }
-static int getPanelY() { return HEADER_HEIGHT + PANEL_MARGIN; }
-static int getButtonX(int index) { return getPanelX(index) + 20; }
-static int getButtonY() { return getPanelY() + 60; }
-static int getButtonWidth() { return PANEL_WIDTH - 40; }
-static int getSliderX(int index) { return getPanelX(index) + SLIDER_MARGIN; }
-static int getSliderY() { return getButtonY() + BUTTON_HEIGHT + 40; }
-static int getSliderWidth() { return PANEL_WIDTH - SLIDER_MARGIN * 2; }
+
+// 減光中に後回しにしたページ全体の状態取得を、復帰時に行う
+static bool refreshOnWake = false;
+
+static RefreshCounts refreshVisible(bool staleOnly, uint32_t ttlMs);
+static void refreshAfterWake();
+
+// タッチを読み取った時刻（タッチ→表示の遅延計測用）
+static uint32_t touchSampleUs = 0;
+
+// 前回ループで処理しきれなかった API の完了通知がある
+static bool dispatchBacklog = false;
 
 // バッテリー状態更新
 static void updateBatteryStatus()
 {
-    batteryLevel = M5.Power.getBatteryLevel();
+    profilerEnter(PROFILE_BATTERY);
+    batteryLevel = halBatteryLevel();
+    pollPolicyNotePower(batteryLevel, halBatteryCharging());
+    profilerLeave();
 }
 
-// ヘッダー描画（直接描画）
-static void drawHeader()
+// タッチ操作で変化したパネルを描き直す
+static void renderTouchedPanel(int index)
 {
-    M5.Display.fillRect(0, 0, SCREEN_WIDTH, HEADER_HEIGHT, COLOR_HEADER);
-    M5.Display.setTextColor(COLOR_TEXT);
-    M5.Display.setTextSize(1);
-    M5.Display.setFont(&fonts::FreeSansBold18pt7b);
-    M5.Display.setTextDatum(ML_DATUM);
-    M5.Display.drawString("SwitchBot Controller", 20, HEADER_HEIGHT / 2);
+    profilerEnter(PROFILE_RENDER);
+    renderBulbPanel(index);
+    profilerLeave();
+    profilerNoteInput(touchSampleUs);
+}
 
-    // バッテリー表示（中央）
-    M5.Display.setTextDatum(MC_DATUM);
-    char battStr[16];
-    if (batteryLevel >= 0)
-    {
-        snprintf(battStr, sizeof(battStr), "BAT %d%%", batteryLevel);
-    }
-    else
-    {
-        strcpy(battStr, "BAT --");
-    }
-    M5.Display.drawString(battStr, SCREEN_WIDTH / 2, HEADER_HEIGHT / 2);
+// 表示中のページのパネル位置に並ぶ電球（なければ・背景なら -1）
+static int deviceAtSlot(int slot)
+{
+    if (slot < 0)
+        return -1;
+    int device = renderGetPage() * PANELS_PER_PAGE + slot;
+    return device < bulbs.count ? device : -1;
+}
 
-    // 温湿度表示（右側）
-    M5.Display.setTextDatum(MR_DATUM);
-    if (meter.valid)
-    {
-        char tempHumStr[32];
-        snprintf(tempHumStr, sizeof(tempHumStr), "%.1fC  %d%%", meter.temperature, meter.humidity);
-        M5.Display.drawString(tempHumStr, SCREEN_WIDTH - 20, HEADER_HEIGHT / 2);
-    }
-    else
+// 表示中のページのパネル位置に並ぶシーン・グループのボタン（なければ -1）
+static int shortcutAtSlot(int slot)
+{
+    if (slot < 0 || renderGetPage() < bulbPageCount())
+        return -1;
+    int entry = (renderGetPage() - bulbPageCount()) * PANELS_PER_PAGE + slot;
+    return entry < shortcutCount ? entry : -1;
+}
+
+// シーン・グループのボタンを並べる
+static void initShortcuts()
+{
+    shortcutCount = 0;
+    for (int i = 0; i < sceneCount() && shortcutCount < UI_SHORTCUT_MAX; i++)
+        shortcuts[shortcutCount++] = {sceneName(i), false, false};
+    for (int i = 0; i < groupCount() && shortcutCount < UI_SHORTCUT_MAX; i++)
+        shortcuts[shortcutCount++] = {groupName(i), true, sceneGroupAnyOn(i)};
+    renderSetShortcuts(shortcuts, shortcutCount);
+}
+
+// グループのボタンの ON/OFF を電球の状態に合わせ、表示中なら描き直す
+static void updateShortcuts()
+{
+    int group = 0;
+    for (int i = 0; i < shortcutCount; i++)
     {
-        M5.Display.drawString("--C  --%", SCREEN_WIDTH - 20, HEADER_HEIGHT / 2);
+        if (shortcuts[i].group)
+            shortcuts[i].on = sceneGroupAnyOn(group++);
     }
+    profilerEnter(PROFILE_RENDER);
+    renderShortcutPanels();
+    profilerLeave();
 }
 
-// 電球パネル描画（スプライト使用）
-static void drawBulbPanel(int index)
+// シーン・グループのボタンの長押し
+static void activateShortcut(int entry)
 {
-    BulbDevice &bulb = bulbs[index];
-    int panelX = getPanelX(index);
-    int panelY = getPanelY();
-    bool enabled = !bulb.deviceId.isEmpty();
+    int scenes = min(sceneCount(), UI_SHORTCUT_MAX);
+    bool started = entry < scenes ? uiActivateScene(entry) : uiToggleGroup(entry - scenes);
+    Serial.printf("Shortcut %s: %s\n", shortcuts[entry].name, started ? "started" : "busy");
+    profilerNoteInput(touchSampleUs);
+}
 
-    // スプライトに描画
-    panelSprite.fillSprite(COLOR_PANEL);
-    panelSprite.fillRoundRect(0, 0, PANEL_WIDTH, PANEL_HEIGHT, 10, COLOR_PANEL);
+// スライダー値を計算
+static int calculateSliderValue(int index, int tx)
+{
+    int sliderX = getSliderX(index % PANELS_PER_PAGE);
+    int sliderW = getSliderWidth();
+    int value = ((tx - sliderX) * 100) / sliderW;
+    return constrain(value, 1, 100);
+}
 
-    // 電球名
-    panelSprite.setTextSize(1);
-    panelSprite.setFont(&fonts::lgfxJapanGothic_28);
-    panelSprite.setTextColor(enabled ? COLOR_TEXT : COLOR_DISABLED);
-    panelSprite.setTextDatum(MC_DATUM);
-    panelSprite.drawString(bulb.name.c_str(), PANEL_WIDTH / 2, 35);
+// 表示中のページのパネルを描き直す（変化した部品だけ）
+static void renderVisiblePanels()
+{
+    int first = renderGetPage() * PANELS_PER_PAGE;
+    int last = min(first + PANELS_PER_PAGE, bulbs.count);
+    profilerEnter(PROFILE_RENDER);
+    for (int i = first; i < last; i++)
+    {
+        renderBulbPanel(i);
+    }
+    profilerLeave();
+}
+
+// 電球ステータス取得完了（UIスレッドで呼ばれる）
+static void onBulbStatus(const ApiResult &result)
+{
+    bool reconcile = result.value == STATUS_JOB_RECONCILE;
+    if (!reconcile)
+    {
+        // 同じ電球に後から投入した取得があれば、この結果は数えず値も反映しない
+        // （後の取得の結果より後に届くことがある）
+        if (result.value != statusSeq[result.index] || !statusInFlight[result.index])
+            return;
+        statusInFlight[result.index] = false;
+        if (refreshRemaining > 0 && --refreshRemaining == 0)
+        {
+            Serial.printf("Bulb status refresh done in %lu ms\n", millis() - refreshStartTime);
+            bootNoteStatusDone();
+        }
+    }
 
-    // ON/OFFボタン（パネル内座標）
-    int btnX = 20;
-    int btnY = 60;
-    int btnW = PANEL_WIDTH - 40;
-    uint16_t btnColor = !enabled ? COLOR_DISABLED : (bulb.powerState ? COLOR_ON : COLOR_OFF);
+    // 操作した電球の確認を捨てたら予定を入れ直す（失敗はしばらく待ち、操作中なら終わってから確かめる）
+    if (!result.success)
+    {
+        if (reconcile)
+            stateCacheNoteDropped(result.index, millis(),
+                                  apiQuotaStretch(STATE_RECONCILE_DELAY_MS, apiQuotaNowSec()));
+        return;
+    }
 
-    panelSprite.fillRoundRect(btnX, btnY, btnW, BUTTON_HEIGHT, 8, btnColor);
-    panelSprite.setFont(&fonts::FreeSansBold18pt7b);
-    panelSprite.setTextColor(COLOR_TEXT);
-    panelSprite.drawString(bulb.powerState ? "ON" : "OFF", btnX + btnW / 2, btnY + BUTTON_HEIGHT / 2);
+    // 操作中・送信待ちの電球は画面の状態を優先
+    if (result.index == activeSlider || result.index == pendingOffBulbIndex || !coalescerIdle(result.index) ||
+        !sceneIdle(result.index))
+    {
+        if (reconcile)
+            stateCacheNoteDropped(result.index, millis(), 0);
+        return;
+    }
 
-    // スライダー（パネル内座標）
-    int sliderX = SLIDER_MARGIN;
-    int sliderY = btnY + BUTTON_HEIGHT + 40;
-    int sliderW = PANEL_WIDTH - SLIDER_MARGIN * 2;
+    coalescerNoteStatus(result.index, result.powerState, result.brightness);
+    stateCacheNoteConfirmed(result.index, millis());
 
-    panelSprite.fillRoundRect(sliderX, sliderY, sliderW, SLIDER_HEIGHT, 5, COLOR_SLIDER_BG);
+    uiUpdateBulbState(result.index, result.powerState, result.brightness);
+    Serial.printf("Bulb %d: power=%s, brightness=%d\n", result.index, result.powerState ? "on" : "off", result.brightness);
+}
 
-    if (enabled && bulb.powerState)
+// 電球コマンド完了（UIスレッドで呼ばれる）
+// 失敗は送り直してもあきらめたときだけ届くので、すぐに状態を確かめて画面を実際の状態に合わせる
+// 成功応答（statusCode 100）で表示している電源・明るさがどちらも受け付けられた値なら、状態を確かめる取得を省く
+// （続けて送る指示があるか、明るさを一度も確認していなければ予定どおり確かめる）
+static void onBulbCommand(const ApiResult &result)
+{
+    int index = result.index;
+    if (!result.success)
     {
-        int fillW = (sliderW * bulb.brightness) / 100;
-        panelSprite.fillRoundRect(sliderX, sliderY, fillW, SLIDER_HEIGHT, 5, COLOR_SLIDER_FG);
+        Serial.printf("Command failed: bulb %d (type=%d, value=%d)\n", index, (int)result.type, result.value);
+        stateCacheNoteFailed(index, millis());
+        return;
     }
 
-    if (enabled)
+    if (index == activeSlider || index == pendingOffBulbIndex || !coalescerIdle(index) || !sceneIdle(index))
+        return;
+    if (coalescerConfirmed(index, API_JOB_BULB_POWER, bulbs.powerState[index] ? 1 : 0) &&
+        coalescerConfirmed(index, API_JOB_BULB_BRIGHTNESS, bulbs.brightness[index]))
+        stateCacheNoteAccepted(index, millis());
+}
+
+// シーン・グループ実行完了（UIスレッドで呼ばれる）
+static void onSceneDone(const SceneSummary &summary)
+{
+    // 失敗したコマンドがあれば画面を実際の状態に合わせる
+    if (summary.failed > 0)
     {
-        int handleX = sliderX + (sliderW * bulb.brightness) / 100;
-        panelSprite.fillCircle(handleX, sliderY + SLIDER_HEIGHT / 2, 15, COLOR_TEXT);
+        uiRefreshVisibleBulbStatus();
     }
+}
+
+// 操作した値を表示した（しばらくしてからこの電球だけ状態を確かめる）
+// Webhook のイベントが届いている間は、変化のイベントで確認できるので待ち時間を延ばす
+static void noteOperated(int index, unsigned long now)
+{
+    uint32_t delayMs = webhookActive(now) ? WEBHOOK_CONFIRM_WAIT_MS : STATE_RECONCILE_DELAY_MS;
+    stateCacheNoteOptimistic(index, now, apiQuotaStretch(delayMs, apiQuotaNowSec()));
+}
 
-    // 明るさ表示
-    panelSprite.setFont(&fonts::FreeSansBold12pt7b);
-    panelSprite.setTextColor(enabled ? COLOR_TEXT : COLOR_DISABLED);
-    char brightnessStr[16];
-    if (enabled && bulb.powerState)
+// Webhook のイベント（UIスレッドで呼ばれる）
+// 変化した電球のパネル・温湿度だけを描き直す（表示中のページにない電球は値だけ更新）
+static bool onWebhookEvent(const WebhookEvent &event)
+{
+    const DeviceStatus &s = event.status;
+    if (strcmp(event.deviceId, meter.deviceId) == 0)
     {
-        snprintf(brightnessStr, sizeof(brightnessStr), "%d%%", bulb.brightness);
+        if ((s.found & (STATUS_FIELD_TEMPERATURE | STATUS_FIELD_HUMIDITY)) == 0)
+            return false;
+        if (s.found & STATUS_FIELD_TEMPERATURE)
+            meter.temperature = s.temperature;
+        if (s.found & STATUS_FIELD_HUMIDITY)
+            meter.humidity = s.humidity;
+        meter.valid = true;
+        uiUpdateMeter();
+        return true;
     }
-    else
+
+    int index = registryFindBulb(event.deviceId);
+    if (index < 0 || (s.found & STATUS_FIELD_POWER) == 0)
+        return false;
+
+    // 操作中・送信待ちの電球は画面の状態を優先（送信後の確認に任せる）
+    if (index == activeSlider || index == pendingOffBulbIndex || !coalescerIdle(index) || !sceneIdle(index))
+        return true;
+
+    int brightness = (s.found & STATUS_FIELD_BRIGHTNESS) ? constrain(s.brightness, 1, 100) : bulbs.brightness[index];
+    coalescerNoteStatus(index, s.power, brightness);
+    stateCacheNoteConfirmed(index, millis());
+
+    uiUpdateBulbState(index, s.power, brightness);
+    Serial.printf("Bulb %d (webhook): power=%s, brightness=%d\n", index, s.power ? "on" : "off", brightness);
+    return true;
+}
+
+// 確かめる時刻になった電球の状態取得を投入（操作中・送信待ちの電球は後回し）
+static void reconcileOperatedBulbs(unsigned long now)
+{
+    if (stateCacheReconcilePending() == 0)
+        return;
+
+    for (int i = 0; i < bulbs.count; i++)
     {
-        strcpy(brightnessStr, bulb.powerState ? "100%" : "OFF");
+        if (!stateCacheReconcileDue(i, now))
+            continue;
+        if (i == activeSlider || i == pendingOffBulbIndex || !coalescerIdle(i) || !sceneIdle(i))
+            continue;
+        if (!apiWorkerSubmit(API_JOB_BULB_STATUS, bulbs.deviceId[i], i, STATUS_JOB_RECONCILE, onBulbStatus))
+            break;
+        stateCacheNoteRequested(i, true);
     }
-    panelSprite.drawString(brightnessStr, PANEL_WIDTH / 2, sliderY + SLIDER_HEIGHT + 40);
+}
 
-    if (!enabled)
+// 登録簿を差し替えてよいか（デバイス番号を持つ操作・送信がない）
+static bool devicesQuiet()
+{
+    if (apiWorkerPending() > 0 || sceneRunning() || gestureActive() ||
+        pendingOffBulbIndex >= 0)
+        return false;
+    for (int i = 0; i < bulbs.count; i++)
     {
-        panelSprite.setFont(&fonts::lgfxJapanGothic_20);
-        panelSprite.setTextColor(COLOR_DISABLED);
-        panelSprite.drawString("(ID未設定)", PANEL_WIDTH / 2, sliderY + SLIDER_HEIGHT + 70);
+        if (!coalescerIdle(i))
+            return false;
     }
+    return true;
+}
+
+// 再取得したデバイス一覧を反映して描き直す
+static void applyDiscoveredDevices()
+{
+    if (!discoveryApply())
+        return;
+
+    // デバイス番号が変わるので、送信済みの値と状態の出どころを捨てる
+    coalescerInit(onBulbCommand);
+    stateCacheInit();
 
-    // スプライトを画面に転送
-    panelSprite.pushSprite(panelX, panelY);
+    profilerEnter(PROFILE_RENDER);
+    renderSetPage(0);
+    renderAll(batteryLevel);
+    profilerLeave();
+    uiRefreshVisibleBulbStatus();
 }
 
-// UI全体描画
-static void drawUI()
+// 押した部品で操作を始めてよいか（電球のない位置・OFF の電球のスライダーは背景として扱う）
+// シーン・グループのページはボタンだけ
+static bool acceptWidget(const GestureWidget &widget)
 {
-    M5.Display.fillScreen(COLOR_BG);
-    drawHeader();
-    for (int i = 0; i < NUM_BULBS; i++)
+    if (shortcutAtSlot(widget.slot) >= 0)
+        return widget.kind == WIDGET_BUTTON;
+    int device = deviceAtSlot(widget.slot);
+    if (!bulbEnabled(device))
+        return false;
+    return widget.kind != WIDGET_SLIDER || bulbs.powerState[device];
+}
+
+// 待っていた OFF を送る（その間に ON に戻されていれば送らない）
+static void sendPendingOff(unsigned long now)
+{
+    int idx = pendingOffBulbIndex;
+    pendingOffBulbIndex = -1;
+    if (!bulbs.powerState[idx])
     {
-        drawBulbPanel(i);
+        coalescerSetPower(idx, false);
+        noteOperated(idx, now);
     }
 }
 
-// ボタンタッチ判定
-static int checkButtonTouch(int tx, int ty)
+// ボタンの長押しで ON/OFF（OFF は BULB_OFF_DELAY_MS 後に送り、その間に押し直せば取り消す）
+static void toggleBulb(int index, unsigned long now)
 {
-    int btnY = getButtonY();
-    if (ty < btnY || ty > btnY + BUTTON_HEIGHT)
-        return -1;
+    bool wasOn = bulbs.powerState[index];
+    if (pendingOffBulbIndex == index)
+        pendingOffBulbIndex = -1;
+
+    // 待てる OFF は1台分なので、別の電球を押したら待っていた OFF はすぐに送る
+    if (pendingOffBulbIndex >= 0)
+        sendPendingOff(now);
+
+    bulbs.powerState[index] = !wasOn;
+    renderTouchedPanel(index);
 
-    for (int i = 0; i < NUM_BULBS; i++)
+    if (wasOn)
     {
-        int btnX = getButtonX(i);
-        int btnW = getButtonWidth();
-        if (tx >= btnX && tx <= btnX + btnW)
-            return i;
+        pendingOffBulbIndex = index;
+        pendingOffStartTime = now;
+    }
+    else
+    {
+        coalescerSetPower(index, true);
+        noteOperated(index, now);
     }
-    return -1;
 }
 
-// スライダータッチ判定
-static int checkSliderTouch(int tx, int ty)
+// スライダーのドラッグ中（表示だけ更新し、送信は離したとき）
+static void dragSlider(int tx)
 {
-    int sliderY = getSliderY();
-    if (ty < sliderY - 20 || ty > sliderY + SLIDER_HEIGHT + 20)
-        return -1;
+    int newBrightness = calculateSliderValue(activeSlider, tx);
+    if (newBrightness == bulbs.brightness[activeSlider])
+        return;
 
-    for (int i = 0; i < NUM_BULBS; i++)
-    {
-        int sliderX = getSliderX(i);
-        int sliderW = getSliderWidth();
-        if (tx >= sliderX - 20 && tx <= sliderX + sliderW + 20)
-            return i;
-    }
-    return -1;
+    bulbs.brightness[activeSlider] = newBrightness;
+    renderTouchedPanel(activeSlider);
+#if SLIDER_STREAM_WHILE_DRAGGING
+    coalescerSetBrightness(activeSlider, newBrightness, false);
+#endif
+    Serial.printf("[DEBUG] Dragging: x=%d, brightness=%d\n", tx, newBrightness);
 }
 
-// スライダー値を計算
-static int calculateSliderValue(int index, int tx)
+// 横スワイプで1ページ送る
+static void swipePage(int dx)
 {
-    int sliderX = getSliderX(index);
-    int sliderW = getSliderWidth();
-    int value = ((tx - sliderX) * 100) / sliderW;
-    return constrain(value, 1, 100);
+    int page = renderGetPage() + (dx < 0 ? 1 : -1);
+    if (page < 0 || page >= pageCount())
+        return;
+
+    if (page >= bulbPageCount())
+        updateShortcuts();
+    profilerEnter(PROFILE_RENDER);
+    renderSetPage(page);
+    profilerLeave();
+    profilerNoteInput(touchSampleUs);
+
+    // しばらく状態を取得していない電球だけ取得する
+    uiRefreshStaleBulbStatus();
+}
+
+// タッチ操作の認識から動作を受け取る（UIスレッド）
+static void onGesture(const GestureEvent &event)
+{
+    unsigned long now = event.at;
+    int device = deviceAtSlot(event.widget->slot);
+
+    switch (event.action)
+    {
+    case GESTURE_ACTION_PRESS:
+        if (event.widget->kind == WIDGET_SLIDER)
+        {
+            activeSlider = device;
+            Serial.printf("[DEBUG] Slider touch start: index=%d, startX=%d\n", device, event.x);
+        }
+        break;
+    case GESTURE_ACTION_DRAG:
+        if (activeSlider >= 0)
+            dragSlider(event.x);
+        break;
+    case GESTURE_ACTION_DRAG_END:
+        if (activeSlider >= 0)
+        {
+            // 送信中なら保留スロットを上書きし、完了後に最後の値だけを送る
+            coalescerSetBrightness(activeSlider, bulbs.brightness[activeSlider], true);
+            noteOperated(activeSlider, now);
+            Serial.printf("[DEBUG] Brightness requested: %d\n", bulbs.brightness[activeSlider]);
+        }
+        activeSlider = -1;
+        break;
+    case GESTURE_ACTION_TAP:
+    case GESTURE_ACTION_CANCEL:
+        activeSlider = -1;
+        break;
+    case GESTURE_ACTION_LONG_PRESS:
+        if (bulbEnabled(device))
+            toggleBulb(device, now);
+        else if (shortcutAtSlot(event.widget->slot) >= 0)
+            activateShortcut(shortcutAtSlot(event.widget->slot));
+        break;
+    case GESTURE_ACTION_SWIPE:
+        swipePage(event.dx);
+        break;
+    default:
+        break;
+    }
 }
 
 void uiInit()
 {
-    M5.Display.setRotation(1);
+    // 描画初期化
+    renderInit();
 
-    // パネル用スプライト作成（1パネル分のみ）
-    panelSprite.createSprite(PANEL_WIDTH, PANEL_HEIGHT);
+    // コマンド送信スロット初期化
+    coalescerInit(onBulbCommand);
+    sceneInit(onSceneDone);
+    webhookInit(onWebhookEvent);
+    gestureInit(acceptWidget, onGesture);
 
     // バッテリー状態初期化
+    pollPolicyInit(millis());
     updateBatteryStatus();
 
     lastTouchTime = millis();
-    drawUI();
+    initShortcuts();
+    renderAll(batteryLevel);
 }
 
-void uiUpdate()
+// 1ループ分の処理（タッチ・完了通知・タイマーで時刻が来たものを処理する）
+static void updateOnce()
 {
-    M5.update();
-
-    auto touch = M5.Touch.getDetail();
+    profilerEnter(PROFILE_TOUCH);
+    halTouchUpdate();
+    touchSampleUs = micros();
+    profilerLeave();
+
+    // 前回ループで描画した分を1フレームとして集計（DMA転送の完了を待つ）
+    profilerEnter(PROFILE_RENDER);
+    renderEndFrame();
+    profilerLeave();
+    profilerNotePresent();
+
+    // ネットワークワーカーの完了通知・Webhook のイベントを処理し、保留中のコマンドを送信
+    profilerEnter(PROFILE_NETWORK);
+    dispatchBacklog = (apiWorkerDispatch(API_DISPATCH_PER_LOOP) >= API_DISPATCH_PER_LOOP);
+    coalescerService(millis());
+    sceneService(millis());
+    webhookService(millis());
+    profilerLeave();
+
+    // 接続待ちの間はヘッダーに接続状態を出す
+    profilerEnter(PROFILE_RENDER);
+    renderSetTitle(bootStatusText());
+    profilerLeave();
+
+    // 再取得したデバイス一覧は操作・送信が途切れたときに反映する
+    if (discoveryUpdateReady() && devicesQuiet())
+        applyDiscoveredDevices();
+
+    TouchState touch = halTouchRead();
     unsigned long now = millis();
 
+    // バッテリー状態更新（減光中も充電状態を見るため間隔を空けて続ける）
+    if (now - lastBatteryUpdate >= pollPolicyRates().batteryMs)
+    {
+        lastBatteryUpdate = now;
+        int oldLevel = batteryLevel;
+        updateBatteryStatus();
+        if (batteryLevel != oldLevel)
+        {
+            profilerEnter(PROFILE_RENDER);
+            renderHeader(batteryLevel);
+            profilerLeave();
+        }
+    }
+
     // 減光中にタッチされたら復帰
     if (screenDimmed)
     {
-        if (touch.wasPressed())
+        if (touch.wasPressed)
         {
             screenDimmed = false;
             lastTouchTime = now;
             wakeUpTime = now;
+            gestureReset();
             setBacklight(BACKLIGHT_MAX);
-            uiRefreshAllBulbStatus();
+            refreshAfterWake();
+        }
+        else if (pollPolicyPrefetchDue(now))
+        {
+            // 減光の長さが揃っていれば見込んだ復帰の少し前に表示中のページを先読みし、復帰時に取得を待たずに済ませる
+            // 呼び出し回数の割り当てで間隔を引き延ばしている間は、なくても困らない先読みは見送る
+            if (apiQuotaStretch(STATE_TTL_MS, apiQuotaNowSec()) > STATE_TTL_MS)
+            {
+                pollPolicyNotePrefetchSkipped();
+            }
+            else
+            {
+                RefreshCounts counts = refreshVisible(true, STATE_TTL_MS);
+                pollPolicyNotePrefetch(counts.submitted);
+            }
         }
         return;
     }
@@ -303,181 +593,246 @@ void uiUpdate()
         {
             screenDimmed = true;
             setBacklight(BACKLIGHT_DIM);
+            gestureReset();
+            activeSlider = -1;
+
+            // 操作が途切れたところで、次の起動で表示する状態を保存する
+            // 温湿度の履歴は METER_HISTORY_CHECKPOINT_INTERVAL_MS に1回まで
+            lastStateSave(true);
+            meterHistoryCheckpoint(false);
         }
         return;
     }
 
-    int tx = touch.x;
-    int ty = touch.y;
-
-    // タッチ開始
-    if (touch.wasPressed())
-    {
+    // タッチ操作の認識（動作は onGesture で処理する）
+    if (touch.isPressed || touch.wasReleased)
         lastTouchTime = now;
+    gestureUpdate(touch, now);
 
-        // ボタンタッチ判定
-        int btnIndex = checkButtonTouch(tx, ty);
-        if (btnIndex >= 0 && !bulbs[btnIndex].deviceId.isEmpty())
-        {
-            pressedButtonIndex = btnIndex;
-            buttonPressStartTime = now;
-        }
+    // 遅延OFF処理
+    if (pendingOffBulbIndex >= 0 && (now - pendingOffStartTime >= BULB_OFF_DELAY_MS))
+        sendPendingOff(now);
 
-        // スライダータッチ開始
-        int sliderIndex = checkSliderTouch(tx, ty);
-        if (sliderIndex >= 0 && !bulbs[sliderIndex].deviceId.isEmpty() && bulbs[sliderIndex].powerState)
-        {
-            activeSlider = sliderIndex;
-            sliderStartX = tx;
-            sliderDragged = false;
-            Serial.printf("[DEBUG] Slider touch start: index=%d, startX=%d\n", sliderIndex, tx);
-        }
-    }
+    // 操作した電球だけ状態を確かめる
+    reconcileOperatedBulbs(now);
+}
 
-    // タッチ中（isPressed で継続的に追跡）
-    if (activeSlider >= 0 && touch.isPressed())
-    {
-        lastTouchTime = now;
-        int dragDistance = abs(tx - sliderStartX);
+// 時刻を待つ処理ごとに次にループを起こす時刻を決める
+static void scheduleWakeups(unsigned long now)
+{
+    unsigned long at;
+
+    // 描画の転送中・完了通知が残っている間だけ TICK ごと
+    // 操作中はタッチの割り込み（指が動いた・離した）と長押しの判定の時刻に起き、触れたまま止まっている間は回さない
+    TouchState touch = halTouchRead();
+    bool interacting = touch.isPressed || gestureActive();
+    if (renderFramePending() || dispatchBacklog)
+        eventLoopSchedule(LOOP_TIMER_ACTIVE, now + EVENT_LOOP_TICK_MS);
+    else if (!halTouchCanWake() && !screenDimmed && interacting)
+        // タッチ割り込みがなければ、触れている間は従来どおり TICK ごとに見に行く
+        eventLoopSchedule(LOOP_TIMER_ACTIVE, now + EVENT_LOOP_TICK_MS);
+    else if (!halTouchCanWake())
+        // 減光中は復帰のタッチだけなので間隔を空ける
+        eventLoopSchedule(LOOP_TIMER_ACTIVE, now + (screenDimmed ? EVENT_LOOP_POLL_MS : EVENT_LOOP_TOUCH_POLL_MS));
+    else
+        eventLoopCancel(LOOP_TIMER_ACTIVE);
 
-        if (dragDistance >= SLIDER_DRAG_THRESHOLD)
-        {
-            sliderDragged = true;
-            int newBrightness = calculateSliderValue(activeSlider, tx);
-            if (newBrightness != bulbs[activeSlider].brightness)
-            {
-                bulbs[activeSlider].brightness = newBrightness;
-                drawBulbPanel(activeSlider);
-                Serial.printf("[DEBUG] Dragging: x=%d, brightness=%d\n", tx, newBrightness);
-            }
-        }
-    }
+    // ボタンの長押しの判定
+    uint32_t gestureAt;
+    if (!screenDimmed && gestureNextDeadline(gestureAt))
+        eventLoopSchedule(LOOP_TIMER_GESTURE, gestureAt);
+    else
+        eventLoopCancel(LOOP_TIMER_GESTURE);
 
-    // タッチリリース
-    if (touch.wasReleased())
+    // 画面減光・復帰直後のタッチ無視の終わり・バッテリー
+    if (screenDimmed)
     {
-        lastTouchTime = now;
-
-        // スライダー操作完了
-        if (activeSlider >= 0)
-        {
-            Serial.printf("[DEBUG] Released: dragged=%d\n", sliderDragged);
-            if (sliderDragged && (now - lastApiCall >= API_DEBOUNCE_MS))
-            {
-                switchbotBulbBrightness(bulbs[activeSlider].deviceId, bulbs[activeSlider].brightness);
-                lastApiCall = now;
-                operationOccurred = true;
-                lastStatusUpdate = now;
-                Serial.printf("[DEBUG] API called: brightness=%d\n", bulbs[activeSlider].brightness);
-            }
-            activeSlider = -1;
-            sliderDragged = false;
-        }
-
-        // ボタンリリース
-        if (pressedButtonIndex >= 0)
-        {
-            pressedButtonIndex = -1;
-        }
+        eventLoopCancel(LOOP_TIMER_SCREEN);
     }
-
-    // ボタン長押し判定
-    if (touch.isHolding() && pressedButtonIndex >= 0)
+    else
     {
-        lastTouchTime = now;
-        int btnIndex = checkButtonTouch(tx, ty);
-        if (btnIndex == pressedButtonIndex && (now - buttonPressStartTime >= BUTTON_LONG_PRESS_MS))
-        {
-            bool wasOn = bulbs[pressedButtonIndex].powerState;
+        if (wakeUpTime > 0)
+            eventLoopSchedule(LOOP_TIMER_SCREEN, wakeUpTime + WAKE_UP_IGNORE_MS);
+        else
+            eventLoopSchedule(LOOP_TIMER_SCREEN, lastTouchTime + SCREEN_OFF_TIMEOUT_MS);
+    }
+    eventLoopSchedule(LOOP_TIMER_BATTERY, lastBatteryUpdate + pollPolicyRates().batteryMs);
 
-            if (pendingOffBulbIndex == pressedButtonIndex)
-                pendingOffBulbIndex = -1;
+    // 見込んだ復帰の前の先読み
+    if (screenDimmed && pollPolicyNextPrefetch(at))
+        eventLoopSchedule(LOOP_TIMER_PREFETCH, at);
+    else
+        eventLoopCancel(LOOP_TIMER_PREFETCH);
 
-            bulbs[pressedButtonIndex].powerState = !bulbs[pressedButtonIndex].powerState;
-            drawBulbPanel(pressedButtonIndex);
+    // 遅延OFF
+    if (pendingOffBulbIndex >= 0)
+        eventLoopSchedule(LOOP_TIMER_BULB_OFF, pendingOffStartTime + BULB_OFF_DELAY_MS);
+    else
+        eventLoopCancel(LOOP_TIMER_BULB_OFF);
 
-            if (wasOn)
-            {
-                pendingOffBulbIndex = pressedButtonIndex;
-                pendingOffStartTime = now;
-            }
-            else
-            {
-                switchbotBulbPower(bulbs[pressedButtonIndex].deviceId, true);
-                lastApiCall = now;
-                operationOccurred = true;
-                lastStatusUpdate = now;
-            }
-            pressedButtonIndex = -1;
-        }
-    }
+    // 操作した電球の確認（時刻を過ぎても送れないのは操作中・送信中のときで、その完了で起きる）
+    if (stateCacheNextReconcile(at) && (long)(at - now) > 0)
+        eventLoopSchedule(LOOP_TIMER_RECONCILE, at);
+    else
+        eventLoopCancel(LOOP_TIMER_RECONCILE);
 
-    // 遅延OFF処理
-    if (pendingOffBulbIndex >= 0 && (now - pendingOffStartTime >= BULB_OFF_DELAY_MS))
+    // 保留中のコマンド・シーンの再送
+    unsigned long sceneAt;
+    bool command = coalescerNextService(now, at);
+    if (sceneNextService(now, sceneAt) && (!command || (long)(sceneAt - at) < 0))
     {
-        int idx = pendingOffBulbIndex;
-        pendingOffBulbIndex = -1;
-        if (!bulbs[idx].powerState)
-        {
-            switchbotBulbPower(bulbs[idx].deviceId, false);
-            lastApiCall = now;
-            operationOccurred = true;
-            lastStatusUpdate = now;
-        }
+        at = sceneAt;
+        command = true;
     }
+    if (command)
+        eventLoopSchedule(LOOP_TIMER_COMMAND, at);
+    else
+        eventLoopCancel(LOOP_TIMER_COMMAND);
 
-    // 操作後の状態取得
-    if (operationOccurred && (now - lastStatusUpdate >= STATUS_UPDATE_INTERVAL_MS))
-    {
-        uiRefreshAllBulbStatus();
-        operationOccurred = false;
-    }
+    // Webhook の待ち受け
+    if (webhookNextService(now, at))
+        eventLoopSchedule(LOOP_TIMER_WEBHOOK, at);
+    else
+        eventLoopCancel(LOOP_TIMER_WEBHOOK);
+}
 
-    // バッテリー状態更新（10秒ごと）
-    if (now - lastBatteryUpdate >= BATTERY_UPDATE_INTERVAL_MS)
-    {
-        lastBatteryUpdate = now;
-        int oldLevel = batteryLevel;
-        updateBatteryStatus();
-        if (batteryLevel != oldLevel)
-        {
-            drawHeader();
-        }
-    }
+void uiUpdate()
+{
+    updateOnce();
+
+    // 画面・電源・操作の状態から状態取得の間隔を決め直す
+    unsigned long now = millis();
+    pollPolicyUpdate(now, screenDimmed, lastTouchTime);
+    scheduleWakeups(now);
 }
 
 void uiUpdateBulbState(int index, bool powerState, int brightness)
 {
-    if (index < 0 || index >= NUM_BULBS)
+    if (index < 0 || index >= bulbs.count)
         return;
 
-    bulbs[index].powerState = powerState;
-    bulbs[index].brightness = brightness;
-    drawBulbPanel(index);
+    bool changed = bulbs.powerState[index] != powerState;
+    bulbs.powerState[index] = powerState;
+    bulbs.brightness[index] = brightness;
+    profilerEnter(PROFILE_RENDER);
+    renderBulbPanel(index);
+    profilerLeave();
+    if (changed)
+        updateShortcuts();
 }
 
 void uiUpdateMeter()
 {
-    drawHeader();
+    // 履歴に記録し、ヘッダーの折れ線に反映する（時刻同期前は記録しない）
+    if (meter.valid)
+        meterHistoryAdd((uint32_t)time(nullptr), meter.temperature, meter.humidity);
+
+    profilerEnter(PROFILE_RENDER);
+    renderHeader(batteryLevel);
+    profilerLeave();
+}
+
+bool uiActivateScene(int scene)
+{
+    if (!sceneActivate(scene))
+        return false;
+
+    // 目標の状態を先に表示する
+    renderVisiblePanels();
+    updateShortcuts();
+    return true;
+}
+
+bool uiToggleGroup(int group)
+{
+    if (!sceneSetGroup(group, !sceneGroupAnyOn(group), -1))
+        return false;
+
+    renderVisiblePanels();
+    updateShortcuts();
+    return true;
 }
 
-void uiRefreshAllBulbStatus()
+// 表示中のページの電球の状態取得を投入（staleOnly なら確認してから ttlMs 以上経った電球だけ）
+// staleOnly では結果を待っている電球には投入しない（届く結果で足りる）
+// staleOnly でなければ投入し直し、前の取得の結果は捨てる（操作・シーンの前に送った取得の値を反映しない）
+static RefreshCounts refreshVisible(bool staleOnly, uint32_t ttlMs)
 {
-    Serial.println("Refreshing all bulb status...");
-    for (int i = 0; i < NUM_BULBS; i++)
+    // 表示中のページの電球を一度に投入し、ワーカー数まで並列に取得する
+    // 結果は onBulbStatus で届いた順にパネルへ反映される
+    int page = renderGetPage();
+    int first = page * PANELS_PER_PAGE;
+    int last = min(first + PANELS_PER_PAGE, bulbs.count);
+    unsigned long now = millis();
+    // Webhook のイベントが届いている間は、取りこぼしに備えた間隔まで延ばす
+    uint32_t ttl = apiQuotaStretch(webhookPollInterval(ttlMs, now), apiQuotaNowSec());
+
+    RefreshCounts counts = {0, 0, 0};
+    for (int i = first; i < last; i++)
     {
-        if (!bulbs[i].deviceId.isEmpty())
+        if (!bulbEnabled(i))
+            continue;
+        if (staleOnly && statusInFlight[i])
         {
-            bool powerState;
-            int brightness;
-            if (switchbotBulbStatus(bulbs[i].deviceId, powerState, brightness))
-            {
-                bulbs[i].powerState = powerState;
-                bulbs[i].brightness = brightness;
-                drawBulbPanel(i);
-                Serial.printf("Bulb %d: power=%s, brightness=%d\n", i, powerState ? "on" : "off", brightness);
-            }
+            counts.inFlight++;
+            continue;
+        }
+        if (staleOnly && !stateCacheStale(i, now, ttl))
+        {
+            stateCacheNoteFresh();
+            counts.fresh++;
+            continue;
         }
+        int seq = (statusSeq[i] + 1) & 0x7FFFFFFF;
+        if (!apiWorkerSubmit(API_JOB_BULB_STATUS, bulbs.deviceId[i], i, seq, onBulbStatus))
+            continue;
+        statusSeq[i] = seq;
+        stateCacheNoteRequested(i, false);
+        counts.submitted++;
+        // 投入し直した電球は前の取得の分を引き継ぐ
+        if (!statusInFlight[i])
+        {
+            statusInFlight[i] = true;
+            if (refreshRemaining++ == 0)
+                refreshStartTime = now;
+        }
+    }
+    if (counts.submitted > 0)
+    {
+        Serial.printf("Refreshing bulb status (page %d, %d bulbs)...\n", page + 1, counts.submitted);
     }
-    lastStatusUpdate = millis();
+    return counts;
+}
+
+// 画面復帰時の状態取得（先読みした値・後回しにした取得はここで反映する）
+static void refreshAfterWake()
+{
+    // 後回しにした取得があれば表示中のページを取り直し、なければ古い電球（先読みした値は新しいまま）だけ取得する
+    bool staleOnly = !refreshOnWake;
+    refreshOnWake = false;
+    RefreshCounts counts = refreshVisible(staleOnly, STATE_TTL_MS);
+    pollPolicyNoteWake(counts.submitted + counts.inFlight + counts.fresh, counts.fresh);
+}
+
+void uiRefreshVisibleBulbStatus()
+{
+    // 減光中で画面に出ていない間の取得を控える状態なら、復帰時にまとめて取得する
+    if (screenDimmed && !pollPolicyRates().bulbBackground)
+    {
+        if (!refreshOnWake)
+            pollPolicyNoteDeferred();
+        refreshOnWake = true;
+        return;
+    }
+    refreshVisible(false, STATE_TTL_MS);
+}
+
+void uiRefreshStaleBulbStatus()
+{
+    refreshVisible(true, STATE_TTL_MS);
+}
+
+int uiRefreshRemaining()
+{
+    return refreshRemaining;
 }
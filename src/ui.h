@@ -1,22 +1,34 @@
 #ifndef UI_H
 #define UI_H
 
-#include <M5Unified.h>
-#include "devices.h"
+#include <Arduino.h>
 
 // UI初期化
 void uiInit();
 
-// UI描画（メインループで呼び出す）
+// UI描画（メインループで呼び出す、次にループを起こすタイマーも設定する）
 void uiUpdate();
 
 // 電球の状態を更新
 void uiUpdateBulbState(int index, bool powerState, int brightness);
 
-// 温湿度表示を更新
+// 温湿度表示を更新（meter の値を温湿度の履歴に記録する）
 void uiUpdateMeter();
 
-// 全電球の状態を取得して更新
-void uiRefreshAllBulbStatus();
+// シーンを実行（戻り値: 開始した=true）
+bool uiActivateScene(int scene);
+
+// グループの電球をまとめてON/OFF（どれか1台でもONなら全てOFF、それ以外は全てON）
+bool uiToggleGroup(int group);
+
+// 表示中のページの電球の状態取得を要求（結果は届き次第パネルに反映、結果を待っている電球にも投入し直す）
+void uiRefreshVisibleBulbStatus();
+
+// 表示中のページのうち、確認してから STATE_TTL_MS 以上経った電球だけ状態取得を要求
+// （Webhook のイベントが届いている間は WEBHOOK_SAFETY_INTERVAL_MS 以上、結果を待っている電球には投入しない）
+void uiRefreshStaleBulbStatus();
+
+// ページの状態取得で、結果を待っている電球の数（前のページの分を含み、投入し直した電球は1つと数える）
+int uiRefreshRemaining();
 
 #endif // UI_H
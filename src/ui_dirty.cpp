@@ -0,0 +1,170 @@
+#include "ui_dirty.h"
+#include "ui_layout.h"
+
+// シーン・グループのボタンの数（pageSetShortcutCount）
+static int shortcutCount = 0;
+
+void formatBrightnessLabel(int device, bool enabled, char *buf, size_t size)
+{
+    bool powerState = bulbs.powerState[device];
+    if (enabled && powerState)
+    {
+        snprintf(buf, size, "%d%%", bulbs.brightness[device]);
+    }
+    else
+    {
+        strncpy(buf, powerState ? "100%" : "OFF", size - 1);
+        buf[size - 1] = '\0';
+    }
+}
+
+void formatBatteryText(int batteryLevel, char *buf, size_t size)
+{
+    if (batteryLevel >= 0)
+    {
+        snprintf(buf, size, "BAT %d%%", batteryLevel);
+    }
+    else
+    {
+        snprintf(buf, size, "BAT --");
+    }
+}
+
+void formatMeterText(const MeterDevice &meter, char *buf, size_t size)
+{
+    if (meter.valid)
+    {
+        snprintf(buf, size, "%.1fC  %d%%", meter.temperature, meter.humidity);
+    }
+    else
+    {
+        snprintf(buf, size, "--C  --%%");
+    }
+}
+
+// 温度（℃×10）から折れ線の Y 座標（上が高温）
+static int sparkY(int temp, int lo, int hi, int height)
+{
+    return (hi - temp) * (height - 1) / (hi - lo);
+}
+
+void sparklineColumns(const HistoryBucket *buckets, int count, int height, SparkColumn *out)
+{
+    int lo = INT16_MAX;
+    int hi = INT16_MIN;
+    for (int i = 0; i < count; i++)
+    {
+        if (buckets[i].count == 0)
+            continue;
+        lo = min(lo, (int)buckets[i].tempMin);
+        hi = max(hi, (int)buckets[i].tempMax);
+    }
+    if (hi - lo < 10)
+    {
+        int mid = (lo + hi) / 2;
+        lo = mid - 5;
+        hi = lo + 10;
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        out[i] = {};
+        if (buckets[i].count == 0)
+            continue;
+        out[i].valid = true;
+        out[i].top = sparkY(buckets[i].tempMax, lo, hi, height);
+        out[i].bottom = sparkY(buckets[i].tempMin, lo, hi, height);
+        out[i].avg = min(sparkY(buckets[i].tempAvg, lo, hi, height), height - 2);
+    }
+}
+
+void formatPageText(int page, char *buf, size_t size)
+{
+    int pages = pageCount();
+    if (pages > 1)
+    {
+        snprintf(buf, size, "%d/%d", page + 1, pages);
+    }
+    else
+    {
+        buf[0] = '\0';
+    }
+}
+
+void pageSetShortcutCount(int count)
+{
+    shortcutCount = max(count, 0);
+}
+
+int bulbPageCount()
+{
+    int pages = (bulbs.count + PANELS_PER_PAGE - 1) / PANELS_PER_PAGE;
+    return pages > 0 ? pages : 1;
+}
+
+int pageCount()
+{
+    return bulbPageCount() + (shortcutCount + PANELS_PER_PAGE - 1) / PANELS_PER_PAGE;
+}
+
+int sliderHandleX(int brightness)
+{
+    return PANEL_SLIDER_X + (PANEL_SLIDER_WIDTH * brightness) / 100;
+}
+
+bool panelNeedsFullRedraw(const PanelState &state, int device, bool enabled)
+{
+    return !state.valid || state.device != device || state.enabled != enabled;
+}
+
+int panelDirtyRects(const PanelState &state, int device, bool enabled, const char *label, DirtyRect *rects)
+{
+    int count = 0;
+
+    // スライダー全体（つまみがはみ出す分を含む）
+    const DirtyRect sliderRect = {PANEL_SLIDER_X - SLIDER_HANDLE_RADIUS - 1, PANEL_SLIDER_Y,
+                                  PANEL_SLIDER_WIDTH + (SLIDER_HANDLE_RADIUS + 1) * 2, SLIDER_HEIGHT};
+    const DirtyRect buttonRect = {PANEL_BUTTON_X, PANEL_BUTTON_Y, PANEL_BUTTON_WIDTH, BUTTON_HEIGHT};
+    const DirtyRect labelRect = {0, PANEL_LABEL_Y - 20, PANEL_WIDTH, 40};
+
+    if (panelNeedsFullRedraw(state, device, enabled))
+    {
+        rects[count++] = {0, 0, PANEL_WIDTH, PANEL_HEIGHT};
+        return count;
+    }
+
+    bool powerState = bulbs.powerState[device];
+    int brightness = bulbs.brightness[device];
+    if (state.powerState != powerState)
+    {
+        rects[count++] = buttonRect;
+        rects[count++] = sliderRect;
+    }
+    else if (state.brightness != brightness)
+    {
+        // 塗りの端とつまみが動いた範囲だけ
+        int oldX = sliderHandleX(state.brightness);
+        int newX = sliderHandleX(brightness);
+        int x0 = min(oldX, newX) - SLIDER_HANDLE_RADIUS - 1;
+        int x1 = max(oldX, newX) + SLIDER_HANDLE_RADIUS + 1;
+        x0 = max(x0, sliderRect.x);
+        x1 = min(x1, sliderRect.x + sliderRect.w);
+        rects[count++] = {x0, PANEL_SLIDER_Y, x1 - x0, SLIDER_HEIGHT};
+    }
+    if (strcmp(state.label, label) != 0)
+    {
+        rects[count++] = labelRect;
+    }
+    return count;
+}
+
+void panelStateUpdate(PanelState &state, int device, bool enabled, const char *label)
+{
+    state.valid = true;
+    state.device = device;
+    state.enabled = enabled;
+    state.powerState = bulbs.powerState[device];
+    state.brightness = bulbs.brightness[device];
+    strncpy(state.label, label, sizeof(state.label) - 1);
+    state.label[sizeof(state.label) - 1] = '\0';
+}
@@ -0,0 +1,71 @@
+#ifndef UI_DIRTY_H
+#define UI_DIRTY_H
+
+#include <Arduino.h>
+#include "device_registry.h"
+#include "meter_history.h"
+
+// 1パネルで一度に描き直す矩形の最大数
+#define MAX_DIRTY_RECTS 4
+
+// パネル内の矩形（パネル左上が原点）
+struct DirtyRect
+{
+    int x, y, w, h;
+};
+
+// パネルの描画済み状態（変化した部品だけを描き直すために保持）
+struct PanelState
+{
+    bool valid;
+    int device; // 描画したデバイス番号（ページ送りで変わったら全体を描き直す）
+    bool enabled;
+    bool powerState;
+    int brightness;
+    char label[16];
+};
+
+// 明るさ表示の文字列
+void formatBrightnessLabel(int device, bool enabled, char *buf, size_t size);
+
+// ヘッダーの表示文字列
+void formatBatteryText(int batteryLevel, char *buf, size_t size);
+void formatMeterText(const MeterDevice &meter, char *buf, size_t size);
+void formatPageText(int page, char *buf, size_t size); // 1ページだけなら空文字列
+
+// 温度の折れ線の1列（折れ線の領域の上端からの Y 座標、valid=false なら記録なし）
+struct SparkColumn
+{
+    bool valid;
+    int top;    // 最高温度
+    int bottom; // 最低温度
+    int avg;    // 平均温度（2ピクセルの高さで描く）
+};
+
+// 区間ごとの温度から折れ線の列を求める
+// 縦の範囲は記録のある区間の最低〜最高（差が 1℃ 未満なら 1℃ の幅）
+void sparklineColumns(const HistoryBucket *buckets, int count, int height, SparkColumn *out);
+
+// シーン・グループのボタンの数（電球のページの後ろに PANELS_PER_PAGE 個ずつ並べる）
+void pageSetShortcutCount(int count);
+
+// 電球のページ数（登録がなくても1）
+int bulbPageCount();
+
+// ページ数（電球のページとシーン・グループのページ）
+int pageCount();
+
+// スライダーのつまみ位置（パネル内X座標）
+int sliderHandleX(int brightness);
+
+// パネル全体（背景を含む）を描き直す必要があるか
+bool panelNeedsFullRedraw(const PanelState &state, int device, bool enabled);
+
+// 描画済み状態から変化した矩形を求める
+// 戻り値: 矩形の数（最大 MAX_DIRTY_RECTS）
+int panelDirtyRects(const PanelState &state, int device, bool enabled, const char *label, DirtyRect *rects);
+
+// 描画済み状態を更新
+void panelStateUpdate(PanelState &state, int device, bool enabled, const char *label);
+
+#endif // UI_DIRTY_H
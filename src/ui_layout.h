@@ -0,0 +1,87 @@
+#ifndef UI_LAYOUT_H
+#define UI_LAYOUT_H
+
+// 画面サイズ
+#define SCREEN_WIDTH 1280
+#define SCREEN_HEIGHT 720
+
+// 1ページに並べるパネル数（横一列）
+#define PANELS_PER_PAGE 4
+
+// UIレイアウト定数
+#define HEADER_HEIGHT 80
+#define PANEL_MARGIN 20
+#define PANEL_WIDTH ((SCREEN_WIDTH - PANEL_MARGIN * (PANELS_PER_PAGE + 1)) / PANELS_PER_PAGE)
+#define PANEL_HEIGHT (SCREEN_HEIGHT - HEADER_HEIGHT - PANEL_MARGIN * 2)
+#define BUTTON_HEIGHT 150
+#define SLIDER_HEIGHT 40
+#define SLIDER_MARGIN 30
+#define SLIDER_HANDLE_RADIUS 15
+
+// ページ送りと判定する横スワイプの距離
+#define PAGE_SWIPE_THRESHOLD 120
+
+// パネル内座標
+#define PANEL_BUTTON_X 20
+#define PANEL_BUTTON_Y 60
+#define PANEL_BUTTON_WIDTH (PANEL_WIDTH - 40)
+#define PANEL_SLIDER_X SLIDER_MARGIN
+#define PANEL_SLIDER_Y (PANEL_BUTTON_Y + BUTTON_HEIGHT + 40)
+#define PANEL_SLIDER_WIDTH (PANEL_WIDTH - SLIDER_MARGIN * 2)
+#define PANEL_LABEL_Y (PANEL_SLIDER_Y + SLIDER_HEIGHT + 40)
+#define PANEL_NOTE_Y (PANEL_SLIDER_Y + SLIDER_HEIGHT + 70)
+
+// ヘッダー内の表示欄（X座標と幅）
+#define HEADER_TITLE_X 0
+#define HEADER_TITLE_WIDTH HEADER_PAGE_X
+#define HEADER_PAGE_X 400
+#define HEADER_PAGE_WIDTH 110
+#define HEADER_BATTERY_X (SCREEN_WIDTH / 2 - 120)
+#define HEADER_BATTERY_WIDTH 240
+#define HEADER_METER_X (SCREEN_WIDTH - 400)
+#define HEADER_METER_WIDTH 400
+
+// 温湿度欄の左側の温度の折れ線（直近24時間、1列が METER_HISTORY_ROLLUP_SEC の区切り1つ）
+#define HEADER_SPARK_X (HEADER_METER_X + 16)
+#define HEADER_SPARK_Y 16
+#define HEADER_SPARK_WIDTH 144
+#define HEADER_SPARK_HEIGHT (HEADER_HEIGHT - HEADER_SPARK_Y * 2)
+
+// 色定義
+#define COLOR_BG 0x1082
+#define COLOR_PANEL 0x2945
+#define COLOR_HEADER 0x001F
+#define COLOR_ON 0x07E0
+#define COLOR_OFF 0xF800
+#define COLOR_SCENE 0x7A1F
+#define COLOR_SLIDER_BG 0x4208
+#define COLOR_SLIDER_FG 0xFFE0
+#define COLOR_TEXT 0xFFFF
+#define COLOR_DISABLED 0x6B4D
+#define COLOR_SPARK_BAND 0x3A7F
+#define COLOR_SPARK_LINE 0xFFE0
+
+// 座標計算（index はページ内の位置 0 〜 PANELS_PER_PAGE-1）
+static inline int getPanelX(int index) { return PANEL_MARGIN + index * (PANEL_WIDTH + PANEL_MARGIN); }
+static inline int getPanelY() { return HEADER_HEIGHT + PANEL_MARGIN; }
+static inline int getButtonX(int index) { return getPanelX(index) + PANEL_BUTTON_X; }
+static inline int getButtonY() { return getPanelY() + PANEL_BUTTON_Y; }
+static inline int getButtonWidth() { return PANEL_BUTTON_WIDTH; }
+static inline int getSliderX(int index) { return getPanelX(index) + PANEL_SLIDER_X; }
+static inline int getSliderY() { return getPanelY() + PANEL_SLIDER_Y; }
+static inline int getSliderWidth() { return PANEL_SLIDER_WIDTH; }
+
+// 画面座標からページ内のパネル位置を求める（パネル間の余白・パネル外は -1）
+// 等間隔の格子なので割り算だけで決まり、デバイス数によらない
+static inline int panelSlotAt(int x, int y)
+{
+    if (y < getPanelY() || y >= getPanelY() + PANEL_HEIGHT || x < PANEL_MARGIN)
+        return -1;
+    int pitch = PANEL_WIDTH + PANEL_MARGIN;
+    int slot = (x - PANEL_MARGIN) / pitch;
+    if (slot >= PANELS_PER_PAGE || (x - PANEL_MARGIN) % pitch >= PANEL_WIDTH)
+        return -1;
+    return slot;
+}
+
+#endif // UI_LAYOUT_H
@@ -0,0 +1,499 @@
+#include "ui_render.h"
+#include <Arduino.h>
+#include "ui_layout.h"
+#include "ui_dirty.h"
+#include "hal/hal_clock.h"
+#include "hal/hal_display.h"
+
+// パネル位置ごとの静的背景レイヤー（パネル背景・電球名・スライダー溝、PSRAMに保持）
+// 表示中のページの分だけ持ち、ページ送りで別の電球が来たら作り直す
+static HalSurface *bgLayers[PANELS_PER_PAGE];
+static bool bgValid[PANELS_PER_PAGE];
+
+// 合成用フレームバッファ（ダブルバッファ）
+// 片方をDMA転送している間にもう片方へ次の矩形を合成する
+static HalSurface *frameBuffers[2];
+static int backBuffer = 0;
+static bool writing = false; // フレーム内で表示の書き込みトランザクションを開始済みか
+
+// パネル位置ごとの描画済み状態
+static PanelState panelStates[PANELS_PER_PAGE];
+
+// シーン・グループのボタン（renderSetShortcuts）と、パネル位置ごとに描いたボタン
+struct ShortcutSlot
+{
+    int entry; // 描いたボタンの番号（描いていなければ -1）
+    bool on;
+};
+static const ShortcutPanel *shortcuts = nullptr;
+static int shortcutCount = 0;
+static ShortcutSlot shortcutSlots[PANELS_PER_PAGE];
+
+// 表示中のページ
+static int currentPage = 0;
+
+// ヘッダーの描画済み状態
+static bool headerValid = false;
+static char headerBattery[16];
+static char headerMeter[32];
+static char headerPage[16];
+static const char *headerTitle = "SwitchBot Controller";
+static uint32_t headerSpark = 0; // 描画した折れ線の履歴の版
+
+// 折れ線の作業領域（ループタスクのスタックに置かない）
+static HistoryBucket sparkBuckets[HEADER_SPARK_WIDTH];
+static SparkColumn sparkColumns[HEADER_SPARK_WIDTH];
+
+// 描画統計
+static uint32_t framePixels = 0;
+static uint32_t frameComposeUs = 0;
+static uint32_t framePushUs = 0;
+static RenderStats stats = {};
+
+// 静的な部分（背景・電球名・スライダー溝）を描く
+static void drawPanelBackground(HalSurface *dst, int device, bool enabled)
+{
+    halDrawFillRect(dst, 0, 0, PANEL_WIDTH, PANEL_HEIGHT, COLOR_PANEL);
+    halDrawFillRoundRect(dst, 0, 0, PANEL_WIDTH, PANEL_HEIGHT, 10, COLOR_PANEL);
+
+    // 電球名
+    halDrawText(dst, bulbs.name[device], PANEL_WIDTH / 2, 35, HAL_FONT_JP_28, HAL_DATUM_MC,
+                enabled ? COLOR_TEXT : COLOR_DISABLED);
+
+    // スライダー溝
+    halDrawFillRoundRect(dst, PANEL_SLIDER_X, PANEL_SLIDER_Y, PANEL_SLIDER_WIDTH, SLIDER_HEIGHT, 5, COLOR_SLIDER_BG);
+
+    if (!enabled)
+    {
+        halDrawText(dst, "(ID未設定)", PANEL_WIDTH / 2, PANEL_NOTE_Y, HAL_FONT_JP_20, HAL_DATUM_MC, COLOR_DISABLED);
+    }
+}
+
+// 状態によって変わる部分（ボタン・スライダーの塗りとつまみ・明るさ表示）を描く
+static void drawPanelDynamic(HalSurface *dst, int device, bool enabled, const char *label)
+{
+    bool powerState = bulbs.powerState[device];
+    int brightness = bulbs.brightness[device];
+
+    // ON/OFFボタン
+    uint16_t btnColor = !enabled ? COLOR_DISABLED : (powerState ? COLOR_ON : COLOR_OFF);
+    halDrawFillRoundRect(dst, PANEL_BUTTON_X, PANEL_BUTTON_Y, PANEL_BUTTON_WIDTH, BUTTON_HEIGHT, 8, btnColor);
+    halDrawText(dst, powerState ? "ON" : "OFF", PANEL_BUTTON_X + PANEL_BUTTON_WIDTH / 2,
+                PANEL_BUTTON_Y + BUTTON_HEIGHT / 2, HAL_FONT_SANS_18, HAL_DATUM_MC, COLOR_TEXT);
+
+    // スライダー
+    if (enabled && powerState)
+    {
+        int fillW = (PANEL_SLIDER_WIDTH * brightness) / 100;
+        halDrawFillRoundRect(dst, PANEL_SLIDER_X, PANEL_SLIDER_Y, fillW, SLIDER_HEIGHT, 5, COLOR_SLIDER_FG);
+    }
+    if (enabled)
+    {
+        halDrawFillCircle(dst, sliderHandleX(brightness), PANEL_SLIDER_Y + SLIDER_HEIGHT / 2, SLIDER_HANDLE_RADIUS,
+                          COLOR_TEXT);
+    }
+
+    // 明るさ表示
+    halDrawText(dst, label, PANEL_WIDTH / 2, PANEL_LABEL_Y, HAL_FONT_SANS_12, HAL_DATUM_MC,
+                enabled ? COLOR_TEXT : COLOR_DISABLED);
+}
+
+// 背景レイヤーを作り直す
+static void rebuildBackground(int slot, int device, bool enabled)
+{
+    bgValid[slot] = false;
+    if (bgLayers[slot] == nullptr)
+        return;
+
+    drawPanelBackground(bgLayers[slot], device, enabled);
+    bgValid[slot] = true;
+}
+
+// シーン・グループのボタンのパネルを描く
+static void drawShortcutPanel(HalSurface *dst, const ShortcutPanel &panel)
+{
+    halDrawFillRect(dst, 0, 0, PANEL_WIDTH, PANEL_HEIGHT, COLOR_PANEL);
+    halDrawText(dst, panel.name, PANEL_WIDTH / 2, 35, HAL_FONT_JP_28, HAL_DATUM_MC, COLOR_TEXT);
+
+    int textX = PANEL_BUTTON_X + PANEL_BUTTON_WIDTH / 2;
+    int textY = PANEL_BUTTON_Y + BUTTON_HEIGHT / 2;
+    if (panel.group)
+    {
+        halDrawFillRoundRect(dst, PANEL_BUTTON_X, PANEL_BUTTON_Y, PANEL_BUTTON_WIDTH, BUTTON_HEIGHT, 8,
+                             panel.on ? COLOR_ON : COLOR_OFF);
+        halDrawText(dst, panel.on ? "ON" : "OFF", textX, textY, HAL_FONT_SANS_18, HAL_DATUM_MC, COLOR_TEXT);
+    }
+    else
+    {
+        halDrawFillRoundRect(dst, PANEL_BUTTON_X, PANEL_BUTTON_Y, PANEL_BUTTON_WIDTH, BUTTON_HEIGHT, 8, COLOR_SCENE);
+        halDrawText(dst, "実行", textX, textY, HAL_FONT_JP_28, HAL_DATUM_MC, COLOR_TEXT);
+    }
+
+    halDrawText(dst, panel.group ? "グループ" : "シーン", PANEL_WIDTH / 2, PANEL_LABEL_Y, HAL_FONT_JP_20, HAL_DATUM_MC,
+                COLOR_DISABLED);
+}
+
+// 合成した矩形を画面にDMA転送（t0 は合成を始めた時刻）
+static void presentPanelRect(int slot, const DirtyRect &r, unsigned long t0)
+{
+    int panelX = getPanelX(slot);
+    int panelY = getPanelY();
+    HalSurface *dst = frameBuffers[backBuffer];
+    unsigned long t1 = halMicros();
+
+    // 転送: 前の転送の完了を待ってから、このバッファをDMAで送る
+    if (!writing)
+    {
+        halDisplayStartWrite();
+        writing = true;
+    }
+    halDisplayWaitDMA();
+    halDrawSetClip(nullptr, panelX + r.x, panelY + r.y, r.w, r.h);
+    halDisplayPushSurface(dst, panelX, panelY);
+    halDrawClearClip(nullptr);
+    unsigned long t2 = halMicros();
+
+    backBuffer ^= 1;
+    framePixels += r.w * r.h;
+    frameComposeUs += t1 - t0;
+    framePushUs += t2 - t1;
+}
+
+// パネル内の矩形を合成して画面にDMA転送
+static void pushPanelRect(int slot, int device, bool enabled, const char *label, const DirtyRect &r)
+{
+    HalSurface *dst = frameBuffers[backBuffer];
+    if (dst == nullptr)
+        return;
+
+    // 合成: 背景レイヤーをコピーして動的な部品を重ねる（前の矩形のDMA転送と並行）
+    unsigned long t0 = halMicros();
+    halDrawSetClip(dst, r.x, r.y, r.w, r.h);
+    if (bgValid[slot])
+    {
+        halSurfaceCopy(bgLayers[slot], dst, 0, 0);
+    }
+    else
+    {
+        drawPanelBackground(dst, device, enabled);
+    }
+    drawPanelDynamic(dst, device, enabled, label);
+    halDrawClearClip(dst);
+    presentPanelRect(slot, r, t0);
+}
+
+// パネル位置を背景色で消す
+static void eraseSlot(int slot)
+{
+    halDrawFillRect(nullptr, getPanelX(slot), getPanelY(), PANEL_WIDTH, PANEL_HEIGHT, COLOR_BG);
+    framePixels += PANEL_WIDTH * PANEL_HEIGHT;
+    panelStates[slot].valid = false;
+    shortcutSlots[slot].entry = -1;
+}
+
+// パネル位置に並ぶシーン・グループのボタンを描く（状態が変わったときだけパネル全体を描き直す）
+static void renderShortcutSlot(int slot)
+{
+    ShortcutSlot &drawn = shortcutSlots[slot];
+    int entry = (currentPage - bulbPageCount()) * PANELS_PER_PAGE + slot;
+    if (entry >= shortcutCount)
+    {
+        if (panelStates[slot].valid || drawn.entry >= 0)
+            eraseSlot(slot);
+        return;
+    }
+
+    const ShortcutPanel &panel = shortcuts[entry];
+    if (drawn.entry == entry && drawn.on == panel.on)
+        return;
+    HalSurface *dst = frameBuffers[backBuffer];
+    if (dst == nullptr)
+        return;
+
+    unsigned long t0 = halMicros();
+    drawShortcutPanel(dst, panel);
+    presentPanelRect(slot, {0, 0, PANEL_WIDTH, PANEL_HEIGHT}, t0);
+
+    // 電球のページに戻ったらパネル全体を描き直す
+    panelStates[slot].valid = false;
+    drawn.entry = entry;
+    drawn.on = panel.on;
+}
+
+// パネル位置に並ぶ電球を描く（電球がない位置は背景色で消す）
+static void renderSlot(int slot)
+{
+    if (currentPage >= bulbPageCount())
+    {
+        renderShortcutSlot(slot);
+        return;
+    }
+
+    PanelState &state = panelStates[slot];
+    int device = currentPage * PANELS_PER_PAGE + slot;
+    if (device >= bulbs.count)
+    {
+        if (state.valid || shortcutSlots[slot].entry >= 0)
+            eraseSlot(slot);
+        return;
+    }
+
+    // シーン・グループのボタンを描いていた位置は全体を描き直す
+    if (shortcutSlots[slot].entry >= 0)
+    {
+        state.valid = false;
+        shortcutSlots[slot].entry = -1;
+    }
+
+    bool enabled = bulbEnabled(device);
+
+    char label[16];
+    formatBrightnessLabel(device, enabled, label, sizeof(label));
+
+    // パネル全体を描き直すときは背景レイヤーも作り直す
+    if (panelNeedsFullRedraw(state, device, enabled))
+    {
+        rebuildBackground(slot, device, enabled);
+    }
+
+    DirtyRect rects[MAX_DIRTY_RECTS];
+    int count = panelDirtyRects(state, device, enabled, label, rects);
+    for (int i = 0; i < count; i++)
+    {
+        pushPanelRect(slot, device, enabled, label, rects[i]);
+    }
+
+    panelStateUpdate(state, device, enabled, label);
+}
+
+// ヘッダーの1欄を描き直す
+static void drawHeaderField(int x, int w, const char *text, HalTextDatum datum, int textX)
+{
+    halDrawFillRect(nullptr, x, 0, w, HEADER_HEIGHT, COLOR_HEADER);
+    halDrawText(nullptr, text, textX, HEADER_HEIGHT / 2, HAL_FONT_SANS_18, datum, COLOR_TEXT);
+    framePixels += w * HEADER_HEIGHT;
+}
+
+// 温湿度欄の温度の折れ線（直近24時間、列ごとに最低〜最高の帯と平均）
+static void drawSparkline()
+{
+    meterHistoryRecentDay(sparkBuckets, HEADER_SPARK_WIDTH);
+    sparklineColumns(sparkBuckets, HEADER_SPARK_WIDTH, HEADER_SPARK_HEIGHT, sparkColumns);
+    halDrawFillRect(nullptr, HEADER_SPARK_X, HEADER_SPARK_Y, HEADER_SPARK_WIDTH, HEADER_SPARK_HEIGHT, COLOR_HEADER);
+    for (int i = 0; i < HEADER_SPARK_WIDTH; i++)
+    {
+        const SparkColumn &c = sparkColumns[i];
+        if (!c.valid)
+            continue;
+        int x = HEADER_SPARK_X + i;
+        halDrawFillRect(nullptr, x, HEADER_SPARK_Y + c.top, 1, c.bottom - c.top + 1, COLOR_SPARK_BAND);
+        halDrawFillRect(nullptr, x, HEADER_SPARK_Y + c.avg, 1, 2, COLOR_SPARK_LINE);
+    }
+    framePixels += HEADER_SPARK_WIDTH * HEADER_SPARK_HEIGHT;
+    headerSpark = meterHistoryVersion();
+}
+
+void renderInit()
+{
+    halDisplayInit();
+
+    // 大きなバッファはPSRAMに置く（二度目の呼び出しでは確保済みのものを使う）
+    for (int i = 0; i < 2; i++)
+    {
+        if (frameBuffers[i] == nullptr)
+            frameBuffers[i] = halSurfaceCreate(PANEL_WIDTH, PANEL_HEIGHT);
+        if (frameBuffers[i] == nullptr)
+        {
+            Serial.printf("Frame buffer %d: allocation failed\n", i);
+        }
+    }
+    for (int i = 0; i < PANELS_PER_PAGE; i++)
+    {
+        // 確保できなければ毎回背景から描く
+        if (bgLayers[i] == nullptr)
+            bgLayers[i] = halSurfaceCreate(PANEL_WIDTH, PANEL_HEIGHT);
+        if (bgLayers[i] == nullptr)
+        {
+            Serial.printf("Background layer %d: allocation failed\n", i);
+        }
+        bgValid[i] = false;
+        panelStates[i].valid = false;
+        shortcutSlots[i].entry = -1;
+    }
+    currentPage = 0;
+    headerValid = false;
+}
+
+void renderAll(int batteryLevel)
+{
+    halDrawFillRect(nullptr, 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, COLOR_BG);
+    framePixels += SCREEN_WIDTH * SCREEN_HEIGHT;
+
+    headerValid = false;
+    renderHeader(batteryLevel);
+    for (int i = 0; i < PANELS_PER_PAGE; i++)
+    {
+        panelStates[i].valid = false;
+        shortcutSlots[i].entry = -1;
+        renderSlot(i);
+    }
+}
+
+void renderHeader(int batteryLevel)
+{
+    char battStr[16];
+    formatBatteryText(batteryLevel, battStr, sizeof(battStr));
+
+    char meterStr[32];
+    formatMeterText(meter, meterStr, sizeof(meterStr));
+
+    char pageStr[16];
+    formatPageText(currentPage, pageStr, sizeof(pageStr));
+
+    if (!headerValid)
+    {
+        // 全体を描き直す
+        halDrawFillRect(nullptr, 0, 0, SCREEN_WIDTH, HEADER_HEIGHT, COLOR_HEADER);
+        framePixels += SCREEN_WIDTH * HEADER_HEIGHT;
+        halDrawText(nullptr, headerTitle, 20, HEADER_HEIGHT / 2, HAL_FONT_SANS_18, HAL_DATUM_ML, COLOR_TEXT);
+        halDrawText(nullptr, battStr, SCREEN_WIDTH / 2, HEADER_HEIGHT / 2, HAL_FONT_SANS_18, HAL_DATUM_MC, COLOR_TEXT);
+        halDrawText(nullptr, pageStr, HEADER_PAGE_X + HEADER_PAGE_WIDTH / 2, HEADER_HEIGHT / 2, HAL_FONT_SANS_18,
+                    HAL_DATUM_MC, COLOR_TEXT);
+        halDrawText(nullptr, meterStr, SCREEN_WIDTH - 20, HEADER_HEIGHT / 2, HAL_FONT_SANS_18, HAL_DATUM_MR,
+                    COLOR_TEXT);
+        drawSparkline();
+        headerValid = true;
+    }
+    else
+    {
+        // 変化した欄だけ
+        if (strcmp(battStr, headerBattery) != 0)
+        {
+            drawHeaderField(HEADER_BATTERY_X, HEADER_BATTERY_WIDTH, battStr, HAL_DATUM_MC, SCREEN_WIDTH / 2);
+        }
+        // 温湿度欄を塗り直したら折れ線も描き直す
+        if (strcmp(meterStr, headerMeter) != 0)
+        {
+            drawHeaderField(HEADER_METER_X, HEADER_METER_WIDTH, meterStr, HAL_DATUM_MR, SCREEN_WIDTH - 20);
+            drawSparkline();
+        }
+        else if (headerSpark != meterHistoryVersion())
+        {
+            drawSparkline();
+        }
+        if (strcmp(pageStr, headerPage) != 0)
+        {
+            drawHeaderField(HEADER_PAGE_X, HEADER_PAGE_WIDTH, pageStr, HAL_DATUM_MC, HEADER_PAGE_X + HEADER_PAGE_WIDTH / 2);
+        }
+    }
+
+    strcpy(headerBattery, battStr);
+    strcpy(headerMeter, meterStr);
+    strcpy(headerPage, pageStr);
+}
+
+void renderSetTitle(const char *title)
+{
+    if (strcmp(title, headerTitle) == 0)
+        return;
+
+    headerTitle = title;
+    if (headerValid)
+    {
+        drawHeaderField(HEADER_TITLE_X, HEADER_TITLE_WIDTH, title, HAL_DATUM_ML, 20);
+    }
+}
+
+void renderSetPage(int page)
+{
+    page = constrain(page, 0, pageCount() - 1);
+    if (page == currentPage)
+        return;
+
+    // 電球が入れ替わった位置は panelNeedsFullRedraw で全体が描き直される
+    currentPage = page;
+    for (int i = 0; i < PANELS_PER_PAGE; i++)
+    {
+        renderSlot(i);
+    }
+
+    char pageStr[16];
+    formatPageText(currentPage, pageStr, sizeof(pageStr));
+    if (headerValid && strcmp(pageStr, headerPage) != 0)
+    {
+        drawHeaderField(HEADER_PAGE_X, HEADER_PAGE_WIDTH, pageStr, HAL_DATUM_MC, HEADER_PAGE_X + HEADER_PAGE_WIDTH / 2);
+        strcpy(headerPage, pageStr);
+    }
+}
+
+int renderGetPage()
+{
+    return currentPage;
+}
+
+void renderBulbPanel(int index)
+{
+    if (index < 0 || index >= bulbs.count || index / PANELS_PER_PAGE != currentPage)
+        return;
+
+    renderSlot(index % PANELS_PER_PAGE);
+}
+
+void renderSetShortcuts(const ShortcutPanel *panels, int count)
+{
+    shortcuts = panels;
+    shortcutCount = count;
+    pageSetShortcutCount(count);
+}
+
+void renderShortcutPanels()
+{
+    if (currentPage < bulbPageCount())
+        return;
+
+    for (int i = 0; i < PANELS_PER_PAGE; i++)
+    {
+        renderShortcutSlot(i);
+    }
+}
+
+void renderEndFrame()
+{
+    // 最後の転送の完了を待ってトランザクションを閉じる
+    if (writing)
+    {
+        unsigned long t0 = halMicros();
+        halDisplayWaitDMA();
+        halDisplayEndWrite();
+        writing = false;
+        framePushUs += halMicros() - t0;
+    }
+
+    if (framePixels == 0)
+        return;
+
+    stats.frames++;
+    stats.lastFramePixels = framePixels;
+    if (framePixels > stats.peakFramePixels)
+        stats.peakFramePixels = framePixels;
+    stats.totalPixels += framePixels;
+    stats.lastComposeUs = frameComposeUs;
+    stats.lastPushUs = framePushUs;
+    if (frameComposeUs > stats.peakComposeUs)
+        stats.peakComposeUs = frameComposeUs;
+    if (framePushUs > stats.peakPushUs)
+        stats.peakPushUs = framePushUs;
+    framePixels = 0;
+    frameComposeUs = 0;
+    framePushUs = 0;
+}
+
+bool renderFramePending()
+{
+    return writing || framePixels > 0;
+}
+
+RenderStats renderGetStats()
+{
+    return stats;
+}
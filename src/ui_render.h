@@ -0,0 +1,63 @@
+#ifndef UI_RENDER_H
+#define UI_RENDER_H
+
+#include <stdint.h>
+
+// 描画統計
+struct RenderStats
+{
+    uint32_t frames;          // 描画があったフレーム数
+    uint32_t lastFramePixels; // 直近のフレームで転送したピクセル数
+    uint32_t peakFramePixels; // 1フレームで転送した最大ピクセル数
+    uint64_t totalPixels;     // 累計転送ピクセル数
+    uint32_t lastComposeUs;   // 直近のフレームの合成時間（マイクロ秒）
+    uint32_t peakComposeUs;   // 合成時間の最大値
+    uint32_t lastPushUs;      // 直近のフレームの転送時間（DMA完了待ちを含む）
+    uint32_t peakPushUs;      // 転送時間の最大値
+};
+
+// 描画初期化
+void renderInit();
+
+// 画面全体を描き直す
+void renderAll(int batteryLevel);
+
+// ヘッダーの変化した欄だけを描き直す
+void renderHeader(int batteryLevel);
+
+// ヘッダー左端の表示（アプリ名・接続状態、title は呼び出し側で保持する文字列）
+void renderSetTitle(const char *title);
+
+// 表示するページを切り替えて、パネルとページ表示を描き直す
+void renderSetPage(int page);
+
+// 表示中のページ
+int renderGetPage();
+
+// 電球パネルの変化した部品だけを描き直す（表示中のページにない電球は何もしない）
+void renderBulbPanel(int index);
+
+// シーン・グループのボタン（電球のページの後ろのページに並べ、長押しで実行する）
+struct ShortcutPanel
+{
+    const char *name; // シーン名・グループ名
+    bool group;       // グループなら true（ボタンは ON/OFF、シーンは「実行」）
+    bool on;          // グループにONの電球があるか
+};
+
+// シーン・グループのボタンを設定する（panels は呼び出し側で保持し、変えたら renderShortcutPanels を呼ぶ）
+void renderSetShortcuts(const ShortcutPanel *panels, int count);
+
+// 表示中のページのシーン・グループのボタンのうち、変化したものを描き直す
+void renderShortcutPanels();
+
+// フレーム終了（uiUpdate の最後に呼ぶ）
+void renderEndFrame();
+
+// renderEndFrame で閉じていない描画があるか（あればループをもう一度回す）
+bool renderFramePending();
+
+// 統計取得
+RenderStats renderGetStats();
+
+#endif // UI_RENDER_H
@@ -0,0 +1,370 @@
+#include "webhook.h"
+#include "event_loop.h"
+#include "hal/hal_server.h"
+#include "secrets.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// 中継と共有する合言葉（secrets.h、未設定なら待ち受けない）
+#ifndef WEBHOOK_TOKEN
+#define WEBHOOK_TOKEN ""
+#endif
+
+// 接続ごとの読み取りの段階
+enum WebhookConnState : uint8_t
+{
+    WEBHOOK_CONN_IDLE,   // 未使用
+    WEBHOOK_CONN_HEADER, // リクエスト行・ヘッダーを読んでいる
+    WEBHOOK_CONN_BODY    // ボディを読んでパーサーに流している
+};
+
+// 受け付けた接続1つ分（接続番号 = halServerAccept の戻り値）
+struct WebhookConnection
+{
+    WebhookConnState state;
+    unsigned long startedAt;
+    char line[WEBHOOK_LINE_MAX];
+    size_t lineLen;
+    bool requestLine; // 次の行がリクエスト行か
+    bool methodOk;    // POST か
+    bool pathOk;      // WEBHOOK_PATH 宛てか
+    bool tokenOk;     // 合言葉（WEBHOOK_TOKEN_HEADER または ?token=）が一致したか
+    long contentLength;
+    long received;
+    WebhookEventParser parser;
+};
+
+static WebhookConnection connections[HAL_SERVER_MAX_CLIENTS];
+static WebhookEventHandler eventHandler = nullptr;
+static bool listening = false;
+static bool anyEvent = false;
+static unsigned long lastEventAt = 0;
+static WebhookStats stats = {};
+
+static const char *reasonPhrase(int code)
+{
+    switch (code)
+    {
+    case 204:
+        return "No Content";
+    case 401:
+        return "Unauthorized";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 411:
+        return "Length Required";
+    case 413:
+        return "Payload Too Large";
+    default:
+        return "Bad Request";
+    }
+}
+
+// 応答して接続を閉じる（中継が再送の要否を決められるよう、ステータスだけ返す）
+static void respond(int client, int code)
+{
+    char response[96];
+    int len = snprintf(response, sizeof(response),
+                       "HTTP/1.1 %d %s\r\nContent-Length: 0\r\nConnection: close\r\n\r\n", code, reasonPhrase(code));
+    halServerWrite(client, response, len);
+    halServerClose(client);
+    connections[client].state = WEBHOOK_CONN_IDLE;
+    if (code != 204)
+        stats.rejected++;
+}
+
+// 合言葉と一致するか（len 文字、一致しない位置で時間が変わらないよう最後まで比べる）
+static bool tokenMatches(const char *value, size_t len)
+{
+    const char *token = WEBHOOK_TOKEN;
+    size_t tokenLen = strlen(token);
+    if (tokenLen == 0 || len != tokenLen)
+        return false;
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++)
+        diff |= (uint8_t)(value[i] ^ token[i]);
+    return diff == 0;
+}
+
+// クエリの token=（"?src=relay&token=..."）
+static bool queryTokenOk(const char *query)
+{
+    while (*query != '\0' && *query != ' ')
+    {
+        size_t len = strcspn(query, "& ");
+        if (strncmp(query, "token=", 6) == 0 && tokenMatches(query + 6, len - 6))
+            return true;
+        query += len;
+        if (*query == '&')
+            query++;
+    }
+    return false;
+}
+
+// リクエスト行（"POST /switchbot HTTP/1.1"）
+static void parseRequestLine(WebhookConnection &conn)
+{
+    const char *line = conn.line;
+    conn.methodOk = strncmp(line, "POST ", 5) == 0;
+    const char *path = strchr(line, ' ');
+    if (path == nullptr)
+        return;
+    path++;
+    size_t pathLen = strlen(WEBHOOK_PATH);
+    conn.pathOk = strncmp(path, WEBHOOK_PATH, pathLen) == 0 && (path[pathLen] == ' ' || path[pathLen] == '?');
+    if (conn.pathOk && path[pathLen] == '?')
+        conn.tokenOk = queryTokenOk(path + pathLen + 1);
+}
+
+// ヘッダー1行（必要なのは Content-Length と合言葉だけ、chunked は受け付けない）
+static void parseHeaderLine(WebhookConnection &conn)
+{
+    const char *line = conn.line;
+    size_t headerLen = strlen(WEBHOOK_TOKEN_HEADER);
+    if (strncasecmp(line, WEBHOOK_TOKEN_HEADER, headerLen) == 0 && line[headerLen] == ':')
+    {
+        const char *value = line + headerLen + 1;
+        while (*value == ' ')
+            value++;
+        size_t len = strlen(value);
+        while (len > 0 && value[len - 1] == ' ')
+            len--;
+        conn.tokenOk = conn.tokenOk || tokenMatches(value, len);
+    }
+    else if (strncasecmp(line, "Content-Length:", 15) == 0)
+    {
+        conn.contentLength = strtol(line + 15, nullptr, 10);
+    }
+    else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0)
+    {
+        // 長さの分からないボディは扱わない（411 を返す）
+        conn.contentLength = -1;
+    }
+}
+
+// ヘッダーを読み終えた（戻り値: ボディを読む=true、応答済み=false）
+static bool headerDone(int client, WebhookConnection &conn)
+{
+    if (!conn.methodOk)
+    {
+        respond(client, 405);
+        return false;
+    }
+    if (!conn.pathOk)
+    {
+        respond(client, 404);
+        return false;
+    }
+    if (!conn.tokenOk)
+    {
+        respond(client, 401);
+        return false;
+    }
+    if (conn.contentLength < 0)
+    {
+        respond(client, 411);
+        return false;
+    }
+    if (conn.contentLength > WEBHOOK_BODY_MAX)
+    {
+        respond(client, 413);
+        return false;
+    }
+    conn.state = WEBHOOK_CONN_BODY;
+    return true;
+}
+
+// ボディを読み終えた: イベントを反映して応答
+static void bodyDone(int client, WebhookConnection &conn, unsigned long now)
+{
+    if (conn.parser.failed() || !conn.parser.finished())
+    {
+        Serial.println("Webhook: malformed event");
+        respond(client, 400);
+        return;
+    }
+
+    // 反映できたイベントだけを「届いている」とみなす（関係ないイベントで定期取得を止めない）
+    const WebhookEvent &event = conn.parser.result();
+    stats.events++;
+    if (event.changeReport && eventHandler != nullptr && eventHandler(event))
+    {
+        stats.applied++;
+        anyEvent = true;
+        lastEventAt = now;
+    }
+    else
+    {
+        stats.ignored++;
+    }
+    respond(client, 204);
+}
+
+// 受信したバイト列を処理（戻り値: まだ接続中=true）
+static bool consume(int client, WebhookConnection &conn, const char *data, size_t len, unsigned long now)
+{
+    size_t pos = 0;
+    while (pos < len && conn.state == WEBHOOK_CONN_HEADER)
+    {
+        char c = data[pos++];
+        if (c == '\r')
+            continue;
+        if (c != '\n')
+        {
+            // 長すぎる行（Cookie など）は先頭だけ見る
+            if (conn.lineLen + 1 < sizeof(conn.line))
+                conn.line[conn.lineLen++] = c;
+            continue;
+        }
+
+        conn.line[conn.lineLen] = '\0';
+        if (conn.requestLine)
+        {
+            parseRequestLine(conn);
+            conn.requestLine = false;
+        }
+        else if (conn.lineLen == 0)
+        {
+            if (!headerDone(client, conn))
+                return false;
+        }
+        else
+        {
+            parseHeaderLine(conn);
+        }
+        conn.lineLen = 0;
+    }
+
+    if (conn.state == WEBHOOK_CONN_BODY && pos < len)
+    {
+        // Content-Length を超えた分は読み捨てる
+        size_t n = min(len - pos, (size_t)(conn.contentLength - conn.received));
+        conn.parser.feed(data + pos, n);
+        conn.received += n;
+    }
+    if (conn.state == WEBHOOK_CONN_BODY && conn.received >= conn.contentLength)
+    {
+        bodyDone(client, conn, now);
+        return false;
+    }
+    return true;
+}
+
+void webhookInit(WebhookEventHandler handler)
+{
+    eventHandler = handler;
+    for (int i = 0; i < HAL_SERVER_MAX_CLIENTS; i++)
+        connections[i].state = WEBHOOK_CONN_IDLE;
+}
+
+void webhookBegin()
+{
+#if WEBHOOK_LISTENER
+    if (listening)
+        return;
+    if (strlen(WEBHOOK_TOKEN) == 0)
+    {
+        Serial.println("Webhook: WEBHOOK_TOKEN is not set in secrets.h, not listening");
+        return;
+    }
+    listening = halServerBegin(WEBHOOK_PORT);
+    if (listening)
+        Serial.printf("Webhook: listening on :%u%s\n", (unsigned)halServerPort(), WEBHOOK_PATH);
+#endif
+}
+
+void webhookService(unsigned long now)
+{
+    if (!listening)
+        return;
+
+    int client = halServerAccept();
+    if (client >= 0)
+    {
+        WebhookConnection &conn = connections[client];
+        conn.state = WEBHOOK_CONN_HEADER;
+        conn.startedAt = now;
+        conn.lineLen = 0;
+        conn.requestLine = true;
+        conn.methodOk = false;
+        conn.pathOk = false;
+        conn.tokenOk = false;
+        conn.contentLength = 0;
+        conn.received = 0;
+        conn.parser.reset();
+        stats.requests++;
+    }
+
+    for (int i = 0; i < HAL_SERVER_MAX_CLIENTS; i++)
+    {
+        WebhookConnection &conn = connections[i];
+        if (conn.state == WEBHOOK_CONN_IDLE)
+            continue;
+
+        char buf[128];
+        int budget = WEBHOOK_READ_PER_LOOP;
+        while (budget > 0)
+        {
+            int n = halServerRead(i, buf, min((size_t)budget, sizeof(buf)));
+            if (n < 0)
+            {
+                // 読み終える前に切断された
+                halServerClose(i);
+                conn.state = WEBHOOK_CONN_IDLE;
+                stats.rejected++;
+                break;
+            }
+            if (n == 0 || !consume(i, conn, buf, n, now))
+                break;
+            budget -= n;
+        }
+
+        if (conn.state != WEBHOOK_CONN_IDLE && now - conn.startedAt >= WEBHOOK_CLIENT_TIMEOUT_MS)
+        {
+            Serial.println("Webhook: request timed out");
+            respond(i, 400);
+        }
+    }
+}
+
+bool webhookNextService(unsigned long now, unsigned long &at)
+{
+    if (!listening)
+        return false;
+
+    at = eventLoopNextPoll(now);
+    for (int i = 0; i < HAL_SERVER_MAX_CLIENTS; i++)
+    {
+        if (connections[i].state != WEBHOOK_CONN_IDLE)
+            at = now + EVENT_LOOP_TICK_MS;
+    }
+    return true;
+}
+
+bool webhookActive(unsigned long now)
+{
+    return anyEvent && now - lastEventAt < WEBHOOK_ACTIVE_MS;
+}
+
+uint32_t webhookPollInterval(uint32_t baseMs, unsigned long now)
+{
+    if (!webhookActive(now) || baseMs >= WEBHOOK_SAFETY_INTERVAL_MS)
+        return baseMs;
+    return WEBHOOK_SAFETY_INTERVAL_MS;
+}
+
+WebhookStats webhookGetStats()
+{
+    return stats;
+}
+
+void webhookPrint()
+{
+    Serial.printf("Webhook: requests=%lu events=%lu applied=%lu ignored=%lu rejected=%lu active=%d\n",
+                  (unsigned long)stats.requests, (unsigned long)stats.events, (unsigned long)stats.applied,
+                  (unsigned long)stats.ignored, (unsigned long)stats.rejected, webhookActive(millis()) ? 1 : 0);
+}
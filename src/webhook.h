@@ -0,0 +1,78 @@
+#ifndef WEBHOOK_H
+#define WEBHOOK_H
+
+#include <Arduino.h>
+#include "webhook_event.h"
+
+// SwitchBot の Webhook イベントを LAN 内の中継から受け取る（0 にすると定期取得だけを使う）
+// SwitchBot クラウドはインターネットから届く URL にしか送れないため、
+// 外部で受けたイベントを LAN 内の中継がこのパネルの WEBHOOK_PORT / WEBHOOK_PATH へ POST する
+#ifndef WEBHOOK_LISTENER
+#define WEBHOOK_LISTENER 1
+#endif
+
+#ifndef WEBHOOK_PORT
+#define WEBHOOK_PORT 8080
+#endif
+#define WEBHOOK_PATH "/switchbot"
+
+// 中継は secrets.h の WEBHOOK_TOKEN をこのヘッダー（または WEBHOOK_PATH?token=...）で送る、一致しなければ 401
+#define WEBHOOK_TOKEN_HEADER "X-Webhook-Token"
+
+// 受け付けるボディの最大長（超えたら 413）と、1行（リクエスト行・ヘッダー）の最大長
+#define WEBHOOK_BODY_MAX 2048
+#define WEBHOOK_LINE_MAX 128
+
+// リクエストを読み終えるまでの時間（超えたら切断）
+#define WEBHOOK_CLIENT_TIMEOUT_MS 2000
+
+// 1ループで1接続から読むバイト数の上限（uiUpdate の処理時間を抑える）
+#define WEBHOOK_READ_PER_LOOP 512
+
+// 最後のイベントからこの時間はイベントが届いているとみなす
+#define WEBHOOK_ACTIVE_MS 1800000
+
+// イベントが届いている間の定期取得の間隔（取りこぼしに備えた確認だけにする）
+#define WEBHOOK_SAFETY_INTERVAL_MS 600000
+
+// イベントが届いている間、操作した電球の変化のイベントを待つ時間（届かなければ状態を取得して確かめる）
+#define WEBHOOK_CONFIRM_WAIT_MS 60000
+
+// 受信の集計
+struct WebhookStats
+{
+    uint32_t requests; // 受け付けた接続
+    uint32_t events;   // 読めたイベント
+    uint32_t applied;  // 登録簿の電球・温湿度計に反映したイベント
+    uint32_t ignored;  // 登録されていないデバイス・changeReport 以外のイベント
+    uint32_t rejected; // 不正なリクエスト・JSON、合言葉の不一致、タイムアウト
+};
+
+// 読めたイベントの反映先（UIスレッドで呼ばれる）
+// 戻り値: 登録簿のデバイスのイベントだった=true
+typedef bool (*WebhookEventHandler)(const WebhookEvent &event);
+
+// 初期化
+void webhookInit(WebhookEventHandler handler);
+
+// 待ち受けを開始（WiFi 接続後に呼ぶ、開始済みなら何もしない）
+void webhookBegin();
+
+// 接続の受け付け・受信・応答（uiUpdate から毎ループ呼ぶ、待たない）
+void webhookService(unsigned long now);
+
+// 次に webhookService を呼ぶ時刻（受信中の接続があれば EVENT_LOOP_TICK_MS 後、待ち受け中は eventLoopNextPoll）
+// 戻り値: 待ち受けていない=false
+bool webhookNextService(unsigned long now, unsigned long &at);
+
+// イベントが届いているか（最後に反映できたイベントから WEBHOOK_ACTIVE_MS 以内）
+bool webhookActive(unsigned long now);
+
+// 定期取得の間隔（イベントが届いている間は WEBHOOK_SAFETY_INTERVAL_MS まで延ばす）
+uint32_t webhookPollInterval(uint32_t baseMs, unsigned long now);
+
+// 集計取得・シリアル出力
+WebhookStats webhookGetStats();
+void webhookPrint();
+
+#endif // WEBHOOK_H
@@ -0,0 +1,88 @@
+#include "webhook_event.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+// "60:55:F9:2F:CF:D2" / "6055f92fcfd2" を API のデバイスIDの形（"6055F92FCFD2"）にする
+static void normalizeMac(const char *mac, char *out, size_t size)
+{
+    size_t len = 0;
+    for (const char *p = mac; *p != '\0' && len + 1 < size; p++)
+    {
+        if (*p == ':' || *p == '-')
+            continue;
+        out[len++] = (char)toupper((unsigned char)*p);
+    }
+    out[len] = '\0';
+}
+
+WebhookEventParser::WebhookEventParser()
+    : scanner(onValue, this)
+{
+    // "context" 直下より深い入れ子は読まない
+    scanner.setDepthLimit(2);
+    reset();
+}
+
+void WebhookEventParser::reset()
+{
+    memset(&event, 0, sizeof(event));
+    scanner.reset();
+}
+
+bool WebhookEventParser::feed(const char *data, size_t len)
+{
+    if (!scanner.feed(data, len))
+        return false;
+    return !scanner.finished();
+}
+
+void WebhookEventParser::onValue(void *ctx, const char *parentKey, const char *key,
+                                 JsonValueType type, const char *value, bool truncated)
+{
+    WebhookEventParser *self = static_cast<WebhookEventParser *>(ctx);
+    WebhookEvent &e = self->event;
+    DeviceStatus &s = e.status;
+    if (truncated)
+        return;
+
+    // トップレベル
+    if (parentKey[0] == '\0')
+    {
+        if (type == JSON_STRING && strcmp(key, "eventType") == 0)
+            e.changeReport = strcmp(value, "changeReport") == 0;
+        return;
+    }
+
+    // "context" 直下のみ
+    if (strcmp(parentKey, "context") != 0)
+        return;
+
+    if (type == JSON_STRING && strcmp(key, "deviceMac") == 0)
+    {
+        normalizeMac(value, e.deviceId, sizeof(e.deviceId));
+    }
+    else if (type == JSON_STRING && strcmp(key, "powerState") == 0)
+    {
+        // Webhook は "ON" / "OFF"（ステータス取得の "on" / "off" とは大文字小文字が違う）
+        s.power = strcasecmp(value, "on") == 0;
+        s.found |= STATUS_FIELD_POWER;
+    }
+    else if (type == JSON_NUMBER && strcmp(key, "brightness") == 0)
+    {
+        s.brightness = atoi(value);
+        s.found |= STATUS_FIELD_BRIGHTNESS;
+    }
+    else if (type == JSON_NUMBER && strcmp(key, "temperature") == 0)
+    {
+        s.temperature = strtof(value, nullptr);
+        s.found |= STATUS_FIELD_TEMPERATURE;
+    }
+    else if (type == JSON_NUMBER && strcmp(key, "humidity") == 0)
+    {
+        s.humidity = atoi(value);
+        s.found |= STATUS_FIELD_HUMIDITY;
+    }
+}
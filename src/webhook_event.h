@@ -0,0 +1,50 @@
+#ifndef WEBHOOK_EVENT_H
+#define WEBHOOK_EVENT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "json_scanner.h"
+#include "device_registry.h"
+#include "device_status.h"
+
+// SwitchBot の Webhook イベント（状態が変わったときに送られる JSON）
+// {"eventType":"changeReport","eventVersion":"1",
+//  "context":{"deviceType":"WoBulb","deviceMac":"6055F92FCFD2","powerState":"ON","brightness":80,...}}
+struct WebhookEvent
+{
+    bool changeReport;             // eventType が changeReport か
+    char deviceId[DEVICE_ID_LEN];  // deviceMac（区切りの ':' を除いて大文字にしたもの、API のデバイスIDと同じ形）
+    DeviceStatus status;           // context の値（found に STATUS_FIELD_POWER / BRIGHTNESS / TEMPERATURE / HUMIDITY）
+};
+
+// Webhook イベントのストリーミングパーサー
+// トップレベルの eventType と "context" 直下のフィールドだけを取り出す。ヒープは使わない。
+class WebhookEventParser
+{
+public:
+    WebhookEventParser();
+
+    // 次のイベントのために状態を初期化
+    void reset();
+
+    // チャンクを投入
+    // 戻り値: 続きが必要=true, 読み終えたまたは構文エラー=false
+    bool feed(const char *data, size_t len);
+
+    // イベントを最後まで読めたか（ルートのオブジェクトが閉じた）
+    bool finished() const { return scanner.finished(); }
+
+    // 構文エラーが発生したか
+    bool failed() const { return scanner.failed(); }
+
+    const WebhookEvent &result() const { return event; }
+
+private:
+    static void onValue(void *ctx, const char *parentKey, const char *key,
+                        JsonValueType type, const char *value, bool truncated);
+
+    WebhookEvent event;
+    JsonScanner scanner;
+};
+
+#endif // WEBHOOK_EVENT_H